@@ -0,0 +1,29 @@
+/*
+The MIT License (MIT) 
+Copyright (c) 2009,2010,2016 Andreas Heck <aheck@gmx.de>
+
+Permission to use, copy, modify, and/or distribute this software for any
+purpose with or without fee is hereby granted, provided that the above
+copyright notice and this permission notice appear in all copies.
+
+THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+*/
+
+#ifndef __ACCESSFLAGS_H__
+#define __ACCESSFLAGS_H__
+
+#include <glib.h>
+#include <classreader/javaclass.h>
+#include <classscan.h>
+
+gint64 class_access_flags(JavaClass *c, ClassScan *scan);
+gint64 field_access_flags(JavaField *f, ClassScan *scan, gsize member);
+gint64 method_access_flags(JavaMethod *m, ClassScan *scan, gsize member);
+
+#endif /* __ACCESSFLAGS_H__ */
@@ -0,0 +1,68 @@
+/*
+The MIT License (MIT) 
+Copyright (c) 2009,2010,2016 Andreas Heck <aheck@gmx.de>
+
+Permission to use, copy, modify, and/or distribute this software for any
+purpose with or without fee is hereby granted, provided that the above
+copyright notice and this permission notice appear in all copies.
+
+THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+*/
+
+#ifndef __AHOCORASICK_H__
+#define __AHOCORASICK_H__
+
+#include <glib.h>
+
+/*
+ * Called for every occurrence of a pattern found by ahocorasick_search()
+ *
+ * id is the ID the pattern was added with and end the offset behind the
+ * occurrence. Returning FALSE stops the search.
+ */
+typedef gboolean (*AhoCorasickFunc)(guint id, gsize end, gpointer user_data);
+
+/*
+ * Aho-Corasick automaton finding any number of byte strings in a single
+ * pass over a text
+ *
+ * The patterns are compiled into a DFA whose transitions are one table
+ * lookup per byte of the text. Bytes which don't occur in any pattern share
+ * one column of the table, so it only grows with the distinct bytes of the
+ * patterns instead of all 256. Once compiled an automaton is read-only and
+ * can be used by several threads at the same time.
+ */
+typedef struct {
+    gboolean ignore_case;       // only ASCII letters are folded
+    GPtrArray *patterns;        // GBytes until ahocorasick_compile()
+    GArray *ids;
+
+    // column of each byte in the table; with all 256 bytes in patterns
+    // there are 257 columns, so a column doesn't fit into a byte
+    guint16 classes[256];
+    guint alphabet;             // number of columns
+
+    // transitions of each state; the entries are the offset of the target
+    // state in the table shifted left by one with the lowest bit set if a
+    // pattern ends in it
+    guint32 *next;
+    guint32 *match;             // ID + 1 of the pattern ending in a state
+    guint32 *match_link;        // next shorter suffix state with a match
+    guint32 states;
+} AhoCorasick;
+
+AhoCorasick *ahocorasick_new(gboolean ignore_case);
+void ahocorasick_add(AhoCorasick *ac, const gchar *pattern, gsize length,
+        guint id);
+void ahocorasick_compile(AhoCorasick *ac);
+gboolean ahocorasick_search(const AhoCorasick *ac, const guchar *text,
+        gsize length, AhoCorasickFunc func, gpointer user_data);
+void ahocorasick_free(AhoCorasick *ac);
+
+#endif /* __AHOCORASICK_H__ */
@@ -0,0 +1,43 @@
+/*
+The MIT License (MIT) 
+Copyright (c) 2009,2010,2016 Andreas Heck <aheck@gmx.de>
+
+Permission to use, copy, modify, and/or distribute this software for any
+purpose with or without fee is hereby granted, provided that the above
+copyright notice and this permission notice appear in all copies.
+
+THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+*/
+
+#ifndef __ANNOTATIONS_H__
+#define __ANNOTATIONS_H__
+
+#include <glib.h>
+
+#include <classscan.h>
+
+/*
+ * Callbacks for the annotations of a Runtime(In)VisibleAnnotations
+ * attribute
+ *
+ * The type is the fully qualified name of the annotation (e.g.
+ * javax.persistence.Entity). Each simple element value of the annotation
+ * is reported after its type; elements which are arrays of simple values
+ * are reported once per element, nested annotations are skipped.
+ */
+typedef struct {
+    void (*annotation)(const gchar *type, gpointer user_data);
+    void (*value)(const gchar *name, const gchar *value, gpointer user_data);
+} AnnotationHandler;
+
+gboolean annotations_parse(ClassScan *scan, const guchar *data,
+        guint32 length, AnnotationHandler *handler, gpointer user_data);
+gchar *annotations_type_name(const gchar *descriptor, gsize length);
+
+#endif /* __ANNOTATIONS_H__ */
@@ -0,0 +1,69 @@
+/*
+The MIT License (MIT) 
+Copyright (c) 2009,2010,2016 Andreas Heck <aheck@gmx.de>
+
+Permission to use, copy, modify, and/or distribute this software for any
+purpose with or without fee is hereby granted, provided that the above
+copyright notice and this permission notice appear in all copies.
+
+THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+*/
+
+#ifndef __APICHANGE_H__
+#define __APICHANGE_H__
+
+#include <glib.h>
+
+/*
+ * Kinds of elements of the API in the order of the API query of
+ * java-apidiff
+ */
+enum {
+    API_CLASS,
+    API_FIELD,
+    API_METHOD
+};
+
+typedef enum {
+    CHANGE_ADDED,
+    CHANGE_REMOVED,
+    CHANGE_CHANGED
+} ChangeType;
+
+/*
+ * Binary compatibility of a change as defined by chapter 13 of the Java
+ * Language Specification; a change of the superclass may or may not break
+ * clients depending on the rest of the class hierarchy
+ */
+typedef enum {
+    COMPATIBLE,
+    MAYBE_INCOMPATIBLE,
+    INCOMPATIBLE
+} Compatibility;
+
+/*
+ * A class, field or method of the public API of an index
+ *
+ * Classes have an empty name and descriptor, members no parent.
+ */
+typedef struct {
+    const gchar *namespace;
+    const gchar *class;
+    int kind;
+    const gchar *name;
+    const gchar *descriptor;
+    gint64 access_flags;
+    const gchar *parent;
+} ApiRow;
+
+int apichange_compare(const ApiRow *a, const ApiRow *b);
+Compatibility apichange_classify(ChangeType change, const ApiRow *old,
+        const ApiRow *new, GPtrArray *reasons);
+
+#endif /* __APICHANGE_H__ */
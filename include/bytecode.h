@@ -0,0 +1,41 @@
+/*
+The MIT License (MIT) 
+Copyright (c) 2009,2010,2016 Andreas Heck <aheck@gmx.de>
+
+Permission to use, copy, modify, and/or distribute this software for any
+purpose with or without fee is hereby granted, provided that the above
+copyright notice and this permission notice appear in all copies.
+
+THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+*/
+
+#ifndef __BYTECODE_H__
+#define __BYTECODE_H__
+
+#include <glib.h>
+
+#include <classscan.h>
+
+/*
+ * Figures from the Code attribute of a method which decide how HotSpot
+ * compiles it
+ */
+typedef struct {
+    guint32 code_length;
+    guint16 max_stack;
+    guint16 max_locals;
+    guint16 exception_handlers;
+    guint32 invocations;        // invoke* instructions in the bytecode
+} CodeStats;
+
+gboolean bytecode_code_stats(ClassScan *scan, gsize method, CodeStats *stats);
+gsize bytecode_instruction_length(const guchar *code, guint32 length,
+        guint32 pc);
+
+#endif /* __BYTECODE_H__ */
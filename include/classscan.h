@@ -0,0 +1,102 @@
+/*
+The MIT License (MIT) 
+Copyright (c) 2009,2010,2016 Andreas Heck <aheck@gmx.de>
+
+Permission to use, copy, modify, and/or distribute this software for any
+purpose with or without fee is hereby granted, provided that the above
+copyright notice and this permission notice appear in all copies.
+
+THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+*/
+
+#ifndef __CLASSSCAN_H__
+#define __CLASSSCAN_H__
+
+#include <glib.h>
+
+// constant pool tags
+#define CONSTANT_Utf8               1
+#define CONSTANT_Integer            3
+#define CONSTANT_Float              4
+#define CONSTANT_Long               5
+#define CONSTANT_Double             6
+#define CONSTANT_Class              7
+#define CONSTANT_String             8
+#define CONSTANT_Fieldref           9
+#define CONSTANT_Methodref          10
+#define CONSTANT_InterfaceMethodref 11
+#define CONSTANT_NameAndType        12
+#define CONSTANT_MethodHandle       15
+#define CONSTANT_MethodType         16
+#define CONSTANT_Dynamic            17
+#define CONSTANT_InvokeDynamic      18
+#define CONSTANT_Module             19
+#define CONSTANT_Package            20
+
+/*
+ * Result of a lightweight scan over the raw bytes of a class file
+ *
+ * In contrast to libclassreader nothing is decoded or copied; the scan only
+ * records where the parts of the class file start. A ClassScan can be
+ * reused for many classes so that the constant pool index is allocated only
+ * once per thread. It has to be zero-initialized before its first use.
+ */
+typedef struct {
+    const guchar *data;
+    gsize size;
+
+    guint16 minor_version;
+    guint16 major_version;
+
+    // offsets of the constant pool entries (index 0 is unused)
+    guint16 constant_pool_count;
+    guint32 *constant_pool;
+    guint constant_pool_capacity;
+
+    guint16 access_flags;
+    guint16 this_class;
+    guint16 super_class;
+    guint16 interfaces_count;
+    guint16 fields_count;
+    guint16 methods_count;
+
+    gsize interfaces_start;
+    gsize fields_start;
+    gsize methods_start;
+    gsize attributes_start;
+} ClassScan;
+
+gboolean classscan_init(ClassScan *scan, const guchar *data, gsize size);
+void classscan_clear(ClassScan *scan);
+
+guint8 classscan_tag(ClassScan *scan, guint16 index);
+const guchar *classscan_utf8(ClassScan *scan, guint16 index, guint16 *length);
+gchar *classscan_string(ClassScan *scan, guint16 index);
+gchar *classscan_class_name(ClassScan *scan, guint16 index);
+gchar *classscan_constant_name(ClassScan *scan, guint16 index, guint8 tag);
+const guchar *classscan_attribute(ClassScan *scan, const gchar *name,
+        guint32 *length);
+gsize classscan_next_member(ClassScan *scan, gsize member);
+gboolean classscan_member_is(ClassScan *scan, gsize member,
+        const gchar *name);
+const guchar *classscan_member_attribute(ClassScan *scan, gsize member,
+        const gchar *name, guint32 *length);
+
+static inline guint16 classscan_u2(const guchar *p)
+{
+    return (guint16) ((p[0] << 8) | p[1]);
+}
+
+static inline guint32 classscan_u4(const guchar *p)
+{
+    return ((guint32) p[0] << 24) | ((guint32) p[1] << 16)
+        | ((guint32) p[2] << 8) | (guint32) p[3];
+}
+
+#endif /* __CLASSSCAN_H__ */
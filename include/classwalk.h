@@ -0,0 +1,41 @@
+/*
+The MIT License (MIT) 
+Copyright (c) 2009,2010,2016 Andreas Heck <aheck@gmx.de>
+
+Permission to use, copy, modify, and/or distribute this software for any
+purpose with or without fee is hereby granted, provided that the above
+copyright notice and this permission notice appear in all copies.
+
+THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+*/
+
+#ifndef __CLASSWALK_H__
+#define __CLASSWALK_H__
+
+#include <glib.h>
+
+/*
+ * Called for every class file found by classwalk_path()
+ *
+ * container is the JAR the class was read from or NULL for a loose class
+ * file. name is the entry name inside the JAR or the path of the class
+ * file. The callback takes ownership of bytes and has to g_free() them.
+ */
+typedef void (*ClassWalkFunc)(const gchar *container, const gchar *name,
+        guchar *bytes, gsize size, gpointer user_data);
+
+void classwalk_path(const gchar *path, gboolean skip_inner,
+        ClassWalkFunc func, gpointer user_data);
+void classwalk_jar(const gchar *jarfile, gboolean skip_inner,
+        ClassWalkFunc func, gpointer user_data);
+void classwalk_dir(const gchar *dirname, gboolean skip_inner,
+        ClassWalkFunc func, gpointer user_data);
+void classwalk_list(const gchar *path, GPtrArray *containers);
+
+#endif /* __CLASSWALK_H__ */
@@ -21,4 +21,17 @@ OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
 #define DB_FILE "index.db"
 #define DEFAULT_PACKAGE "(default)"
 
+// access flags as defined by the JVM specification
+#define ACC_PUBLIC       0x0001
+#define ACC_PRIVATE      0x0002
+#define ACC_PROTECTED    0x0004
+#define ACC_STATIC       0x0008
+#define ACC_FINAL        0x0010
+#define ACC_SYNCHRONIZED 0x0020
+#define ACC_INTERFACE    0x0200
+#define ACC_ABSTRACT     0x0400
+#define ACC_ANNOTATION   0x2000
+#define ACC_ENUM         0x4000
+#define ACC_MODULE       0x8000
+
 #endif /* __GLOBAL_H__ */
@@ -0,0 +1,51 @@
+/*
+The MIT License (MIT) 
+Copyright (c) 2009,2010,2016 Andreas Heck <aheck@gmx.de>
+
+Permission to use, copy, modify, and/or distribute this software for any
+purpose with or without fee is hereby granted, provided that the above
+copyright notice and this permission notice appear in all copies.
+
+THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+*/
+
+#ifndef __NESTEDJAR_H__
+#define __NESTEDJAR_H__
+
+#include <glib.h>
+#include <zip.h>
+
+/*
+ * A JAR which is read from a file or from an entry of another JAR
+ *
+ * Nested JARs (e.g. the JARs in BOOT-INF/lib of Spring Boot or WEB-INF/lib
+ * of a WAR) are opened in memory and never extracted to disk. A stored
+ * entry is used right out of the mapping of its parent, only a compressed
+ * one is inflated into a buffer of its own.
+ */
+typedef struct {
+    struct zip *zip;
+    const gchar *path;          // file of a top level JAR, otherwise NULL
+    const guchar *data;         // bytes of the JAR or NULL if not mapped yet
+    gsize size;
+    GMappedFile *mapping;       // mapping of a top level JAR
+    guchar *buffer;             // inflated contents of a nested JAR
+    guint32 *offsets;           // local header offsets of the entries
+    guint depth;                // number of JARs around it
+} NestedJar;
+
+NestedJar *nestedjar_new(struct zip *zip, const gchar *path);
+NestedJar *nestedjar_open(NestedJar *parent, zip_uint64_t index,
+        GError **error);
+void nestedjar_close(NestedJar *jar);
+
+gboolean nestedjar_is_archive(const gchar *filename);
+const gchar *nestedjar_class_path(const gchar *filename);
+
+#endif /* __NESTEDJAR_H__ */
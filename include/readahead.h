@@ -0,0 +1,35 @@
+/*
+The MIT License (MIT) 
+Copyright (c) 2009,2010,2016 Andreas Heck <aheck@gmx.de>
+
+Permission to use, copy, modify, and/or distribute this software for any
+purpose with or without fee is hereby granted, provided that the above
+copyright notice and this permission notice appear in all copies.
+
+THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+*/
+
+#ifndef __READAHEAD_H__
+#define __READAHEAD_H__
+
+#include <glib.h>
+
+/*
+ * Helpers to read class files in disk order with a cold page cache
+ *
+ * The kernel is asked to read JARs ahead while they are parsed, and the
+ * entries of JARs and directories are visited in the order in which they
+ * are stored instead of the order of the ZIP central directory or of the
+ * directory entries.
+ */
+void readahead_file(const gchar *path);
+guint *readahead_jar_order(const gchar *jarfile, guint numfiles);
+GPtrArray *readahead_dir(const gchar *dirname, GError **error);
+
+#endif /* __READAHEAD_H__ */
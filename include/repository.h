@@ -0,0 +1,63 @@
+/*
+The MIT License (MIT) 
+Copyright (c) 2009,2010,2016 Andreas Heck <aheck@gmx.de>
+
+Permission to use, copy, modify, and/or distribute this software for any
+purpose with or without fee is hereby granted, provided that the above
+copyright notice and this permission notice appear in all copies.
+
+THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+*/
+
+#ifndef __REPOSITORY_H__
+#define __REPOSITORY_H__
+
+#include <glib.h>
+
+/*
+ * A version of an artifact with the JARs found for it, e.g. the main JAR
+ * and JARs with classifiers like linux-x86_64
+ */
+typedef struct {
+    gchar *version;
+    GPtrArray *jars;
+} ArtifactVersion;
+
+/*
+ * A class which is contained in the versions first to last of an artifact
+ * (indexes into its sorted versions) without a gap
+ */
+typedef struct {
+    gchar *name;                // fully qualified, e.g. java.util.Map$Entry
+    guint first;
+    guint last;
+} ClassRun;
+
+/*
+ * All versions of an artifact of a Maven or Gradle repository
+ *
+ * The versions are collected by repository_collect() and sorted and
+ * scanned into runs by repository_scan_artifact().
+ */
+typedef struct {
+    gchar *group_id;
+    gchar *artifact_id;
+    GPtrArray *versions;        // ArtifactVersion
+    GPtrArray *runs;            // ClassRun
+} Artifact;
+
+void repository_collect(const gchar *root, GHashTable *artifacts);
+GPtrArray *repository_sorted(GHashTable *artifacts);
+gboolean repository_coordinates(const gchar *root, const gchar *path,
+        gchar **group_id, gchar **artifact_id, gchar **version);
+gint repository_version_compare(const gchar *a, const gchar *b);
+void repository_scan_artifact(Artifact *artifact);
+void repository_artifact_free(Artifact *artifact);
+
+#endif /* __REPOSITORY_H__ */
@@ -0,0 +1,44 @@
+/*
+The MIT License (MIT) 
+Copyright (c) 2009,2010,2016 Andreas Heck <aheck@gmx.de>
+
+Permission to use, copy, modify, and/or distribute this software for any
+purpose with or without fee is hereby granted, provided that the above
+copyright notice and this permission notice appear in all copies.
+
+THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+*/
+
+#ifndef __SERVICES_H__
+#define __SERVICES_H__
+
+#include <glib.h>
+
+/*
+ * Kinds of resource files which register implementations of a service
+ */
+typedef enum {
+    SERVICES_NONE = -1,
+    SERVICES_LOADER,            // META-INF/services/SERVICE
+    SERVICES_SPRING_FACTORIES,  // META-INF/spring.factories
+    SERVICES_SPRING_IMPORTS     // META-INF/spring/SERVICE.imports
+} ServicesKind;
+
+/*
+ * Callback for each provider of a service in a resource file; both are
+ * fully qualified class names
+ */
+typedef void (*ServicesHandler)(ServicesKind kind, const gchar *service,
+        const gchar *provider, gpointer user_data);
+
+ServicesKind services_kind(const gchar *path);
+void services_parse(const gchar *path, const gchar *data, gsize size,
+        ServicesHandler handler, gpointer user_data);
+
+#endif /* __SERVICES_H__ */
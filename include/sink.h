@@ -0,0 +1,144 @@
+/*
+The MIT License (MIT) 
+Copyright (c) 2009,2010,2016 Andreas Heck <aheck@gmx.de>
+
+Permission to use, copy, modify, and/or distribute this software for any
+purpose with or without fee is hereby granted, provided that the above
+copyright notice and this permission notice appear in all copies.
+
+THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+*/
+
+#ifndef __SINK_H__
+#define __SINK_H__
+
+#include <stdio.h>
+#include <glib.h>
+
+#include <classscan.h>
+#include <bytecode.h>
+#include <services.h>
+#include <classreader/javaclass.h>
+
+/*
+ * A class as java-indexproject reads it
+ *
+ * The names are those of libclassreader. The parsed class and the raw scan
+ * of its bytes (NULL if they couldn't be scanned) are passed on for sinks
+ * which need more, like the summaries of the sqlite sink.
+ */
+typedef struct {
+    const gchar *name;          // simple name, e.g. Map$Entry
+    const gchar *package;       // DEFAULT_PACKAGE for the default package
+    const gchar *parent;        // fully qualified or NULL
+    gint64 access_flags;
+    const gchar *signature;     // generic signature or NULL
+    JavaClass *javaclass;
+    ClassScan *scan;
+} SinkClass;
+
+/*
+ * A field or method of a SinkClass
+ */
+typedef struct {
+    const gchar *name;
+    const gchar *descriptor;
+    const gchar *signature;     // generic signature or NULL
+    gint64 access_flags;
+    CodeStats *code;            // NULL for fields and methods without code
+} SinkMember;
+
+/*
+ * Targets of annotations
+ */
+enum {
+    ANNOTATION_TARGET_CLASS,
+    ANNOTATION_TARGET_FIELD,
+    ANNOTATION_TARGET_METHOD
+};
+
+/*
+ * An annotation of a SinkClass or of one of its fields or methods
+ */
+typedef struct {
+    const gchar *type;          // fully qualified, e.g. javax.inject.Named
+    int target;                 // one of ANNOTATION_TARGET_*
+    const gchar *member_name;   // NULL for the class itself
+    const gchar *descriptor;    // of the member or NULL
+    gboolean visible;           // retained at runtime
+} SinkAnnotation;
+
+/*
+ * A module a SinkModule requires
+ */
+typedef struct {
+    gchar *name;
+    gchar *version;             // version compiled against or NULL
+    gint64 flags;
+} SinkRequire;
+
+/*
+ * A package a SinkModule exports, once per module it is exported to
+ */
+typedef struct {
+    gchar *package;
+    gchar *target;              // NULL for an unqualified export
+    gint64 flags;
+} SinkExport;
+
+/*
+ * A module read from a module-info.class
+ */
+typedef struct {
+    gchar *name;
+    gchar *version;             // NULL if none
+    gint64 access_flags;
+    GArray *requires;           // of SinkRequire
+    GArray *exports;            // of SinkExport
+} SinkModule;
+
+/*
+ * Callbacks for what java-indexproject reads
+ *
+ * Everything is read from a container (a JAR or a directory of the class
+ * path), which begin_container and end_container enclose. Within it the
+ * regular files of the project directory, modules, providers of services
+ * and classes are reported in the order they are read.
+ *
+ * Each class starts with begin_class. If it returns FALSE the class is
+ * skipped (e.g. because it is already in the index) and nothing else is
+ * reported for it. Otherwise the fields, the methods each followed by the
+ * exceptions it declares, the interfaces and the annotations each followed
+ * by its values follow, and end_class closes it. The data passed to the
+ * callbacks are only valid during the call.
+ */
+typedef struct {
+    void (*begin_container)(const gchar *path, gpointer user_data);
+    void (*file)(const gchar *dirname, const gchar *name, gpointer user_data);
+    void (*module)(SinkModule *module, gpointer user_data);
+    ServicesHandler service;
+    gboolean (*begin_class)(SinkClass *c, gpointer user_data);
+    void (*field)(SinkMember *field, gpointer user_data);
+    void (*method)(SinkMember *method, gpointer user_data);
+    void (*exception)(const gchar *name, gpointer user_data);
+    void (*interface)(const gchar *name, gpointer user_data);
+    void (*annotation)(SinkAnnotation *annotation, gpointer user_data);
+    void (*annotation_value)(const gchar *name, const gchar *value,
+            gpointer user_data);
+    void (*end_class)(gpointer user_data);
+    void (*end_container)(gpointer user_data);
+} IndexSink;
+
+extern IndexSink null_sink;
+extern IndexSink ndjson_sink;
+
+gpointer sink_ndjson_new(FILE *fp);
+void sink_ndjson_free(gpointer user_data);
+
+#endif /* __SINK_H__ */
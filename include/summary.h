@@ -0,0 +1,63 @@
+/*
+The MIT License (MIT) 
+Copyright (c) 2009,2010,2016 Andreas Heck <aheck@gmx.de>
+
+Permission to use, copy, modify, and/or distribute this software for any
+purpose with or without fee is hereby granted, provided that the above
+copyright notice and this permission notice appear in all copies.
+
+THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+*/
+
+#ifndef __SUMMARY_H__
+#define __SUMMARY_H__
+
+#include <glib.h>
+#include <classreader/javaclass.h>
+#include <classscan.h>
+
+/*
+ * Compact record of a class and all its members
+ *
+ * The record is stored compressed with zlib in one row per class so that
+ * all members of a class can be read without joining the tables of the
+ * index. Numbers are unsigned LEB128 varints and strings are their length
+ * plus one followed by the bytes; a length of 0 is a NULL string.
+ *
+ *   version
+ *   access_flags fq_name parent signature
+ *   interface_count   { fq_name }
+ *   field_count       { access_flags name descriptor signature }
+ *   method_count      { access_flags name descriptor signature
+ *                       exception_count { fq_name } }
+ */
+#define SUMMARY_VERSION 1
+
+typedef struct {
+    const guchar *data;
+    gsize size;
+    gsize pos;
+    gboolean error;     // set if the record ended unexpectedly
+} SummaryReader;
+
+GByteArray *summary_new(JavaClass *c, ClassScan *scan);
+void summary_put_uint(GByteArray *buffer, guint64 value);
+void summary_put_string(GByteArray *buffer, const gchar *str);
+
+void summary_reader_init(SummaryReader *reader, const guchar *data,
+        gsize size);
+guint64 summary_get_uint(SummaryReader *reader);
+gchar *summary_get_string(SummaryReader *reader);
+
+guchar *summary_compress(const guchar *data, gsize size,
+        gsize *compressed_size);
+guchar *summary_uncompress(const guchar *data, gsize size,
+        gsize uncompressed_size);
+
+#endif /* __SUMMARY_H__ */
@@ -0,0 +1,63 @@
+/*
+The MIT License (MIT) 
+Copyright (c) 2009,2010,2016 Andreas Heck <aheck@gmx.de>
+
+Permission to use, copy, modify, and/or distribute this software for any
+purpose with or without fee is hereby granted, provided that the above
+copyright notice and this permission notice appear in all copies.
+
+THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+*/
+
+#ifndef __SYMTAB_H__
+#define __SYMTAB_H__
+
+#include <glib.h>
+
+/*
+ * Symbol table mapping strings to database IDs
+ *
+ * An open-addressing hash table with Robin Hood probing. Each slot holds
+ * the hash, the offset of the string in one contiguous arena and the ID
+ * inline, so a lookup touches one cache line in the common case and no
+ * per-entry allocations are necessary. IDs have to be greater than 0.
+ */
+typedef struct _SymTab SymTab;
+
+SymTab *symtab_new(guint expected);
+void symtab_free(SymTab *table);
+void symtab_reserve(SymTab *table, guint additional);
+void symtab_clear(SymTab *table);
+
+guint64 symtab_hash(const gchar *str);
+gint64 symtab_lookup(SymTab *table, const gchar *str, guint64 hash);
+void symtab_insert(SymTab *table, const gchar *str, guint64 hash, gint64 id);
+
+guint symtab_size(SymTab *table);
+gsize symtab_memory(SymTab *table);
+
+/*
+ * Two generations of symbol tables keeping the recently used strings of a
+ * bounded-memory run
+ *
+ * Lookups move the strings of the previous generation into the current
+ * one. Once the current tables of a set of caches outgrow their limit,
+ * symcache_limit() turns them into the previous ones and drops the old
+ * previous ones. This keeps the recently used strings like an LRU cache
+ * without any bookkeeping per lookup.
+ */
+typedef struct {
+    SymTab *current;
+    SymTab *previous;           // NULL as long as the memory isn't bounded
+} SymCache;
+
+gint64 symcache_lookup(SymCache *cache, const gchar *str, guint64 hash);
+gboolean symcache_limit(SymCache **caches, guint count, gsize limit);
+
+#endif /* __SYMTAB_H__ */
@@ -0,0 +1,53 @@
+/*
+The MIT License (MIT) 
+Copyright (c) 2009,2010,2016 Andreas Heck <aheck@gmx.de>
+
+Permission to use, copy, modify, and/or distribute this software for any
+purpose with or without fee is hereby granted, provided that the above
+copyright notice and this permission notice appear in all copies.
+
+THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+*/
+
+#ifndef __TRACE_H__
+#define __TRACE_H__
+
+#include <glib.h>
+
+// set by trace_open()
+extern gboolean trace_enabled;
+
+void trace_open(const gchar *filename);
+void trace_close();
+void trace_span(const gchar *category, const gchar *name, gint64 start,
+        gint64 bytes);
+void trace_child(int part);
+void trace_merge(int part);
+
+/*
+ * Return the start of a span for trace_end() or 0 if tracing is disabled
+ */
+static inline gint64 trace_start()
+{
+    return trace_enabled ? g_get_monotonic_time() : 0;
+}
+
+/*
+ * Record a span of work started with trace_start() on the calling thread;
+ * bytes is the amount of data it processed or -1 if it doesn't apply
+ *
+ * Unless tracing is enabled this is only a comparison.
+ */
+static inline void trace_end(const gchar *category, const gchar *name,
+        gint64 start, gint64 bytes)
+{
+    if (start != 0) trace_span(category, name, start, bytes);
+}
+
+#endif /* __TRACE_H__ */
@@ -0,0 +1,56 @@
+/*
+The MIT License (MIT) 
+Copyright (c) 2009,2010,2016 Andreas Heck <aheck@gmx.de>
+
+Permission to use, copy, modify, and/or distribute this software for any
+purpose with or without fee is hereby granted, provided that the above
+copyright notice and this permission notice appear in all copies.
+
+THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+*/
+
+#ifndef __ZIPDIR_H__
+#define __ZIPDIR_H__
+
+#include <glib.h>
+
+/*
+ * Reader of the central directory of ZIP archives
+ *
+ * libzip doesn't expose where the entries of an archive are stored, so the
+ * offsets of their local headers are read from the central directory here.
+ * Anything unusual like a ZIP64 archive is rejected and left to libzip.
+ */
+
+// the end of central directory record is followed by a comment of at most
+// 64 KiB, so it is found in this many bytes at the end of an archive
+#define ZIPDIR_MAX_TAIL (22 + 0xffff)
+
+typedef struct {
+    guint count;                // number of entries
+    guint32 size;               // size of the central directory
+    guint32 offset;             // offset of the central directory
+} ZipDirEnd;
+
+static inline guint16 zipdir_u2(const guchar *p)
+{
+    return p[0] | (p[1] << 8);
+}
+
+static inline guint32 zipdir_u4(const guchar *p)
+{
+    return (guint32) p[0] | ((guint32) p[1] << 8) | ((guint32) p[2] << 16)
+        | ((guint32) p[3] << 24);
+}
+
+gboolean zipdir_read_end(const guchar *tail, gsize tail_size,
+        gsize archive_size, ZipDirEnd *end);
+guint32 *zipdir_read_offsets(const guchar *cdir, gsize size, guint count);
+
+#endif /* __ZIPDIR_H__ */
@@ -0,0 +1,86 @@
+/*
+The MIT License (MIT) 
+Copyright (c) 2009,2010,2016 Andreas Heck <aheck@gmx.de>
+
+Permission to use, copy, modify, and/or distribute this software for any
+purpose with or without fee is hereby granted, provided that the above
+copyright notice and this permission notice appear in all copies.
+
+THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+*/
+
+#include <glib.h>
+
+#include <global.h>
+#include <accessflags.h>
+#include <classscan.h>
+#include <classreader/javaclass.h>
+
+/*
+ * Return the access_flags of a class, field or method
+ *
+ * The modifiers libclassreader offers don't cover all of the flags (e.g.
+ * VOLATILE, TRANSIENT, NATIVE, SYNTHETIC, BRIDGE, VARARGS or STRICT), so the
+ * raw u2 of the class file is read from the scan if there is one. member is
+ * the offset of the field or method in the scan (e.g. fields_start) and is
+ * only trusted if its name matches. Without a scan the flags are combined
+ * from the modifiers libclassreader knows about.
+ */
+gint64 class_access_flags(JavaClass *c, ClassScan *scan)
+{
+    gint64 flags = 0;
+
+    if (scan != NULL) return scan->access_flags;
+
+    if (javaclass_is_public(c))     flags |= ACC_PUBLIC;
+    if (javaclass_is_final(c))      flags |= ACC_FINAL;
+    if (javaclass_is_interface(c))  flags |= ACC_INTERFACE;
+    if (javaclass_is_abstract(c))   flags |= ACC_ABSTRACT;
+    if (javaclass_is_annotation(c)) flags |= ACC_ANNOTATION;
+    if (javaclass_is_enum(c))       flags |= ACC_ENUM;
+
+    return flags;
+}
+
+gint64 field_access_flags(JavaField *f, ClassScan *scan, gsize member)
+{
+    gint64 flags = 0;
+
+    if (classscan_member_is(scan, member, javafield_get_name(f))) {
+        return classscan_u2(scan->data + member);
+    }
+
+    if (javafield_is_public(f))    flags |= ACC_PUBLIC;
+    if (javafield_is_protected(f)) flags |= ACC_PROTECTED;
+    if (javafield_is_private(f))   flags |= ACC_PRIVATE;
+    if (javafield_is_static(f))    flags |= ACC_STATIC;
+    if (javafield_is_final(f))     flags |= ACC_FINAL;
+    if (javafield_is_enum(f))      flags |= ACC_ENUM;
+
+    return flags;
+}
+
+gint64 method_access_flags(JavaMethod *m, ClassScan *scan, gsize member)
+{
+    gint64 flags = 0;
+
+    if (classscan_member_is(scan, member, javamethod_get_name(m))) {
+        return classscan_u2(scan->data + member);
+    }
+
+    if (javamethod_is_public(m))       flags |= ACC_PUBLIC;
+    if (javamethod_is_protected(m))    flags |= ACC_PROTECTED;
+    if (javamethod_is_private(m))      flags |= ACC_PRIVATE;
+    if (javamethod_is_static(m))       flags |= ACC_STATIC;
+    if (javamethod_is_final(m))        flags |= ACC_FINAL;
+    if (javamethod_is_synchronized(m)) flags |= ACC_SYNCHRONIZED;
+    if (javamethod_is_abstract(m))     flags |= ACC_ABSTRACT;
+
+    return flags;
+}
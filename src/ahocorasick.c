@@ -0,0 +1,216 @@
+/*
+The MIT License (MIT) 
+Copyright (c) 2009,2010,2016 Andreas Heck <aheck@gmx.de>
+
+Permission to use, copy, modify, and/or distribute this software for any
+purpose with or without fee is hereby granted, provided that the above
+copyright notice and this permission notice appear in all copies.
+
+THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+*/
+
+#include <string.h>
+#include <glib.h>
+
+#include <ahocorasick.h>
+
+#define ROOT 0
+
+/*
+ * Create an empty automaton
+ */
+AhoCorasick *ahocorasick_new(gboolean ignore_case)
+{
+    AhoCorasick *ac = g_new0(AhoCorasick, 1);
+
+    ac->ignore_case = ignore_case;
+    ac->patterns = g_ptr_array_new_with_free_func(
+            (GDestroyNotify) g_bytes_unref);
+    ac->ids = g_array_new(FALSE, FALSE, sizeof(guint));
+
+    return ac;
+}
+
+/*
+ * Add a pattern of length bytes which is reported with id; patterns have to
+ * be added before the automaton is compiled and must not be empty
+ */
+void ahocorasick_add(AhoCorasick *ac, const gchar *pattern, gsize length,
+        guint id)
+{
+    g_return_if_fail(ac->patterns != NULL && length > 0);
+
+    g_ptr_array_add(ac->patterns, g_bytes_new(pattern, length));
+    g_array_append_val(ac->ids, id);
+}
+
+static guint8 fold(const AhoCorasick *ac, guint8 c)
+{
+    return ac->ignore_case ? (guint8) g_ascii_tolower(c) : c;
+}
+
+/*
+ * Build the DFA of all patterns which were added
+ *
+ * First the patterns are inserted into a trie. Then the states are visited
+ * breadth first, so that the failure link of each state (the longest proper
+ * suffix which is a state as well) is complete before its children, and
+ * every missing transition is replaced by the one of the failure link.
+ */
+void ahocorasick_compile(AhoCorasick *ac)
+{
+    gsize max_states = 1;
+    guint32 *fail = NULL;
+    guint32 *queue = NULL;
+    guint32 head = 0, tail = 0;
+    guint columns = 0;
+
+    // column 0 is shared by all bytes which don't occur in any pattern
+    memset(ac->classes, 0, sizeof(ac->classes));
+    ac->alphabet = 1;
+
+    for (guint i = 0; i < ac->patterns->len; i++) {
+        gsize length = 0;
+        const guint8 *p = g_bytes_get_data(
+                g_ptr_array_index(ac->patterns, i), &length);
+
+        for (gsize j = 0; j < length; j++) {
+            guint8 c = fold(ac, p[j]);
+            if (ac->classes[c] == 0) ac->classes[c] = ac->alphabet++;
+        }
+
+        max_states += length;
+    }
+
+    if (ac->ignore_case) {
+        for (int c = 'A'; c <= 'Z'; c++) {
+            ac->classes[c] = ac->classes[(guint8) g_ascii_tolower(c)];
+        }
+    }
+
+    columns = ac->alphabet;
+    ac->next = g_new0(guint32, max_states * columns);
+    ac->match = g_new0(guint32, max_states);
+    ac->match_link = g_new0(guint32, max_states);
+    ac->states = 1;
+
+    // the trie; while it is built the transitions are plain state numbers
+    // and ROOT means that there is none since no edge leads back to it
+    for (guint i = 0; i < ac->patterns->len; i++) {
+        gsize length = 0;
+        const guint8 *p = g_bytes_get_data(
+                g_ptr_array_index(ac->patterns, i), &length);
+        guint32 state = ROOT;
+
+        for (gsize j = 0; j < length; j++) {
+            guint32 *t = &ac->next[state * columns + ac->classes[p[j]]];
+
+            if (*t == ROOT) *t = ac->states++;
+            state = *t;
+        }
+
+        if (ac->match[state] == 0) {
+            ac->match[state] = g_array_index(ac->ids, guint, i) + 1;
+        }
+    }
+
+    fail = g_new0(guint32, ac->states);
+    queue = g_new(guint32, ac->states);
+
+    for (guint k = 0; k < columns; k++) {
+        guint32 t = ac->next[ROOT * columns + k];
+        if (t != ROOT) queue[tail++] = t;
+    }
+
+    while (head < tail) {
+        guint32 state = queue[head++];
+        guint32 f = fail[state];
+
+        ac->match_link[state] = ac->match[f] != 0 ? f : ac->match_link[f];
+
+        for (guint k = 0; k < columns; k++) {
+            guint32 *t = &ac->next[state * columns + k];
+
+            if (*t != ROOT) {
+                fail[*t] = ac->next[f * columns + k];
+                queue[tail++] = *t;
+            } else {
+                *t = ac->next[f * columns + k];
+            }
+        }
+    }
+
+    // turn the state numbers into table offsets and flag the states in
+    // which a pattern or one of its suffixes ends
+    for (gsize i = 0; i < (gsize) ac->states * columns; i++) {
+        guint32 t = ac->next[i];
+        gboolean output = ac->match[t] != 0 || ac->match_link[t] != 0;
+
+        ac->next[i] = (t * columns) << 1 | (output ? 1 : 0);
+    }
+
+    ac->next = g_renew(guint32, ac->next, (gsize) ac->states * columns);
+
+    g_free(fail);
+    g_free(queue);
+
+    g_ptr_array_free(ac->patterns, TRUE);
+    ac->patterns = NULL;
+    g_array_free(ac->ids, TRUE);
+    ac->ids = NULL;
+}
+
+/*
+ * Search text for all patterns and call func for each occurrence
+ *
+ * Returns TRUE if any pattern was found. Without func the search stops at
+ * the first occurrence.
+ */
+gboolean ahocorasick_search(const AhoCorasick *ac, const guchar *text,
+        gsize length, AhoCorasickFunc func, gpointer user_data)
+{
+    const guint32 *next = ac->next;
+    const guint16 *classes = ac->classes;
+    gboolean found = FALSE;
+    guint32 state = 0;
+
+    for (gsize i = 0; i < length; i++) {
+        state = next[(state >> 1) + classes[text[i]]];
+
+        if ((state & 1) == 0) continue;
+        if (func == NULL) return TRUE;
+
+        found = TRUE;
+
+        guint32 s = (state >> 1) / ac->alphabet;
+        if (ac->match[s] == 0) s = ac->match_link[s];
+
+        for (; s != ROOT; s = ac->match_link[s]) {
+            if (!func(ac->match[s] - 1, i + 1, user_data)) return TRUE;
+        }
+    }
+
+    return found;
+}
+
+/*
+ * Free an automaton
+ */
+void ahocorasick_free(AhoCorasick *ac)
+{
+    if (ac == NULL) return;
+
+    if (ac->patterns != NULL) g_ptr_array_free(ac->patterns, TRUE);
+    if (ac->ids != NULL) g_array_free(ac->ids, TRUE);
+
+    g_free(ac->next);
+    g_free(ac->match);
+    g_free(ac->match_link);
+    g_free(ac);
+}
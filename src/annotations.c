@@ -0,0 +1,274 @@
+/*
+The MIT License (MIT) 
+Copyright (c) 2009,2010,2016 Andreas Heck <aheck@gmx.de>
+
+Permission to use, copy, modify, and/or distribute this software for any
+purpose with or without fee is hereby granted, provided that the above
+copyright notice and this permission notice appear in all copies.
+
+THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+*/
+
+#include <stdio.h>
+#include <string.h>
+#include <glib.h>
+
+#include <classscan.h>
+#include <annotations.h>
+
+// nested annotations and arrays are read recursively; a malformed attribute
+// nesting them deeper is rejected instead of exhausting the stack
+#define MAX_NESTING 64
+
+typedef struct {
+    ClassScan *scan;
+    const guchar *pos;
+    const guchar *end;
+    AnnotationHandler *handler;
+    gpointer user_data;
+    guint depth;
+} AnnotationReader;
+
+static gboolean read_annotation(AnnotationReader *reader, gboolean report);
+
+static gboolean read_u2(AnnotationReader *reader, guint16 *value)
+{
+    if (reader->pos + 2 > reader->end) return FALSE;
+
+    *value = classscan_u2(reader->pos);
+    reader->pos += 2;
+
+    return TRUE;
+}
+
+/*
+ * Convert a field descriptor like Lcom/example/Foo; into com.example.Foo;
+ * other descriptors (primitives and arrays) are returned unchanged
+ */
+gchar *annotations_type_name(const gchar *descriptor, gsize length)
+{
+    gchar *name = NULL;
+
+    if (length >= 2 && descriptor[0] == 'L' && descriptor[length - 1] == ';') {
+        name = g_strndup(descriptor + 1, length - 2);
+        g_strdelimit(name, "/", '.');
+    } else {
+        name = g_strndup(descriptor, length);
+    }
+
+    return name;
+}
+
+/*
+ * Format the constant of a const_value_index element value
+ */
+static gchar *format_constant(ClassScan *scan, guint8 tag, guint16 index)
+{
+    guint8 constant_tag = classscan_tag(scan, index);
+    const guchar *entry = NULL;
+
+    if (tag == 's') return classscan_string(scan, index);
+    if (constant_tag == 0) return NULL;
+
+    entry = scan->data + scan->constant_pool[index] + 1;
+
+    switch (constant_tag) {
+        case CONSTANT_Integer: {
+            gint32 value = (gint32) classscan_u4(entry);
+
+            if (tag == 'Z') return g_strdup(value ? "true" : "false");
+            if (tag == 'C') {
+                gchar buffer[8] = {0};
+
+                g_unichar_to_utf8(value, buffer);
+                return g_strdup(buffer);
+            }
+
+            return g_strdup_printf("%d", value);
+        }
+        case CONSTANT_Long: {
+            gint64 value = ((guint64) classscan_u4(entry) << 32)
+                | classscan_u4(entry + 4);
+
+            return g_strdup_printf("%" G_GINT64_FORMAT, value);
+        }
+        case CONSTANT_Float: {
+            union { guint32 bits; gfloat value; } f;
+
+            f.bits = classscan_u4(entry);
+            return g_strdup_printf("%g", f.value);
+        }
+        case CONSTANT_Double: {
+            union { guint64 bits; gdouble value; } d;
+
+            d.bits = ((guint64) classscan_u4(entry) << 32)
+                | classscan_u4(entry + 4);
+            return g_strdup_printf("%g", d.value);
+        }
+    }
+
+    return NULL;
+}
+
+/*
+ * Read an element_value and report it under name if it is a simple value
+ * and report is TRUE; arrays are reported element by element
+ */
+static gboolean read_element_value(AnnotationReader *reader,
+        const gchar *name, gboolean report)
+{
+    ClassScan *scan = reader->scan;
+    guint16 index = 0, index2 = 0, count = 0;
+    gchar *value = NULL;
+    guint16 length = 0;
+    gboolean ok = TRUE;
+
+    if (reader->pos + 1 > reader->end) return FALSE;
+
+    guint8 tag = *reader->pos++;
+
+    switch (tag) {
+        case 'B': case 'C': case 'D': case 'F': case 'I': case 'J':
+        case 'S': case 'Z': case 's':
+            if (!read_u2(reader, &index)) return FALSE;
+            if (report) value = format_constant(scan, tag, index);
+            break;
+        case 'e':
+            if (!read_u2(reader, &index) || !read_u2(reader, &index2)) {
+                return FALSE;
+            }
+
+            if (report) {
+                const guchar *type = classscan_utf8(scan, index, &length);
+                gchar *constant = classscan_string(scan, index2);
+
+                if (type != NULL && constant != NULL) {
+                    gchar *type_name = annotations_type_name(
+                            (const gchar*) type, length);
+
+                    value = g_strconcat(type_name, ".", constant, NULL);
+                    g_free(type_name);
+                }
+
+                g_free(constant);
+            }
+            break;
+        case 'c':
+            if (!read_u2(reader, &index)) return FALSE;
+
+            if (report) {
+                const guchar *type = classscan_utf8(scan, index, &length);
+
+                if (type != NULL) {
+                    value = annotations_type_name((const gchar*) type, length);
+                }
+            }
+            break;
+        case '@':
+            if (reader->depth >= MAX_NESTING) return FALSE;
+
+            reader->depth++;
+            ok = read_annotation(reader, FALSE);
+            reader->depth--;
+
+            return ok;
+        case '[':
+            if (!read_u2(reader, &count)) return FALSE;
+            if (reader->depth >= MAX_NESTING) return FALSE;
+
+            // only arrays of simple values are reported
+            reader->depth++;
+            for (guint16 i = 0; i < count && ok; i++) {
+                gboolean simple = reader->pos < reader->end
+                    && *reader->pos != '@' && *reader->pos != '[';
+
+                ok = read_element_value(reader, name, report && simple);
+            }
+            reader->depth--;
+
+            if (!ok) return FALSE;
+            break;
+        default:
+            return FALSE;
+    }
+
+    if (value != NULL) {
+        reader->handler->value(name, value, reader->user_data);
+        g_free(value);
+    }
+
+    return TRUE;
+}
+
+/*
+ * Read an annotation structure and report it and its element values if
+ * report is TRUE
+ */
+static gboolean read_annotation(AnnotationReader *reader, gboolean report)
+{
+    guint16 type_index = 0;
+    guint16 count = 0;
+    guint16 length = 0;
+
+    if (!read_u2(reader, &type_index) || !read_u2(reader, &count)) {
+        return FALSE;
+    }
+
+    if (report) {
+        const guchar *type = classscan_utf8(reader->scan, type_index, &length);
+        if (type == NULL) return FALSE;
+
+        gchar *type_name = annotations_type_name((const gchar*) type, length);
+        reader->handler->annotation(type_name, reader->user_data);
+        g_free(type_name);
+    }
+
+    for (guint16 i = 0; i < count; i++) {
+        guint16 name_index = 0;
+        gchar *name = NULL;
+
+        if (!read_u2(reader, &name_index)) return FALSE;
+        if (report) name = classscan_string(reader->scan, name_index);
+
+        gboolean ok = read_element_value(reader, name,
+                report && name != NULL);
+        g_free(name);
+
+        if (!ok) return FALSE;
+    }
+
+    return TRUE;
+}
+
+/*
+ * Report all annotations of the info of a RuntimeVisibleAnnotations or
+ * RuntimeInvisibleAnnotations attribute; returns FALSE if it is truncated
+ * or malformed
+ */
+gboolean annotations_parse(ClassScan *scan, const guchar *data,
+        guint32 length, AnnotationHandler *handler, gpointer user_data)
+{
+    AnnotationReader reader;
+    guint16 count = 0;
+
+    reader.scan      = scan;
+    reader.pos       = data;
+    reader.end       = data + length;
+    reader.handler   = handler;
+    reader.user_data = user_data;
+    reader.depth     = 0;
+
+    if (!read_u2(&reader, &count)) return FALSE;
+
+    for (guint16 i = 0; i < count; i++) {
+        if (!read_annotation(&reader, TRUE)) return FALSE;
+    }
+
+    return TRUE;
+}
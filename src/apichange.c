@@ -0,0 +1,144 @@
+/*
+The MIT License (MIT) 
+Copyright (c) 2009,2010,2016 Andreas Heck <aheck@gmx.de>
+
+Permission to use, copy, modify, and/or distribute this software for any
+purpose with or without fee is hereby granted, provided that the above
+copyright notice and this permission notice appear in all copies.
+
+THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+*/
+
+#include <string.h>
+#include <glib.h>
+
+#include <global.h>
+#include <apichange.h>
+
+/*
+ * Compare two rows in the order of the API query
+ *
+ * Fields are identified by their name only so that a new type shows up as
+ * a change of the field, while methods are overloaded by their descriptor.
+ */
+int apichange_compare(const ApiRow *a, const ApiRow *b)
+{
+    int result = strcmp(a->namespace, b->namespace);
+
+    if (result == 0) result = strcmp(a->class, b->class);
+    if (result == 0) result = a->kind - b->kind;
+    if (result == 0) result = strcmp(a->name, b->name);
+    if (result == 0 && a->kind != API_FIELD) {
+        result = strcmp(a->descriptor, b->descriptor);
+    }
+
+    return result;
+}
+
+/*
+ * Add a reason to a change and return the worse of both compatibilities
+ */
+static Compatibility add_reason(GPtrArray *reasons, const gchar *reason,
+        Compatibility current, Compatibility compatibility)
+{
+    g_ptr_array_add(reasons, g_strdup(reason));
+
+    return MAX(current, compatibility);
+}
+
+/*
+ * Collect how an element of the API changed between both indexes and
+ * classify the change
+ */
+static Compatibility classify_change(const ApiRow *old, const ApiRow *new,
+        GPtrArray *reasons)
+{
+    Compatibility result = COMPATIBLE;
+    gint64 removed = old->access_flags & ~new->access_flags;
+    gint64 added = new->access_flags & ~old->access_flags;
+
+    if (removed & ACC_PUBLIC) {
+        result = add_reason(reasons, "public to protected", result,
+                INCOMPATIBLE);
+    } else if (added & ACC_PUBLIC) {
+        result = add_reason(reasons, "protected to public", result,
+                COMPATIBLE);
+    }
+
+    // the value of a final field may have been inlined into clients
+    if (added & ACC_FINAL) {
+        result = add_reason(reasons, "made final", result, INCOMPATIBLE);
+    } else if (removed & ACC_FINAL) {
+        result = add_reason(reasons, "no longer final", result,
+                old->kind == API_FIELD ? MAYBE_INCOMPATIBLE : COMPATIBLE);
+    }
+
+    if (added & ACC_STATIC) {
+        result = add_reason(reasons, "made static", result, INCOMPATIBLE);
+    } else if (removed & ACC_STATIC) {
+        result = add_reason(reasons, "no longer static", result,
+                INCOMPATIBLE);
+    }
+
+    if (old->kind == API_CLASS && (added & ACC_INTERFACE)) {
+        result = add_reason(reasons, "class to interface", result,
+                INCOMPATIBLE);
+    } else if (old->kind == API_CLASS && (removed & ACC_INTERFACE)) {
+        result = add_reason(reasons, "interface to class", result,
+                INCOMPATIBLE);
+    } else if (added & ACC_ABSTRACT) {
+        result = add_reason(reasons, "made abstract", result, INCOMPATIBLE);
+    } else if (removed & ACC_ABSTRACT) {
+        result = add_reason(reasons, "no longer abstract", result,
+                COMPATIBLE);
+    }
+
+    if (old->kind == API_FIELD && strcmp(old->descriptor, new->descriptor)) {
+        gchar *reason = g_strdup_printf("type %s to %s", old->descriptor,
+                new->descriptor);
+        result = add_reason(reasons, reason, result, INCOMPATIBLE);
+        g_free(reason);
+    }
+
+    if (old->kind == API_CLASS && g_strcmp0(old->parent, new->parent)) {
+        gchar *reason = g_strdup_printf("superclass %s to %s", old->parent,
+                new->parent);
+        result = add_reason(reasons, reason, result, MAYBE_INCOMPATIBLE);
+        g_free(reason);
+    }
+
+    return result;
+}
+
+/*
+ * Classify an element of the API which was added (old is NULL), removed
+ * (new is NULL) or changed and collect the reasons of a change
+ *
+ * Removing an element breaks its clients. An added abstract method is
+ * missing from subclasses and implementations compiled against the old
+ * version, which throw AbstractMethodError once it is called.
+ */
+Compatibility apichange_classify(ChangeType change, const ApiRow *old,
+        const ApiRow *new, GPtrArray *reasons)
+{
+    switch (change) {
+        case CHANGE_REMOVED:
+            return INCOMPATIBLE;
+        case CHANGE_ADDED:
+            if (new->kind == API_METHOD
+                    && (new->access_flags & ACC_ABSTRACT)) {
+                return add_reason(reasons, "abstract method", COMPATIBLE,
+                        MAYBE_INCOMPATIBLE);
+            }
+
+            return COMPATIBLE;
+        default:
+            return classify_change(old, new, reasons);
+    }
+}
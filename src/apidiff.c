@@ -0,0 +1,391 @@
+/*
+The MIT License (MIT) 
+Copyright (c) 2009,2010,2016 Andreas Heck <aheck@gmx.de>
+
+Permission to use, copy, modify, and/or distribute this software for any
+purpose with or without fee is hereby granted, provided that the above
+copyright notice and this permission notice appear in all copies.
+
+THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <glib.h>
+#include <sqlite3.h>
+
+#include <global.h>
+#include <jsonutil.h>
+#include <apichange.h>
+
+// the access flags of the API as SQL literals
+#define SQL_PUBLIC G_STRINGIFY(ACC_PUBLIC)
+#define SQL_API "(" G_STRINGIFY(ACC_PUBLIC) " | " G_STRINGIFY(ACC_PROTECTED) ")"
+
+/*
+ * The public and protected API of an index sorted by namespace, class,
+ * kind of member, member name and descriptor
+ *
+ * Classes come with an empty name and descriptor so that each class
+ * precedes its members. SQLite sorts the rows with a bounded amount of
+ * memory and spills to temporary files for big indexes.
+ */
+const gchar *API_QUERY = ""
+    "SELECT n.name, i.name, 0, '', '', c.access_flags,"
+    "    CASE WHEN pn.name IS NULL THEN NULL"
+    "    ELSE pn.name || '.' || pi.name END"
+    "    FROM importables_namespaces_data c"
+    "    JOIN namespaces n ON n.id = c.namespace_id"
+    "    JOIN importables i ON i.id = c.importable_id"
+    "    LEFT JOIN namespaces pn ON pn.id = c.parent_namespace_id"
+    "    LEFT JOIN importables pi ON pi.id = c.parent_importable_id"
+    "    WHERE c.done AND (c.access_flags & " SQL_PUBLIC ") != 0"
+    " UNION ALL "
+    "SELECT n.name, i.name, 1, f.name, d.name, f.access_flags, NULL"
+    "    FROM fields_data f"
+    "    JOIN importables_namespaces_data c"
+    "    ON c.importable_id = f.importable_id"
+    "    AND c.namespace_id = f.namespace_id"
+    "    JOIN namespaces n ON n.id = f.namespace_id"
+    "    JOIN importables i ON i.id = f.importable_id"
+    "    JOIN descriptors d ON d.id = f.descriptor_id"
+    "    WHERE c.done AND (c.access_flags & " SQL_PUBLIC ") != 0"
+    "    AND (f.access_flags & " SQL_API ") != 0"
+    " UNION ALL "
+    "SELECT n.name, i.name, 2, m.name, d.name, m.access_flags, NULL"
+    "    FROM methods_data m"
+    "    JOIN importables_namespaces_data c"
+    "    ON c.importable_id = m.importable_id"
+    "    AND c.namespace_id = m.namespace_id"
+    "    JOIN namespaces n ON n.id = m.namespace_id"
+    "    JOIN importables i ON i.id = m.importable_id"
+    "    JOIN descriptors d ON d.id = m.descriptor_id"
+    "    WHERE c.done AND (c.access_flags & " SQL_PUBLIC ") != 0"
+    "    AND (m.access_flags & " SQL_API ") != 0"
+    " ORDER BY 1, 2, 3, 4, 5";
+
+static const gchar *API_KINDS[] = {"class", "field", "method"};
+
+static const gchar *CHANGE_NAMES[] = {"added", "removed", "changed"};
+static const gchar CHANGE_MARKS[] = {'+', '-', '~'};
+
+static const gchar *COMPATIBILITY_NAMES[] = {
+    "compatible",
+    "maybe-incompatible",
+    "incompatible"
+};
+
+/*
+ * The API of one index read row by row
+ *
+ * The strings are the columns of the current row and stay valid until the
+ * stream is advanced, so no row is copied.
+ */
+typedef struct {
+    sqlite3 *db;
+    sqlite3_stmt *stmt;
+    gboolean done;
+    ApiRow row;
+} ApiStream;
+
+static gboolean json = FALSE;
+
+static GOptionEntry options[] =
+{
+    {"json", 'j', 0, G_OPTION_ARG_NONE, &json, "Print one JSON object per line and change"},
+    {NULL}
+};
+
+/*
+ * Number of changes by type and of incompatible ones
+ */
+static int counts[3];
+static int incompatible = 0;
+
+void handle_sql_error(sqlite3 *db, int status, int line);
+
+void usage(gchar *errormsg, GOptionContext *context)
+{
+    if (errormsg != NULL) fprintf(stderr, "ERROR: %s\n", errormsg);
+    fprintf(stderr, "%s", g_option_context_get_help(context, TRUE, NULL));
+
+    exit(2);
+}
+
+/*
+ * Read the next row of the API of an index
+ */
+void api_stream_next(ApiStream *stream)
+{
+    int status = sqlite3_step(stream->stmt);
+    sqlite3_stmt *stmt = stream->stmt;
+    ApiRow *row = &stream->row;
+
+    handle_sql_error(stream->db, status, __LINE__);
+
+    if (status != SQLITE_ROW) {
+        stream->done = TRUE;
+        return;
+    }
+
+    row->namespace    = (const gchar*) sqlite3_column_text(stmt, 0);
+    row->class        = (const gchar*) sqlite3_column_text(stmt, 1);
+    row->kind         = sqlite3_column_int(stmt, 2);
+    row->name         = (const gchar*) sqlite3_column_text(stmt, 3);
+    row->descriptor   = (const gchar*) sqlite3_column_text(stmt, 4);
+    row->access_flags = sqlite3_column_int64(stmt, 5);
+    row->parent       = (const gchar*) sqlite3_column_text(stmt, 6);
+}
+
+/*
+ * Open an index and start reading its API
+ *
+ * Overlay indexes written with --base-dir only contain the classes of a
+ * project, so they can't be compared on their own.
+ */
+void api_stream_open(ApiStream *stream, const gchar *filename)
+{
+    sqlite3_stmt *stmt = NULL;
+    int status = 0;
+
+    memset(stream, 0, sizeof(ApiStream));
+
+    status = sqlite3_open_v2(filename, &stream->db, SQLITE_OPEN_READONLY,
+            NULL);
+
+    if (status != SQLITE_OK) {
+        fprintf(stderr, "Can't open database %s: %s\n", filename,
+                sqlite3_errmsg(stream->db));
+        exit(2);
+    }
+
+    // indexes of older versions don't have a layers table
+    status = sqlite3_prepare_v2(stream->db, "SELECT path FROM layers", -1,
+            &stmt, NULL);
+    if (status == SQLITE_OK) {
+        if (sqlite3_step(stmt) == SQLITE_ROW) {
+            fprintf(stderr, "ERROR: %s is an overlay of the base index %s\n",
+                    filename, sqlite3_column_text(stmt, 0));
+            exit(2);
+        }
+
+        sqlite3_finalize(stmt);
+    }
+
+    status = sqlite3_prepare_v2(stream->db, API_QUERY, -1, &stream->stmt,
+            NULL);
+    handle_sql_error(stream->db, status, __LINE__);
+
+    api_stream_next(stream);
+}
+
+void api_stream_close(ApiStream *stream)
+{
+    sqlite3_finalize(stream->stmt);
+    sqlite3_close(stream->db);
+}
+
+/*
+ * Print a change of an element of the API; row is the element in the new
+ * index unless it was removed
+ */
+void report_change(ChangeType change, ApiRow *row, gint64 old_flags,
+        GPtrArray *reasons, Compatibility compatibility, GString *out)
+{
+    counts[change]++;
+    if (compatibility == INCOMPATIBLE) incompatible++;
+
+    g_string_truncate(out, 0);
+
+    if (json) {
+        g_string_append_printf(out, "{\"change\":\"%s\",\"kind\":\"%s\","
+                "\"package\":", CHANGE_NAMES[change], API_KINDS[row->kind]);
+        json_append_string(out, row->namespace);
+        g_string_append(out, ",\"class\":");
+        json_append_string(out, row->class);
+
+        if (row->kind != API_CLASS) {
+            g_string_append(out, ",\"name\":");
+            json_append_string(out, row->name);
+            g_string_append(out, ",\"descriptor\":");
+            json_append_string(out, row->descriptor);
+        }
+
+        if (change != CHANGE_ADDED) {
+            g_string_append_printf(out, ",\"old_access_flags\":%u",
+                    (guint) old_flags);
+        }
+        if (change != CHANGE_REMOVED) {
+            g_string_append_printf(out, ",\"new_access_flags\":%u",
+                    (guint) row->access_flags);
+        }
+
+        g_string_append(out, ",\"reasons\":[");
+        for (guint i = 0; reasons != NULL && i < reasons->len; i++) {
+            if (i > 0) g_string_append_c(out, ',');
+            json_append_string(out, g_ptr_array_index(reasons, i));
+        }
+
+        g_string_append_printf(out, "],\"compatibility\":\"%s\"}\n",
+                COMPATIBILITY_NAMES[compatibility]);
+    } else {
+        g_string_append_printf(out, "%c %s %s.%s", CHANGE_MARKS[change],
+                API_KINDS[row->kind], row->namespace, row->class);
+
+        if (row->kind == API_FIELD) {
+            g_string_append_printf(out, ".%s:%s", row->name, row->descriptor);
+        } else if (row->kind == API_METHOD) {
+            g_string_append_printf(out, ".%s%s", row->name, row->descriptor);
+        }
+
+        for (guint i = 0; reasons != NULL && i < reasons->len; i++) {
+            g_string_append(out, i == 0 ? ": " : ", ");
+            g_string_append(out, g_ptr_array_index(reasons, i));
+        }
+
+        g_string_append_printf(out, " [%s]\n",
+                COMPATIBILITY_NAMES[compatibility]);
+    }
+
+    fwrite(out->str, 1, out->len, stdout);
+}
+
+/*
+ * Check if a row belongs to the class which was added or removed as a
+ * whole, since its members aren't reported on their own
+ */
+gboolean in_class(ApiRow *row, const gchar *namespace, const gchar *class)
+{
+    return class != NULL && row->kind != API_CLASS
+        && strcmp(row->class, class) == 0
+        && strcmp(row->namespace, namespace) == 0;
+}
+
+/*
+ * Merge both sorted streams and report every difference
+ */
+void diff_apis(ApiStream *old, ApiStream *new)
+{
+    GString *out = g_string_new(NULL);
+    GPtrArray *reasons = g_ptr_array_new_with_free_func(g_free);
+    gchar *skip_namespace = NULL;
+    gchar *skip_class = NULL;
+    Compatibility compatibility = COMPATIBLE;
+
+    while (!old->done || !new->done) {
+        int order = 0;
+
+        if (old->done) {
+            order = 1;
+        } else if (new->done) {
+            order = -1;
+        } else {
+            order = apichange_compare(&old->row, &new->row);
+        }
+
+        if (order < 0) {
+            if (!in_class(&old->row, skip_namespace, skip_class)) {
+                compatibility = apichange_classify(CHANGE_REMOVED, &old->row,
+                        NULL, reasons);
+                report_change(CHANGE_REMOVED, &old->row,
+                        old->row.access_flags, reasons, compatibility, out);
+                g_ptr_array_set_size(reasons, 0);
+            }
+            if (old->row.kind == API_CLASS) {
+                g_free(skip_namespace);
+                g_free(skip_class);
+                skip_namespace = g_strdup(old->row.namespace);
+                skip_class = g_strdup(old->row.class);
+            }
+
+            api_stream_next(old);
+        } else if (order > 0) {
+            if (!in_class(&new->row, skip_namespace, skip_class)) {
+                compatibility = apichange_classify(CHANGE_ADDED, NULL,
+                        &new->row, reasons);
+                report_change(CHANGE_ADDED, &new->row, 0, reasons,
+                        compatibility, out);
+                g_ptr_array_set_size(reasons, 0);
+            }
+            if (new->row.kind == API_CLASS) {
+                g_free(skip_namespace);
+                g_free(skip_class);
+                skip_namespace = g_strdup(new->row.namespace);
+                skip_class = g_strdup(new->row.class);
+            }
+
+            api_stream_next(new);
+        } else {
+            compatibility = apichange_classify(CHANGE_CHANGED, &old->row,
+                    &new->row, reasons);
+
+            // changes of other flags (e.g. synchronized) don't matter
+            if (reasons->len > 0) {
+                report_change(CHANGE_CHANGED, &new->row,
+                        old->row.access_flags, reasons, compatibility, out);
+                g_ptr_array_set_size(reasons, 0);
+            }
+
+            api_stream_next(old);
+            api_stream_next(new);
+        }
+    }
+
+    g_free(skip_namespace);
+    g_free(skip_class);
+    g_ptr_array_free(reasons, TRUE);
+    g_string_free(out, TRUE);
+}
+
+int main(int argc, char **argv)
+{
+    GError *error = NULL;
+    GOptionContext *context;
+    ApiStream old;
+    ApiStream new;
+
+    context = g_option_context_new(
+            "OLD NEW - Print the differences of the public API in two "
+            "indexes written by java-indexproject");
+    g_option_context_add_main_entries(context, options, NULL);
+    g_option_context_set_description(context,
+            "Exits with status 1 if there are binary incompatible changes.");
+
+    if (!g_option_context_parse(context, &argc, &argv, &error)) {
+        usage(error->message, context);
+    }
+
+    if (argc != 3) usage("Expected exactly two indexes", context);
+
+    api_stream_open(&old, argv[1]);
+    api_stream_open(&new, argv[2]);
+
+    diff_apis(&old, &new);
+
+    if (!json) {
+        printf("%d added, %d removed, %d changed, %d incompatible\n",
+                counts[CHANGE_ADDED], counts[CHANGE_REMOVED],
+                counts[CHANGE_CHANGED], incompatible);
+    }
+
+    api_stream_close(&old);
+    api_stream_close(&new);
+    g_option_context_free(context);
+
+    return incompatible > 0 ? 1 : 0;
+}
+
+void handle_sql_error(sqlite3 *db, int status, int line)
+{
+    if (status != SQLITE_OK && status != SQLITE_DONE && status != SQLITE_ROW) {
+        fprintf(stderr, "SQL error on line %d: %s\n", line, sqlite3_errmsg(db));
+        exit(2);
+    }
+}
@@ -0,0 +1,161 @@
+/*
+The MIT License (MIT) 
+Copyright (c) 2009,2010,2016 Andreas Heck <aheck@gmx.de>
+
+Permission to use, copy, modify, and/or distribute this software for any
+purpose with or without fee is hereby granted, provided that the above
+copyright notice and this permission notice appear in all copies.
+
+THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+*/
+
+#include <string.h>
+#include <glib.h>
+
+#include <classscan.h>
+#include <bytecode.h>
+
+// opcodes with operands of variable length
+#define OPCODE_TABLESWITCH     0xaa
+#define OPCODE_LOOKUPSWITCH    0xab
+#define OPCODE_WIDE            0xc4
+#define OPCODE_IINC            0x84
+
+// the opcodes invokevirtual to invokedynamic invoke methods
+#define OPCODE_INVOKEVIRTUAL   0xb6
+#define OPCODE_INVOKEDYNAMIC   0xba
+
+/*
+ * Length of the instructions with a fixed length by opcode; 0 for
+ * undefined opcodes and the ones of variable length
+ */
+static const guint8 INSTRUCTION_LENGTHS[256] = {
+    // 0x00 - 0x0f: nop, aconst_null, iconst_*, lconst_*, fconst_*, dconst_*
+    1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1,
+    // 0x10 - 0x1f: bipush, sipush, ldc, ldc_w, ldc2_w, *load, *load_n
+    2, 3, 2, 3, 3, 2, 2, 2, 2, 2, 1, 1, 1, 1, 1, 1,
+    // 0x20 - 0x35: *load_n, *aload
+    1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1,
+    1, 1, 1, 1, 1, 1,
+    // 0x36 - 0x3a: *store
+    2, 2, 2, 2, 2,
+    // 0x3b - 0x83: *store_n, *astore, stack, arithmetic
+    1, 1, 1, 1, 1,
+    1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1,
+    1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1,
+    1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1,
+    1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1,
+    1, 1, 1, 1,
+    // 0x84: iinc
+    3,
+    // 0x85 - 0x98: conversions and comparisons
+    1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1,
+    1, 1, 1, 1, 1, 1, 1, 1, 1,
+    // 0x99 - 0xa8: if*, goto, jsr
+    3, 3, 3, 3, 3, 3, 3, 3, 3, 3, 3, 3, 3, 3, 3, 3,
+    // 0xa9 - 0xab: ret, tableswitch, lookupswitch
+    2, 0, 0,
+    // 0xac - 0xb1: *return
+    1, 1, 1, 1, 1, 1,
+    // 0xb2 - 0xb5: getstatic, putstatic, getfield, putfield
+    3, 3, 3, 3,
+    // 0xb6 - 0xba: invokevirtual, invokespecial, invokestatic,
+    // invokeinterface, invokedynamic
+    3, 3, 3, 5, 5,
+    // 0xbb - 0xc3: new, newarray, anewarray, arraylength, athrow,
+    // checkcast, instanceof, monitorenter, monitorexit
+    3, 2, 3, 1, 1, 3, 3, 1, 1,
+    // 0xc4 - 0xc9: wide, multianewarray, ifnull, ifnonnull, goto_w, jsr_w
+    0, 4, 3, 3, 5, 5
+};
+
+/*
+ * Return the length of the instruction at offset pc of the bytecode of a
+ * method or 0 if it is malformed
+ */
+gsize bytecode_instruction_length(const guchar *code, guint32 length,
+        guint32 pc)
+{
+    guint8 opcode = code[pc];
+    gsize size = INSTRUCTION_LENGTHS[opcode];
+    // the operands of the switches are aligned to 4 bytes from the start
+    // of the bytecode
+    guint32 operands = (pc + 4) & ~3u;
+    gint32 low = 0;
+    gint32 high = 0;
+
+    switch (opcode) {
+        case OPCODE_TABLESWITCH:
+            if (operands + 12 > length) return 0;
+
+            low  = (gint32) classscan_u4(code + operands + 4);
+            high = (gint32) classscan_u4(code + operands + 8);
+            if (high < low) return 0;
+
+            size = operands - pc + 12 + 4 * ((gint64) high - low + 1);
+            break;
+        case OPCODE_LOOKUPSWITCH:
+            if (operands + 8 > length) return 0;
+
+            size = operands - pc + 8
+                + 8 * (gint64) classscan_u4(code + operands + 4);
+            break;
+        case OPCODE_WIDE:
+            if (pc + 1 >= length) return 0;
+            size = code[pc + 1] == OPCODE_IINC ? 6 : 4;
+            break;
+    }
+
+    if (size == 0 || pc + size > length) return 0;
+
+    return size;
+}
+
+/*
+ * Read the figures of the Code attribute of the method at offset method of
+ * a scanned class
+ *
+ * Returns FALSE if the method has no code (it is abstract or native) or
+ * its Code attribute is malformed.
+ */
+gboolean bytecode_code_stats(ClassScan *scan, gsize method, CodeStats *stats)
+{
+    guint32 length = 0;
+    const guchar *info = classscan_member_attribute(scan, method, "Code",
+            &length);
+
+    memset(stats, 0, sizeof(CodeStats));
+
+    if (info == NULL || length < 8) return FALSE;
+
+    stats->max_stack   = classscan_u2(info);
+    stats->max_locals  = classscan_u2(info + 2);
+    stats->code_length = classscan_u4(info + 4);
+
+    if ((gsize) stats->code_length + 10 > length) return FALSE;
+
+    const guchar *code = info + 8;
+    stats->exception_handlers = classscan_u2(code + stats->code_length);
+
+    for (guint32 pc = 0; pc < stats->code_length;) {
+        gsize size = bytecode_instruction_length(code, stats->code_length,
+                pc);
+
+        if (size == 0) return FALSE;
+
+        if (code[pc] >= OPCODE_INVOKEVIRTUAL
+                && code[pc] <= OPCODE_INVOKEDYNAMIC) {
+            stats->invocations++;
+        }
+
+        pc += size;
+    }
+
+    return TRUE;
+}
@@ -0,0 +1,301 @@
+/*
+The MIT License (MIT) 
+Copyright (c) 2009,2010,2016 Andreas Heck <aheck@gmx.de>
+
+Permission to use, copy, modify, and/or distribute this software for any
+purpose with or without fee is hereby granted, provided that the above
+copyright notice and this permission notice appear in all copies.
+
+THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+*/
+
+#include <string.h>
+#include <glib.h>
+
+#include <classscan.h>
+
+#define CLASS_MAGIC 0xCAFEBABE
+
+/*
+ * Skip the fields or methods table starting at offset pos and return the
+ * offset behind it or 0 if the class file is truncated
+ */
+static gsize skip_members(ClassScan *scan, gsize pos, guint16 count)
+{
+    for (guint16 i = 0; i < count && pos != 0; i++) {
+        pos = classscan_next_member(scan, pos);
+    }
+
+    return pos;
+}
+
+/*
+ * Find an attribute by name in the attributes table starting at offset pos
+ */
+static const guchar *find_attribute(ClassScan *scan, gsize pos,
+        const gchar *name, guint32 *length)
+{
+    gsize name_length = strlen(name);
+
+    if (pos + 2 > scan->size) return NULL;
+
+    guint16 count = classscan_u2(scan->data + pos);
+
+    pos += 2;
+    for (guint16 i = 0; i < count; i++) {
+        guint16 attribute_name_length = 0;
+
+        if (pos + 6 > scan->size) return NULL;
+
+        const guchar *attribute_name = classscan_utf8(scan,
+                classscan_u2(scan->data + pos), &attribute_name_length);
+        guint32 attribute_length = classscan_u4(scan->data + pos + 2);
+
+        pos += 6;
+        if (pos + attribute_length > scan->size) return NULL;
+
+        if (attribute_name != NULL && attribute_name_length == name_length
+                && memcmp(attribute_name, name, name_length) == 0) {
+            *length = attribute_length;
+            return scan->data + pos;
+        }
+
+        pos += attribute_length;
+    }
+
+    return NULL;
+}
+
+/*
+ * Scan the constant pool, the header and the member tables of a class file
+ *
+ * Returns FALSE if data is not a complete class file. The scan references
+ * data and stays valid as long as data does.
+ */
+gboolean classscan_init(ClassScan *scan, const guchar *data, gsize size)
+{
+    gsize pos = 0;
+
+    scan->data = data;
+    scan->size = size;
+
+    if (size < 10 || classscan_u4(data) != CLASS_MAGIC) return FALSE;
+
+    scan->minor_version       = classscan_u2(data + 4);
+    scan->major_version       = classscan_u2(data + 6);
+    scan->constant_pool_count = classscan_u2(data + 8);
+
+    if (scan->constant_pool_capacity < scan->constant_pool_count) {
+        scan->constant_pool_capacity = scan->constant_pool_count;
+        scan->constant_pool = g_renew(guint32, scan->constant_pool,
+                scan->constant_pool_capacity);
+    }
+
+    if (scan->constant_pool_count > 0) scan->constant_pool[0] = 0;
+
+    pos = 10;
+    for (guint16 i = 1; i < scan->constant_pool_count; i++) {
+        if (pos >= size) return FALSE;
+
+        scan->constant_pool[i] = pos;
+
+        switch (data[pos]) {
+            case CONSTANT_Utf8:
+                if (pos + 3 > size) return FALSE;
+                pos += 3 + classscan_u2(data + pos + 1);
+                break;
+            case CONSTANT_Class:
+            case CONSTANT_String:
+            case CONSTANT_MethodType:
+            case CONSTANT_Module:
+            case CONSTANT_Package:
+                pos += 3;
+                break;
+            case CONSTANT_MethodHandle:
+                pos += 4;
+                break;
+            case CONSTANT_Integer:
+            case CONSTANT_Float:
+            case CONSTANT_Fieldref:
+            case CONSTANT_Methodref:
+            case CONSTANT_InterfaceMethodref:
+            case CONSTANT_NameAndType:
+            case CONSTANT_Dynamic:
+            case CONSTANT_InvokeDynamic:
+                pos += 5;
+                break;
+            case CONSTANT_Long:
+            case CONSTANT_Double:
+                // 8 byte constants take up two entries of the pool
+                pos += 9;
+                i++;
+                if (i < scan->constant_pool_count) scan->constant_pool[i] = 0;
+                break;
+            default:
+                return FALSE;
+        }
+    }
+
+    if (pos + 8 > size) return FALSE;
+
+    scan->access_flags     = classscan_u2(data + pos);
+    scan->this_class       = classscan_u2(data + pos + 2);
+    scan->super_class      = classscan_u2(data + pos + 4);
+    scan->interfaces_count = classscan_u2(data + pos + 6);
+    scan->interfaces_start = pos + 8;
+
+    pos = scan->interfaces_start + 2 * scan->interfaces_count;
+    if (pos + 2 > size) return FALSE;
+    scan->fields_count = classscan_u2(data + pos);
+    scan->fields_start = pos + 2;
+
+    pos = skip_members(scan, scan->fields_start, scan->fields_count);
+    if (pos == 0 || pos + 2 > size) return FALSE;
+    scan->methods_count = classscan_u2(data + pos);
+    scan->methods_start = pos + 2;
+
+    pos = skip_members(scan, scan->methods_start, scan->methods_count);
+    if (pos == 0 || pos + 2 > size) return FALSE;
+    scan->attributes_start = pos;
+
+    return TRUE;
+}
+
+/*
+ * Free the constant pool index of a scan
+ */
+void classscan_clear(ClassScan *scan)
+{
+    g_free(scan->constant_pool);
+    memset(scan, 0, sizeof(ClassScan));
+}
+
+/*
+ * Return the tag of a constant pool entry or 0 if the index is invalid
+ */
+guint8 classscan_tag(ClassScan *scan, guint16 index)
+{
+    if (index == 0 || index >= scan->constant_pool_count) return 0;
+    if (scan->constant_pool[index] == 0) return 0;
+
+    return scan->data[scan->constant_pool[index]];
+}
+
+/*
+ * Return the bytes of a CONSTANT_Utf8 entry (not NUL-terminated) or NULL
+ */
+const guchar *classscan_utf8(ClassScan *scan, guint16 index, guint16 *length)
+{
+    if (classscan_tag(scan, index) != CONSTANT_Utf8) return NULL;
+
+    const guchar *entry = scan->data + scan->constant_pool[index];
+    *length = classscan_u2(entry + 1);
+
+    if (scan->constant_pool[index] + 3 + *length > scan->size) return NULL;
+
+    return entry + 3;
+}
+
+/*
+ * Return a copy of the CONSTANT_Utf8 entry at index or NULL
+ */
+gchar *classscan_string(ClassScan *scan, guint16 index)
+{
+    guint16 length = 0;
+    const guchar *str = classscan_utf8(scan, index, &length);
+
+    if (str == NULL) return NULL;
+
+    return g_strndup((const gchar*) str, length);
+}
+
+/*
+ * Return a copy of the internal name (e.g. java/lang/Object) of the
+ * CONSTANT_Class entry at index or NULL
+ */
+gchar *classscan_class_name(ClassScan *scan, guint16 index)
+{
+    return classscan_constant_name(scan, index, CONSTANT_Class);
+}
+
+/*
+ * Return a copy of the name of a CONSTANT_Class, CONSTANT_Module or
+ * CONSTANT_Package entry at index or NULL if it has another tag
+ */
+gchar *classscan_constant_name(ClassScan *scan, guint16 index, guint8 tag)
+{
+    guint16 length = 0;
+
+    if (classscan_tag(scan, index) != tag) return NULL;
+
+    const guchar *name = classscan_utf8(scan,
+            classscan_u2(scan->data + scan->constant_pool[index] + 1), &length);
+    if (name == NULL) return NULL;
+
+    return g_strndup((const gchar*) name, length);
+}
+
+/*
+ * Return the info of the class attribute with the given name or NULL if the
+ * class has no such attribute
+ */
+const guchar *classscan_attribute(ClassScan *scan, const gchar *name,
+        guint32 *length)
+{
+    return find_attribute(scan, scan->attributes_start, name, length);
+}
+
+/*
+ * Return the offset of the field or method behind the one at offset member
+ * (e.g. fields_start) or 0 if the class file is truncated
+ */
+gsize classscan_next_member(ClassScan *scan, gsize member)
+{
+    // access_flags, name_index, descriptor_index, attributes_count
+    if (member + 8 > scan->size) return 0;
+    guint16 attributes_count = classscan_u2(scan->data + member + 6);
+    gsize pos = member + 8;
+
+    for (guint16 j = 0; j < attributes_count; j++) {
+        if (pos + 6 > scan->size) return 0;
+        // added as gsize, since 6 + a length near 4 GiB wraps in 32 bits
+        pos += 6 + (gsize) classscan_u4(scan->data + pos + 2);
+    }
+
+    return pos;
+}
+
+/*
+ * Check that the field or method at offset member has the given name; a
+ * NULL scan or a member of 0 never matches
+ */
+gboolean classscan_member_is(ClassScan *scan, gsize member,
+        const gchar *name)
+{
+    guint16 length = 0;
+
+    if (scan == NULL || member == 0 || name == NULL) return FALSE;
+    if (member + 8 > scan->size) return FALSE;
+
+    const guchar *scanned_name = classscan_utf8(scan,
+            classscan_u2(scan->data + member + 2), &length);
+
+    return scanned_name != NULL && strlen(name) == length
+        && memcmp(scanned_name, name, length) == 0;
+}
+
+/*
+ * Return the info of an attribute of the field or method at offset member
+ * or NULL if it has no such attribute
+ */
+const guchar *classscan_member_attribute(ClassScan *scan, gsize member,
+        const gchar *name, guint32 *length)
+{
+    return find_attribute(scan, member + 6, name, length);
+}
@@ -0,0 +1,198 @@
+/*
+The MIT License (MIT) 
+Copyright (c) 2009,2010,2016 Andreas Heck <aheck@gmx.de>
+
+Permission to use, copy, modify, and/or distribute this software for any
+purpose with or without fee is hereby granted, provided that the above
+copyright notice and this permission notice appear in all copies.
+
+THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <glib.h>
+#include <zip.h>
+
+#include <classwalk.h>
+#include <readahead.h>
+
+/*
+ * Read all class files of a directory, a JAR or a single class file
+ */
+void classwalk_path(const gchar *path, gboolean skip_inner,
+        ClassWalkFunc func, gpointer user_data)
+{
+    if (g_file_test(path, G_FILE_TEST_IS_DIR)) {
+        classwalk_dir(path, skip_inner, func, user_data);
+    } else if (g_str_has_suffix(path, ".jar")) {
+        classwalk_jar(path, skip_inner, func, user_data);
+    } else {
+        gchar *contents = NULL;
+        gsize size = 0;
+        GError *error = NULL;
+
+        if (!g_file_get_contents(path, &contents, &size, &error)) {
+            fprintf(stderr, "ERROR: %s\n", error->message);
+            g_error_free(error);
+            return;
+        }
+
+        func(NULL, path, (guchar*) contents, size, user_data);
+    }
+}
+
+/*
+ * Read all class files of a JAR
+ */
+void classwalk_jar(const gchar *jarfile, gboolean skip_inner,
+        ClassWalkFunc func, gpointer user_data)
+{
+    struct zip *jar = NULL;
+    int errorp = 0;
+    struct zip_stat buffer;
+    struct zip_file *fp = NULL;
+    guint *order = NULL;
+
+    readahead_file(jarfile);
+
+    jar = zip_open(jarfile, 0, &errorp);
+    if (jar == NULL) {
+        fprintf(stderr, "Failed to open '%s'\n", jarfile);
+        return;
+    }
+
+    int numfiles = zip_get_num_files(jar);
+
+    // read the entries in the order in which they are stored
+    order = readahead_jar_order(jarfile, numfiles);
+
+    for (int n = 0; n < numfiles; n++) {
+        int i = order != NULL ? order[n] : n;
+        const gchar *filename = zip_get_name(jar, i, 0);
+        if (filename == NULL) continue;
+        if (!g_str_has_suffix(filename, ".class")) continue;
+        if (skip_inner && g_strrstr(filename, "$") != NULL) continue;
+
+        if (zip_stat_index(jar, i, 0, &buffer) != 0) {
+            fprintf(stderr, "ERROR: Failed to read the entry '%s' of '%s'\n",
+                    filename, jarfile);
+            continue;
+        }
+
+        gsize filesize = buffer.size;
+        guchar *classbytes = g_malloc(filesize);
+
+        fp = zip_fopen_index(jar, i, 0);
+        if (fp == NULL) {
+            fprintf(stderr, "ERROR: Failed to open '%s' in '%s'\n",
+                    filename, jarfile);
+            g_free(classbytes);
+            continue;
+        }
+
+        zip_int64_t nbytes = zip_fread(fp, classbytes, filesize);
+        zip_fclose(fp);
+
+        if (nbytes < 0 || (gsize) nbytes != filesize) {
+            fprintf(stderr, "ERROR: Read error! Requested %lu bytes but got %ld!\n",
+                    (unsigned long) filesize, (long) nbytes);
+            g_free(classbytes);
+            continue;
+        }
+
+        func(jarfile, filename, classbytes, filesize, user_data);
+    }
+
+    g_free(order);
+    zip_close(jar);
+}
+
+/*
+ * Read all class files and JARs of a directory and all its subdirectories
+ */
+void classwalk_dir(const gchar *dirname, gboolean skip_inner,
+        ClassWalkFunc func, gpointer user_data)
+{
+    GPtrArray *names = NULL;
+    GError *error = NULL;
+
+    names = readahead_dir(dirname, &error);
+
+    if (error != NULL) {
+        fprintf(stderr, "ERROR: %s\n", error->message);
+        g_error_free(error);
+        return;
+    }
+
+    for (guint i = 0; i < names->len; i++) {
+        const gchar *name = g_ptr_array_index(names, i);
+        gchar *filename = g_build_filename(dirname, name, NULL);
+
+        if (g_file_test(filename, G_FILE_TEST_IS_DIR)) {
+            if (!g_str_has_prefix(name, ".")) {
+                classwalk_dir(filename, skip_inner, func, user_data);
+            }
+        } else if (g_str_has_suffix(name, ".jar")) {
+            classwalk_jar(filename, skip_inner, func, user_data);
+        } else if (g_str_has_suffix(name, ".class")) {
+            if (!skip_inner || g_strrstr(name, "$") == NULL) {
+                classwalk_path(filename, skip_inner, func, user_data);
+            }
+        }
+
+        g_free(filename);
+    }
+
+    g_ptr_array_free(names, TRUE);
+}
+
+/*
+ * Collect the JARs and loose class files below path into containers
+ *
+ * Each of the collected paths can be passed to classwalk_path() on its own,
+ * e.g. to read several JARs in parallel. The caller has to g_free() the
+ * paths.
+ */
+void classwalk_list(const gchar *path, GPtrArray *containers)
+{
+    GDir *dir = NULL;
+    const gchar *name = NULL;
+    GError *error = NULL;
+
+    if (!g_file_test(path, G_FILE_TEST_IS_DIR)) {
+        g_ptr_array_add(containers, g_strdup(path));
+        return;
+    }
+
+    dir = g_dir_open(path, 0, &error);
+
+    if (error != NULL) {
+        fprintf(stderr, "ERROR: %s\n", error->message);
+        g_error_free(error);
+        return;
+    }
+
+    while ((name = g_dir_read_name(dir)) != NULL) {
+        gchar *filename = g_build_filename(path, name, NULL);
+
+        if (g_file_test(filename, G_FILE_TEST_IS_DIR)) {
+            if (!g_str_has_prefix(name, ".")) {
+                classwalk_list(filename, containers);
+            }
+        } else if (g_str_has_suffix(name, ".jar")
+                || g_str_has_suffix(name, ".class")) {
+            g_ptr_array_add(containers, g_strdup(filename));
+        }
+
+        g_free(filename);
+    }
+
+    g_dir_close(dir);
+}
@@ -17,166 +17,738 @@ OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
 
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 #include <glib.h>
 
-#include <sys/types.h>
-#include <sys/stat.h>
-#include <unistd.h>
-
 #include <global.h>
+#include <accessflags.h>
+#include <classscan.h>
+#include <classwalk.h>
+#include <jsonutil.h>
+#include <trace.h>
 #include <classreader/javaclass.h>
 
-void usage(gchar *binary)
-{
-    fprintf(stderr, "Usage: %s <CLASSFILE>\n", binary);
-    exit(2);
-}
+// upper bound of classes which were read but not yet dumped, so that reading
+// a huge JAR can't run far ahead of the parser threads
+#define MAX_PENDING_CLASSES 1024
 
-int main(int argc, char** argv)
-{
-    JavaClass *c = NULL;
-    FILE *fp = NULL;
-    guchar *contents = NULL;
-    int filesize = 0;
-    int nbytes = 0;
-    struct stat buffer;
-    guint32 status;
-    gchar *classfile = NULL;
-    gchar *access = NULL;
-    gchar *type = NULL;
+// limits of the census histograms
+#define CENSUS_MAX_VERSION    256
+#define CENSUS_METHOD_BUCKETS 18
+#define CENSUS_LARGEST        20
 
-    if (argc != 2) {
-        usage(argv[0]);
-    }
-
-    classfile = argv[1];
-
-    printf("Reading file '%s'...\n", classfile);
-
-    fp = fopen(classfile, "r");
-
-    if (fp == NULL) {
-        fprintf(stderr, "Failed to open file '%s'\n", classfile);
-        return 1;
-    }
+static gboolean json = FALSE;
+static gboolean census = FALSE;
+static gint threads = 0;
+static gchar *trace_file = NULL;
 
-    // get the size of the file
-    status = fstat(fileno(fp), &buffer);
-    filesize = buffer.st_size;
+static GOptionEntry options[] =
+{
+    {"json", 'j', 0, G_OPTION_ARG_NONE, &json, "Print one JSON object per line and class"},
+    {"threads", 't', 0, G_OPTION_ARG_INT, &threads, "Number of threads parsing classes (default: number of CPUs)", "N"},
+    {"census", 'c', 0, G_OPTION_ARG_NONE, &census, "Only print aggregate statistics about versions, types and sizes of all classes"},
+    {"trace", 0, 0, G_OPTION_ARG_FILENAME, &trace_file, "Write a timeline of the JARs and classes each thread processed to FILE for chrome://tracing or Perfetto", "FILE"},
+    {NULL}
+};
 
-    contents = g_new(guchar, filesize);
+/*
+ * A class file read by the main thread and dumped by one of the workers
+ */
+typedef struct {
+    gchar *container;
+    gchar *name;
+    guchar *bytes;
+    gsize size;
+} DumpJob;
 
-    nbytes = fread(contents, 1, filesize, fp);
-    if (nbytes != filesize) {
-        fprintf(stderr, "ERROR: Read error! Requested %d bytes but got %d!\n",
-                filesize, nbytes);
-        return 1;
-    }
+/*
+ * Class types in the order they are checked by class_type()
+ */
+enum {
+    CLASS_TYPE_INTERFACE,
+    CLASS_TYPE_ABSTRACT,
+    CLASS_TYPE_ENUM,
+    CLASS_TYPE_ANNOTATION,
+    CLASS_TYPE_CLASS,
+    CLASS_TYPE_NUM
+};
+
+const gchar *CLASS_TYPES[CLASS_TYPE_NUM] = {
+    "interface",
+    "abstract class",
+    "enum",
+    "annotation",
+    "class"
+};
+
+typedef struct {
+    gchar *name;
+    gsize size;
+} CensusClass;
 
-    fclose(fp);
+/*
+ * Counters of the census mode
+ *
+ * Each thread of the pool aggregates into its own Census so that the
+ * threads never have to synchronize; the counters are merged at the end.
+ */
+typedef struct {
+    guint64 classes;
+    guint64 errors;
+    guint64 bytes;
+    guint64 fields;
+    guint64 methods;
+    guint64 versions[CENSUS_MAX_VERSION];
+    guint64 types[CLASS_TYPE_NUM];
+    // classes with 0, 1, 2-3, 4-7, ... methods
+    guint64 method_buckets[CENSUS_METHOD_BUCKETS];
+    // sorted by size in descending order
+    CensusClass largest[CENSUS_LARGEST];
+    ClassScan scan;
+} Census;
+
+static GPrivate census_key = G_PRIVATE_INIT(NULL);
+GPtrArray *censuses = NULL;
+GMutex census_lock;
+
+GMutex output_lock;
+GMutex pending_lock;
+GCond pending_cond;
+gint pending = 0;
+int exit_status = 0;
+
+void usage(gchar *errormsg, GOptionContext *context)
+{
+    if (errormsg != NULL) fprintf(stderr, "ERROR: %s\n", errormsg);
+    fprintf(stderr, "%s", g_option_context_get_help(context, TRUE, NULL));
 
-    GError *error = NULL;
-    c = javaclass_new(contents, filesize, FALSE, &error);
+    exit(2);
+}
 
-    if (error != NULL) {
-        fprintf(stderr, "Failed to read the class file %s\n", classfile);
-        fprintf(stderr, "%s", error->message);
-        g_error_free(error);
-        return 1;
-    }
+int class_type_from_flags(gint64 access_flags)
+{
+    if (access_flags & ACC_INTERFACE)
+        return CLASS_TYPE_INTERFACE;
+    else if (access_flags & ACC_ABSTRACT)
+        return CLASS_TYPE_ABSTRACT;
+    else if (access_flags & ACC_ENUM)
+        return CLASS_TYPE_ENUM;
+    else if (access_flags & ACC_ANNOTATION)
+        return CLASS_TYPE_ANNOTATION;
+
+    return CLASS_TYPE_CLASS;
+}
 
-    if (javaclass_is_public(c))
-        access = "public";
-    else
-        access = "package";
+const gchar *class_type(JavaClass *c)
+{
+    return CLASS_TYPES[class_type_from_flags(class_access_flags(c, NULL))];
+}
 
-    if (javaclass_is_interface(c))
-        type = "interface";
-    else if (javaclass_is_abstract(c))
-        type = "abstract class";
-    else if (javaclass_is_enum(c))
-        type = "enum";
-    else if (javaclass_is_annotation(c))
-        type = "annotation";
-    else
-        type = "class";
+/*
+ * Append the human readable description of a class to out; scan is used
+ * for the raw access flags and may be NULL
+ */
+void dump_text(JavaClass *c, ClassScan *scan, GString *out)
+{
+    gsize member = 0;
 
+    const gchar *access = javaclass_is_public(c) ? "public" : "package";
     const gchar *package = javaclass_get_package(c);
     if (package == NULL) package = DEFAULT_PACKAGE;
     const gchar *class_signature = javaclass_get_signature(c);
     if (class_signature == NULL) class_signature = "(none)";
 
-    printf("Classname: %s\n", javaclass_get_name(c));
-    printf("Class signature: %s\n", class_signature);
-    printf("Package: %s\n", package);
-    printf("Fully-qulified classname: %s\n", javaclass_get_fq_name(c));
-    printf("Parent class: %s\n", javaclass_get_fq_parent(c));
-    printf("Access: %s\n", access);
-    printf("Type: %s\n", type);
-    printf("Final: %s\n", javaclass_is_final(c) ? "yes" : "no");
-    printf("Classfile version number: %d.%d\n", javaclass_get_major_version_number(c),
+    g_string_append_printf(out, "Classname: %s\n", javaclass_get_name(c));
+    g_string_append_printf(out, "Class signature: %s\n", class_signature);
+    g_string_append_printf(out, "Package: %s\n", package);
+    g_string_append_printf(out, "Fully-qulified classname: %s\n",
+            javaclass_get_fq_name(c));
+    g_string_append_printf(out, "Parent class: %s\n",
+            javaclass_get_fq_parent(c));
+    g_string_append_printf(out, "Access: %s\n", access);
+    g_string_append_printf(out, "Type: %s\n", class_type(c));
+    g_string_append_printf(out, "Final: %s\n",
+            javaclass_is_final(c) ? "yes" : "no");
+    g_string_append_printf(out, "Classfile version number: %d.%d\n",
+            javaclass_get_major_version_number(c),
             javaclass_get_minor_version_number(c));
-    printf("Classfile version: %s\n", javaclass_get_version_name(c));
-    printf("Interfaces count: %d\n", javaclass_get_interface_number(c));
+    g_string_append_printf(out, "Classfile version: %s\n",
+            javaclass_get_version_name(c));
+    g_string_append_printf(out, "Interfaces count: %d\n",
+            javaclass_get_interface_number(c));
 
     // print interfaces if there are any
     if (javaclass_get_interface_number(c) > 0) {
-        printf("Interfaces:\n");
+        g_string_append(out, "Interfaces:\n");
         gchar **interfaces = javaclass_get_interfaces(c);
 
         for (int i = 0; interfaces[i]; i++) {
-            printf("    %s\n", interfaces[i]);
+            g_string_append_printf(out, "    %s\n", interfaces[i]);
         }
     }
 
-    printf("Fields count: %d\n", javaclass_get_field_number(c));
+    g_string_append_printf(out, "Fields count: %d\n",
+            javaclass_get_field_number(c));
 
     if (javaclass_get_field_number(c) > 0) {
-        printf("Fields:\n");
+        g_string_append(out, "Fields:\n");
         JavaField **fields = javaclass_get_fields(c);
-        GString *fielddef = g_string_new("");
 
+        member = scan != NULL ? scan->fields_start : 0;
         for (int i = 0; fields[i]; i++) {
-            printf("    ");
-
-            //printf("%s\n", fields[i]);
+            g_string_append_printf(out, "    %s %s (flags 0x%04x)\n",
+                    javafield_get_descriptor(fields[i]),
+                    javafield_get_name(fields[i]),
+                    (guint) field_access_flags(fields[i], scan, member));
+            if (member != 0) member = classscan_next_member(scan, member);
 
             const gchar *sig = javafield_get_signature(fields[i]);
-            if (sig != NULL) printf("    Signature: %s\n", sig);
+            if (sig != NULL) {
+                g_string_append_printf(out, "        Signature: %s\n", sig);
+            }
         }
-
-        g_string_free(fielddef, TRUE);
     }
 
-    printf("Methods count: %d\n", javaclass_get_method_number(c));
+    g_string_append_printf(out, "Methods count: %d\n",
+            javaclass_get_method_number(c));
 
     if (javaclass_get_method_number(c) > 0) {
-        printf("Methods:\n");
+        g_string_append(out, "Methods:\n");
         JavaMethod **methods = javaclass_get_methods(c);
-        GString *methoddef = g_string_new("");
 
+        member = scan != NULL ? scan->methods_start : 0;
         for (int i = 0; methods[i]; i++) {
-            //printf("    %s\n", methods[i]);
+            g_string_append_printf(out, "    %s%s (flags 0x%04x)\n",
+                    javamethod_get_name(methods[i]),
+                    javamethod_get_descriptor(methods[i]),
+                    (guint) method_access_flags(methods[i], scan, member));
+            if (member != 0) member = classscan_next_member(scan, member);
 
             gchar **exceptions = javamethod_get_exceptions(methods[i]);
             if (exceptions != NULL) {
-                printf("        throws");
-                for (int i = 0; exceptions[i]; i++) {
-                    printf(" %s", exceptions[i]);
+                g_string_append(out, "        throws");
+                for (int j = 0; exceptions[j]; j++) {
+                    g_string_append_printf(out, " %s", exceptions[j]);
                 }
-                printf("\n");
+                g_string_append_c(out, '\n');
             }
 
             const gchar *sig = javamethod_get_signature(methods[i]);
-            if (sig != NULL) printf("    Signature: %s\n", sig);
+            if (sig != NULL) {
+                g_string_append_printf(out, "        Signature: %s\n", sig);
+            }
+        }
+    }
+}
+
+/*
+ * Append a class as one line of JSON to out; scan is used for the raw
+ * access flags and may be NULL
+ */
+void dump_json(const gchar *container, const gchar *name, JavaClass *c,
+        ClassScan *scan, GString *out)
+{
+    gsize member = 0;
+
+    g_string_append(out, "{\"container\":");
+    json_append_string(out, container);
+    g_string_append(out, ",\"file\":");
+    json_append_string(out, name);
+    g_string_append(out, ",\"name\":");
+    json_append_string(out, javaclass_get_name(c));
+    g_string_append(out, ",\"package\":");
+    json_append_string(out, javaclass_get_package(c));
+    g_string_append(out, ",\"fq_name\":");
+    json_append_string(out, javaclass_get_fq_name(c));
+    g_string_append(out, ",\"parent\":");
+    json_append_string(out, javaclass_get_fq_parent(c));
+    g_string_append(out, ",\"signature\":");
+    json_append_string(out, javaclass_get_signature(c));
+    g_string_append(out, ",\"access\":");
+    json_append_string(out, javaclass_is_public(c) ? "public" : "package");
+    g_string_append(out, ",\"type\":");
+    json_append_string(out, class_type(c));
+    g_string_append_printf(out, ",\"final\":%s",
+            javaclass_is_final(c) ? "true" : "false");
+    g_string_append_printf(out, ",\"access_flags\":%d",
+            (int) class_access_flags(c, scan));
+    g_string_append_printf(out, ",\"major_version\":%d,\"minor_version\":%d",
+            javaclass_get_major_version_number(c),
+            javaclass_get_minor_version_number(c));
+    g_string_append(out, ",\"version\":");
+    json_append_string(out, javaclass_get_version_name(c));
+
+    g_string_append(out, ",\"interfaces\":[");
+    if (javaclass_get_interface_number(c) > 0) {
+        gchar **interfaces = javaclass_get_interfaces(c);
+
+        for (int i = 0; interfaces[i]; i++) {
+            if (i > 0) g_string_append_c(out, ',');
+            json_append_string(out, interfaces[i]);
+        }
+    }
+
+    g_string_append(out, "],\"fields\":[");
+    if (javaclass_get_field_number(c) > 0) {
+        JavaField **fields = javaclass_get_fields(c);
+
+        member = scan != NULL ? scan->fields_start : 0;
+        for (int i = 0; fields[i]; i++) {
+            if (i > 0) g_string_append_c(out, ',');
+            g_string_append(out, "{\"name\":");
+            json_append_string(out, javafield_get_name(fields[i]));
+            g_string_append(out, ",\"descriptor\":");
+            json_append_string(out, javafield_get_descriptor(fields[i]));
+            g_string_append(out, ",\"signature\":");
+            json_append_string(out, javafield_get_signature(fields[i]));
+            g_string_append_printf(out, ",\"access_flags\":%d}",
+                    (int) field_access_flags(fields[i], scan, member));
+            if (member != 0) member = classscan_next_member(scan, member);
+        }
+    }
+
+    g_string_append(out, "],\"methods\":[");
+    if (javaclass_get_method_number(c) > 0) {
+        JavaMethod **methods = javaclass_get_methods(c);
+
+        member = scan != NULL ? scan->methods_start : 0;
+        for (int i = 0; methods[i]; i++) {
+            if (i > 0) g_string_append_c(out, ',');
+            g_string_append(out, "{\"name\":");
+            json_append_string(out, javamethod_get_name(methods[i]));
+            g_string_append(out, ",\"descriptor\":");
+            json_append_string(out, javamethod_get_descriptor(methods[i]));
+            g_string_append(out, ",\"signature\":");
+            json_append_string(out, javamethod_get_signature(methods[i]));
+            g_string_append_printf(out, ",\"access_flags\":%d",
+                    (int) method_access_flags(methods[i], scan, member));
+            if (member != 0) member = classscan_next_member(scan, member);
+
+            g_string_append(out, ",\"exceptions\":[");
+            gchar **exceptions = javamethod_get_exceptions(methods[i]);
+            if (exceptions != NULL) {
+                for (int j = 0; exceptions[j]; j++) {
+                    if (j > 0) g_string_append_c(out, ',');
+                    json_append_string(out, exceptions[j]);
+                }
+            }
+            g_string_append(out, "]}");
+        }
+    }
+
+    g_string_append(out, "]}\n");
+}
+
+/*
+ * Parse and print one class; runs in the threads of the pool
+ */
+void dump_class(gpointer data, gpointer user_data)
+{
+    DumpJob *job = (DumpJob*) data;
+    GError *error = NULL;
+    GString *out = g_string_sized_new(4096);
+    gint64 start = trace_start();
+    ClassScan scan = { 0 };
+
+    JavaClass *c = javaclass_new(job->bytes, job->size, FALSE, &error);
+    ClassScan *raw = classscan_init(&scan, job->bytes, job->size)
+        ? &scan : NULL;
+
+    if (error != NULL) {
+        g_mutex_lock(&output_lock);
+        fprintf(stderr, "Failed to read the class file %s\n", job->name);
+        fprintf(stderr, "%s\n", error->message);
+        exit_status = 1;
+        g_mutex_unlock(&output_lock);
+
+        g_error_free(error);
+    } else {
+        if (json) {
+            dump_json(job->container, job->name, c, raw, out);
+        } else {
+            if (job->container != NULL) {
+                g_string_append_printf(out, "Reading file '%s' from '%s'...\n",
+                        job->name, job->container);
+            } else {
+                g_string_append_printf(out, "Reading file '%s'...\n",
+                        job->name);
+            }
+
+            dump_text(c, raw, out);
+            g_string_append_c(out, '\n');
+        }
+
+        // write the whole class at once so that the output of the threads
+        // isn't interleaved
+        g_mutex_lock(&output_lock);
+        fwrite(out->str, 1, out->len, stdout);
+        g_mutex_unlock(&output_lock);
+
+        javaclass_free(c);
+    }
+
+    trace_end("class", job->name, start, job->size);
+
+    classscan_clear(&scan);
+    g_string_free(out, TRUE);
+    g_free(job->container);
+    g_free(job->name);
+    g_free(job->bytes);
+    g_free(job);
+
+    g_mutex_lock(&pending_lock);
+    pending--;
+    g_cond_signal(&pending_cond);
+    g_mutex_unlock(&pending_lock);
+}
+
+/*
+ * Hand a class read by classwalk_path() over to the thread pool
+ */
+void queue_class(const gchar *container, const gchar *name, guchar *bytes,
+        gsize size, gpointer user_data)
+{
+    GThreadPool *pool = (GThreadPool*) user_data;
+    DumpJob *job = g_new(DumpJob, 1);
+
+    job->container = g_strdup(container);
+    job->name      = g_strdup(name);
+    job->bytes     = bytes;
+    job->size      = size;
+
+    g_mutex_lock(&pending_lock);
+    while (pending >= MAX_PENDING_CLASSES) {
+        g_cond_wait(&pending_cond, &pending_lock);
+    }
+    pending++;
+    g_mutex_unlock(&pending_lock);
+
+    g_thread_pool_push(pool, job, NULL);
+}
+
+/*
+ * Return the Census of the calling thread
+ */
+Census *get_census()
+{
+    Census *cur = g_private_get(&census_key);
+
+    if (cur == NULL) {
+        cur = g_new0(Census, 1);
+        g_private_set(&census_key, cur);
+
+        g_mutex_lock(&census_lock);
+        g_ptr_array_add(censuses, cur);
+        g_mutex_unlock(&census_lock);
+    }
+
+    return cur;
+}
+
+/*
+ * Keep name if the class is one of the CENSUS_LARGEST largest classes seen
+ * so far; takes ownership of name
+ */
+void census_add_largest(Census *cur, gchar *name, gsize size)
+{
+    int pos = CENSUS_LARGEST;
+
+    while (pos > 0 && cur->largest[pos - 1].size < size) pos--;
+
+    if (pos == CENSUS_LARGEST) {
+        g_free(name);
+        return;
+    }
+
+    g_free(cur->largest[CENSUS_LARGEST - 1].name);
+    memmove(&cur->largest[pos + 1], &cur->largest[pos],
+            (CENSUS_LARGEST - pos - 1) * sizeof(CensusClass));
+
+    cur->largest[pos].name = name;
+    cur->largest[pos].size = size;
+}
+
+/*
+ * Count one class; only the header and the member tables are scanned,
+ * nothing is decoded
+ */
+void census_class(const gchar *container, const gchar *name, guchar *bytes,
+        gsize size, gpointer user_data)
+{
+    Census *cur = get_census();
+    ClassScan *scan = &cur->scan;
+    gint64 start = trace_start();
+
+    if (!classscan_init(scan, bytes, size)) {
+        cur->errors++;
+        g_free(bytes);
+        return;
+    }
+
+    cur->classes++;
+    cur->bytes   += size;
+    cur->fields  += scan->fields_count;
+    cur->methods += scan->methods_count;
+
+    cur->versions[MIN(scan->major_version, CENSUS_MAX_VERSION - 1)]++;
+    cur->types[class_type_from_flags(scan->access_flags)]++;
+
+    int bucket = 0;
+    for (guint n = scan->methods_count; n > 0; n >>= 1) bucket++;
+    cur->method_buckets[bucket]++;
+
+    if (size > cur->largest[CENSUS_LARGEST - 1].size) {
+        gchar *classname = classscan_class_name(scan, scan->this_class);
+        if (classname == NULL) classname = g_strdup(name);
+        g_strdelimit(classname, "/", '.');
+
+        census_add_largest(cur, classname, size);
+    }
+
+    g_free(bytes);
+
+    trace_end("class", name, start, size);
+}
+
+/*
+ * Count all classes of a JAR or class file; runs in the threads of the pool
+ */
+void census_container(gpointer data, gpointer user_data)
+{
+    gchar *path = (gchar*) data;
+    gint64 start = trace_start();
+
+    classwalk_path(path, FALSE, census_class, NULL);
+
+    trace_end("jar", path, start, -1);
+    g_free(path);
+}
+
+/*
+ * Return the Java release which introduced a class file version
+ */
+gchar *java_version_name(int major)
+{
+    if (major >= 49) return g_strdup_printf("Java %d", major - 44);
+    if (major >= 45) return g_strdup_printf("Java 1.%d", major - 44);
+
+    return g_strdup("unknown");
+}
+
+/*
+ * Merge the counters of all threads and print them
+ */
+void print_census()
+{
+    Census *total = g_new0(Census, 1);
+
+    for (guint i = 0; i < censuses->len; i++) {
+        Census *cur = g_ptr_array_index(censuses, i);
+
+        total->classes += cur->classes;
+        total->errors  += cur->errors;
+        total->bytes   += cur->bytes;
+        total->fields  += cur->fields;
+        total->methods += cur->methods;
+
+        for (int j = 0; j < CENSUS_MAX_VERSION; j++) {
+            total->versions[j] += cur->versions[j];
+        }
+
+        for (int j = 0; j < CLASS_TYPE_NUM; j++) {
+            total->types[j] += cur->types[j];
+        }
+
+        for (int j = 0; j < CENSUS_METHOD_BUCKETS; j++) {
+            total->method_buckets[j] += cur->method_buckets[j];
+        }
+
+        for (int j = 0; j < CENSUS_LARGEST && cur->largest[j].name; j++) {
+            census_add_largest(total, cur->largest[j].name,
+                    cur->largest[j].size);
+        }
+
+        classscan_clear(&cur->scan);
+        g_free(cur);
+    }
+
+    GString *out = g_string_new("");
+
+    if (json) {
+        g_string_append_printf(out, "{\"classes\":%" G_GUINT64_FORMAT
+                ",\"errors\":%" G_GUINT64_FORMAT
+                ",\"bytes\":%" G_GUINT64_FORMAT
+                ",\"fields\":%" G_GUINT64_FORMAT
+                ",\"methods\":%" G_GUINT64_FORMAT,
+                total->classes, total->errors, total->bytes, total->fields,
+                total->methods);
+
+        g_string_append(out, ",\"versions\":{");
+        gboolean first = TRUE;
+        for (int i = 0; i < CENSUS_MAX_VERSION; i++) {
+            if (total->versions[i] == 0) continue;
+            g_string_append_printf(out, "%s\"%d\":%" G_GUINT64_FORMAT,
+                    first ? "" : ",", i, total->versions[i]);
+            first = FALSE;
+        }
+
+        g_string_append(out, "},\"types\":{");
+        for (int i = 0; i < CLASS_TYPE_NUM; i++) {
+            if (i > 0) g_string_append_c(out, ',');
+            json_append_string(out, CLASS_TYPES[i]);
+            g_string_append_printf(out, ":%" G_GUINT64_FORMAT,
+                    total->types[i]);
+        }
+
+        g_string_append(out, "},\"methods_per_class\":[");
+        for (int i = 0; i < CENSUS_METHOD_BUCKETS; i++) {
+            if (i > 0) g_string_append_c(out, ',');
+            g_string_append_printf(out, "%" G_GUINT64_FORMAT,
+                    total->method_buckets[i]);
+        }
+
+        g_string_append(out, "],\"largest\":[");
+        for (int i = 0; i < CENSUS_LARGEST && total->largest[i].name; i++) {
+            if (i > 0) g_string_append_c(out, ',');
+            g_string_append(out, "{\"name\":");
+            json_append_string(out, total->largest[i].name);
+            g_string_append_printf(out, ",\"size\":%lu}",
+                    (unsigned long) total->largest[i].size);
+        }
+        g_string_append(out, "]}\n");
+    } else {
+        g_string_append_printf(out, "Classes: %" G_GUINT64_FORMAT "\n",
+                total->classes);
+        g_string_append_printf(out, "Unreadable classes: %" G_GUINT64_FORMAT
+                "\n", total->errors);
+        g_string_append_printf(out, "Total size: %" G_GUINT64_FORMAT
+                " bytes\n", total->bytes);
+        g_string_append_printf(out, "Fields: %" G_GUINT64_FORMAT "\n",
+                total->fields);
+        g_string_append_printf(out, "Methods: %" G_GUINT64_FORMAT "\n",
+                total->methods);
+
+        g_string_append(out, "Classfile versions:\n");
+        for (int i = 0; i < CENSUS_MAX_VERSION; i++) {
+            if (total->versions[i] == 0) continue;
+            gchar *version = java_version_name(i);
+            g_string_append_printf(out, "    %d (%s): %" G_GUINT64_FORMAT "\n",
+                    i, version, total->versions[i]);
+            g_free(version);
+        }
+
+        g_string_append(out, "Types:\n");
+        for (int i = 0; i < CLASS_TYPE_NUM; i++) {
+            g_string_append_printf(out, "    %s: %" G_GUINT64_FORMAT "\n",
+                    CLASS_TYPES[i], total->types[i]);
+        }
+
+        g_string_append(out, "Methods per class:\n");
+        for (int i = 0; i < CENSUS_METHOD_BUCKETS; i++) {
+            if (total->method_buckets[i] == 0) continue;
+            guint low  = i == 0 ? 0 : 1u << (i - 1);
+            guint high = i == 0 ? 0 : (1u << i) - 1;
+            g_string_append_printf(out, "    %u-%u: %" G_GUINT64_FORMAT "\n",
+                    low, high, total->method_buckets[i]);
+        }
+
+        g_string_append(out, "Largest classes:\n");
+        for (int i = 0; i < CENSUS_LARGEST && total->largest[i].name; i++) {
+            g_string_append_printf(out, "    %s: %lu bytes\n",
+                    total->largest[i].name,
+                    (unsigned long) total->largest[i].size);
+        }
+    }
+
+    fwrite(out->str, 1, out->len, stdout);
+    g_string_free(out, TRUE);
+
+    for (int i = 0; i < CENSUS_LARGEST; i++) {
+        g_free(total->largest[i].name);
+    }
+    g_free(total);
+}
+
+int main(int argc, char** argv)
+{
+    GError *error = NULL;
+    GOptionContext *context;
+    GThreadPool *pool = NULL;
+
+    context = g_option_context_new(
+            "PATH... - Dump information about class files, JARs and "
+            "directories of class files");
+    g_option_context_add_main_entries(context, options, NULL);
+
+    if (!g_option_context_parse(context, &argc, &argv, &error)) {
+        usage(error->message, context);
+    }
+
+    if (argc < 2) {
+        usage(NULL, context);
+    }
+
+    if (threads <= 0) threads = g_get_num_processors();
+
+    if (trace_file != NULL) {
+        trace_open(trace_file);
+        atexit(trace_close);
+    }
+
+    g_mutex_init(&output_lock);
+    g_mutex_init(&pending_lock);
+    g_cond_init(&pending_cond);
+
+    if (census) {
+        g_mutex_init(&census_lock);
+        censuses = g_ptr_array_new();
+
+        // in census mode the threads read whole JARs so that inflating is
+        // done in parallel, too
+        pool = g_thread_pool_new(census_container, NULL, threads, TRUE,
+                &error);
+    } else {
+        pool = g_thread_pool_new(dump_class, NULL, threads, TRUE, &error);
+    }
+
+    if (pool == NULL) {
+        fprintf(stderr, "ERROR: %s\n", error->message);
+        return 1;
+    }
+
+    for (int i = 1; i < argc; i++) {
+        if (!g_file_test(argv[i], G_FILE_TEST_EXISTS)) {
+            fprintf(stderr, "Failed to open file '%s'\n", argv[i]);
+            exit_status = 1;
+            continue;
         }
 
-        g_string_free(methoddef, TRUE);
+        if (census) {
+            GPtrArray *containers = g_ptr_array_new();
+            classwalk_list(argv[i], containers);
+
+            for (guint j = 0; j < containers->len; j++) {
+                g_thread_pool_push(pool, g_ptr_array_index(containers, j),
+                        NULL);
+            }
+
+            g_ptr_array_free(containers, TRUE);
+        } else {
+            gint64 start = trace_start();
+
+            // the main thread reads the classes for the pool
+            classwalk_path(argv[i], FALSE, queue_class, pool);
+            trace_end("read", argv[i], start, -1);
+        }
     }
 
-    javaclass_free(c);
+    // wait until all queued classes are processed
+    g_thread_pool_free(pool, FALSE, TRUE);
 
-    g_free(contents);
+    if (census) {
+        print_census();
+        g_ptr_array_free(censuses, TRUE);
+    }
 
-    return 0;
+    return exit_status;
 }
@@ -22,44 +22,84 @@ OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
 #include <sqlite3.h>
 #include <zip.h>
 
+#include <nestedjar.h>
+#include <trace.h>
 #include <classreader/javaclass.h>
 
 static gboolean verbose = FALSE;
+static gchar *trace_file = NULL;
 
 static GOptionEntry options[] = 
 {
     {"verbose", 'v', 0, G_OPTION_ARG_NONE, &verbose, "Return the full names of all completion suggestions"},
+    {"trace", 0, 0, G_OPTION_ARG_FILENAME, &trace_file, "Write a timeline of the searched directories, JARs and classes to FILE for chrome://tracing or Perfetto", "FILE"},
     {NULL}
 };
 
-void search_jar(const gchar *filename, const gchar *searchname,
-        const gchar *suffix)
+void search_archive(NestedJar *archive, const gchar *filename,
+        const gchar *searchname, const gchar *suffix)
 {
-    struct zip *jar = NULL;
-    int errorp = 0;
-
-    jar = zip_open(filename, 0, &errorp);
-    if (jar == NULL) {
-        fprintf(stderr, "Failed to open '%s'\n", filename);
-        return;
-    }
-
-    int numfiles = zip_get_num_files(jar);
+    int numfiles = zip_get_num_files(archive->zip);
 
     for (int i = 0; i < numfiles; i++) {
-        const gchar *classfile = zip_get_name(jar, i, 0);
+        const gchar *classfile = zip_get_name(archive->zip, i, 0);
         if (classfile == NULL) continue;
+
+        // JARs in fat JARs and WARs are searched in memory
+        if (nestedjar_is_archive(classfile)) {
+            GError *error = NULL;
+            gint64 start = trace_start();
+            NestedJar *nested = nestedjar_open(archive, i, &error);
+
+            if (error != NULL) {
+                fprintf(stderr, "ERROR: %s in %s\n", error->message, filename);
+                g_error_free(error);
+                continue;
+            }
+
+            gchar *nested_name = g_strconcat(filename, "!/", classfile, NULL);
+            if (verbose) printf("Searching JAR file %s\n", nested_name);
+            search_archive(nested, nested_name, searchname, suffix);
+            trace_end("jar", nested_name, start, -1);
+
+            g_free(nested_name);
+            nestedjar_close(nested);
+            continue;
+        }
+
         if (!g_str_has_suffix(classfile, ".class")) continue;
         if (g_strrstr(classfile, "$") != NULL) continue; // skip inner classes
 
+        // the package of a class in BOOT-INF/classes or WEB-INF/classes
+        // starts below that directory
+        classfile = nestedjar_class_path(classfile);
+
         if (g_strcmp0(classfile, searchname) == 0) {
             fprintf(stdout, "%s %s\n", filename, classfile);
         } else if (g_str_has_suffix(classfile, suffix)) {
             fprintf(stdout, "%s %s\n", filename, classfile);
         }
     }
+}
+
+void search_jar(const gchar *filename, const gchar *searchname,
+        const gchar *suffix)
+{
+    struct zip *jar = NULL;
+    int errorp = 0;
+    gint64 start = trace_start();
 
-    zip_close(jar);
+    jar = zip_open(filename, 0, &errorp);
+    if (jar == NULL) {
+        fprintf(stderr, "Failed to open '%s'\n", filename);
+        return;
+    }
+
+    NestedJar *archive = nestedjar_new(jar, filename);
+    search_archive(archive, filename, searchname, suffix);
+    nestedjar_close(archive);
+
+    trace_end("jar", filename, start, -1);
 }
 
 void search_dir(const gchar *dirname, const gchar *searchname,
@@ -69,6 +109,7 @@ void search_dir(const gchar *dirname, const gchar *searchname,
     const gchar *name = NULL;
     gchar *filename = NULL;
     GError *error = NULL;
+    gint64 start = trace_start();
 
     dir = g_dir_open(dirname, 0, &error);
 
@@ -83,13 +124,14 @@ void search_dir(const gchar *dirname, const gchar *searchname,
         if (g_file_test(filename, G_FILE_TEST_IS_DIR)
                 && !g_str_has_prefix(name, ".")) {
             search_dir(filename, searchname, suffix);
-        } else if (g_str_has_suffix(filename, ".jar")) {
+        } else if (nestedjar_is_archive(filename)) {
             if (verbose) printf("Searching JAR file %s\n", filename);
             search_jar(filename, searchname, suffix);
         } else if (g_str_has_suffix(filename, ".class")) {
             if (g_strrstr(filename, "$") != NULL) continue; // skip inner classes
 
             GError *error = NULL;
+            gint64 class_start = trace_start();
             JavaClass *javaclass = javaclass_new_from_file(filename, FALSE, &error);
 
             if (error != NULL) {
@@ -111,10 +153,14 @@ void search_dir(const gchar *dirname, const gchar *searchname,
                 g_string_free(buffer, TRUE);
                 javaclass_free(javaclass);
             }
+
+            trace_end("class", filename, class_start, -1);
         }
     }
 
     g_dir_close(dir);
+
+    trace_end("dir", dirname, start, -1);
 }
 
 void usage(gchar *errormsg, GOptionContext *context)
@@ -142,6 +188,11 @@ int main(int argc, char **argv)
         usage(NULL, context);
     }
 
+    if (trace_file != NULL) {
+        trace_open(trace_file);
+        atexit(trace_close);
+    }
+
     const gchar *searchname = argv[1];
     gboolean qualified = FALSE;
 
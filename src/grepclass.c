@@ -0,0 +1,464 @@
+/*
+The MIT License (MIT) 
+Copyright (c) 2009,2010,2016 Andreas Heck <aheck@gmx.de>
+
+Permission to use, copy, modify, and/or distribute this software for any
+purpose with or without fee is hereby granted, provided that the above
+copyright notice and this permission notice appear in all copies.
+
+THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <glib.h>
+
+#include <classscan.h>
+#include <classwalk.h>
+#include <ahocorasick.h>
+#include <jsonutil.h>
+
+/*
+ * How a CONSTANT_Utf8 entry is used by the other entries of the constant
+ * pool and the member tables of a class
+ */
+enum {
+    KIND_OTHER,         // e.g. signatures, attribute names or annotations
+    KIND_STRING,        // a string literal (CONSTANT_String)
+    KIND_CLASS,         // the name of a class (CONSTANT_Class)
+    KIND_MEMBER,        // the name of a field or method
+    KIND_DESCRIPTOR,    // the descriptor of a field or method
+    KIND_NUM
+};
+
+const gchar *KINDS[KIND_NUM] = {
+    "other",
+    "string",
+    "class",
+    "member",
+    "descriptor"
+};
+
+static gchar **pattern_args = NULL;
+static gchar *pattern_file = NULL;
+static gboolean ignore_case = FALSE;
+static gchar *kind_name = NULL;
+static gboolean list_classes = FALSE;
+static gboolean json = FALSE;
+static gint threads = 0;
+
+static GOptionEntry options[] =
+{
+    {"pattern", 'e', 0, G_OPTION_ARG_STRING_ARRAY, &pattern_args, "Search for PATTERN; can be given several times", "PATTERN"},
+    {"file", 'f', 0, G_OPTION_ARG_FILENAME, &pattern_file, "Search for the patterns in FILE, one per line", "FILE"},
+    {"ignore-case", 'i', 0, G_OPTION_ARG_NONE, &ignore_case, "Ignore the case of ASCII letters"},
+    {"kind", 'k', 0, G_OPTION_ARG_STRING, &kind_name, "Only search constants used as KIND (string, class, member, descriptor or other)", "KIND"},
+    {"classes", 'l', 0, G_OPTION_ARG_NONE, &list_classes, "Only print the container and name of each matching class"},
+    {"json", 'j', 0, G_OPTION_ARG_NONE, &json, "Print one JSON object per line and match"},
+    {"threads", 't', 0, G_OPTION_ARG_INT, &threads, "Number of threads reading JARs (default: number of CPUs)", "N"},
+    {NULL}
+};
+
+/*
+ * State of one thread of the pool which is reused for all its classes
+ */
+typedef struct {
+    ClassScan scan;
+    guint8 *kinds;              // KIND_* of each constant pool entry
+    guint kinds_capacity;
+    GString *out;
+} GrepState;
+
+static void free_grep_state(gpointer data);
+
+static GPrivate state_key = G_PRIVATE_INIT(free_grep_state);
+
+AhoCorasick *matcher = NULL;
+GPtrArray *patterns = NULL;
+int kind_filter = -1;
+
+GMutex output_lock;
+gboolean found = FALSE;
+
+void usage(gchar *errormsg, GOptionContext *context)
+{
+    if (errormsg != NULL) fprintf(stderr, "ERROR: %s\n", errormsg);
+    fprintf(stderr, "%s", g_option_context_get_help(context, TRUE, NULL));
+
+    exit(2);
+}
+
+static void free_grep_state(gpointer data)
+{
+    GrepState *state = (GrepState*) data;
+
+    classscan_clear(&state->scan);
+    g_free(state->kinds);
+    g_string_free(state->out, TRUE);
+    g_free(state);
+}
+
+/*
+ * Return the GrepState of the calling thread
+ */
+GrepState *get_state()
+{
+    GrepState *state = g_private_get(&state_key);
+
+    if (state == NULL) {
+        state = g_new0(GrepState, 1);
+        state->out = g_string_sized_new(4096);
+        g_private_set(&state_key, state);
+    }
+
+    return state;
+}
+
+/*
+ * Add a pattern to the matcher
+ *
+ * Class names are stored with slashes in the constant pool, so a pattern
+ * with dots also matches the internal form, e.g. java.util.Date finds
+ * java/util/Date as well as string literals for Class.forName().
+ */
+void add_pattern(const gchar *pattern)
+{
+    guint id = patterns->len;
+
+    g_ptr_array_add(patterns, g_strdup(pattern));
+    ahocorasick_add(matcher, pattern, strlen(pattern), id);
+
+    if (strchr(pattern, '.') != NULL) {
+        gchar *internal = g_strdup(pattern);
+
+        g_strdelimit(internal, ".", '/');
+        ahocorasick_add(matcher, internal, strlen(internal), id);
+        g_free(internal);
+    }
+}
+
+/*
+ * Read the patterns of --file, one per line; empty lines are skipped
+ */
+void read_pattern_file(const gchar *filename)
+{
+    gchar *contents = NULL;
+    GError *error = NULL;
+
+    if (!g_file_get_contents(filename, &contents, NULL, &error)) {
+        fprintf(stderr, "ERROR: %s\n", error->message);
+        exit(2);
+    }
+
+    gchar **lines = g_strsplit(contents, "\n", 0);
+
+    for (int i = 0; lines[i] != NULL; i++) {
+        g_strchomp(lines[i]);
+        if (lines[i][0] != '\0') add_pattern(lines[i]);
+    }
+
+    g_strfreev(lines);
+    g_free(contents);
+}
+
+static void set_kind(GrepState *state, guint16 index, guint8 kind)
+{
+    if (index < state->scan.constant_pool_count
+            && state->kinds[index] == KIND_OTHER) {
+        state->kinds[index] = kind;
+    }
+}
+
+/*
+ * Record how each CONSTANT_Utf8 entry of a class is used; an entry which
+ * is used in several ways keeps the first one
+ */
+void classify_constants(GrepState *state)
+{
+    ClassScan *scan = &state->scan;
+    guint16 count = scan->constant_pool_count;
+
+    if (state->kinds_capacity < count) {
+        state->kinds_capacity = count;
+        state->kinds = g_renew(guint8, state->kinds, count);
+    }
+
+    memset(state->kinds, KIND_OTHER, count);
+
+    for (guint16 i = 1; i < count; i++) {
+        const guchar *entry = NULL;
+
+        switch (classscan_tag(scan, i)) {
+            case CONSTANT_String:
+                entry = scan->data + scan->constant_pool[i];
+                set_kind(state, classscan_u2(entry + 1), KIND_STRING);
+                break;
+            case CONSTANT_Class:
+                entry = scan->data + scan->constant_pool[i];
+                set_kind(state, classscan_u2(entry + 1), KIND_CLASS);
+                break;
+            case CONSTANT_NameAndType:
+                entry = scan->data + scan->constant_pool[i];
+                set_kind(state, classscan_u2(entry + 1), KIND_MEMBER);
+                set_kind(state, classscan_u2(entry + 3), KIND_DESCRIPTOR);
+                break;
+            case CONSTANT_MethodType:
+                entry = scan->data + scan->constant_pool[i];
+                set_kind(state, classscan_u2(entry + 1), KIND_DESCRIPTOR);
+                break;
+        }
+    }
+
+    // the fields and methods declared by the class itself
+    gsize member = scan->fields_start;
+    guint members = scan->fields_count + scan->methods_count;
+
+    for (guint i = 0; i < members && member != 0; i++) {
+        if (i == scan->fields_count) member = scan->methods_start;
+
+        const guchar *p = scan->data + member;
+
+        set_kind(state, classscan_u2(p + 2), KIND_MEMBER);
+        set_kind(state, classscan_u2(p + 4), KIND_DESCRIPTOR);
+
+        member = classscan_next_member(scan, member);
+    }
+}
+
+/*
+ * Append a constant to the text output with tabs, newlines and
+ * backslashes escaped so that each match stays on one line
+ */
+void append_escaped(GString *out, const guchar *str, guint16 length)
+{
+    for (guint16 i = 0; i < length; i++) {
+        switch (str[i]) {
+            case '\\': g_string_append(out, "\\\\"); break;
+            case '\n': g_string_append(out, "\\n"); break;
+            case '\r': g_string_append(out, "\\r"); break;
+            case '\t': g_string_append(out, "\\t"); break;
+            default: g_string_append_c(out, str[i]);
+        }
+    }
+}
+
+gboolean first_match(guint id, gsize end, gpointer user_data)
+{
+    *(guint*) user_data = id;
+
+    return FALSE;
+}
+
+/*
+ * Search the CONSTANT_Utf8 entries of one class; nothing but the constant
+ * pool and the member tables is looked at
+ */
+void grep_class(const gchar *container, const gchar *name, guchar *bytes,
+        gsize size, gpointer user_data)
+{
+    GrepState *state = get_state();
+    ClassScan *scan = &state->scan;
+    gchar *classname = NULL;
+
+    // loose class files are their own container
+    if (container == NULL) container = name;
+
+    if (!classscan_init(scan, bytes, size)) {
+        g_mutex_lock(&output_lock);
+        fprintf(stderr, "Failed to read the class file %s\n", name);
+        g_mutex_unlock(&output_lock);
+
+        g_free(bytes);
+        return;
+    }
+
+    classify_constants(state);
+    g_string_truncate(state->out, 0);
+
+    for (guint16 i = 1; i < scan->constant_pool_count; i++) {
+        guint16 length = 0;
+        guint id = 0;
+
+        if (kind_filter >= 0 && state->kinds[i] != kind_filter) continue;
+
+        const guchar *utf8 = classscan_utf8(scan, i, &length);
+        if (utf8 == NULL) continue;
+
+        if (!ahocorasick_search(matcher, utf8, length, first_match, &id)) {
+            continue;
+        }
+
+        if (classname == NULL) {
+            classname = classscan_class_name(scan, scan->this_class);
+            if (classname == NULL) classname = g_strdup(name);
+            g_strdelimit(classname, "/", '.');
+        }
+
+        if (list_classes) break;
+
+        if (json) {
+            gchar *constant = g_strndup((const gchar*) utf8, length);
+
+            g_string_append(state->out, "{\"container\":");
+            json_append_string(state->out, container);
+            g_string_append(state->out, ",\"class\":");
+            json_append_string(state->out, classname);
+            g_string_append(state->out, ",\"kind\":");
+            json_append_string(state->out, KINDS[state->kinds[i]]);
+            g_string_append(state->out, ",\"constant\":");
+            json_append_string(state->out, constant);
+            g_string_append(state->out, ",\"pattern\":");
+            json_append_string(state->out, g_ptr_array_index(patterns, id));
+            g_string_append(state->out, "}\n");
+
+            g_free(constant);
+        } else {
+            g_string_append_printf(state->out, "%s\t%s\t%s\t", container,
+                    classname, KINDS[state->kinds[i]]);
+            append_escaped(state->out, utf8, length);
+            g_string_append_c(state->out, '\n');
+        }
+    }
+
+    if (classname != NULL && list_classes) {
+        if (json) {
+            g_string_append(state->out, "{\"container\":");
+            json_append_string(state->out, container);
+            g_string_append(state->out, ",\"class\":");
+            json_append_string(state->out, classname);
+            g_string_append(state->out, "}\n");
+        } else {
+            g_string_append_printf(state->out, "%s\t%s\n", container,
+                    classname);
+        }
+    }
+
+    // write the whole class at once so that the output of the threads
+    // isn't interleaved
+    if (classname != NULL) {
+        g_mutex_lock(&output_lock);
+        fwrite(state->out->str, 1, state->out->len, stdout);
+        found = TRUE;
+        g_mutex_unlock(&output_lock);
+    }
+
+    g_free(classname);
+    g_free(bytes);
+}
+
+/*
+ * Search all classes of a JAR or class file; runs in the threads of the
+ * pool so that inflating is done in parallel, too
+ */
+void grep_container(gpointer data, gpointer user_data)
+{
+    gchar *path = (gchar*) data;
+
+    classwalk_path(path, FALSE, grep_class, NULL);
+
+    g_free(path);
+}
+
+int main(int argc, char** argv)
+{
+    GError *error = NULL;
+    GOptionContext *context;
+    GThreadPool *pool = NULL;
+    GPtrArray *containers = NULL;
+    gchar **paths = NULL;
+    int first_path = 1;
+
+    context = g_option_context_new(
+            "[PATTERN] [PATH...] - Find classes whose constant pool contains "
+            "a string");
+    g_option_context_add_main_entries(context, options, NULL);
+
+    if (!g_option_context_parse(context, &argc, &argv, &error)) {
+        usage(error->message, context);
+    }
+
+    if (kind_name != NULL) {
+        for (int i = 0; i < KIND_NUM; i++) {
+            if (g_strcmp0(kind_name, KINDS[i]) == 0) kind_filter = i;
+        }
+
+        if (kind_filter < 0) usage("Unknown kind of constant", context);
+    }
+
+    matcher = ahocorasick_new(ignore_case);
+    patterns = g_ptr_array_new_with_free_func(g_free);
+
+    for (int i = 0; pattern_args != NULL && pattern_args[i] != NULL; i++) {
+        if (pattern_args[i][0] == '\0') usage("Empty pattern", context);
+        add_pattern(pattern_args[i]);
+    }
+
+    if (pattern_file != NULL) read_pattern_file(pattern_file);
+
+    // like grep the first argument is the pattern unless -e or -f is used
+    if (pattern_args == NULL && pattern_file == NULL) {
+        if (argc < 2) usage(NULL, context);
+        if (argv[1][0] == '\0') usage("Empty pattern", context);
+
+        add_pattern(argv[1]);
+        first_path = 2;
+    }
+
+    if (patterns->len == 0) usage("No patterns", context);
+
+    ahocorasick_compile(matcher);
+
+    // without paths the class path is searched
+    if (first_path < argc) {
+        paths = g_strdupv(argv + first_path);
+    } else if (g_getenv("CLASSPATH") != NULL) {
+        paths = g_strsplit(g_getenv("CLASSPATH"), G_SEARCHPATH_SEPARATOR_S, 0);
+    } else {
+        usage("No paths given and CLASSPATH is not set", context);
+    }
+
+    if (threads <= 0) threads = g_get_num_processors();
+
+    g_mutex_init(&output_lock);
+
+    pool = g_thread_pool_new(grep_container, NULL, threads, TRUE, &error);
+
+    if (pool == NULL) {
+        fprintf(stderr, "ERROR: %s\n", error->message);
+        return 2;
+    }
+
+    containers = g_ptr_array_new();
+
+    for (int i = 0; paths[i] != NULL; i++) {
+        if (paths[i][0] == '\0') continue;
+
+        if (!g_file_test(paths[i], G_FILE_TEST_EXISTS)) {
+            fprintf(stderr, "Failed to open file '%s'\n", paths[i]);
+            continue;
+        }
+
+        classwalk_list(paths[i], containers);
+    }
+
+    for (guint i = 0; i < containers->len; i++) {
+        g_thread_pool_push(pool, g_ptr_array_index(containers, i), NULL);
+    }
+
+    // wait until all containers are searched
+    g_thread_pool_free(pool, FALSE, TRUE);
+
+    g_ptr_array_free(containers, TRUE);
+    g_ptr_array_free(patterns, TRUE);
+    ahocorasick_free(matcher);
+    g_strfreev(paths);
+
+    return found ? 0 : 1;
+}
@@ -24,11 +24,30 @@ OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
 
 #include <sys/types.h>
 #include <sys/stat.h>
+#include <sys/wait.h>
 #include <unistd.h>
 
 #include <global.h>
+#include <accessflags.h>
+#include <symtab.h>
+#include <summary.h>
+#include <schema.h>
+#include <readahead.h>
+#include <classscan.h>
+#include <nestedjar.h>
+#include <annotations.h>
+#include <bytecode.h>
+#include <services.h>
+#include <priority.h>
+#include <repository.h>
+#include <sink.h>
+#include <trace.h>
 #include <classreader/javaclass.h>
 
+// directory of the versioned entries of multi-release JARs
+#define VERSIONS_DIR "META-INF/versions/"
+#define MODULE_INFO "module-info.class"
+
 const gchar *DDL = "CREATE TABLE namespaces ("
     "    id INTEGER NOT NULL PRIMARY KEY AUTOINCREMENT,"
     "    name VARCHAR NOT NULL"
@@ -37,49 +56,177 @@ const gchar *DDL = "CREATE TABLE namespaces ("
     "    id INTEGER NOT NULL PRIMARY KEY AUTOINCREMENT,"
     "    name VARCHAR NOT NULL"
     ");"
-    "CREATE TABLE importables_namespaces ("
+    "CREATE TABLE descriptors ("
+    "    id INTEGER NOT NULL PRIMARY KEY AUTOINCREMENT,"
+    "    name VARCHAR NOT NULL"
+    ");"
+    "CREATE TABLE signatures ("
+    "    id INTEGER NOT NULL PRIMARY KEY AUTOINCREMENT,"
+    "    name VARCHAR NOT NULL"
+    ");"
+    "CREATE TABLE files ("
+    "    id INTEGER NOT NULL PRIMARY KEY AUTOINCREMENT,"
+    "    path VARCHAR,"
+    "    filename VARCHAR"
+    ");"
+    // the JARs and directories the classes were read from in the order in
+    // which they were indexed
+    "CREATE TABLE containers ("
+    "    id INTEGER NOT NULL PRIMARY KEY,"
+    "    path VARCHAR NOT NULL,"
+    "    complete BOOLEAN NOT NULL DEFAULT 0"
+    ");"
+    // compressed records of whole classes written with --summaries; they
+    // are looked up by the fully qualified class name alone
+    "CREATE TABLE class_summaries ("
+    "    name VARCHAR NOT NULL PRIMARY KEY,"
+    "    importable_id INTEGER,"
+    "    namespace_id INTEGER,"
+    "    size INTEGER NOT NULL,"
+    "    summary BLOB NOT NULL"
+    ") WITHOUT ROWID;"
+    // classes which were found again in a container that is read later
+    // and ignored because the first one wins
+    "CREATE TABLE shadowed_classes ("
+    "    importable_id INTEGER NOT NULL,"
+    "    namespace_id INTEGER NOT NULL,"
+    "    container_id INTEGER NOT NULL,"
+    "    PRIMARY KEY (importable_id, namespace_id, container_id)"
+    ") WITHOUT ROWID;"
+    // the annotations of classes, fields and methods; the type of an
+    // annotation is an importable like the classes themselves and target
+    // is one of ANNOTATION_TARGET_*
+    "CREATE TABLE annotations ("
+    "    id INTEGER NOT NULL PRIMARY KEY AUTOINCREMENT,"
+    "    type_importable_id INTEGER NOT NULL,"
+    "    type_namespace_id INTEGER NOT NULL,"
+    "    importable_id INTEGER NOT NULL,"
+    "    namespace_id INTEGER NOT NULL,"
+    "    target INTEGER NOT NULL,"
+    "    member_name VARCHAR,"
+    "    descriptor_id INTEGER,"
+    "    visible BOOLEAN NOT NULL"
+    ");"
+    // the simple element values of the annotations; arrays have one row
+    // per element
+    "CREATE TABLE annotation_values ("
+    "    annotation_id INTEGER NOT NULL,"
+    "    name VARCHAR NOT NULL,"
+    "    value VARCHAR"
+    ");"
+    // the implementations of services registered in META-INF/services,
+    // spring.factories or META-INF/spring/*.imports; kind is one of
+    // SERVICES_*
+    "CREATE TABLE services ("
+    "    service_importable_id INTEGER NOT NULL,"
+    "    service_namespace_id INTEGER NOT NULL,"
+    "    provider_importable_id INTEGER NOT NULL,"
+    "    provider_namespace_id INTEGER NOT NULL,"
+    "    kind INTEGER NOT NULL,"
+    "    container_id INTEGER"
+    ");"
+    // the module descriptors (module-info.class) of the containers with
+    // the access_flags of their Module attribute
+    "CREATE TABLE modules ("
+    "    id INTEGER NOT NULL PRIMARY KEY AUTOINCREMENT,"
+    "    name VARCHAR NOT NULL,"
+    "    version VARCHAR,"
+    "    access_flags INTEGER NOT NULL,"
+    "    container_id INTEGER"
+    ");"
+    "CREATE TABLE module_requires ("
+    "    module_id INTEGER NOT NULL,"
+    "    name VARCHAR NOT NULL,"
+    "    version VARCHAR,"
+    "    access_flags INTEGER NOT NULL"
+    ");"
+    // target is NULL unless the package is only exported to some modules
+    "CREATE TABLE module_exports ("
+    "    module_id INTEGER NOT NULL,"
+    "    package VARCHAR NOT NULL,"
+    "    target VARCHAR,"
+    "    access_flags INTEGER NOT NULL"
+    ");"
+    // the base index an overlay index was built on with --base-dir
+    "CREATE TABLE layers ("
+    "    id INTEGER NOT NULL PRIMARY KEY,"
+    "    path VARCHAR NOT NULL"
+    ");"
+    // the state of the index is "indexing" until it is "complete"
+    "CREATE TABLE metadata ("
+    "    name VARCHAR NOT NULL PRIMARY KEY,"
+    "    value VARCHAR"
+    ");"
+    "INSERT INTO metadata (name, value) VALUES ('state', 'indexing');"
+    "";
+
+const gchar *ARTIFACTS_DDL = ""
+    // the artifacts of the Maven repositories and Gradle caches indexed
+    // with --repository; the IDs of the versions of an artifact are
+    // consecutive in ascending version order
+    "CREATE TABLE artifacts ("
+    "    id INTEGER NOT NULL PRIMARY KEY,"
+    "    group_id VARCHAR NOT NULL,"
+    "    artifact_id VARCHAR NOT NULL"
+    ");"
+    "CREATE TABLE artifact_versions ("
+    "    id INTEGER NOT NULL PRIMARY KEY,"
+    "    artifact_id INTEGER NOT NULL,"
+    "    version VARCHAR NOT NULL,"
+    "    path VARCHAR NOT NULL"
+    ");"
+    // a class is in all versions from first_version_id to last_version_id
+    "CREATE TABLE artifact_classes ("
+    "    importable_id INTEGER NOT NULL,"
+    "    namespace_id INTEGER NOT NULL,"
+    "    first_version_id INTEGER NOT NULL,"
+    "    last_version_id INTEGER NOT NULL,"
+    "    PRIMARY KEY (importable_id, namespace_id, first_version_id)"
+    ") WITHOUT ROWID;"
+    "";
+
+/*
+ * The tables of the classes and their members
+ *
+ * They are replaced by CLUSTERED_CLASS_TABLES with --clustered. The IDs of
+ * fields and methods are assigned by the indexer in both cases.
+ */
+const gchar *CLASS_TABLES = ""
+    "CREATE TABLE importables_namespaces_data ("
     "    importable_id INTEGER,"
     "    namespace_id INTEGER,"
     "    parent_importable_id INTEGER,"
     "    parent_namespace_id INTEGER,"
     "    done BOOLEAN,"
-    "    ispublic BOOLEAN,"
-    "    isfinal BOOLEAN,"
-    "    isinterface BOOLEAN,"
-    "    isabstract BOOLEAN,"
-    "    isannotation BOOLEAN,"
-    "    isenum BOOLEAN,"
+    "    access_flags INTEGER,"
     "    signature VARCHAR,"
+    "    container_id INTEGER,"
     "    PRIMARY KEY (importable_id, namespace_id)"
     ");"
-    "CREATE TABLE fields ("
+    "CREATE TABLE fields_data ("
     "    id INTEGER NOT NULL PRIMARY KEY AUTOINCREMENT,"
     "    name VARCHAR NOT NULL,"
-    "    descriptor VARCHAR NOT NULL,"
-    "    signature VARCHAR,"
+    "    descriptor_id INTEGER NOT NULL,"
+    "    signature_id INTEGER,"
     "    importable_id INTEGER,"
     "    namespace_id INTEGER,"
-    "    ispublic BOOLEAN,"
-    "    isprotected BOOLEAN,"
-    "    isprivate BOOLEAN,"
-    "    isstatic BOOLEAN,"
-    "    isfinal BOOLEAN,"
-    "    isenum BOOLEAN"
+    "    access_flags INTEGER NOT NULL"
     ");"
-    "CREATE TABLE methods ("
+    // the figures of the Code attribute are NULL for abstract and native
+    // methods
+    "CREATE TABLE methods_data ("
     "    id INTEGER NOT NULL PRIMARY KEY AUTOINCREMENT,"
     "    name VARCHAR NOT NULL,"
-    "    descriptor VARCHAR NOT NULL,"
-    "    signature VARCHAR,"
+    "    descriptor_id INTEGER NOT NULL,"
+    "    signature_id INTEGER,"
     "    importable_id INTEGER,"
     "    namespace_id INTEGER,"
-    "    ispublic BOOLEAN,"
-    "    isprotected BOOLEAN,"
-    "    isprivate BOOLEAN,"
-    "    isstatic BOOLEAN,"
-    "    isfinal BOOLEAN,"
-    "    issynchronized BOOLEAN,"
-    "    isabstract BOOLEAN"
+    "    access_flags INTEGER NOT NULL,"
+    "    code_length INTEGER,"
+    "    max_stack INTEGER,"
+    "    max_locals INTEGER,"
+    "    exception_handlers INTEGER,"
+    "    invocations INTEGER"
     ");"
     "CREATE TABLE interfaces ("
     "    importable_id INTEGER,"
@@ -95,29 +242,566 @@ const gchar *DDL = "CREATE TABLE namespaces ("
     "    namespace_id INTEGER,"
     "    PRIMARY KEY (method_id, importable_id, namespace_id)"
     ");"
-    "CREATE TABLE files ("
-    "    id INTEGER NOT NULL PRIMARY KEY AUTOINCREMENT,"
-    "    path VARCHAR,"
-    "    filename VARCHAR"
-    ");"
     "";
 
-const gchar *INDEXES = "CREATE UNIQUE INDEX IDX_UNIQUE_NAMESPACES "
-    "ON namespaces (name);"
-    "CREATE UNIQUE INDEX IDX_IMPORTABLES ON importables (name);"
-    "CREATE UNIQUE INDEX IDX_UNIQUE_FIELDS ON fields"
+/*
+ * The tables of the classes and their members as WITHOUT ROWID tables
+ * clustered by class for --clustered
+ *
+ * The primary keys start with the class, so the members of a class are
+ * stored together. The rows are inserted in the order the classes are
+ * indexed, not in key order; see the README for why they aren't sorted
+ * first. Fields and methods keep the IDs of the indexer, which only break
+ * ties within a class.
+ */
+const gchar *CLUSTERED_CLASS_TABLES = ""
+    "CREATE TABLE importables_namespaces_data ("
+    "    importable_id INTEGER,"
+    "    namespace_id INTEGER,"
+    "    parent_importable_id INTEGER,"
+    "    parent_namespace_id INTEGER,"
+    "    done BOOLEAN,"
+    "    access_flags INTEGER,"
+    "    signature VARCHAR,"
+    "    container_id INTEGER,"
+    "    PRIMARY KEY (importable_id, namespace_id)"
+    ") WITHOUT ROWID;"
+    "CREATE TABLE fields_data ("
+    "    id INTEGER NOT NULL,"
+    "    name VARCHAR NOT NULL,"
+    "    descriptor_id INTEGER NOT NULL,"
+    "    signature_id INTEGER,"
+    "    importable_id INTEGER,"
+    "    namespace_id INTEGER,"
+    "    access_flags INTEGER NOT NULL,"
+    "    PRIMARY KEY (importable_id, namespace_id, id)"
+    ") WITHOUT ROWID;"
+    "CREATE TABLE methods_data ("
+    "    id INTEGER NOT NULL,"
+    "    name VARCHAR NOT NULL,"
+    "    descriptor_id INTEGER NOT NULL,"
+    "    signature_id INTEGER,"
+    "    importable_id INTEGER,"
+    "    namespace_id INTEGER,"
+    "    access_flags INTEGER NOT NULL,"
+    "    code_length INTEGER,"
+    "    max_stack INTEGER,"
+    "    max_locals INTEGER,"
+    "    exception_handlers INTEGER,"
+    "    invocations INTEGER,"
+    "    PRIMARY KEY (importable_id, namespace_id, id)"
+    ") WITHOUT ROWID;"
+    // the exceptions of a method are joined by its ID, which isn't the key
+    // of the table
+    "CREATE UNIQUE INDEX IDX_METHODS_ID ON methods_data (id);"
+    "CREATE TABLE interfaces ("
+    "    importable_id INTEGER,"
+    "    namespace_id INTEGER,"
+    "    interface_importable_id INTEGER,"
+    "    interface_namespace_id INTEGER,"
+    "    PRIMARY KEY (importable_id, namespace_id, interface_importable_id, "
+    "    interface_namespace_id)"
+    ") WITHOUT ROWID;"
+    "CREATE TABLE exceptions ("
+    "    method_id INTEGER,"
+    "    importable_id INTEGER,"
+    "    namespace_id INTEGER,"
+    "    PRIMARY KEY (method_id, importable_id, namespace_id)"
+    ") WITHOUT ROWID;"
+    "";
+
+// with --max-memory these are created up front for the lookups of strings
+// which were dropped from memory
+const gchar *NAME_INDEXES = "CREATE UNIQUE INDEX IF NOT EXISTS "
+    "    IDX_UNIQUE_NAMESPACES ON namespaces (name);"
+    "CREATE UNIQUE INDEX IF NOT EXISTS IDX_IMPORTABLES ON importables (name);"
+    "CREATE UNIQUE INDEX IF NOT EXISTS IDX_UNIQUE_DESCRIPTORS "
+    "    ON descriptors (name);"
+    "CREATE UNIQUE INDEX IF NOT EXISTS IDX_UNIQUE_SIGNATURES "
+    "    ON signatures (name);"
+    "";
+
+const gchar *INDEXES = ""
+    "CREATE UNIQUE INDEX IF NOT EXISTS IDX_UNIQUE_FIELDS ON fields_data"
     "    (name, importable_id, namespace_id);"
-    "CREATE UNIQUE INDEX IDX_UNIQUE_METHODS ON methods "
-    "    (name, signature, importable_id, namespace_id);"
+    "CREATE UNIQUE INDEX IF NOT EXISTS IDX_UNIQUE_METHODS ON methods_data "
+    "    (name, signature_id, importable_id, namespace_id);"
+    // covering indexes for queries filtering by a mask of access flags: the
+    // few distinct flag combinations are scanned in the small index instead
+    // of the whole table
+    "CREATE INDEX IF NOT EXISTS IDX_CLASSES_FLAGS ON importables_namespaces_data "
+    "    (access_flags, importable_id, namespace_id);"
+    "CREATE INDEX IF NOT EXISTS IDX_FIELDS_FLAGS ON fields_data "
+    "    (access_flags, importable_id, namespace_id);"
+    "CREATE INDEX IF NOT EXISTS IDX_METHODS_FLAGS ON methods_data "
+    "    (access_flags, importable_id, namespace_id);"
+    "CREATE INDEX IF NOT EXISTS IDX_ANNOTATIONS_TYPE ON annotations "
+    "    (type_importable_id, type_namespace_id);"
+    "CREATE INDEX IF NOT EXISTS IDX_ANNOTATION_VALUES ON annotation_values "
+    "    (annotation_id);"
+    "CREATE INDEX IF NOT EXISTS IDX_MODULES_NAME ON modules (name);"
+    "CREATE INDEX IF NOT EXISTS IDX_MODULE_REQUIRES ON module_requires "
+    "    (module_id);"
+    "CREATE INDEX IF NOT EXISTS IDX_MODULE_EXPORTS ON module_exports "
+    "    (module_id);"
+    "CREATE INDEX IF NOT EXISTS IDX_SERVICES ON services "
+    "    (service_importable_id, service_namespace_id);"
+    "";
+
+/*
+ * Statements removing everything which was indexed from the containers
+ * that weren't completed before an interrupted run
+ *
+ * Classes which were only referenced before they were indexed become
+ * references again.
+ */
+const gchar *RESUME_CLEANUP = ""
+    "CREATE TEMP TABLE resumed_classes AS"
+    "    SELECT importable_id, namespace_id FROM importables_namespaces_data"
+    "    WHERE container_id IN (SELECT id FROM containers WHERE NOT complete);"
+    "DELETE FROM exceptions WHERE method_id IN (SELECT m.id"
+    "    FROM methods_data m JOIN temp.resumed_classes r"
+    "    ON r.importable_id = m.importable_id"
+    "    AND r.namespace_id = m.namespace_id);"
+    "DELETE FROM methods_data WHERE EXISTS (SELECT 1"
+    "    FROM temp.resumed_classes r"
+    "    WHERE r.importable_id = methods_data.importable_id"
+    "    AND r.namespace_id = methods_data.namespace_id);"
+    "DELETE FROM fields_data WHERE EXISTS (SELECT 1"
+    "    FROM temp.resumed_classes r"
+    "    WHERE r.importable_id = fields_data.importable_id"
+    "    AND r.namespace_id = fields_data.namespace_id);"
+    "DELETE FROM interfaces WHERE EXISTS (SELECT 1"
+    "    FROM temp.resumed_classes r"
+    "    WHERE r.importable_id = interfaces.importable_id"
+    "    AND r.namespace_id = interfaces.namespace_id);"
+    "DELETE FROM class_summaries WHERE EXISTS (SELECT 1"
+    "    FROM temp.resumed_classes r"
+    "    WHERE r.importable_id = class_summaries.importable_id"
+    "    AND r.namespace_id = class_summaries.namespace_id);"
+    "DELETE FROM annotation_values WHERE annotation_id IN (SELECT a.id"
+    "    FROM annotations a JOIN temp.resumed_classes r"
+    "    ON r.importable_id = a.importable_id"
+    "    AND r.namespace_id = a.namespace_id);"
+    "DELETE FROM annotations WHERE EXISTS (SELECT 1"
+    "    FROM temp.resumed_classes r"
+    "    WHERE r.importable_id = annotations.importable_id"
+    "    AND r.namespace_id = annotations.namespace_id);"
+    "DELETE FROM shadowed_classes"
+    "    WHERE container_id IN (SELECT id FROM containers WHERE NOT complete);"
+    "DELETE FROM module_requires WHERE module_id IN (SELECT m.id"
+    "    FROM modules m JOIN containers c ON c.id = m.container_id"
+    "    WHERE NOT c.complete);"
+    "DELETE FROM module_exports WHERE module_id IN (SELECT m.id"
+    "    FROM modules m JOIN containers c ON c.id = m.container_id"
+    "    WHERE NOT c.complete);"
+    "DELETE FROM modules"
+    "    WHERE container_id IN (SELECT id FROM containers WHERE NOT complete);"
+    "DELETE FROM services"
+    "    WHERE container_id IN (SELECT id FROM containers WHERE NOT complete);"
+    "UPDATE importables_namespaces_data SET done = 0,"
+    "    parent_importable_id = NULL, parent_namespace_id = NULL,"
+    "    access_flags = NULL, signature = NULL, container_id = NULL"
+    "    WHERE container_id IN (SELECT id FROM containers WHERE NOT complete);"
+    // only the project directory lists its files
+    "DELETE FROM files WHERE EXISTS (SELECT 1 FROM containers"
+    "    WHERE path = '.' AND NOT complete);"
+    "DELETE FROM containers WHERE NOT complete;"
+    "DROP TABLE temp.resumed_classes;"
+    "";
+
+/*
+ * Statements seeding an overlay index with the base index attached as "base"
+ *
+ * All names of the base are copied so that the overlay assigns the same IDs
+ * and continues the IDs of the members, so both can be queried together
+ * without mapping any IDs.
+ */
+const gchar *SEED_OVERLAY = ""
+    "INSERT INTO main.namespaces SELECT id, name FROM base.namespaces;"
+    "INSERT INTO main.importables SELECT id, name FROM base.importables;"
+    "INSERT INTO main.descriptors SELECT id, name FROM base.descriptors;"
+    "INSERT INTO main.signatures SELECT id, name FROM base.signatures;"
+    "INSERT INTO main.containers (id, path, complete) "
+    "    SELECT id, path, complete FROM base.containers;"
+    "INSERT INTO main.sqlite_sequence (name, seq) "
+    "    SELECT 'fields_data', COALESCE(MAX(id), 0) FROM base.fields_data;"
+    "INSERT INTO main.sqlite_sequence (name, seq) "
+    "    SELECT 'methods_data', COALESCE(MAX(id), 0) FROM base.methods_data;"
+    "INSERT INTO main.sqlite_sequence (name, seq) "
+    "    SELECT 'modules', COALESCE(MAX(id), 0) FROM base.modules;"
+    "INSERT INTO main.sqlite_sequence (name, seq) "
+    "    SELECT 'annotations', COALESCE(MAX(id), 0) FROM base.annotations;"
+    "";
+
+/*
+ * Statements merging the shard databases of --jobs into the index
+ *
+ * The shard which is merged is attached as "shard" and its number is bound
+ * to ?1. The IDs of the shards are mapped to the IDs of the index by the
+ * map_* tables which are filled per string table by MERGE_STRINGS.
+ */
+const gchar *MERGE_DDL = ""
+    "CREATE TEMP TABLE shard_classes ("
+    "    id INTEGER PRIMARY KEY,"
+    "    shard INTEGER,"
+    "    importable_id INTEGER,"
+    "    namespace_id INTEGER,"
+    "    parent_importable_id INTEGER,"
+    "    parent_namespace_id INTEGER,"
+    "    done BOOLEAN,"
+    "    access_flags INTEGER,"
+    "    signature VARCHAR,"
+    "    container_id INTEGER"
+    ");"
+    // the row of shard_classes which is used for each class: a class which
+    // was found in several shards is taken from the container which comes
+    // first on the class path like the sequential indexer would do
+    "CREATE TEMP TABLE winners ("
+    "    importable_id INTEGER,"
+    "    namespace_id INTEGER,"
+    "    class_id INTEGER,"
+    "    shard INTEGER,"
+    "    PRIMARY KEY (importable_id, namespace_id)"
+    ") WITHOUT ROWID;"
     "";
 
+// %s is replaced by the name of the string table
+const gchar *MERGE_STRINGS[] = {
+    "CREATE TEMP TABLE IF NOT EXISTS map_%s ("
+    "    shard INTEGER,"
+    "    old_id INTEGER,"
+    "    new_id INTEGER,"
+    "    PRIMARY KEY (shard, old_id)"
+    ") WITHOUT ROWID",
+    "INSERT OR IGNORE INTO main.%s (name) "
+    "    SELECT name FROM shard.%s ORDER BY id",
+    "INSERT INTO temp.map_%s (shard, old_id, new_id) "
+    "    SELECT ?1, s.id, m.id FROM shard.%s s "
+    "    JOIN main.%s m ON m.name = s.name",
+    NULL
+};
+
+const gchar *MERGE_CLASSES[] = {
+    "INSERT INTO temp.shard_classes (shard, importable_id, namespace_id, "
+    "    parent_importable_id, parent_namespace_id, done, access_flags, "
+    "    signature, container_id) "
+    "    SELECT ?1, i.new_id, n.new_id,"
+    "    CASE WHEN c.parent_importable_id IS NULL THEN NULL "
+    "        ELSE COALESCE(pi.new_id, 0) END,"
+    "    CASE WHEN c.parent_namespace_id IS NULL THEN NULL "
+    "        ELSE COALESCE(pn.new_id, 0) END,"
+    "    c.done, c.access_flags, c.signature, c.container_id "
+    "    FROM shard.importables_namespaces_data c "
+    "    JOIN temp.map_importables i ON i.shard = ?1 "
+    "        AND i.old_id = c.importable_id "
+    "    JOIN temp.map_namespaces n ON n.shard = ?1 "
+    "        AND n.old_id = c.namespace_id "
+    "    LEFT JOIN temp.map_importables pi ON pi.shard = ?1 "
+    "        AND pi.old_id = c.parent_importable_id "
+    "    LEFT JOIN temp.map_namespaces pn ON pn.shard = ?1 "
+    "        AND pn.old_id = c.parent_namespace_id",
+    NULL
+};
+
+const gchar *MERGE_WINNERS[] = {
+    "INSERT OR IGNORE INTO temp.winners "
+    "    SELECT importable_id, namespace_id, id, shard "
+    "    FROM temp.shard_classes "
+    "    ORDER BY done DESC, container_id ASC, id ASC",
+    "INSERT INTO main.importables_namespaces_data (importable_id, "
+    "    namespace_id, parent_importable_id, parent_namespace_id, done, "
+    "    access_flags, signature, container_id) "
+    "    SELECT c.importable_id, c.namespace_id, c.parent_importable_id,"
+    "    c.parent_namespace_id, c.done, c.access_flags, c.signature,"
+    "    c.container_id "
+    "    FROM temp.winners w JOIN temp.shard_classes c ON c.id = w.class_id "
+    "    ORDER BY c.id",
+    // the classes which lost against a class of another shard
+    "INSERT OR IGNORE INTO main.shadowed_classes "
+    "    SELECT c.importable_id, c.namespace_id, c.container_id "
+    "    FROM temp.shard_classes c JOIN temp.winners w "
+    "    ON w.importable_id = c.importable_id "
+    "    AND w.namespace_id = c.namespace_id "
+    "    WHERE c.done AND c.id != w.class_id",
+    NULL
+};
+
+// only the fields of the classes which were taken from the shard are
+// copied; their IDs are shifted by ?2 to keep them unique
+const gchar *MERGE_FIELDS[] = {
+    "INSERT INTO main.fields_data (id, name, descriptor_id, signature_id, "
+    "    importable_id, namespace_id, access_flags) "
+    "    SELECT f.id + ?2, f.name, d.new_id, s.new_id, w.importable_id,"
+    "    w.namespace_id, f.access_flags "
+    "    FROM shard.fields_data f "
+    "    JOIN temp.map_importables i ON i.shard = ?1 "
+    "        AND i.old_id = f.importable_id "
+    "    JOIN temp.map_namespaces n ON n.shard = ?1 "
+    "        AND n.old_id = f.namespace_id "
+    "    JOIN temp.winners w ON w.importable_id = i.new_id "
+    "        AND w.namespace_id = n.new_id AND w.shard = ?1 "
+    "    JOIN temp.map_descriptors d ON d.shard = ?1 "
+    "        AND d.old_id = f.descriptor_id "
+    "    LEFT JOIN temp.map_signatures s ON s.shard = ?1 "
+    "        AND s.old_id = f.signature_id "
+    "    ORDER BY f.id",
+    NULL
+};
+
+// only the members of the classes which were taken from the shard are
+// copied; the IDs of its methods are shifted by ?2 to keep them unique
+const gchar *MERGE_MEMBERS[] = {
+    "INSERT INTO main.methods_data (id, name, descriptor_id, signature_id, "
+    "    importable_id, namespace_id, access_flags, code_length, max_stack, "
+    "    max_locals, exception_handlers, invocations) "
+    "    SELECT m.id + ?2, m.name, d.new_id, s.new_id, w.importable_id,"
+    "    w.namespace_id, m.access_flags, m.code_length, m.max_stack, "
+    "    m.max_locals, m.exception_handlers, m.invocations "
+    "    FROM shard.methods_data m "
+    "    JOIN temp.map_importables i ON i.shard = ?1 "
+    "        AND i.old_id = m.importable_id "
+    "    JOIN temp.map_namespaces n ON n.shard = ?1 "
+    "        AND n.old_id = m.namespace_id "
+    "    JOIN temp.winners w ON w.importable_id = i.new_id "
+    "        AND w.namespace_id = n.new_id AND w.shard = ?1 "
+    "    JOIN temp.map_descriptors d ON d.shard = ?1 "
+    "        AND d.old_id = m.descriptor_id "
+    "    LEFT JOIN temp.map_signatures s ON s.shard = ?1 "
+    "        AND s.old_id = m.signature_id "
+    "    ORDER BY m.id",
+    "INSERT OR IGNORE INTO main.exceptions "
+    "    SELECT e.method_id + ?2, i.new_id, n.new_id "
+    "    FROM shard.exceptions e "
+    "    JOIN main.methods_data m ON m.id = e.method_id + ?2 "
+    "    JOIN temp.map_importables i ON i.shard = ?1 "
+    "        AND i.old_id = e.importable_id "
+    "    JOIN temp.map_namespaces n ON n.shard = ?1 "
+    "        AND n.old_id = e.namespace_id",
+    "INSERT OR IGNORE INTO main.interfaces "
+    "    SELECT w.importable_id, w.namespace_id, ii.new_id, ni.new_id "
+    "    FROM shard.interfaces f "
+    "    JOIN temp.map_importables i ON i.shard = ?1 "
+    "        AND i.old_id = f.importable_id "
+    "    JOIN temp.map_namespaces n ON n.shard = ?1 "
+    "        AND n.old_id = f.namespace_id "
+    "    JOIN temp.winners w ON w.importable_id = i.new_id "
+    "        AND w.namespace_id = n.new_id AND w.shard = ?1 "
+    "    JOIN temp.map_importables ii ON ii.shard = ?1 "
+    "        AND ii.old_id = f.interface_importable_id "
+    "    JOIN temp.map_namespaces ni ON ni.shard = ?1 "
+    "        AND ni.old_id = f.interface_namespace_id",
+    "INSERT INTO main.files (path, filename) "
+    "    SELECT path, filename FROM shard.files ORDER BY id",
+    "INSERT INTO main.class_summaries "
+    "    SELECT c.name, w.importable_id, w.namespace_id, c.size, c.summary "
+    "    FROM shard.class_summaries c "
+    "    JOIN temp.map_importables i ON i.shard = ?1 "
+    "        AND i.old_id = c.importable_id "
+    "    JOIN temp.map_namespaces n ON n.shard = ?1 "
+    "        AND n.old_id = c.namespace_id "
+    "    JOIN temp.winners w ON w.importable_id = i.new_id "
+    "        AND w.namespace_id = n.new_id AND w.shard = ?1",
+    // the container IDs of the shards are already the global ones
+    "INSERT OR IGNORE INTO main.shadowed_classes "
+    "    SELECT i.new_id, n.new_id, c.container_id "
+    "    FROM shard.shadowed_classes c "
+    "    JOIN temp.map_importables i ON i.shard = ?1 "
+    "        AND i.old_id = c.importable_id "
+    "    JOIN temp.map_namespaces n ON n.shard = ?1 "
+    "        AND n.old_id = c.namespace_id",
+    // a container has at most one module, so modules are matched by it
+    "INSERT INTO main.modules (name, version, access_flags, container_id) "
+    "    SELECT name, version, access_flags, container_id "
+    "    FROM shard.modules ORDER BY id",
+    "INSERT INTO main.module_requires "
+    "    SELECT m.id, r.name, r.version, r.access_flags "
+    "    FROM shard.module_requires r "
+    "    JOIN shard.modules s ON s.id = r.module_id "
+    "    JOIN main.modules m ON m.container_id = s.container_id "
+    "        AND m.name = s.name",
+    "INSERT INTO main.module_exports "
+    "    SELECT m.id, e.package, e.target, e.access_flags "
+    "    FROM shard.module_exports e "
+    "    JOIN shard.modules s ON s.id = e.module_id "
+    "    JOIN main.modules m ON m.container_id = s.container_id "
+    "        AND m.name = s.name",
+    "INSERT INTO main.services "
+    "    SELECT si.new_id, sn.new_id, pi.new_id, pn.new_id, s.kind, "
+    "    s.container_id "
+    "    FROM shard.services s "
+    "    JOIN temp.map_importables si ON si.shard = ?1 "
+    "        AND si.old_id = s.service_importable_id "
+    "    JOIN temp.map_namespaces sn ON sn.shard = ?1 "
+    "        AND sn.old_id = s.service_namespace_id "
+    "    JOIN temp.map_importables pi ON pi.shard = ?1 "
+    "        AND pi.old_id = s.provider_importable_id "
+    "    JOIN temp.map_namespaces pn ON pn.shard = ?1 "
+    "        AND pn.old_id = s.provider_namespace_id "
+    "    ORDER BY s.rowid",
+    NULL
+};
+
+// the annotations of the classes taken from the shard; the IDs of its
+// annotations are shifted by ?2 to keep them unique
+const gchar *MERGE_ANNOTATIONS[] = {
+    "INSERT INTO main.annotations (id, type_importable_id, type_namespace_id, "
+    "    importable_id, namespace_id, target, member_name, descriptor_id, "
+    "    visible) "
+    "    SELECT a.id + ?2, ti.new_id, tn.new_id, w.importable_id,"
+    "    w.namespace_id, a.target, a.member_name, d.new_id, a.visible "
+    "    FROM shard.annotations a "
+    "    JOIN temp.map_importables i ON i.shard = ?1 "
+    "        AND i.old_id = a.importable_id "
+    "    JOIN temp.map_namespaces n ON n.shard = ?1 "
+    "        AND n.old_id = a.namespace_id "
+    "    JOIN temp.winners w ON w.importable_id = i.new_id "
+    "        AND w.namespace_id = n.new_id AND w.shard = ?1 "
+    "    JOIN temp.map_importables ti ON ti.shard = ?1 "
+    "        AND ti.old_id = a.type_importable_id "
+    "    JOIN temp.map_namespaces tn ON tn.shard = ?1 "
+    "        AND tn.old_id = a.type_namespace_id "
+    "    LEFT JOIN temp.map_descriptors d ON d.shard = ?1 "
+    "        AND d.old_id = a.descriptor_id "
+    "    ORDER BY a.id",
+    "INSERT INTO main.annotation_values "
+    "    SELECT v.annotation_id + ?2, v.name, v.value "
+    "    FROM shard.annotation_values v "
+    "    JOIN main.annotations a ON a.id = v.annotation_id + ?2",
+    NULL
+};
+
+/*
+ * Files written by the optional TSV export
+ */
+enum {
+    EXPORT_NAMESPACES,
+    EXPORT_IMPORTABLES,
+    EXPORT_DESCRIPTORS,
+    EXPORT_SIGNATURES,
+    EXPORT_CLASSES,
+    EXPORT_FIELDS,
+    EXPORT_METHODS,
+    EXPORT_INTERFACES,
+    EXPORT_ANNOTATIONS,
+    EXPORT_ANNOTATION_VALUES,
+    EXPORT_SERVICES,
+    EXPORT_NUM
+};
+
+const gchar *EXPORT_FILES[EXPORT_NUM][2] = {
+    {"namespaces.tsv", "id\tname"},
+    {"importables.tsv", "id\tname"},
+    {"descriptors.tsv", "id\tname"},
+    {"signatures.tsv", "id\tname"},
+    {"classes.tsv", "importable_id\tnamespace_id\tparent_importable_id\t"
+        "parent_namespace_id\taccess_flags\tsignature"},
+    {"fields.tsv", "importable_id\tnamespace_id\tname\tdescriptor_id\t"
+        "signature_id\taccess_flags"},
+    {"methods.tsv", "id\timportable_id\tnamespace_id\tname\t"
+        "descriptor_id\tsignature_id\taccess_flags\tcode_length\tmax_stack\t"
+        "max_locals\texception_handlers\tinvocations"},
+    {"interfaces.tsv", "importable_id\tnamespace_id\tinterface_importable_id\t"
+        "interface_namespace_id"},
+    {"annotations.tsv", "id\ttype_importable_id\ttype_namespace_id\t"
+        "importable_id\tnamespace_id\ttarget\tmember_name\tdescriptor_id\t"
+        "visible"},
+    {"annotation_values.tsv", "annotation_id\tname\tvalue"},
+    {"services.tsv", "service_importable_id\tservice_namespace_id\t"
+        "provider_importable_id\tprovider_namespace_id\tkind\tcontainer_id"}
+};
+
+#define EXPORT_BUFFER_SIZE (1024 * 1024)
+
+/*
+ * Tables of unique strings which are interned while indexing
+ */
+enum {
+    STRINGS_NAMESPACES,
+    STRINGS_IMPORTABLES,
+    STRINGS_DESCRIPTORS,
+    STRINGS_SIGNATURES,
+    STRINGS_NUM
+};
+
+typedef struct {
+    const gchar *table;         // name of the database table
+    int export;                 // export file for newly inserted strings
+    SymCache strings;           // previous generation only with --max-memory
+    sqlite3_stmt *stmt_insert;
+    sqlite3_stmt *stmt_select;  // only used with --max-memory
+} StringTable;
+
+// number of classes after which the transaction is committed with
+// --max-memory and while the libraries are indexed after the project; it
+// bounds the dirty pages a COMMIT writes, which is cheap since the index is
+// written with synchronous = OFF (see --stats for the time it takes)
+#define COMMIT_INTERVAL_CLASSES 5000
+
+/*
+ * Limits of the bounded-memory mode
+ */
+// read buffers which grew beyond this size are given back after each class
+#define MAX_MEMORY_READ_BUFFER (1024 * 1024)
+
+/*
+ * A JAR or the loose class files of a directory which is indexed as a whole
+ * by one of the shard writers of --jobs
+ */
+typedef struct {
+    gchar *path;
+    gboolean is_jar;
+    gboolean index_filenames;   // only set for the project directory
+    gint64 size;                // bytes of class files to balance the shards
+    int shard;
+} Container;
+
+/*
+ * Command line options
+ */
+static gchar *export_dir = NULL;
+static gint max_memory = 0;
+static gint jobs = 1;
+static gboolean summaries = FALSE;
+static gchar *base_dir = NULL;
+static gboolean resume = FALSE;
+static gint release = 0;
+static gboolean background = FALSE;
+static gboolean nice_io = FALSE;
+static gboolean clustered = FALSE;
+static gchar **repositories = NULL;
+static gint threads = 0;
+static gchar *sink_name = NULL;
+static gchar *trace_file = NULL;
+static gboolean show_stats = FALSE;
+
+static GOptionEntry options[] =
+{
+    {"export-dir", 'e', 0, G_OPTION_ARG_FILENAME, &export_dir, "Additionally stream the index as TSV files into DIR", "DIR"},
+    {"max-memory", 'm', 0, G_OPTION_ARG_INT, &max_memory, "Try to keep the memory usage below MB megabytes", "MB"},
+    {"jobs", 'j', 0, G_OPTION_ARG_INT, &jobs, "Index with N processes writing into shard databases", "N"},
+    {"summaries", 's', 0, G_OPTION_ARG_NONE, &summaries, "Also store a compressed summary of each class for java-query", NULL},
+    {"release", 0, 0, G_OPTION_ARG_INT, &release, "Index multi-release JARs for Java release N instead of only their base entries", "N"},
+    {"resume", 'r', 0, G_OPTION_ARG_NONE, &resume, "Continue an interrupted run from its last completed JAR or directory", NULL},
+    {"base-dir", 'b', 0, G_OPTION_ARG_FILENAME, &base_dir, "Share the index of the JDK and CLASSPATH in DIR and only index the project into " DB_FILE, "DIR"},
+    {"background", 0, 0, G_OPTION_ARG_NONE, &background, "Return as soon as the project is indexed and index the CLASSPATH and the JDK in the background", NULL},
+    {"clustered", 'c', 0, G_OPTION_ARG_NONE, &clustered, "Store classes and their members in tables clustered by class", NULL},
+    {"repository", 0, 0, G_OPTION_ARG_FILENAME_ARRAY, &repositories, "Index which versions of the artifacts of the Maven repository or Gradle cache DIR contain which classes", "DIR"},
+    {"threads", 't', 0, G_OPTION_ARG_INT, &threads, "Scan the JARs of --repository with N threads (default: number of CPUs)", "N"},
+    {"sink", 0, 0, G_OPTION_ARG_STRING, &sink_name, "Pass the classes to SINK: sqlite (default), null to only read and parse them or ndjson to print them as JSON lines", "SINK"},
+    {"trace", 0, 0, G_OPTION_ARG_FILENAME, &trace_file, "Write a timeline of the directories, JARs, classes and commits to FILE for chrome://tracing or Perfetto", "FILE"},
+    {"nice", 'n', 0, G_OPTION_ARG_NONE, &nice_io, "Index the CLASSPATH and the JDK with the lowest CPU and I/O priority", NULL},
+    {"stats", 0, 0, G_OPTION_ARG_NONE, &show_stats, "Print the throughput and the time spent in commits and database lookups of names when done", NULL},
+    {NULL}
+};
+
 /*
  * Global variables
  */
 sqlite3 *db = NULL;
 
-sqlite3_stmt *stmt_insert_namespace       = NULL;
-sqlite3_stmt *stmt_insert_class           = NULL;
+FILE *export_fp[EXPORT_NUM];
+
 sqlite3_stmt *stmt_insert_class_namespace = NULL;
 sqlite3_stmt *stmt_insert_field           = NULL;
 sqlite3_stmt *stmt_insert_method          = NULL;
@@ -127,131 +811,503 @@ sqlite3_stmt *stmt_insert_file            = NULL;
 sqlite3_stmt *stmt_is_done                = NULL;
 sqlite3_stmt *stmt_set_done               = NULL;
 sqlite3_stmt *stmt_set_class_attributes   = NULL;
-
-// hash tables to make sure that the data we insert are unique
-GHashTable *inserted_namespaces  = NULL;
-GHashTable *inserted_importables = NULL;
-
-// all strings in this program are put into one huge string chunk because
-// in the JDK alone there are about 15,000 classes and their packages which
-// we need to keep in our hash tables
-GStringChunk *strchunk = NULL;
+sqlite3_stmt *stmt_insert_container       = NULL;
+sqlite3_stmt *stmt_insert_summary         = NULL;
+sqlite3_stmt *stmt_complete_container     = NULL;
+sqlite3_stmt *stmt_insert_shadowed        = NULL;
+sqlite3_stmt *stmt_insert_module          = NULL;
+sqlite3_stmt *stmt_insert_module_require  = NULL;
+sqlite3_stmt *stmt_insert_module_export   = NULL;
+sqlite3_stmt *stmt_insert_annotation      = NULL;
+sqlite3_stmt *stmt_insert_annotation_value = NULL;
+sqlite3_stmt *stmt_insert_service         = NULL;
+sqlite3_stmt *stmt_insert_artifact        = NULL;
+sqlite3_stmt *stmt_insert_artifact_version = NULL;
+sqlite3_stmt *stmt_insert_artifact_class  = NULL;
+
+// symbol tables to make sure that the data we insert are unique; each of
+// them keeps its strings in one arena because in the JDK alone there are
+// about 15,000 classes and their packages
+StringTable string_tables[STRINGS_NUM] = {
+    {"namespaces", EXPORT_NAMESPACES},
+    {"importables", EXPORT_IMPORTABLES},
+    {"descriptors", EXPORT_DESCRIPTORS},
+    {"signatures", EXPORT_SIGNATURES}
+};
+
+// size at which the current string tables are rotated with --max-memory
+gsize string_tables_limit = 0;
+
+// classes processed since the last COMMIT
+guint uncommitted_classes = 0;
+
+// figures printed with --stats; the times are in microseconds
+struct {
+    gint64 start;
+    guint64 classes;
+    guint64 commits;
+    gint64 commit_time;
+    guint64 name_lookups;       // names dropped from memory and looked up
+    gint64 name_lookup_time;
+} stats;
+
+// set once the project is indexed so that the classes of the libraries and
+// the JDK are published in batches instead of only with their container
+gboolean commit_batches = FALSE;
+
+// container the classes which are currently indexed are read from
+gint64 current_container_id = 0;
+
+// scan of the raw bytes of the class which is indexed for the parts that
+// libclassreader doesn't read (annotations and Code attributes)
+ClassScan class_scan;
+
+// paths of the containers which were completed before with --resume
+GHashTable *completed_containers = NULL;
+
+// receives everything which is read
+IndexSink *sink = NULL;
+gpointer sink_data = NULL;
+
+// the IDs of fields and methods are assigned here instead of by SQLite,
+// which can't do it for the WITHOUT ROWID tables of --clustered
+gint64 last_field_id = 0;
+gint64 last_method_id = 0;
+
+// IDs of the class which is indexed by the SQLite sink
+struct {
+    gint64 class_id;
+    gint64 namespace_id;
+    gint64 method_id;
+    gint64 annotation_id;       // annotation whose values are inserted
+    JavaClass *javaclass;
+    ClassScan *scan;
+} indexed_class;
+
+// buffer the class files of JARs are read into
+guchar *read_buffer = NULL;
+gsize read_buffer_size = 0;
 
 /*
  * Function prototypes
  */
-void index_dir(const gchar *dirname, gboolean index_filenames);
+void index_dir(const gchar *dirname, gboolean index_filenames,
+        gboolean index_jars);
 void index_jar(gchar *jarfile);
-void insert_file(const gchar *path, const gchar *filename);
-void process_class(JavaClass *c);
+void index_jar_classes(gchar *jarfile);
+void index_archive(NestedJar *archive, const gchar *name, guint *order);
+void index_nested_jar(NestedJar *parent, int index, const gchar *name);
+gboolean is_multi_release(struct zip *jar);
+void parse_multi_release(const gchar *header, gboolean *multi_release);
+int select_module_info(struct zip *jar, int numfiles, GHashTable *versioned);
+const gchar *versioned_path(const gchar *filename, int *version);
+GHashTable *select_versioned_entries(struct zip *jar, int numfiles);
+void index_module(const guchar *data, gsize size, const gchar *filename);
+void index_services(const guchar *data, gsize size, const gchar *path);
+gint64 insert_qualified_class(const gchar *name, gint64 *namespace_id);
+gint64 insert_class_name(const gchar *name, gint64 *namespace_id);
+void insert_artifact(Artifact *artifact);
+void index_repositories(gchar **roots);
+extern IndexSink sqlite_sink;
+gint64 insert_container(const gchar *path, gint64 id);
+void index_root_dir(const gchar *dirname, gboolean index_filenames);
+gboolean is_completed(const gchar *path);
+void complete_container(gint64 container_id);
+int bind_id_or_null(sqlite3_stmt *stmt, int col, gint64 id);
+gboolean method_code_stats(ClassScan *scan, gsize member, const gchar *name,
+        CodeStats *stats);
+void bind_code_stats(sqlite3_stmt *stmt, int col, CodeStats *stats);
+void export_code_stats(FILE *fp, CodeStats *stats);
+void insert_container_start(const gchar *path, gpointer user_data);
+void insert_container_end(gpointer user_data);
+void insert_file(const gchar *path, const gchar *filename, gpointer user_data);
+void insert_module(SinkModule *module, gpointer user_data);
+void insert_service(ServicesKind kind, const gchar *service,
+        const gchar *provider, gpointer user_data);
+void insert_annotation(SinkAnnotation *annotation, gpointer user_data);
+void insert_annotation_value(const gchar *name, const gchar *value,
+        gpointer user_data);
+void process_class(JavaClass *c, const guchar *data, gsize size);
+void walk_annotations(ClassScan *scan);
 void index_classpath(gchar *classpath);
-void create_database();
+void continue_in_background();
+void create_database(const gchar *filename);
+void open_database(const gchar *filename);
+gboolean resume_database();
+void set_state(const gchar *state);
+void prepare_statements();
+GPtrArray *collect_containers(gchar *classpath, gchar *javahome);
+void index_shards(GPtrArray *containers);
+void merge_shards(GPtrArray *containers);
+gint64 max_id(const gchar *table);
+gchar *base_filename(gchar *classpath, gchar *javahome);
+void list_class_files(GPtrArray *lines, const gchar *root,
+        const gchar *dirname);
+void create_base(const gchar *filename, gchar *classpath, gchar *javahome);
+void seed_overlay(const gchar *base);
+void load_string_tables();
 void create_indexes();
+void limit_memory();
+void commit_periodically();
+void print_stats();
+guchar *get_read_buffer(gsize size);
+void trim_read_buffer();
+void open_export_files();
+void close_export_files();
+void export_string(FILE *fp, const gchar *str, gboolean last);
+void export_int(FILE *fp, gint64 value, gboolean last);
+void export_id(FILE *fp, gint64 id, gboolean last);
 void handle_sql_error(int status, int line);
 
-void cleanup()
+/*
+ * Finalize a prepared statement unless it wasn't prepared
+ */
+void finalize_statement(sqlite3_stmt **stmt)
+{
+    if (*stmt != NULL) {
+        sqlite3_finalize(*stmt);
+        *stmt = NULL;
+    }
+}
+
+/*
+ * Finalize all prepared statements and free the string tables so that
+ * another database can be indexed
+ */
+void finalize_statements()
 {
-    if (inserted_namespaces != NULL) {
-        g_hash_table_destroy(inserted_namespaces);
+    for (int i = 0; i < STRINGS_NUM; i++) {
+        StringTable *table = &string_tables[i];
+
+        symtab_free(table->strings.current);
+        symtab_free(table->strings.previous);
+        table->strings.current  = NULL;
+        table->strings.previous = NULL;
+
+        finalize_statement(&table->stmt_insert);
+        finalize_statement(&table->stmt_select);
     }
 
-    if (inserted_importables != NULL) {
-        g_hash_table_destroy(inserted_importables);
+    finalize_statement(&stmt_insert_class_namespace);
+    finalize_statement(&stmt_insert_field);
+    finalize_statement(&stmt_insert_method);
+    finalize_statement(&stmt_insert_interface);
+    finalize_statement(&stmt_insert_exception);
+    finalize_statement(&stmt_insert_file);
+    finalize_statement(&stmt_is_done);
+    finalize_statement(&stmt_set_done);
+    finalize_statement(&stmt_set_class_attributes);
+    finalize_statement(&stmt_insert_container);
+    finalize_statement(&stmt_insert_summary);
+    finalize_statement(&stmt_complete_container);
+    finalize_statement(&stmt_insert_shadowed);
+    finalize_statement(&stmt_insert_module);
+    finalize_statement(&stmt_insert_module_require);
+    finalize_statement(&stmt_insert_module_export);
+    finalize_statement(&stmt_insert_annotation);
+    finalize_statement(&stmt_insert_annotation_value);
+    finalize_statement(&stmt_insert_service);
+    finalize_statement(&stmt_insert_artifact);
+    finalize_statement(&stmt_insert_artifact_version);
+    finalize_statement(&stmt_insert_artifact_class);
+}
+
+void cleanup()
+{
+    finalize_statements();
+    g_free(read_buffer);
+    classscan_clear(&class_scan);
+    close_export_files();
+
+    if (completed_containers != NULL) {
+        g_hash_table_destroy(completed_containers);
     }
+}
+
+void usage(gchar *errormsg, GOptionContext *context)
+{
+    if (errormsg != NULL) fprintf(stderr, "ERROR: %s\n", errormsg);
+    fprintf(stderr, "%s", g_option_context_get_help(context, TRUE, NULL));
+
+    exit(2);
+}
+
+int main(int argc, char** argv)
+{
+    gchar *classpath = NULL;
+    gchar *javahome  = NULL;
+    gchar *error_msg = NULL;
+    int status = 0;
+    GError *error = NULL;
+    GOptionContext *context;
 
-    if (strchunk != NULL) {
-        g_string_chunk_free(strchunk);
+    context = g_option_context_new(
+            "- Index the Java classes of a project into " DB_FILE);
+    g_option_context_add_main_entries(context, options, NULL);
+
+    if (!g_option_context_parse(context, &argc, &argv, &error)) {
+        usage(error->message, context);
     }
 
-    if (stmt_insert_namespace != NULL) {
-        sqlite3_finalize(stmt_insert_namespace);
+    if (jobs < 1) usage("The number of jobs has to be at least 1", context);
+    if (jobs > 1 && export_dir != NULL) {
+        usage("--export-dir can't be combined with --jobs", context);
+    }
+    if (base_dir != NULL && (jobs > 1 || export_dir != NULL)) {
+        usage("--base-dir can't be combined with --jobs or --export-dir",
+                context);
+    }
+    if (resume && (jobs > 1 || export_dir != NULL || base_dir != NULL)) {
+        usage("--resume can't be combined with --jobs, --export-dir or "
+                "--base-dir", context);
+    }
+    if (background && (jobs > 1 || base_dir != NULL)) {
+        usage("--background can't be combined with --jobs or --base-dir",
+                context);
     }
 
-    if (stmt_insert_class != NULL) {
-        sqlite3_finalize(stmt_insert_class);
+    if (repositories != NULL && (jobs > 1 || export_dir != NULL
+                || base_dir != NULL || resume || background)) {
+        usage("--repository can't be combined with --jobs, --export-dir, "
+                "--base-dir, --resume or --background", context);
+    }
+    if (threads < 0) usage("The number of threads can't be negative", context);
+
+    if (sink_name == NULL || g_strcmp0(sink_name, "sqlite") == 0) {
+        sink = &sqlite_sink;
+    } else if (g_strcmp0(sink_name, "null") == 0) {
+        sink = &null_sink;
+    } else if (g_strcmp0(sink_name, "ndjson") == 0) {
+        sink = &ndjson_sink;
+        sink_data = sink_ndjson_new(stdout);
+    } else {
+        usage("The sink has to be sqlite, null or ndjson", context);
     }
+    if (sink != &sqlite_sink && (jobs > 1 || export_dir != NULL
+                || base_dir != NULL || resume || background
+                || repositories != NULL)) {
+        usage("Only the sqlite sink can be combined with --jobs, "
+                "--export-dir, --base-dir, --resume, --background or "
+                "--repository", context);
+    }
+
+    atexit(cleanup);
+
+    // registered after cleanup() so that they run before it
+    stats.start = g_get_monotonic_time();
+    if (show_stats) atexit(print_stats);
 
-    if (stmt_insert_class_namespace != NULL) {
-        sqlite3_finalize(stmt_insert_class_namespace);
+    if (trace_file != NULL) {
+        trace_open(trace_file);
+        atexit(trace_close);
     }
 
-    if (stmt_insert_field != NULL) {
-        sqlite3_finalize(stmt_insert_field);
+    if (repositories != NULL) {
+        if (nice_io) priority_lower();
+        if (threads == 0) threads = g_get_num_processors();
+
+        create_database(DB_FILE);
+
+        if (max_memory > 0) limit_memory();
+
+        prepare_statements();
+
+        status = sqlite3_exec(db, "BEGIN TRANSACTION", NULL, 0, &error_msg);
+        handle_sql_error(status, __LINE__);
+
+        commit_batches = TRUE;
+        index_repositories(repositories);
+        g_strfreev(repositories);
+
+        create_indexes();
+        set_state("complete");
+
+        status = sqlite3_exec(db, "COMMIT", NULL, 0, &error_msg);
+        handle_sql_error(status, __LINE__);
+        sqlite3_close(db);
+
+        return 0;
     }
 
-    if (stmt_insert_method != NULL) {
-        sqlite3_finalize(stmt_insert_method);
+    classpath = g_strdup(g_getenv("CLASSPATH"));
+    javahome  = g_strdup(g_getenv("JAVA_HOME"));
+
+    if (javahome == NULL) {
+        fprintf(stderr, "JDK classes can't be indexed since JAVA_HOME is not set\n");
     }
 
-    if (stmt_insert_interface != NULL) {
-        sqlite3_finalize(stmt_insert_interface);
+    // the project isn't indexed on its own in these modes, so everything
+    // is indexed with the lower priority
+    if (nice_io && (jobs > 1 || base_dir != NULL)) priority_lower();
+
+    if (jobs > 1) {
+        GPtrArray *containers = collect_containers(classpath, javahome);
+
+        index_shards(containers);
+        merge_shards(containers);
+
+        g_ptr_array_free(containers, TRUE);
+        g_free(classpath);
+        g_free(javahome);
+
+        return 0;
     }
 
-    if (stmt_insert_exception != NULL) {
-        sqlite3_finalize(stmt_insert_exception);
+    if (base_dir != NULL) {
+        gchar *base = base_filename(classpath, javahome);
+
+        if (!g_file_test(base, G_FILE_TEST_EXISTS)) {
+            create_base(base, classpath, javahome);
+        }
+
+        create_database(DB_FILE);
+        seed_overlay(base);
+        g_free(base);
+
+        if (max_memory > 0) limit_memory();
+
+        prepare_statements();
+        load_string_tables();
+
+        status = sqlite3_exec(db, "BEGIN TRANSACTION", NULL, 0, &error_msg);
+        handle_sql_error(status, __LINE__);
+
+        index_root_dir(".", TRUE);
+
+        g_free(classpath);
+        g_free(javahome);
+
+        create_indexes();
+        set_state("complete");
+
+        status = sqlite3_exec(db, "COMMIT", NULL, 0, &error_msg);
+        handle_sql_error(status, __LINE__);
+        sqlite3_close(db);
+
+        return 0;
     }
 
-    if (stmt_insert_file != NULL) {
-        sqlite3_finalize(stmt_insert_file);
+    // the other sinks get everything the indexer reads without a database
+    if (sink != &sqlite_sink) {
+        index_root_dir(".", TRUE);
+        if (nice_io) priority_lower();
+        if (javahome != NULL) index_root_dir(javahome, FALSE);
+        if (classpath != NULL) index_classpath(classpath);
+
+        if (sink == &ndjson_sink) sink_ndjson_free(sink_data);
+
+        g_free(classpath);
+        g_free(javahome);
+
+        return 0;
     }
 
-    if (stmt_is_done != NULL) {
-        sqlite3_finalize(stmt_is_done);
+    gboolean resuming = FALSE;
+
+    if (resume && g_file_test(DB_FILE, G_FILE_TEST_EXISTS)) {
+        open_database(DB_FILE);
+        resuming = resume_database();
     }
 
-    if (stmt_set_done != NULL) {
-        sqlite3_finalize(stmt_set_done);
+    if (!resuming) create_database(DB_FILE);
+    open_export_files();
+
+    if (max_memory > 0) limit_memory();
+
+    prepare_statements();
+    if (resuming) load_string_tables();
+
+    // readers see every committed container while the rest is indexed
+    status = sqlite3_exec(db, "PRAGMA journal_mode = WAL", NULL, 0,
+            &error_msg);
+    handle_sql_error(status, __LINE__);
+
+    status = sqlite3_exec(db, "BEGIN TRANSACTION", NULL, 0, &error_msg);
+    handle_sql_error(status, __LINE__);
+
+    // the project comes first so that it can be queried as soon as possible;
+    // its classes therefore win over copies in the libraries
+    index_root_dir(".", TRUE);
+
+    if (background) continue_in_background();
+    if (nice_io) priority_lower();
+    commit_batches = TRUE;
+
+    // the bootstrap class loader is asked before the class path, so the
+    // classes of the JDK win over copies in the JARs
+    if (javahome != NULL) {
+        index_root_dir(javahome, FALSE);
     }
 
-    if (stmt_set_class_attributes != NULL) {
-        sqlite3_finalize(stmt_set_class_attributes);
+    if (classpath != NULL) {
+        index_classpath(classpath);
     }
+
+    g_free(classpath);
+    g_free(javahome);
+
+    create_indexes();
+    set_state("complete");
+
+    status = sqlite3_exec(db, "COMMIT", NULL, 0, &error_msg);
+    handle_sql_error(status, __LINE__);
+
+    // a finished index is a single file again
+    status = sqlite3_exec(db, "PRAGMA journal_mode = DELETE", NULL, 0,
+            &error_msg);
+    handle_sql_error(status, __LINE__);
+    sqlite3_close(db);
 }
 
-int main(int argc, char** argv)
+/*
+ * Prepare all the SQL statements needed by the other functions
+ */
+void prepare_statements()
 {
-    gchar *classpath = NULL;
-    gchar *javahome  = NULL;
-    gchar *error_msg = NULL;
     int status = 0;
 
-    atexit(cleanup);
+    for (int i = 0; i < STRINGS_NUM; i++) {
+        StringTable *table = &string_tables[i];
+        gchar *sql = g_strdup_printf("INSERT INTO %s (name) VALUES (?);",
+                table->table);
 
-    create_database();
-    sqlite3_extended_result_codes(db, 1);
+        status = sqlite3_prepare_v2(db, sql, -1, &table->stmt_insert, NULL);
+        handle_sql_error(status, __LINE__);
+        g_free(sql);
 
-    // prepare all the SQL statements needed by the other functions
-    status = sqlite3_prepare_v2(db,
-            "INSERT INTO namespaces (name) VALUES (?);",
-            -1, &stmt_insert_namespace, NULL);
-    handle_sql_error(status, __LINE__);
+        if (max_memory > 0) {
+            sql = g_strdup_printf("SELECT id FROM %s WHERE name=?;",
+                    table->table);
 
-    status = sqlite3_prepare_v2(db,
-            "INSERT INTO importables (name) VALUES (?);",
-            -1, &stmt_insert_class, NULL);
-    handle_sql_error(status, __LINE__);
+            status = sqlite3_prepare_v2(db, sql, -1, &table->stmt_select,
+                    NULL);
+            handle_sql_error(status, __LINE__);
+            g_free(sql);
+        }
+
+        table->strings.current = symtab_new(0);
+    }
 
     status = sqlite3_prepare_v2(db,
-            "INSERT INTO importables_namespaces "
+            "INSERT INTO importables_namespaces_data "
             "(importable_id, namespace_id, done) "
             "VALUES (?, ?, ?)",
             -1, &stmt_insert_class_namespace, NULL);
     handle_sql_error(status, __LINE__);
 
     status = sqlite3_prepare_v2(db,
-            "INSERT INTO fields "
-            "(name, descriptor, signature, importable_id, namespace_id, "
-            "ispublic, isprotected, isprivate, isstatic, isfinal, isenum) "
-            "VALUES (?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?)",
+            "INSERT INTO fields_data "
+            "(name, descriptor_id, signature_id, importable_id, "
+            "namespace_id, access_flags, id) VALUES (?, ?, ?, ?, ?, ?, ?)",
             -1, &stmt_insert_field, NULL);
     handle_sql_error(status, __LINE__);
 
     status = sqlite3_prepare_v2(db,
-            "INSERT INTO methods "
-            "(name, descriptor, signature, importable_id, namespace_id, "
-            "ispublic, isprotected, isprivate, isstatic, isfinal, "
-            "issynchronized, isabstract) VALUES "
-            "(?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?)",
+            "INSERT INTO methods_data "
+            "(name, descriptor_id, signature_id, importable_id, "
+            "namespace_id, access_flags, code_length, max_stack, max_locals, "
+            "exception_handlers, invocations, id) "
+            "VALUES (?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?)",
             -1, &stmt_insert_method, NULL);
     handle_sql_error(status, __LINE__);
 
@@ -277,126 +1333,250 @@ int main(int argc, char** argv)
     handle_sql_error(status, __LINE__);
 
     status = sqlite3_prepare_v2(db,
-            "SELECT done FROM importables_namespaces WHERE importable_id=? "
+            "SELECT done FROM importables_namespaces_data WHERE importable_id=? "
             "AND namespace_id=?",
             -1, &stmt_is_done, NULL);
     handle_sql_error(status, __LINE__);
 
     status = sqlite3_prepare_v2(db,
-            "UPDATE importables_namespaces SET done=1 WHERE importable_id=? "
+            "UPDATE importables_namespaces_data SET done=1 WHERE importable_id=? "
             "AND namespace_id=?",
             -1, &stmt_set_done, NULL);
     handle_sql_error(status, __LINE__);
 
     status = sqlite3_prepare_v2(db,
-            "UPDATE importables_namespaces SET parent_importable_id=?, "
-            "parent_namespace_id=?, ispublic=?, isfinal=?, "
-            "isinterface=?, isabstract=?, isannotation=?, isenum=?, "
-            "signature=?"
-            " WHERE importable_id=? AND namespace_id=?",
+            "UPDATE importables_namespaces_data SET parent_importable_id=?, "
+            "parent_namespace_id=?, access_flags=?, signature=?, "
+            "container_id=? WHERE importable_id=? AND namespace_id=?",
             -1, &stmt_set_class_attributes, NULL);
     handle_sql_error(status, __LINE__);
 
-    status = sqlite3_exec(db, "BEGIN TRANSACTION", NULL, 0, &error_msg);
+    status = sqlite3_prepare_v2(db,
+            "INSERT INTO containers (id, path) VALUES (?, ?)",
+            -1, &stmt_insert_container, NULL);
+    handle_sql_error(status, __LINE__);
 
-    inserted_namespaces  = g_hash_table_new_full(g_str_hash, g_str_equal,
-            NULL, g_free);
-    inserted_importables = g_hash_table_new_full(g_str_hash, g_str_equal,
-            NULL, g_free);
+    status = sqlite3_prepare_v2(db,
+            "UPDATE containers SET complete=1 WHERE id=?",
+            -1, &stmt_complete_container, NULL);
+    handle_sql_error(status, __LINE__);
 
-    strchunk = g_string_chunk_new(64);
+    status = sqlite3_prepare_v2(db,
+            "INSERT INTO class_summaries "
+            "(name, importable_id, namespace_id, size, summary) "
+            "VALUES (?, ?, ?, ?, ?)",
+            -1, &stmt_insert_summary, NULL);
+    handle_sql_error(status, __LINE__);
 
-    classpath = g_strdup(g_getenv("CLASSPATH"));
-    javahome  = g_strdup(g_getenv("JAVA_HOME"));
+    status = sqlite3_prepare_v2(db,
+            "INSERT OR IGNORE INTO shadowed_classes "
+            "(importable_id, namespace_id, container_id) VALUES (?, ?, ?)",
+            -1, &stmt_insert_shadowed, NULL);
+    handle_sql_error(status, __LINE__);
 
-    if (classpath != NULL) {
-        index_classpath(classpath);
-    }
+    status = sqlite3_prepare_v2(db,
+            "INSERT INTO modules (name, version, access_flags, container_id) "
+            "VALUES (?, ?, ?, ?)",
+            -1, &stmt_insert_module, NULL);
+    handle_sql_error(status, __LINE__);
 
-    if (javahome != NULL) {
-        index_dir(javahome, FALSE);
-    } else {
-        fprintf(stderr, "JDK classes can't be indexed since JAVA_HOME is not set\n");
-    }
+    status = sqlite3_prepare_v2(db,
+            "INSERT INTO module_requires "
+            "(module_id, name, version, access_flags) VALUES (?, ?, ?, ?)",
+            -1, &stmt_insert_module_require, NULL);
+    handle_sql_error(status, __LINE__);
 
-    index_dir(".", TRUE);
+    status = sqlite3_prepare_v2(db,
+            "INSERT INTO module_exports "
+            "(module_id, package, target, access_flags) VALUES (?, ?, ?, ?)",
+            -1, &stmt_insert_module_export, NULL);
+    handle_sql_error(status, __LINE__);
 
-    g_free(classpath);
-    g_free(javahome);
+    status = sqlite3_prepare_v2(db,
+            "INSERT INTO annotations (type_importable_id, type_namespace_id, "
+            "importable_id, namespace_id, target, member_name, descriptor_id, "
+            "visible) VALUES (?, ?, ?, ?, ?, ?, ?, ?)",
+            -1, &stmt_insert_annotation, NULL);
+    handle_sql_error(status, __LINE__);
 
-    create_indexes();
+    status = sqlite3_prepare_v2(db,
+            "INSERT INTO annotation_values (annotation_id, name, value) "
+            "VALUES (?, ?, ?)",
+            -1, &stmt_insert_annotation_value, NULL);
+    handle_sql_error(status, __LINE__);
 
-    status = sqlite3_exec(db, "COMMIT", NULL, 0, &error_msg);
-    sqlite3_close(db);
+    status = sqlite3_prepare_v2(db,
+            "INSERT INTO services (service_importable_id, service_namespace_id, "
+            "provider_importable_id, provider_namespace_id, kind, "
+            "container_id) VALUES (?, ?, ?, ?, ?, ?)",
+            -1, &stmt_insert_service, NULL);
+    handle_sql_error(status, __LINE__);
+
+    status = sqlite3_prepare_v2(db,
+            "INSERT INTO artifacts (group_id, artifact_id) VALUES (?, ?)",
+            -1, &stmt_insert_artifact, NULL);
+    handle_sql_error(status, __LINE__);
+
+    status = sqlite3_prepare_v2(db,
+            "INSERT INTO artifact_versions (artifact_id, version, path) "
+            "VALUES (?, ?, ?)",
+            -1, &stmt_insert_artifact_version, NULL);
+    handle_sql_error(status, __LINE__);
+
+    status = sqlite3_prepare_v2(db,
+            "INSERT OR IGNORE INTO artifact_classes (importable_id, "
+            "namespace_id, first_version_id, last_version_id) "
+            "VALUES (?, ?, ?, ?)",
+            -1, &stmt_insert_artifact_class, NULL);
+    handle_sql_error(status, __LINE__);
+
+    // continue the IDs of a resumed index or of the base of an overlay
+    last_field_id  = max_id("fields_data");
+    last_method_id = max_id("methods_data");
 }
 
 /*
  * Index a directory and all its subdirectories
+ *
+ * The JARs in the directory are skipped if index_jars is FALSE since
+ * --jobs indexes each of them on its own.
  */
-void index_dir(const gchar *dirname, gboolean index_filenames)
+void index_dir(const gchar *dirname, gboolean index_filenames,
+        gboolean index_jars)
 {
-    GDir *dir = NULL;
+    GPtrArray *names = NULL;
     const gchar *name = NULL;
     gchar *fullname = NULL;
     GError *error = NULL;
+    gint64 start = trace_start();
 
-    dir = g_dir_open(dirname, 0, &error);
+    names = readahead_dir(dirname, &error);
 
     if (error != NULL) {
         fprintf(stderr, "ERROR: %s\n", error->message);
         return;
     }
 
-    while ((name = g_dir_read_name(dir)) != NULL) {
+    for (guint i = 0; i < names->len; i++) {
+        name = g_ptr_array_index(names, i);
         fullname = g_build_filename(dirname, name, NULL);
 
         if (index_filenames == TRUE) {
             if (g_file_test(fullname, G_FILE_TEST_IS_REGULAR)
                     && g_strcmp0(DB_FILE, name) != 0) {
-                insert_file(dirname, name);
+                sink->file(dirname, name, sink_data);
             }
         }
 
         if (g_file_test(fullname, G_FILE_TEST_IS_DIR)
                 && !g_str_has_prefix(name, ".")) {
-            index_dir(fullname, index_filenames);
+            index_dir(fullname, index_filenames, index_jars);
+        } else if (g_strcmp0(name, MODULE_INFO) == 0) {
+            gchar *contents = NULL;
+            gsize length = 0;
+
+            if (g_file_get_contents(fullname, &contents, &length, &error)) {
+                index_module((const guchar*) contents, length, fullname);
+            } else {
+                fprintf(stderr, "%s\n", error->message);
+                g_clear_error(&error);
+            }
+
+            g_free(contents);
+        } else if (services_kind(fullname) != SERVICES_NONE) {
+            gchar *contents = NULL;
+            gsize length = 0;
+
+            if (g_file_get_contents(fullname, &contents, &length, &error)) {
+                index_services((const guchar*) contents, length, fullname);
+            } else {
+                fprintf(stderr, "%s\n", error->message);
+                g_clear_error(&error);
+            }
+
+            g_free(contents);
         } else if (g_str_has_suffix(fullname, ".class") &&
                 g_strrstr(fullname, "$") == NULL) {
-            GError *error = NULL;
-            JavaClass *javaclass = javaclass_new_from_file(fullname, FALSE, &error);
+            gchar *contents = NULL;
+            gsize length = 0;
+
+            // the bytes are kept for the annotations which libclassreader
+            // doesn't read
+            if (g_file_get_contents(fullname, &contents, &length, &error)) {
+                gint64 class_start = trace_start();
+                JavaClass *javaclass = javaclass_new((guchar*) contents,
+                        length, FALSE, &error);
+
+                if (error == NULL) {
+                    process_class(javaclass, (const guchar*) contents, length);
+                } else {
+                    javaclass_free(javaclass);
+                }
+
+                trace_end("class", fullname, class_start, length);
+            }
 
             if (error != NULL) {
                 fprintf(stderr, "%s\n", error->message);
-                javaclass_free(javaclass);
-            } else {
-                process_class(javaclass);
+                g_clear_error(&error);
             }
 
-            javaclass_free(javaclass);
-        } else if (g_str_has_suffix(fullname, ".jar")) {
+            g_free(contents);
+        } else if (index_jars && nestedjar_is_archive(fullname)) {
             index_jar(fullname);
         }
 
         g_free(fullname);
     }
 
-    g_dir_close(dir);
+    g_ptr_array_free(names, TRUE);
+
+    trace_end("dir", dirname, start, -1);
 }
 
 /*
- * Index the contents of a JAR file
+ * Index the contents of a JAR file as a container of its own
  */
 void index_jar(gchar *jarfile)
+{
+    gint64 container_id = current_container_id;
+
+    if (is_completed(jarfile)) return;
+
+    sink->begin_container(jarfile, sink_data);
+    index_jar_classes(jarfile);
+    sink->end_container(sink_data);
+    current_container_id = container_id;
+}
+
+/*
+ * Index a directory of the class path, JAVA_HOME or the project as a
+ * container of its own
+ */
+void index_root_dir(const gchar *dirname, gboolean index_filenames)
+{
+    if (is_completed(dirname)) return;
+
+    sink->begin_container(dirname, sink_data);
+    index_dir(dirname, index_filenames, TRUE);
+    sink->end_container(sink_data);
+}
+
+/*
+ * Index the classes of a JAR file
+ */
+void index_jar_classes(gchar *jarfile)
 {
     struct zip *jar = NULL;
     int errorp = 0;
-    const gchar *filename = NULL;
     int numfiles = 0;
-    struct zip_stat buffer;
-    guint32 filesize = 0;
-    guchar *classbytes = NULL;
-    struct zip_file *fp = NULL;
-    
+    guint *order = NULL;
+    NestedJar *archive = NULL;
+    gint64 start = trace_start();
+    struct stat st;
+
+    readahead_file(jarfile);
+
     jar = zip_open(jarfile, 0, &errorp);
     if (jar == NULL) {
         fprintf(stderr, "Failed to open '%s'\n", jarfile);
@@ -405,15 +1585,100 @@ void index_jar(gchar *jarfile)
 
     numfiles = zip_get_num_files(jar);
 
-    for (int i = 0; i < numfiles; i++) {
+    // size the symbol tables from the central directory up front instead of
+    // growing them while the classes of the JAR are processed
+    if (sink == &sqlite_sink) {
+        symtab_reserve(string_tables[STRINGS_IMPORTABLES].strings.current,
+                numfiles);
+        symtab_reserve(string_tables[STRINGS_NAMESPACES].strings.current,
+                numfiles / 8);
+        symtab_reserve(string_tables[STRINGS_DESCRIPTORS].strings.current,
+                numfiles);
+    }
+
+    // read the entries in the order in which they are stored
+    order = readahead_jar_order(jarfile, numfiles);
+
+    archive = nestedjar_new(jar, jarfile);
+    index_archive(archive, jarfile, order);
+    nestedjar_close(archive);
+
+    g_free(order);
+
+    // the size is only looked up when tracing
+    trace_end("jar", jarfile, start,
+            start != 0 && stat(jarfile, &st) == 0 ? st.st_size : -1);
+}
+
+/*
+ * Index the classes of a top level or nested JAR in the given order of its
+ * entries (or the order of the central directory if order is NULL)
+ *
+ * The classes of nested JARs belong to the container of the top level JAR.
+ */
+void index_archive(NestedJar *archive, const gchar *name, guint *order)
+{
+    struct zip *jar = archive->zip;
+    const gchar *filename = NULL;
+    int numfiles = zip_get_num_files(jar);
+    struct zip_stat buffer;
+    guint32 filesize = 0;
+    guchar *classbytes = NULL;
+    struct zip_file *fp = NULL;
+    GHashTable *versioned = NULL;
+    int module_info = 0;
+
+    if (release > 0 && is_multi_release(jar)) {
+        versioned = select_versioned_entries(jar, numfiles);
+    }
+    module_info = select_module_info(jar, numfiles, versioned);
+
+    for (int n = 0; n < numfiles; n++) {
+        int i = order != NULL ? order[n] : n;
+        const gchar *path = NULL;
+
         filename = zip_get_name(jar, i, 0);
         if (filename == NULL) continue;
-        if (!g_str_has_suffix(filename, ".class")) continue;
-        if (g_strrstr(filename, "$") != NULL) continue; // skip inner classes
 
-        zip_stat_index(jar, i, 0, &buffer);
+        if (nestedjar_is_archive(filename)) {
+            index_nested_jar(archive, i, name);
+            continue;
+        }
+
+        gboolean is_services = services_kind(filename) != SERVICES_NONE;
+
+        if (!is_services) {
+            if (!g_str_has_suffix(filename, ".class")) continue;
+            if (g_strrstr(filename, "$") != NULL) continue; // skip inner classes
+        }
+
+        // of the base entry and the versioned entries of a class only the
+        // one selected for the release is read
+        if (g_str_has_prefix(filename, VERSIONS_DIR)) {
+            if (versioned == NULL && module_info == 0) continue;
+
+            path = versioned_path(filename, NULL);
+            if (path == NULL) continue;
+
+            int selected = versioned != NULL
+                ? GPOINTER_TO_INT(g_hash_table_lookup(versioned, path)) : 0;
+            if (selected != i + 1 && module_info != i + 1) continue;
+        } else {
+            path = nestedjar_class_path(filename);
+
+            if (versioned != NULL && g_hash_table_contains(versioned, path)) {
+                continue;
+            }
+        }
+
+        if (zip_stat_index(jar, i, 0, &buffer) != 0) {
+            fprintf(stderr, "ERROR: Failed to read the entry '%s' of %s\n",
+                    filename, name);
+            continue;
+        }
+
         filesize = buffer.size;
-        classbytes = g_malloc(filesize);
+        classbytes = get_read_buffer(filesize);
 
         fp = zip_fopen_index(jar, i, 0);
         int nbytes = zip_fread(fp, classbytes, filesize);
@@ -422,489 +1687,2617 @@ void index_jar(gchar *jarfile)
         if (filesize != nbytes) {
             fprintf(stderr, "ERROR: Read error! Requested %d bytes but got %d!\n",
                     filesize, nbytes);
-            g_free(classbytes);
 
             continue;
         }
 
+        if (g_strcmp0(path, MODULE_INFO) == 0) {
+            index_module(classbytes, filesize, name);
+            trim_read_buffer();
+            continue;
+        }
+
+        if (is_services) {
+            index_services(classbytes, filesize, path);
+            trim_read_buffer();
+            continue;
+        }
+
         GError *error = NULL;
+        gint64 class_start = trace_start();
         JavaClass *javaclass = javaclass_new(classbytes, filesize, FALSE, &error);
-        g_free(classbytes);
 
         if (error == NULL) {
-            process_class(javaclass);
+            process_class(javaclass, classbytes, filesize);
         } else {
             fprintf(stderr, "ERROR: %s\n", error->message);
         }
+
+        trace_end("class", filename, class_start, filesize);
+        trim_read_buffer();
     }
 
-    zip_close(jar);
+    if (versioned != NULL) g_hash_table_destroy(versioned);
 }
 
 /*
- * Insert a new file into the database
+ * Index the classes of a JAR inside another JAR, e.g. the JARs in BOOT-INF/lib
+ * of a Spring Boot JAR or WEB-INF/lib of a WAR, without extracting it
  */
-void insert_file(const gchar *path, const gchar *filename)
+void index_nested_jar(NestedJar *parent, int index, const gchar *name)
 {
-    int status = 0;
+    GError *error = NULL;
+    gint64 start = trace_start();
+    NestedJar *nested = nestedjar_open(parent, index, &error);
 
-    sqlite3_reset(stmt_insert_file);
-    status = sqlite3_bind_text(stmt_insert_file, 1,
-            path, -1, SQLITE_STATIC);
-    status = sqlite3_bind_text(stmt_insert_file, 2,
-            filename, -1, SQLITE_STATIC);
-    handle_sql_error(status, __LINE__);
+    if (error != NULL) {
+        fprintf(stderr, "ERROR: %s in %s\n", error->message, name);
+        g_error_free(error);
+        return;
+    }
 
-    status = sqlite3_step(stmt_insert_file);
-    handle_sql_error(status, __LINE__);
+    gchar *nested_name = g_strconcat(name, "!/",
+            zip_get_name(parent->zip, index, 0), NULL);
+
+    index_archive(nested, nested_name, NULL);
+    trace_end("jar", nested_name, start, -1);
+
+    g_free(nested_name);
+    nestedjar_close(nested);
 }
 
 /*
- * Insert a new namespace into the database or do nothing if it already exists
+ * Check if the manifest of a JAR declares it as a multi-release JAR
+ *
+ * Without it the versioned entries are ignored like the JVM does.
  */
-gint64 insert_namespace(const gchar* namespace)
+gboolean is_multi_release(struct zip *jar)
 {
-    int status          = 0;
-    gint64 namespace_id = 0;
-    gint64 *data        = NULL;
+    struct zip_stat buffer;
+    struct zip_file *fp = NULL;
+    gboolean multi_release = FALSE;
 
-    // check if the namespace was already inserted and return its ID if this is
-    // the case
-    data = (gint64*) g_hash_table_lookup(inserted_namespaces, namespace);
+    zip_int64_t index = zip_name_locate(jar, "META-INF/MANIFEST.MF", 0);
+    if (index < 0) return FALSE;
+    if (zip_stat_index(jar, index, 0, &buffer) != 0) return FALSE;
 
-    if (data != NULL) {
-        namespace_id = *data;
-        return namespace_id;
-    }
+    gchar *manifest = g_malloc(buffer.size + 1);
+    fp = zip_fopen_index(jar, index, 0);
 
-    sqlite3_reset(stmt_insert_namespace);
-    status = sqlite3_bind_text(stmt_insert_namespace, 1, namespace,
-            -1, SQLITE_STATIC);
-    handle_sql_error(status, __LINE__);
+    if (fp != NULL && zip_fread(fp, manifest, buffer.size) == buffer.size) {
+        manifest[buffer.size] = '\0';
 
-    status = sqlite3_step(stmt_insert_namespace);
-    handle_sql_error(status, __LINE__);
+        gchar **lines = g_strsplit(manifest, "\n", 0);
+        GString *header = g_string_new(NULL);
+
+        // a line starting with a space continues the header before it; the
+        // main section ends with the first empty line
+        for (int i = 0; lines[i] != NULL; i++) {
+            gchar *line = lines[i];
+            gsize length = strlen(line);
+
+            if (length > 0 && line[length - 1] == '\r') line[--length] = '\0';
 
-    namespace_id = sqlite3_last_insert_rowid(db);
-    data         = g_new(gint64, 1);
-    *data        = namespace_id;
+            if (line[0] == ' ') {
+                g_string_append(header, line + 1);
+                continue;
+            }
+
+            parse_multi_release(header->str, &multi_release);
+            g_string_truncate(header, 0);
+
+            if (length == 0) break;
+            g_string_append(header, line);
+        }
+        parse_multi_release(header->str, &multi_release);
 
-    g_hash_table_insert(inserted_namespaces,
-            g_string_chunk_insert(strchunk, namespace), data);
+        g_string_free(header, TRUE);
+        g_strfreev(lines);
+    }
+
+    if (fp != NULL) zip_fclose(fp);
+    g_free(manifest);
 
-    return namespace_id;
+    return multi_release;
 }
 
 /*
- * Insert a new class into the database and return its id
+ * Set multi_release from a Multi-Release header of the manifest; other
+ * headers are ignored
  */
-gint64 insert_class(const gchar* classname)
+void parse_multi_release(const gchar *header, gboolean *multi_release)
 {
-    int status           = 0;
-    gint64 importable_id = 0;
-    gint64 *data         = NULL;
+    if (g_ascii_strncasecmp(header, "Multi-Release:", 14) != 0) return;
 
-    // check if the class was already inserted and return its ID if this is the
-    // case
-    data = g_hash_table_lookup(inserted_importables, classname);
+    gchar *value = g_strstrip(g_strdup(header + 14));
+    *multi_release = g_ascii_strcasecmp(value, "true") == 0;
+    g_free(value);
+}
+
+/*
+ * Return the index + 1 of the versioned module-info.class which is read
+ * instead of a missing one in the root of a JAR or 0 if there is none
+ *
+ * Modular JARs which still support Java 8 often only have a versioned
+ * module descriptor, so the one with the highest version is taken even if
+ * the JAR isn't indexed for a release. One selected for the release wins.
+ */
+int select_module_info(struct zip *jar, int numfiles, GHashTable *versioned)
+{
+    int selected_index = 0;
+    int selected_version = 0;
 
-    if (data != NULL) {
-        importable_id = *data;
-        return importable_id;
+    if (versioned != NULL && g_hash_table_contains(versioned, MODULE_INFO)) {
+        return GPOINTER_TO_INT(g_hash_table_lookup(versioned, MODULE_INFO));
     }
+    if (zip_name_locate(jar, MODULE_INFO, 0) >= 0) return 0;
 
-    sqlite3_reset(stmt_insert_class);
-    status = sqlite3_bind_text(stmt_insert_class, 1, classname,
-            -1, SQLITE_STATIC);
-    handle_sql_error(status, __LINE__);
+    for (int i = 0; i < numfiles; i++) {
+        const gchar *filename = zip_get_name(jar, i, 0);
+        int version = 0;
 
-    status = sqlite3_step(stmt_insert_class);
-    handle_sql_error(status, __LINE__);
+        if (filename == NULL) continue;
+        if (!g_str_has_prefix(filename, VERSIONS_DIR)) continue;
+        if (!g_str_has_suffix(filename, MODULE_INFO)) continue;
 
-    importable_id = sqlite3_last_insert_rowid(db);
-    data          = g_new(gint64, 1);
-    *data         = importable_id;
+        const gchar *path = versioned_path(filename, &version);
+        if (g_strcmp0(path, MODULE_INFO) != 0) continue;
 
-    g_hash_table_insert(inserted_importables,
-            g_string_chunk_insert(strchunk, classname), data);
+        if (version > selected_version) {
+            selected_index = i + 1;
+            selected_version = version;
+        }
+    }
 
-    return importable_id;
+    return selected_index;
 }
 
 /*
- * Associate a class with its namespace
+ * Return the path of a versioned entry (META-INF/versions/N/path) relative
+ * to its version directory and store N in version, or NULL if the name of
+ * the entry is malformed
  */
-gboolean associate_class_and_namespace(gint64 class_id, gint64 namespace_id,
-        gboolean done)
+const gchar *versioned_path(const gchar *filename, int *version)
 {
-    int status = 0;
-    int done_int = 0;
+    const gchar *start = filename + strlen(VERSIONS_DIR);
+    gchar *end = NULL;
+    gint64 n = g_ascii_strtoll(start, &end, 10);
 
-    if (done) done_int = 1;
+    if (end == start || *end != '/' || n <= 0) return NULL;
+    if (version != NULL) *version = n;
 
-    sqlite3_reset(stmt_insert_class_namespace);
-    status = sqlite3_bind_int64(stmt_insert_class_namespace, 1, class_id);
-    handle_sql_error(status, __LINE__);
-    status = sqlite3_bind_int64(stmt_insert_class_namespace, 2, namespace_id);
-    handle_sql_error(status, __LINE__);
-    status = sqlite3_bind_int64(stmt_insert_class_namespace, 3, done);
-    handle_sql_error(status, __LINE__);
+    return end + 1;
+}
 
-    status = sqlite3_step(stmt_insert_class_namespace);
-    if (status == SQLITE_CONSTRAINT) {
-        if (done == FALSE) return TRUE;
+/*
+ * Map the path of every class with a versioned entry for the release to
+ * the index + 1 of the entry with the highest version not above it
+ *
+ * Only the names of the central directory are looked at, so no entry has
+ * to be decompressed. The keys point into the names of the archive.
+ */
+GHashTable *select_versioned_entries(struct zip *jar, int numfiles)
+{
+    GHashTable *selected = g_hash_table_new(g_str_hash, g_str_equal);
 
-        // check if we have a namespace collision
-        sqlite3_reset(stmt_is_done);
-        status = sqlite3_bind_int64(stmt_is_done, 1, class_id);
-        handle_sql_error(status, __LINE__);
-        status = sqlite3_bind_int64(stmt_is_done, 2, namespace_id);
-        handle_sql_error(status, __LINE__);
+    for (int i = 0; i < numfiles; i++) {
+        const gchar *filename = zip_get_name(jar, i, 0);
+        const gchar *path = NULL;
+        int version = 0;
 
-        status = sqlite3_step(stmt_is_done);
-        handle_sql_error(status, __LINE__);
+        if (filename == NULL) continue;
+        if (!g_str_has_prefix(filename, VERSIONS_DIR)) continue;
+        if (!g_str_has_suffix(filename, ".class")) continue;
 
-        gint64 is_done = sqlite3_column_int(stmt_is_done, 0);
+        path = versioned_path(filename, &version);
+        if (path == NULL || version > release) continue;
 
-        if (!is_done) {
-            // set the done flag
-            sqlite3_reset(stmt_set_done);
-            status = sqlite3_bind_int64(stmt_set_done, 1, class_id);
-            handle_sql_error(status, __LINE__);
-            status = sqlite3_bind_int64(stmt_set_done, 2, namespace_id);
-            handle_sql_error(status, __LINE__);
+        gint selected_index = GPOINTER_TO_INT(
+                g_hash_table_lookup(selected, path));
 
-            status = sqlite3_step(stmt_set_done);
-            handle_sql_error(status, __LINE__);
+        if (selected_index > 0) {
+            int selected_version = 0;
 
-            return TRUE;
+            versioned_path(zip_get_name(jar, selected_index - 1, 0),
+                    &selected_version);
+            if (selected_version >= version) continue;
         }
 
-        return FALSE;
-    } else {
-        handle_sql_error(status, __LINE__);
+        g_hash_table_insert(selected, (gpointer) path,
+                GINT_TO_POINTER(i + 1));
     }
 
-    return TRUE; // everything is ok
+    return selected;
 }
 
-
-void set_class_attributes(JavaClass *c, gint64 class_id, gint64 namespace_id,
-        gint64 parent_class_id, gint64 parent_namespace_id)
+/*
+ * Insert a JAR or directory the classes are read from and return its ID
+ *
+ * The ID is assigned by the database if id is 0.
+ */
+gint64 insert_container(const gchar *path, gint64 id)
 {
     int status = 0;
 
-    sqlite3_reset(stmt_set_class_attributes);
-    status = sqlite3_bind_int64(stmt_set_class_attributes, 1,
-            parent_class_id);
-    handle_sql_error(status, __LINE__);
-    status = sqlite3_bind_int64(stmt_set_class_attributes, 2,
-            parent_namespace_id);
-    handle_sql_error(status, __LINE__);
-    status = sqlite3_bind_int(stmt_set_class_attributes, 3,
-            javaclass_is_public(c));
+    sqlite3_reset(stmt_insert_container);
+    status = bind_id_or_null(stmt_insert_container, 1, id);
     handle_sql_error(status, __LINE__);
-    status = sqlite3_bind_int(stmt_set_class_attributes, 4,
-            javaclass_is_final(c));
-    handle_sql_error(status, __LINE__);
-    status = sqlite3_bind_int(stmt_set_class_attributes, 5,
-            javaclass_is_interface(c));
-    handle_sql_error(status, __LINE__);
-    status = sqlite3_bind_int(stmt_set_class_attributes, 6,
-            javaclass_is_abstract(c));
-    handle_sql_error(status, __LINE__);
-    status = sqlite3_bind_int(stmt_set_class_attributes, 7,
-            javaclass_is_annotation(c));
-    handle_sql_error(status, __LINE__);
-    status = sqlite3_bind_int(stmt_set_class_attributes, 8,
-            javaclass_is_enum(c));
-    handle_sql_error(status, __LINE__);
-    status = sqlite3_bind_text(stmt_set_class_attributes, 9,
-            javaclass_get_signature(c), -1, SQLITE_STATIC);
-    handle_sql_error(status, __LINE__);
-    status = sqlite3_bind_int64(stmt_set_class_attributes, 10, class_id);
-    handle_sql_error(status, __LINE__);
-    status = sqlite3_bind_int64(stmt_set_class_attributes, 11, namespace_id);
+    status = sqlite3_bind_text(stmt_insert_container, 2,
+            path, -1, SQLITE_STATIC);
     handle_sql_error(status, __LINE__);
 
-    status = sqlite3_step(stmt_set_class_attributes);
+    status = sqlite3_step(stmt_insert_container);
     handle_sql_error(status, __LINE__);
+
+    return sqlite3_last_insert_rowid(db);
+}
+
+/*
+ * Check if a container was completed by the run which is resumed
+ */
+gboolean is_completed(const gchar *path)
+{
+    if (completed_containers == NULL) return FALSE;
+
+    return g_hash_table_contains(completed_containers, path);
 }
 
 /*
- * Insert all fields of a class into the database
+ * Mark a container as complete and commit everything indexed so far, so
+ * that an interrupted run can be resumed after it
  */
-void insert_fields(JavaClass *c, gint64 class_id, gint64 namespace_id)
+void complete_container(gint64 container_id)
 {
     int status = 0;
+    gint64 start = 0;
 
-    if (javaclass_get_field_number(c) <= 0) return;
+    sqlite3_reset(stmt_complete_container);
+    status = sqlite3_bind_int64(stmt_complete_container, 1, container_id);
+    handle_sql_error(status, __LINE__);
 
-    JavaField** fields = javaclass_get_fields(c);
-    for (int i = 0; fields[i]; i++) {
-        sqlite3_reset(stmt_insert_field);
-        status = sqlite3_bind_text(stmt_insert_field, 1,
-                javafield_get_name(fields[i]), -1, SQLITE_STATIC);
-        handle_sql_error(status, __LINE__);
-        status = sqlite3_bind_text(stmt_insert_field, 2,
-                javafield_get_descriptor(fields[i]), -1, SQLITE_STATIC);
-        handle_sql_error(status, __LINE__);
-        status = sqlite3_bind_text(stmt_insert_field, 3,
-                javafield_get_signature(fields[i]), -1, SQLITE_STATIC);
-        handle_sql_error(status, __LINE__);
-        status = sqlite3_bind_int64(stmt_insert_field, 4,
-                class_id);
-        handle_sql_error(status, __LINE__);
-        status = sqlite3_bind_int64(stmt_insert_field, 5,
-                namespace_id);
-        handle_sql_error(status, __LINE__);
-        status = sqlite3_bind_int(stmt_insert_field, 6,
-                javafield_is_public(fields[i]));
-        handle_sql_error(status, __LINE__);
-        status = sqlite3_bind_int(stmt_insert_field, 7,
-                javafield_is_protected(fields[i]));
-        handle_sql_error(status, __LINE__);
-        status = sqlite3_bind_int(stmt_insert_field, 8,
-                javafield_is_private(fields[i]));
-        handle_sql_error(status, __LINE__);
-        status = sqlite3_bind_int(stmt_insert_field, 9,
-                javafield_is_static(fields[i]));
-        handle_sql_error(status, __LINE__);
-        status = sqlite3_bind_int(stmt_insert_field, 10,
-                javafield_is_final(fields[i]));
-        handle_sql_error(status, __LINE__);
-        status = sqlite3_bind_int(stmt_insert_field, 11,
-                javafield_is_enum(fields[i]));
-        handle_sql_error(status, __LINE__);
+    status = sqlite3_step(stmt_complete_container);
+    handle_sql_error(status, __LINE__);
 
-        status = sqlite3_step(stmt_insert_field);
-        handle_sql_error(status, __LINE__);
-    }
+    start = trace_start();
+    status = sqlite3_exec(db, "COMMIT", NULL, 0, NULL);
+    handle_sql_error(status, __LINE__);
+    status = sqlite3_exec(db, "BEGIN TRANSACTION", NULL, 0, NULL);
+    handle_sql_error(status, __LINE__);
+    trace_end("sqlite", "COMMIT", start, -1);
+
+    uncommitted_classes = 0;
 }
 
 /*
- * Insert all methods of a class into the database
+ * Start a container which is indexed into the database
  */
-void insert_methods(JavaClass *c, gint64 class_id, gint64 namespace_id)
+void insert_container_start(const gchar *path, gpointer user_data)
 {
-    int status = 0;
+    current_container_id = insert_container(path, 0);
+}
+
+/*
+ * Finish the container which is indexed into the database
+ */
+void insert_container_end(gpointer user_data)
+{
+    complete_container(current_container_id);
+}
+
+/*
+ * Insert a new file into the database
+ */
+void insert_file(const gchar *path, const gchar *filename, gpointer user_data)
+{
+    int status = 0;
+
+    sqlite3_reset(stmt_insert_file);
+    status = sqlite3_bind_text(stmt_insert_file, 1,
+            path, -1, SQLITE_STATIC);
+    status = sqlite3_bind_text(stmt_insert_file, 2,
+            filename, -1, SQLITE_STATIC);
+    handle_sql_error(status, __LINE__);
+
+    status = sqlite3_step(stmt_insert_file);
+    handle_sql_error(status, __LINE__);
+}
+
+/*
+ * Give the memory of the string tables back if their current generation
+ * grew beyond its limit
+ *
+ * Strings which are still in use move back into the new generation on
+ * their next lookup, all others have to be looked up in the database
+ * again once the generation after it starts.
+ */
+void limit_string_tables()
+{
+    SymCache *caches[STRINGS_NUM];
+
+    for (int i = 0; i < STRINGS_NUM; i++) {
+        caches[i] = &string_tables[i].strings;
+    }
+
+    symcache_limit(caches, STRINGS_NUM, string_tables_limit);
+}
+
+/*
+ * Look up the ID of a string in the database; needs the unique index on the
+ * name column which is created up front with --max-memory
+ */
+gint64 select_string_id(StringTable *table, const gchar *str)
+{
+    int status = 0;
+    gint64 id  = 0;
+
+    sqlite3_reset(table->stmt_select);
+    status = sqlite3_bind_text(table->stmt_select, 1, str, -1, SQLITE_STATIC);
+    handle_sql_error(status, __LINE__);
+
+    status = sqlite3_step(table->stmt_select);
+    handle_sql_error(status, __LINE__);
+
+    if (status == SQLITE_ROW) id = sqlite3_column_int64(table->stmt_select, 0);
+
+    return id;
+}
+
+/*
+ * Look up a string in one of the string tables and insert it into the
+ * database if it wasn't seen before
+ *
+ * A newly inserted string is also written to the TSV export if it is
+ * enabled.
+ */
+gint64 intern_string(StringTable *table, const gchar *str)
+{
+    int status   = 0;
+    guint64 hash = symtab_hash(str);
+    gint64 id    = 0;
+
+    // check if the string was already inserted and return its ID if this is
+    // the case
+    id = symtab_lookup(table->strings.current, str, hash);
+
+    if (id != 0) return id;
+
+    // with --max-memory the string might have been dropped from memory
+    if (table->strings.previous != NULL) {
+        id = symcache_lookup(&table->strings, str, hash);
+        if (id == 0) {
+            gint64 start = g_get_monotonic_time();
+
+            id = select_string_id(table, str);
+            stats.name_lookups++;
+            stats.name_lookup_time += g_get_monotonic_time() - start;
+
+            if (id != 0) symtab_insert(table->strings.current, str, hash, id);
+        }
+
+        if (id != 0) {
+            limit_string_tables();
+
+            return id;
+        }
+    }
+
+    sqlite3_reset(table->stmt_insert);
+    status = sqlite3_bind_text(table->stmt_insert, 1, str, -1, SQLITE_STATIC);
+    handle_sql_error(status, __LINE__);
+
+    status = sqlite3_step(table->stmt_insert);
+    handle_sql_error(status, __LINE__);
+
+    id = sqlite3_last_insert_rowid(db);
+    symtab_insert(table->strings.current, str, hash, id);
+
+    if (max_memory > 0) limit_string_tables();
+
+    FILE *export = export_fp[table->export];
+    if (export != NULL) {
+        export_int(export, id, FALSE);
+        export_string(export, str, TRUE);
+    }
+
+    return id;
+}
+
+/*
+ * Insert a new namespace into the database or do nothing if it already exists
+ */
+gint64 insert_namespace(const gchar* namespace)
+{
+    return intern_string(&string_tables[STRINGS_NAMESPACES], namespace);
+}
+
+/*
+ * Insert a new class into the database and return its id
+ */
+gint64 insert_class(const gchar* classname)
+{
+    return intern_string(&string_tables[STRINGS_IMPORTABLES], classname);
+}
+
+/*
+ * Insert a field or method descriptor into the database and return its id
+ */
+gint64 insert_descriptor(const gchar* descriptor)
+{
+    return intern_string(&string_tables[STRINGS_DESCRIPTORS], descriptor);
+}
+
+/*
+ * Insert a generic signature into the database and return its id or 0 if
+ * there is no signature
+ */
+gint64 insert_signature(const gchar* signature)
+{
+    if (signature == NULL) return 0;
+
+    return intern_string(&string_tables[STRINGS_SIGNATURES], signature);
+}
+
+/*
+ * Bind a string ID to a statement or NULL if the ID is 0
+ */
+int bind_id_or_null(sqlite3_stmt *stmt, int col, gint64 id)
+{
+    if (id == 0) return sqlite3_bind_null(stmt, col);
+
+    return sqlite3_bind_int64(stmt, col, id);
+}
+
+/*
+ * Associate a class with its namespace
+ */
+gboolean associate_class_and_namespace(gint64 class_id, gint64 namespace_id,
+        gboolean done)
+{
+    int status = 0;
+    int done_int = 0;
+
+    if (done) done_int = 1;
+
+    sqlite3_reset(stmt_insert_class_namespace);
+    status = sqlite3_bind_int64(stmt_insert_class_namespace, 1, class_id);
+    handle_sql_error(status, __LINE__);
+    status = sqlite3_bind_int64(stmt_insert_class_namespace, 2, namespace_id);
+    handle_sql_error(status, __LINE__);
+    status = sqlite3_bind_int64(stmt_insert_class_namespace, 3, done);
+    handle_sql_error(status, __LINE__);
+
+    status = sqlite3_step(stmt_insert_class_namespace);
+    if (status == SQLITE_CONSTRAINT) {
+        if (done == FALSE) return TRUE;
+
+        // check if we have a namespace collision
+        sqlite3_reset(stmt_is_done);
+        status = sqlite3_bind_int64(stmt_is_done, 1, class_id);
+        handle_sql_error(status, __LINE__);
+        status = sqlite3_bind_int64(stmt_is_done, 2, namespace_id);
+        handle_sql_error(status, __LINE__);
+
+        status = sqlite3_step(stmt_is_done);
+        handle_sql_error(status, __LINE__);
+
+        gint64 is_done = sqlite3_column_int(stmt_is_done, 0);
+
+        if (!is_done) {
+            // set the done flag
+            sqlite3_reset(stmt_set_done);
+            status = sqlite3_bind_int64(stmt_set_done, 1, class_id);
+            handle_sql_error(status, __LINE__);
+            status = sqlite3_bind_int64(stmt_set_done, 2, namespace_id);
+            handle_sql_error(status, __LINE__);
+
+            status = sqlite3_step(stmt_set_done);
+            handle_sql_error(status, __LINE__);
+
+            return TRUE;
+        }
+
+        return FALSE;
+    } else {
+        handle_sql_error(status, __LINE__);
+    }
+
+    return TRUE; // everything is ok
+}
+
+void set_class_attributes(SinkClass *c, gint64 class_id, gint64 namespace_id,
+        gint64 parent_class_id, gint64 parent_namespace_id)
+{
+    int status = 0;
+
+    sqlite3_reset(stmt_set_class_attributes);
+    status = sqlite3_bind_int64(stmt_set_class_attributes, 1,
+            parent_class_id);
+    handle_sql_error(status, __LINE__);
+    status = sqlite3_bind_int64(stmt_set_class_attributes, 2,
+            parent_namespace_id);
+    handle_sql_error(status, __LINE__);
+    status = sqlite3_bind_int64(stmt_set_class_attributes, 3,
+            c->access_flags);
+    handle_sql_error(status, __LINE__);
+    status = sqlite3_bind_text(stmt_set_class_attributes, 4,
+            c->signature, -1, SQLITE_STATIC);
+    handle_sql_error(status, __LINE__);
+    status = sqlite3_bind_int64(stmt_set_class_attributes, 5,
+            current_container_id);
+    handle_sql_error(status, __LINE__);
+    status = sqlite3_bind_int64(stmt_set_class_attributes, 6, class_id);
+    handle_sql_error(status, __LINE__);
+    status = sqlite3_bind_int64(stmt_set_class_attributes, 7, namespace_id);
+    handle_sql_error(status, __LINE__);
+
+    status = sqlite3_step(stmt_set_class_attributes);
+    handle_sql_error(status, __LINE__);
+
+    if (export_dir != NULL) {
+        FILE *fp = export_fp[EXPORT_CLASSES];
+
+        export_int(fp, class_id, FALSE);
+        export_int(fp, namespace_id, FALSE);
+        export_int(fp, parent_class_id, FALSE);
+        export_int(fp, parent_namespace_id, FALSE);
+        export_int(fp, c->access_flags, FALSE);
+        export_string(fp, c->signature, TRUE);
+    }
+}
+
+/*
+ * Insert a field of the class which is indexed into the database
+ */
+void insert_field(SinkMember *field, gpointer user_data)
+{
+    int status = 0;
+    gint64 class_id = indexed_class.class_id;
+    gint64 namespace_id = indexed_class.namespace_id;
+    gint64 descriptor_id = insert_descriptor(field->descriptor);
+    gint64 signature_id = insert_signature(field->signature);
+
+    sqlite3_reset(stmt_insert_field);
+    status = sqlite3_bind_text(stmt_insert_field, 1,
+            field->name, -1, SQLITE_STATIC);
+    handle_sql_error(status, __LINE__);
+    status = sqlite3_bind_int64(stmt_insert_field, 2,
+            descriptor_id);
+    handle_sql_error(status, __LINE__);
+    status = bind_id_or_null(stmt_insert_field, 3,
+            signature_id);
+    handle_sql_error(status, __LINE__);
+    status = sqlite3_bind_int64(stmt_insert_field, 4,
+            class_id);
+    handle_sql_error(status, __LINE__);
+    status = sqlite3_bind_int64(stmt_insert_field, 5,
+            namespace_id);
+    handle_sql_error(status, __LINE__);
+    status = sqlite3_bind_int64(stmt_insert_field, 6,
+            field->access_flags);
+    handle_sql_error(status, __LINE__);
+    status = sqlite3_bind_int64(stmt_insert_field, 7,
+            ++last_field_id);
+    handle_sql_error(status, __LINE__);
+
+    status = sqlite3_step(stmt_insert_field);
+    handle_sql_error(status, __LINE__);
+
+    if (export_dir != NULL) {
+        FILE *fp = export_fp[EXPORT_FIELDS];
+
+        export_int(fp, class_id, FALSE);
+        export_int(fp, namespace_id, FALSE);
+        export_string(fp, field->name, FALSE);
+        export_int(fp, descriptor_id, FALSE);
+        export_id(fp, signature_id, FALSE);
+        export_int(fp, field->access_flags, TRUE);
+    }
+}
+
+/*
+ * Insert a method of the class which is indexed into the database
+ */
+void insert_method(SinkMember *method, gpointer user_data)
+{
+    int status = 0;
+    gint64 class_id = indexed_class.class_id;
+    gint64 namespace_id = indexed_class.namespace_id;
+    gint64 descriptor_id = insert_descriptor(method->descriptor);
+    gint64 signature_id = insert_signature(method->signature);
+
+    sqlite3_reset(stmt_insert_method);
+    status = sqlite3_bind_text(stmt_insert_method, 1,
+            method->name, -1, SQLITE_STATIC);
+    handle_sql_error(status, __LINE__);
+    status = sqlite3_bind_int64(stmt_insert_method, 2,
+            descriptor_id);
+    handle_sql_error(status, __LINE__);
+    status = bind_id_or_null(stmt_insert_method, 3,
+            signature_id);
+    handle_sql_error(status, __LINE__);
+    status = sqlite3_bind_int64(stmt_insert_method, 4,
+            class_id);
+    handle_sql_error(status, __LINE__);
+    status = sqlite3_bind_int64(stmt_insert_method, 5,
+            namespace_id);
+    handle_sql_error(status, __LINE__);
+    status = sqlite3_bind_int64(stmt_insert_method, 6,
+            method->access_flags);
+    handle_sql_error(status, __LINE__);
+    bind_code_stats(stmt_insert_method, 7, method->code);
+    indexed_class.method_id = ++last_method_id;
+    status = sqlite3_bind_int64(stmt_insert_method, 12,
+            indexed_class.method_id);
+    handle_sql_error(status, __LINE__);
+
+    status = sqlite3_step(stmt_insert_method);
+    handle_sql_error(status, __LINE__);
+
+    if (export_dir != NULL) {
+        FILE *fp = export_fp[EXPORT_METHODS];
+
+        export_int(fp, indexed_class.method_id, FALSE);
+        export_int(fp, class_id, FALSE);
+        export_int(fp, namespace_id, FALSE);
+        export_string(fp, method->name, FALSE);
+        export_int(fp, descriptor_id, FALSE);
+        export_id(fp, signature_id, FALSE);
+        export_int(fp, method->access_flags, FALSE);
+        export_code_stats(fp, method->code);
+    }
+}
+
+/*
+ * Insert an exception declared by the method inserted last
+ */
+void insert_exception(const gchar *name, gpointer user_data)
+{
+    int status = 0;
+    gchar *classname = javaclass_extract_classname(name);
+    gchar *package = javaclass_extract_package(name);
+
+    gint64 namespace_id = insert_namespace(package);
+    g_free(package);
+
+    gint64 class_id = insert_class(classname);
+    g_free(classname);
+
+    associate_class_and_namespace(class_id, namespace_id, FALSE);
+
+    sqlite3_reset(stmt_insert_exception);
+    status = sqlite3_bind_int64(stmt_insert_exception, 1,
+            indexed_class.method_id);
+    handle_sql_error(status, __LINE__);
+    status = sqlite3_bind_int64(stmt_insert_exception, 2,
+            class_id);
+    handle_sql_error(status, __LINE__);
+    status = sqlite3_bind_int64(stmt_insert_exception, 3,
+            namespace_id);
+    handle_sql_error(status, __LINE__);
+
+    status = sqlite3_step(stmt_insert_exception);
+    handle_sql_error(status, __LINE__);
+}
+
+/*
+ * Read the figures of the Code attribute of the method at offset member of
+ * the scanned class
+ *
+ * The methods of libclassreader are in the order of the class file, but
+ * the name is compared anyway so that a method never gets the figures of
+ * another one. Returns FALSE if the method has no code or the class
+ * couldn't be scanned.
+ */
+gboolean method_code_stats(ClassScan *scan, gsize member, const gchar *name,
+        CodeStats *stats)
+{
+    if (!classscan_member_is(scan, member, name)) return FALSE;
+
+    return bytecode_code_stats(scan, member, stats);
+}
+
+/*
+ * Bind the figures of a Code attribute to five columns starting at col or
+ * NULL if the method has no code
+ */
+void bind_code_stats(sqlite3_stmt *stmt, int col, CodeStats *stats)
+{
+    int status = 0;
+
+    if (stats == NULL) {
+        for (int i = 0; i < 5; i++) {
+            status = sqlite3_bind_null(stmt, col + i);
+            handle_sql_error(status, __LINE__);
+        }
+
+        return;
+    }
+
+    status = sqlite3_bind_int64(stmt, col, stats->code_length);
+    handle_sql_error(status, __LINE__);
+    status = sqlite3_bind_int(stmt, col + 1, stats->max_stack);
+    handle_sql_error(status, __LINE__);
+    status = sqlite3_bind_int(stmt, col + 2, stats->max_locals);
+    handle_sql_error(status, __LINE__);
+    status = sqlite3_bind_int(stmt, col + 3, stats->exception_handlers);
+    handle_sql_error(status, __LINE__);
+    status = sqlite3_bind_int64(stmt, col + 4, stats->invocations);
+    handle_sql_error(status, __LINE__);
+}
+
+/*
+ * Export the figures of a Code attribute as the last five columns of a
+ * row or \N if the method has no code
+ */
+void export_code_stats(FILE *fp, CodeStats *stats)
+{
+    if (stats == NULL) {
+        for (int i = 0; i < 5; i++) export_string(fp, NULL, i == 4);
+        return;
+    }
+
+    export_int(fp, stats->code_length, FALSE);
+    export_int(fp, stats->max_stack, FALSE);
+    export_int(fp, stats->max_locals, FALSE);
+    export_int(fp, stats->exception_handlers, FALSE);
+    export_int(fp, stats->invocations, TRUE);
+}
+
+/*
+ * Insert an interface implemented by the class which is indexed
+ */
+void insert_interface(const gchar *name, gpointer user_data)
+{
+    int status = 0;
+    gint64 class_id = indexed_class.class_id;
+    gint64 namespace_id = indexed_class.namespace_id;
+
+    if (g_strrstr(name, "$") != NULL) return; // skip inner interfaces
+
+    gchar *classname = javaclass_extract_classname(name);
+    gchar *package = javaclass_extract_package(name);
+
+    gint64 interface_namespace_id = insert_namespace(package);
+    g_free(package);
+
+    gint64 interface_class_id = insert_class(classname);
+    g_free(classname);
+
+    associate_class_and_namespace(interface_class_id,
+            interface_namespace_id, FALSE);
+
+    sqlite3_reset(stmt_insert_interface);
+    status = sqlite3_bind_int64(stmt_insert_interface, 1,
+            class_id);
+    handle_sql_error(status, __LINE__);
+    status = sqlite3_bind_int64(stmt_insert_interface, 2,
+            namespace_id);
+    handle_sql_error(status, __LINE__);
+
+    status = sqlite3_bind_int64(stmt_insert_interface, 3,
+            interface_class_id);
+    handle_sql_error(status, __LINE__);
+    status = sqlite3_bind_int64(stmt_insert_interface, 4,
+            interface_namespace_id);
+    handle_sql_error(status, __LINE__);
+
+    status = sqlite3_step(stmt_insert_interface);
+    handle_sql_error(status, __LINE__);
+
+    if (export_dir != NULL) {
+        FILE *fp = export_fp[EXPORT_INTERFACES];
+
+        export_int(fp, class_id, FALSE);
+        export_int(fp, namespace_id, FALSE);
+        export_int(fp, interface_class_id, FALSE);
+        export_int(fp, interface_namespace_id, TRUE);
+    }
+}
+
+/*
+ * Store the compressed summary record of a class
+ */
+void insert_summary(JavaClass *c, ClassScan *scan, gint64 class_id,
+        gint64 namespace_id)
+{
+    int status = 0;
+    GByteArray *record = summary_new(c, scan);
+    gsize compressed_size = 0;
+    guchar *compressed = summary_compress(record->data, record->len,
+            &compressed_size);
+
+    if (compressed == NULL) {
+        fprintf(stderr, "ERROR: Can't compress the summary of %s\n",
+                javaclass_get_fq_name(c));
+        g_byte_array_free(record, TRUE);
+        return;
+    }
+
+    sqlite3_reset(stmt_insert_summary);
+    status = sqlite3_bind_text(stmt_insert_summary, 1,
+            javaclass_get_fq_name(c), -1, SQLITE_STATIC);
+    handle_sql_error(status, __LINE__);
+    status = sqlite3_bind_int64(stmt_insert_summary, 2, class_id);
+    handle_sql_error(status, __LINE__);
+    status = sqlite3_bind_int64(stmt_insert_summary, 3, namespace_id);
+    handle_sql_error(status, __LINE__);
+    status = sqlite3_bind_int64(stmt_insert_summary, 4, record->len);
+    handle_sql_error(status, __LINE__);
+    status = sqlite3_bind_blob(stmt_insert_summary, 5, compressed,
+            compressed_size, SQLITE_STATIC);
+    handle_sql_error(status, __LINE__);
+
+    status = sqlite3_step(stmt_insert_summary);
+    handle_sql_error(status, __LINE__);
+
+    g_free(compressed);
+    g_byte_array_free(record, TRUE);
+}
+
+/*
+ * Read the next u2 of an attribute; returns FALSE at its end
+ */
+gboolean read_u2(const guchar **pos, const guchar *end, guint16 *value)
+{
+    if (*pos + 2 > end) return FALSE;
+
+    *value = classscan_u2(*pos);
+    *pos += 2;
+
+    return TRUE;
+}
+
+/*
+ * Insert a module with the modules it requires and the packages it exports
+ */
+void insert_module(SinkModule *module, gpointer user_data)
+{
+    int status = 0;
+
+    sqlite3_reset(stmt_insert_module);
+    status = sqlite3_bind_text(stmt_insert_module, 1, module->name, -1,
+            SQLITE_STATIC);
+    handle_sql_error(status, __LINE__);
+    status = sqlite3_bind_text(stmt_insert_module, 2, module->version, -1,
+            SQLITE_STATIC);
+    handle_sql_error(status, __LINE__);
+    status = sqlite3_bind_int64(stmt_insert_module, 3, module->access_flags);
+    handle_sql_error(status, __LINE__);
+    status = bind_id_or_null(stmt_insert_module, 4, current_container_id);
+    handle_sql_error(status, __LINE__);
+
+    status = sqlite3_step(stmt_insert_module);
+    handle_sql_error(status, __LINE__);
+
+    gint64 module_id = sqlite3_last_insert_rowid(db);
+
+    for (guint i = 0; i < module->requires->len; i++) {
+        SinkRequire *require = &g_array_index(module->requires, SinkRequire,
+                i);
+
+        sqlite3_reset(stmt_insert_module_require);
+        status = sqlite3_bind_int64(stmt_insert_module_require, 1, module_id);
+        handle_sql_error(status, __LINE__);
+        status = sqlite3_bind_text(stmt_insert_module_require, 2,
+                require->name, -1, SQLITE_STATIC);
+        handle_sql_error(status, __LINE__);
+        status = sqlite3_bind_text(stmt_insert_module_require, 3,
+                require->version, -1, SQLITE_STATIC);
+        handle_sql_error(status, __LINE__);
+        status = sqlite3_bind_int64(stmt_insert_module_require, 4,
+                require->flags);
+        handle_sql_error(status, __LINE__);
+
+        status = sqlite3_step(stmt_insert_module_require);
+        handle_sql_error(status, __LINE__);
+    }
+
+    for (guint i = 0; i < module->exports->len; i++) {
+        SinkExport *export = &g_array_index(module->exports, SinkExport, i);
+
+        sqlite3_reset(stmt_insert_module_export);
+        status = sqlite3_bind_int64(stmt_insert_module_export, 1, module_id);
+        handle_sql_error(status, __LINE__);
+        status = sqlite3_bind_text(stmt_insert_module_export, 2,
+                export->package, -1, SQLITE_STATIC);
+        handle_sql_error(status, __LINE__);
+        status = sqlite3_bind_text(stmt_insert_module_export, 3,
+                export->target, -1, SQLITE_STATIC);
+        handle_sql_error(status, __LINE__);
+        status = sqlite3_bind_int64(stmt_insert_module_export, 4,
+                export->flags);
+        handle_sql_error(status, __LINE__);
+
+        status = sqlite3_step(stmt_insert_module_export);
+        handle_sql_error(status, __LINE__);
+    }
+}
+
+/*
+ * Free the strings of a module read by index_module()
+ */
+void free_module(SinkModule *module)
+{
+    for (guint i = 0; i < module->requires->len; i++) {
+        SinkRequire *require = &g_array_index(module->requires, SinkRequire,
+                i);
+
+        g_free(require->name);
+        g_free(require->version);
+    }
+
+    for (guint i = 0; i < module->exports->len; i++) {
+        SinkExport *export = &g_array_index(module->exports, SinkExport, i);
+
+        g_free(export->package);
+        g_free(export->target);
+    }
+
+    g_array_free(module->requires, TRUE);
+    g_array_free(module->exports, TRUE);
+    g_free(module->name);
+    g_free(module->version);
+}
+
+/*
+ * Pass a module read from the Module attribute of a module-info.class with
+ * the modules it requires and the packages it exports to the sink
+ *
+ * module-info.class isn't a class, so it is read with the raw class file
+ * scanner instead of libclassreader. Of a truncated descriptor what could
+ * be read is passed on.
+ */
+void index_module(const guchar *data, gsize size, const gchar *filename)
+{
+    ClassScan scan;
+    SinkModule module;
+    const guchar *pos = NULL;
+    const guchar *end = NULL;
+    guint32 length = 0;
+    guint16 name_index = 0, flags = 0, version_index = 0, count = 0;
+    gboolean ok = FALSE;
+
+    memset(&scan, 0, sizeof(ClassScan));
+    memset(&module, 0, sizeof(SinkModule));
+
+    if (classscan_init(&scan, data, size) && scan.access_flags & ACC_MODULE) {
+        pos = classscan_attribute(&scan, "Module", &length);
+    }
+
+    if (pos != NULL) {
+        end = pos + length;
+        ok = read_u2(&pos, end, &name_index) && read_u2(&pos, end, &flags)
+            && read_u2(&pos, end, &version_index);
+    }
+
+    module.name = ok ? classscan_constant_name(&scan, name_index,
+            CONSTANT_Module) : NULL;
+
+    if (module.name == NULL) {
+        fprintf(stderr, "ERROR: %s has no valid module descriptor\n",
+                filename);
+        classscan_clear(&scan);
+        return;
+    }
+
+    module.version      = classscan_string(&scan, version_index);
+    module.access_flags = flags;
+    module.requires     = g_array_new(FALSE, FALSE, sizeof(SinkRequire));
+    module.exports      = g_array_new(FALSE, FALSE, sizeof(SinkExport));
+
+    ok = read_u2(&pos, end, &count);
+    for (guint16 i = 0; ok && i < count; i++) {
+        SinkRequire require;
+
+        ok = read_u2(&pos, end, &name_index) && read_u2(&pos, end, &flags)
+            && read_u2(&pos, end, &version_index);
+        if (!ok) break;
+
+        require.name = classscan_constant_name(&scan, name_index,
+                CONSTANT_Module);
+        if (require.name == NULL) continue;
+
+        require.version = classscan_string(&scan, version_index);
+        require.flags   = flags;
+        g_array_append_val(module.requires, require);
+    }
+
+    ok = ok && read_u2(&pos, end, &count);
+    for (guint16 i = 0; ok && i < count; i++) {
+        guint16 targets = 0;
+        guint16 target_index = 0;
+
+        ok = read_u2(&pos, end, &name_index) && read_u2(&pos, end, &flags)
+            && read_u2(&pos, end, &targets);
+        if (!ok) break;
+
+        gchar *package = classscan_constant_name(&scan, name_index,
+                CONSTANT_Package);
+        if (package != NULL) g_strdelimit(package, "/", '.');
+
+        // an unqualified export is reported once without a target
+        for (guint16 j = 0; j < targets || j == 0; j++) {
+            SinkExport export;
+
+            export.target = NULL;
+
+            if (targets > 0) {
+                ok = read_u2(&pos, end, &target_index);
+                if (!ok) break;
+                export.target = classscan_constant_name(&scan, target_index,
+                        CONSTANT_Module);
+            }
+
+            if (package == NULL) {
+                g_free(export.target);
+                continue;
+            }
+
+            export.package = g_strdup(package);
+            export.flags   = flags;
+            g_array_append_val(module.exports, export);
+        }
+
+        g_free(package);
+    }
+
+    sink->module(&module, sink_data);
+
+    if (!ok) {
+        fprintf(stderr, "ERROR: The module descriptor in %s is truncated\n",
+                filename);
+    }
+
+    free_module(&module);
+    classscan_clear(&scan);
+}
+
+/*
+ * Record that a class of the current container is shadowed by the same
+ * class in a container before it on the class path
+ */
+void insert_shadowed(gint64 class_id, gint64 namespace_id)
+{
+    int status = 0;
+
+    sqlite3_reset(stmt_insert_shadowed);
+    status = sqlite3_bind_int64(stmt_insert_shadowed, 1, class_id);
+    handle_sql_error(status, __LINE__);
+    status = sqlite3_bind_int64(stmt_insert_shadowed, 2, namespace_id);
+    handle_sql_error(status, __LINE__);
+    status = sqlite3_bind_int64(stmt_insert_shadowed, 3,
+            current_container_id);
+    handle_sql_error(status, __LINE__);
+
+    status = sqlite3_step(stmt_insert_shadowed);
+    handle_sql_error(status, __LINE__);
+}
+
+/*
+ * Insert a class referenced by its fully qualified name (e.g. java.util.Map)
+ * unless it is known already and return its ID and the ID of its package
+ */
+gint64 insert_qualified_class(const gchar *name, gint64 *namespace_id)
+{
+    gint64 class_id = insert_class_name(name, namespace_id);
+
+    associate_class_and_namespace(class_id, *namespace_id, FALSE);
+
+    return class_id;
+}
+
+/*
+ * Insert the name and the package of a fully qualified class name into the
+ * string tables without adding the class itself and return their IDs
+ */
+gint64 insert_class_name(const gchar *name, gint64 *namespace_id)
+{
+    const gchar *dot = strrchr(name, '.');
+    gchar *package = NULL;
+
+    if (dot != NULL) {
+        package = g_strndup(name, dot - name);
+    } else {
+        package = g_strdup(DEFAULT_PACKAGE);
+    }
+
+    *namespace_id = insert_namespace(package);
+    gint64 class_id = insert_class(dot != NULL ? dot + 1 : name);
+    g_free(package);
+
+    return class_id;
+}
+
+/*
+ * Insert a provider of a service registered in a resource file of the
+ * current container
+ */
+void insert_service(ServicesKind kind, const gchar *service,
+        const gchar *provider, gpointer user_data)
+{
+    gint64 service_namespace_id = 0;
+    gint64 provider_namespace_id = 0;
+    gint64 service_id = insert_qualified_class(service, &service_namespace_id);
+    gint64 provider_id = insert_qualified_class(provider,
+            &provider_namespace_id);
+    int status = 0;
+
+    sqlite3_reset(stmt_insert_service);
+    status = sqlite3_bind_int64(stmt_insert_service, 1, service_id);
+    handle_sql_error(status, __LINE__);
+    status = sqlite3_bind_int64(stmt_insert_service, 2, service_namespace_id);
+    handle_sql_error(status, __LINE__);
+    status = sqlite3_bind_int64(stmt_insert_service, 3, provider_id);
+    handle_sql_error(status, __LINE__);
+    status = sqlite3_bind_int64(stmt_insert_service, 4, provider_namespace_id);
+    handle_sql_error(status, __LINE__);
+    status = sqlite3_bind_int(stmt_insert_service, 5, kind);
+    handle_sql_error(status, __LINE__);
+    status = bind_id_or_null(stmt_insert_service, 6, current_container_id);
+    handle_sql_error(status, __LINE__);
+
+    status = sqlite3_step(stmt_insert_service);
+    handle_sql_error(status, __LINE__);
+
+    if (export_dir != NULL) {
+        FILE *fp = export_fp[EXPORT_SERVICES];
+
+        export_int(fp, service_id, FALSE);
+        export_int(fp, service_namespace_id, FALSE);
+        export_int(fp, provider_id, FALSE);
+        export_int(fp, provider_namespace_id, FALSE);
+        export_int(fp, kind, FALSE);
+        export_id(fp, current_container_id, TRUE);
+    }
+}
+
+/*
+ * Pass the providers registered in a resource file (ServiceLoader's
+ * META-INF/services/SERVICE or one of Spring's) at path to the sink
+ */
+void index_services(const guchar *data, gsize size, const gchar *path)
+{
+    services_parse(path, (const gchar*) data, size, sink->service, sink_data);
+}
+
+/*
+ * Insert an annotation of the class which is indexed
+ */
+void insert_annotation(SinkAnnotation *annotation, gpointer user_data)
+{
+    gint64 type_namespace_id = 0;
+    gint64 type_class_id = insert_qualified_class(annotation->type,
+            &type_namespace_id);
+    gint64 descriptor_id = annotation->descriptor != NULL
+        ? insert_descriptor(annotation->descriptor) : 0;
+    int status = 0;
+
+    sqlite3_reset(stmt_insert_annotation);
+    status = sqlite3_bind_int64(stmt_insert_annotation, 1, type_class_id);
+    handle_sql_error(status, __LINE__);
+    status = sqlite3_bind_int64(stmt_insert_annotation, 2, type_namespace_id);
+    handle_sql_error(status, __LINE__);
+    status = sqlite3_bind_int64(stmt_insert_annotation, 3,
+            indexed_class.class_id);
+    handle_sql_error(status, __LINE__);
+    status = sqlite3_bind_int64(stmt_insert_annotation, 4,
+            indexed_class.namespace_id);
+    handle_sql_error(status, __LINE__);
+    status = sqlite3_bind_int(stmt_insert_annotation, 5, annotation->target);
+    handle_sql_error(status, __LINE__);
+    status = sqlite3_bind_text(stmt_insert_annotation, 6,
+            annotation->member_name, -1, SQLITE_STATIC);
+    handle_sql_error(status, __LINE__);
+    status = bind_id_or_null(stmt_insert_annotation, 7, descriptor_id);
+    handle_sql_error(status, __LINE__);
+    status = sqlite3_bind_int(stmt_insert_annotation, 8, annotation->visible);
+    handle_sql_error(status, __LINE__);
+
+    status = sqlite3_step(stmt_insert_annotation);
+    handle_sql_error(status, __LINE__);
+
+    indexed_class.annotation_id = sqlite3_last_insert_rowid(db);
+
+    if (export_dir != NULL) {
+        FILE *fp = export_fp[EXPORT_ANNOTATIONS];
+
+        export_int(fp, indexed_class.annotation_id, FALSE);
+        export_int(fp, type_class_id, FALSE);
+        export_int(fp, type_namespace_id, FALSE);
+        export_int(fp, indexed_class.class_id, FALSE);
+        export_int(fp, indexed_class.namespace_id, FALSE);
+        export_int(fp, annotation->target, FALSE);
+        export_string(fp, annotation->member_name, FALSE);
+        export_id(fp, descriptor_id, FALSE);
+        export_int(fp, annotation->visible, TRUE);
+    }
+}
+
+/*
+ * Insert an element value of the annotation inserted last
+ */
+void insert_annotation_value(const gchar *name, const gchar *value,
+        gpointer user_data)
+{
+    int status = 0;
+
+    sqlite3_reset(stmt_insert_annotation_value);
+    status = sqlite3_bind_int64(stmt_insert_annotation_value, 1,
+            indexed_class.annotation_id);
+    handle_sql_error(status, __LINE__);
+    status = sqlite3_bind_text(stmt_insert_annotation_value, 2,
+            name, -1, SQLITE_STATIC);
+    handle_sql_error(status, __LINE__);
+    status = sqlite3_bind_text(stmt_insert_annotation_value, 3,
+            value, -1, SQLITE_STATIC);
+    handle_sql_error(status, __LINE__);
+
+    status = sqlite3_step(stmt_insert_annotation_value);
+    handle_sql_error(status, __LINE__);
+
+    if (export_dir != NULL) {
+        FILE *fp = export_fp[EXPORT_ANNOTATION_VALUES];
+
+        export_int(fp, indexed_class.annotation_id, FALSE);
+        export_string(fp, name, FALSE);
+        export_string(fp, value, TRUE);
+    }
+}
+
+/*
+ * Start indexing a class into the database unless it is there already
+ */
+gboolean insert_class_start(SinkClass *c, gpointer user_data)
+{
+    gboolean no_collision = TRUE;
+    gint64 parent_namespace_id = 0;
+    gint64 parent_class_id = 0;
+
+    gint64 namespace_id = insert_namespace(c->package);
+    g_assert(namespace_id != 0);
+    gint64 class_id = insert_class(c->name);
+    g_assert(class_id != 0);
+
+    no_collision = associate_class_and_namespace(class_id, namespace_id, TRUE);
+
+    // a class which is already indexed shadows this copy, which is only
+    // recorded; java-query shadowed reports them
+    if (!no_collision) {
+        insert_shadowed(class_id, namespace_id);
+        return FALSE;
+    }
+
+    if (c->parent != NULL) {
+        gchar *parent_package = javaclass_extract_package(c->parent);
+        gchar *parent_class   = javaclass_extract_classname(c->parent);
+
+        if (parent_package == NULL) parent_package = DEFAULT_PACKAGE;
+        parent_namespace_id = insert_namespace(parent_package);
+        parent_class_id = insert_class(parent_class);
+
+        if (g_strcmp0(parent_package, DEFAULT_PACKAGE) == 0) g_free(parent_package);
+        g_free(parent_class);
+    }
+
+    set_class_attributes(c, class_id, namespace_id, parent_class_id,
+            parent_namespace_id);
+
+    indexed_class.class_id     = class_id;
+    indexed_class.namespace_id = namespace_id;
+    indexed_class.method_id    = 0;
+    indexed_class.javaclass    = c->javaclass;
+    indexed_class.scan         = c->scan;
+
+    return TRUE;
+}
+
+/*
+ * Finish indexing a class with what only the database keeps of it
+ */
+void insert_class_end(gpointer user_data)
+{
+    if (summaries) {
+        insert_summary(indexed_class.javaclass, indexed_class.scan,
+                indexed_class.class_id, indexed_class.namespace_id);
+    }
+
+    commit_periodically();
+}
+
+IndexSink sqlite_sink = {
+    insert_container_start,
+    insert_file,
+    insert_module,
+    insert_service,
+    insert_class_start,
+    insert_field,
+    insert_method,
+    insert_exception,
+    insert_interface,
+    insert_annotation,
+    insert_annotation_value,
+    insert_class_end,
+    insert_container_end
+};
+
+/*
+ * Pass an annotation of the class or member described by user_data to the
+ * sink
+ */
+void walk_annotation(const gchar *type, gpointer user_data)
+{
+    SinkAnnotation *annotation = user_data;
+
+    annotation->type = type;
+    sink->annotation(annotation, sink_data);
+}
+
+void walk_annotation_value(const gchar *name, const gchar *value,
+        gpointer user_data)
+{
+    sink->annotation_value(name, value, sink_data);
+}
+
+static AnnotationHandler annotation_handler = {
+    walk_annotation,
+    walk_annotation_value
+};
+
+/*
+ * Pass the visible and invisible annotations of the class (member is 0) or
+ * of the field or method at offset member of the scanned class to the sink
+ */
+void walk_member_annotations(ClassScan *scan, gsize member,
+        SinkAnnotation *annotation)
+{
+    static const gchar *ATTRIBUTES[] = {
+        "RuntimeInvisibleAnnotations",
+        "RuntimeVisibleAnnotations"
+    };
+    gchar *member_name = NULL;
+    gchar *descriptor = NULL;
+
+    for (int visible = 0; visible < 2; visible++) {
+        const guchar *info = NULL;
+        guint32 length = 0;
+
+        if (member == 0) {
+            info = classscan_attribute(scan, ATTRIBUTES[visible], &length);
+        } else {
+            info = classscan_member_attribute(scan, member,
+                    ATTRIBUTES[visible], &length);
+        }
+
+        if (info == NULL) continue;
+
+        // the name and descriptor are only needed for annotated members
+        if (member != 0 && member_name == NULL) {
+            member_name = classscan_string(scan,
+                    classscan_u2(scan->data + member + 2));
+            descriptor = classscan_string(scan,
+                    classscan_u2(scan->data + member + 4));
+        }
+
+        annotation->member_name = member_name;
+        annotation->descriptor  = descriptor;
+        annotation->visible     = visible;
+
+        if (!annotations_parse(scan, info, length, &annotation_handler,
+                    annotation)) {
+            fprintf(stderr, "ERROR: Malformed %s\n", ATTRIBUTES[visible]);
+        }
+    }
+
+    g_free(member_name);
+    g_free(descriptor);
+}
+
+/*
+ * Pass the annotations of a class and its fields and methods to the sink
+ *
+ * libclassreader doesn't read annotations, so they are taken from the raw
+ * scan of the bytes of the class file (NULL if it couldn't be scanned).
+ */
+void walk_annotations(ClassScan *scan)
+{
+    SinkAnnotation annotation;
+    gsize member = 0;
+
+    if (scan == NULL) return;
+
+    memset(&annotation, 0, sizeof(SinkAnnotation));
+
+    annotation.target = ANNOTATION_TARGET_CLASS;
+    walk_member_annotations(scan, 0, &annotation);
+
+    annotation.target = ANNOTATION_TARGET_FIELD;
+    member = scan->fields_start;
+    for (guint16 i = 0; i < scan->fields_count; i++) {
+        walk_member_annotations(scan, member, &annotation);
+        member = classscan_next_member(scan, member);
+    }
+
+    annotation.target = ANNOTATION_TARGET_METHOD;
+    member = scan->methods_start;
+    for (guint16 i = 0; i < scan->methods_count; i++) {
+        walk_member_annotations(scan, member, &annotation);
+        member = classscan_next_member(scan, member);
+    }
+}
+
+/*
+ * Pass all fields of a class to the sink
+ */
+void walk_fields(JavaClass *c, ClassScan *scan)
+{
+    SinkMember field;
+    gsize member = scan != NULL ? scan->fields_start : 0;
+
+    if (javaclass_get_field_number(c) <= 0) return;
+
+    JavaField** fields = javaclass_get_fields(c);
+    for (int i = 0; fields[i]; i++) {
+        field.name         = javafield_get_name(fields[i]);
+        field.descriptor   = javafield_get_descriptor(fields[i]);
+        field.signature    = javafield_get_signature(fields[i]);
+        field.access_flags = field_access_flags(fields[i], scan, member);
+        field.code         = NULL;
+        if (member != 0) member = classscan_next_member(scan, member);
+
+        sink->field(&field, sink_data);
+    }
+}
+
+/*
+ * Pass all methods of a class with the exceptions they declare to the sink
+ */
+void walk_methods(JavaClass *c, ClassScan *scan)
+{
+    SinkMember method;
+    gsize member = scan != NULL ? scan->methods_start : 0;
 
     if (javaclass_get_method_number(c) <= 0) return;
 
-    JavaMethod** methods = javaclass_get_methods(c);
-    for (int i = 0; methods[i]; i++) {
-        sqlite3_reset(stmt_insert_method);
-        status = sqlite3_bind_text(stmt_insert_method, 1,
-                javamethod_get_name(methods[i]), -1, SQLITE_STATIC);
-        handle_sql_error(status, __LINE__);
-        status = sqlite3_bind_text(stmt_insert_method, 2,
-                javamethod_get_descriptor(methods[i]), -1, SQLITE_STATIC);
+    JavaMethod** methods = javaclass_get_methods(c);
+    for (int i = 0; methods[i]; i++) {
+        CodeStats stats;
+        gboolean has_code = method_code_stats(scan, member,
+                javamethod_get_name(methods[i]), &stats);
+
+        method.name         = javamethod_get_name(methods[i]);
+        method.descriptor   = javamethod_get_descriptor(methods[i]);
+        method.signature    = javamethod_get_signature(methods[i]);
+        method.access_flags = method_access_flags(methods[i], scan, member);
+        if (member != 0) member = classscan_next_member(scan, member);
+        method.code         = has_code ? &stats : NULL;
+
+        sink->method(&method, sink_data);
+
+        gchar **exceptions = javamethod_get_exceptions(methods[i]);
+        if (exceptions == NULL) continue;
+
+        for (int j = 0; exceptions[j]; j++) {
+            sink->exception(exceptions[j], sink_data);
+        }
+    }
+}
+
+/*
+ * Pass all the interfaces implemented by a class to the sink
+ */
+void walk_interfaces(JavaClass *c)
+{
+    if (javaclass_get_interface_number(c) <= 0) return;
+
+    gchar **interfaces = javaclass_get_interfaces(c);
+
+    for (int i = 0; interfaces[i]; i++) {
+        sink->interface(interfaces[i], sink_data);
+    }
+}
+
+/*
+ * Takes the bytes of a classfile and passes the parsed class to the sink
+ */
+void process_class(JavaClass *c, const guchar *data, gsize size)
+{
+    SinkClass cls;
+
+    cls.package = javaclass_get_package(c);
+    if (cls.package == NULL) cls.package = DEFAULT_PACKAGE;
+    if (strlen(cls.package) <= 0) cls.package = DEFAULT_PACKAGE;
+
+    cls.name         = javaclass_get_name(c);
+    cls.parent       = javaclass_get_fq_parent(c);
+    cls.signature    = javaclass_get_signature(c);
+    cls.javaclass    = c;
+    cls.scan = classscan_init(&class_scan, data, size) ? &class_scan : NULL;
+    cls.access_flags = class_access_flags(c, cls.scan);
+
+    stats.classes++;
+
+    if (sink->begin_class(&cls, sink_data)) {
+        walk_fields(c, cls.scan);
+        walk_methods(c, cls.scan);
+        walk_interfaces(c);
+        walk_annotations(cls.scan);
+        sink->end_class(sink_data);
+    }
+
+    javaclass_free(c);
+}
+
+/*
+ * Index all the entries of a CLASSPATH style list of directories and JARs
+ */
+void index_classpath(gchar *classpath)
+{
+    gchar **entries = NULL;
+
+    if (classpath == NULL) return;
+    if (strlen(classpath) == 0) return;
+
+    entries = g_strsplit(classpath, G_SEARCHPATH_SEPARATOR_S, 0);
+
+    for (int i = 0; entries[i] != NULL; i++) {
+        // let the next JAR be read while this one is indexed
+        if (entries[i + 1] != NULL && nestedjar_is_archive(entries[i + 1])) {
+            readahead_file(entries[i + 1]);
+        }
+
+        if (nestedjar_is_archive(entries[i])) {
+            index_jar(entries[i]);
+        } else {
+            if (g_strcmp0(entries[i], ".") == 0) continue;
+            index_root_dir(entries[i], FALSE);
+        }
+    }
+
+    g_strfreev(entries);
+}
+
+/*
+ * Let the caller continue once the project is committed and index the rest
+ * in a child process
+ *
+ * The database is closed before the fork and opened again by the child
+ * since an SQLite connection must not be used in two processes. The export
+ * files are flushed so that the parent doesn't write their buffers again.
+ */
+void continue_in_background()
+{
+    int status = 0;
+    pid_t pid = 0;
+
+    status = sqlite3_exec(db, "COMMIT", NULL, 0, NULL);
+    handle_sql_error(status, __LINE__);
+
+    finalize_statements();
+    sqlite3_close(db);
+    db = NULL;
+
+    for (int i = 0; i < EXPORT_NUM; i++) {
+        if (export_fp[i] != NULL) fflush(export_fp[i]);
+    }
+
+    pid = fork();
+
+    if (pid < 0) {
+        perror("fork");
+        exit(1);
+    }
+
+    // the parent must not run cleanup() on the state the child goes on with
+    if (pid > 0) _exit(0);
+
+    // don't get killed with the terminal or editor session which started us
+    setsid();
+
+    open_database(DB_FILE);
+    if (max_memory > 0) limit_memory();
+
+    prepare_statements();
+    load_string_tables();
+
+    status = sqlite3_exec(db, "BEGIN TRANSACTION", NULL, 0, NULL);
+    handle_sql_error(status, __LINE__);
+}
+
+/*
+ * Add a container to the list of containers indexed by --jobs
+ */
+Container *add_container(GPtrArray *containers, const gchar *path,
+        gboolean is_jar, gboolean index_filenames)
+{
+    Container *container = g_new0(Container, 1);
+    struct stat st;
+
+    container->path = g_strdup(path);
+    container->is_jar = is_jar;
+    container->index_filenames = index_filenames;
+    if (is_jar && stat(path, &st) == 0) container->size = st.st_size;
+
+    g_ptr_array_add(containers, container);
+
+    return container;
+}
+
+void free_container(gpointer data)
+{
+    Container *container = data;
+
+    g_free(container->path);
+    g_free(container);
+}
+
+/*
+ * Walk a directory like index_dir() does, add up the size of its loose class
+ * files and add each JAR in it as a container of its own
+ */
+void collect_dir(GPtrArray *containers, Container *loose, const gchar *dirname)
+{
+    GPtrArray *names = NULL;
+    const gchar *name = NULL;
+    gchar *fullname = NULL;
+    GError *error = NULL;
+    struct stat st;
+
+    names = readahead_dir(dirname, &error);
+
+    if (error != NULL) {
+        fprintf(stderr, "ERROR: %s\n", error->message);
+        g_error_free(error);
+        return;
+    }
+
+    for (guint i = 0; i < names->len; i++) {
+        name = g_ptr_array_index(names, i);
+        fullname = g_build_filename(dirname, name, NULL);
+
+        if (g_file_test(fullname, G_FILE_TEST_IS_DIR)
+                && !g_str_has_prefix(name, ".")) {
+            collect_dir(containers, loose, fullname);
+        } else if (g_str_has_suffix(fullname, ".class") &&
+                g_strrstr(fullname, "$") == NULL) {
+            if (stat(fullname, &st) == 0) loose->size += st.st_size;
+        } else if (nestedjar_is_archive(fullname)) {
+            add_container(containers, fullname, TRUE, FALSE);
+        }
+
+        g_free(fullname);
+    }
+
+    g_ptr_array_free(names, TRUE);
+}
+
+/*
+ * The artifacts of --repository which are scanned by the thread pool
+ */
+typedef struct {
+    GPtrArray *artifacts;       // sorted by groupId and artifactId
+    GAsyncQueue *scanned;       // indexes + 1 of the scanned artifacts
+} RepositoryScan;
+
+static void scan_artifact(gpointer data, gpointer user_data)
+{
+    RepositoryScan *scan = (RepositoryScan*) user_data;
+    guint index = GPOINTER_TO_UINT(data) - 1;
+
+    repository_scan_artifact(g_ptr_array_index(scan->artifacts, index));
+    g_async_queue_push(scan->scanned, data);
+}
+
+/*
+ * Insert an artifact, its versions and the runs of versions its classes
+ * are in
+ */
+void insert_artifact(Artifact *artifact)
+{
+    int status = 0;
+    gint64 artifact_id = 0;
+    gint64 first_version_id = 0;
+
+    sqlite3_reset(stmt_insert_artifact);
+    status = sqlite3_bind_text(stmt_insert_artifact, 1, artifact->group_id,
+            -1, SQLITE_STATIC);
+    handle_sql_error(status, __LINE__);
+    status = sqlite3_bind_text(stmt_insert_artifact, 2,
+            artifact->artifact_id, -1, SQLITE_STATIC);
+    handle_sql_error(status, __LINE__);
+
+    status = sqlite3_step(stmt_insert_artifact);
+    handle_sql_error(status, __LINE__);
+    artifact_id = sqlite3_last_insert_rowid(db);
+
+    for (guint i = 0; i < artifact->versions->len; i++) {
+        ArtifactVersion *version = g_ptr_array_index(artifact->versions, i);
+        gchar *dirname = g_path_get_dirname(
+                g_ptr_array_index(version->jars, 0));
+
+        sqlite3_reset(stmt_insert_artifact_version);
+        status = sqlite3_bind_int64(stmt_insert_artifact_version, 1,
+                artifact_id);
         handle_sql_error(status, __LINE__);
-        status = sqlite3_bind_text(stmt_insert_method, 3,
-                javamethod_get_signature(methods[i]), -1, SQLITE_STATIC);
+        status = sqlite3_bind_text(stmt_insert_artifact_version, 2,
+                version->version, -1, SQLITE_STATIC);
         handle_sql_error(status, __LINE__);
-        status = sqlite3_bind_int64(stmt_insert_method, 4,
-                class_id);
+        status = sqlite3_bind_text(stmt_insert_artifact_version, 3, dirname,
+                -1, SQLITE_STATIC);
         handle_sql_error(status, __LINE__);
-        status = sqlite3_bind_int64(stmt_insert_method, 5,
-                namespace_id);
+
+        status = sqlite3_step(stmt_insert_artifact_version);
         handle_sql_error(status, __LINE__);
-        status = sqlite3_bind_int(stmt_insert_method, 6,
-                javamethod_is_public(methods[i]));
+        g_free(dirname);
+
+        // the versions are inserted one after another, so their IDs are
+        // consecutive
+        if (i == 0) first_version_id = sqlite3_last_insert_rowid(db);
+    }
+
+    for (guint i = 0; i < artifact->runs->len; i++) {
+        ClassRun *run = g_ptr_array_index(artifact->runs, i);
+        gint64 namespace_id = 0;
+        gint64 class_id = insert_class_name(run->name, &namespace_id);
+
+        sqlite3_reset(stmt_insert_artifact_class);
+        status = sqlite3_bind_int64(stmt_insert_artifact_class, 1, class_id);
         handle_sql_error(status, __LINE__);
-        status = sqlite3_bind_int(stmt_insert_method, 7,
-                javamethod_is_protected(methods[i]));
+        status = sqlite3_bind_int64(stmt_insert_artifact_class, 2,
+                namespace_id);
         handle_sql_error(status, __LINE__);
-        status = sqlite3_bind_int(stmt_insert_method, 8,
-                javamethod_is_private(methods[i]));
+        status = sqlite3_bind_int64(stmt_insert_artifact_class, 3,
+                first_version_id + run->first);
         handle_sql_error(status, __LINE__);
-        status = sqlite3_bind_int(stmt_insert_method, 9,
-                javamethod_is_static(methods[i]));
+        status = sqlite3_bind_int64(stmt_insert_artifact_class, 4,
+                first_version_id + run->last);
         handle_sql_error(status, __LINE__);
-        status = sqlite3_bind_int(stmt_insert_method, 10,
-                javamethod_is_final(methods[i]));
+
+        status = sqlite3_step(stmt_insert_artifact_class);
         handle_sql_error(status, __LINE__);
-        status = sqlite3_bind_int(stmt_insert_method, 11,
-                javamethod_is_synchronized(methods[i]));
+
+        commit_periodically();
+    }
+}
+
+/*
+ * Index which versions of the artifacts in the Maven repositories or Gradle
+ * caches contain which classes
+ *
+ * The JARs are only listed, not indexed like the class path. The artifacts
+ * are scanned by a pool of threads and inserted by this thread in the order
+ * of their coordinates so that the IDs don't depend on the scheduling; at
+ * most a few artifacts per thread are held in memory while one which was
+ * submitted before them is still being scanned.
+ */
+void index_repositories(gchar **roots)
+{
+    GHashTable *artifacts = NULL;
+    GPtrArray *sorted = NULL;
+    RepositoryScan scan;
+    GThreadPool *pool = NULL;
+    gboolean *scanned = NULL;
+    guint window = 0;
+    guint submitted = 0;
+    guint inserted = 0;
+
+    artifacts = g_hash_table_new_full(g_str_hash, g_str_equal, g_free,
+            (GDestroyNotify) repository_artifact_free);
+
+    for (int i = 0; roots[i] != NULL; i++) {
+        repository_collect(roots[i], artifacts);
+    }
+
+    sorted = repository_sorted(artifacts);
+    scanned = g_new0(gboolean, sorted->len);
+    window = threads * 4;
+
+    scan.artifacts = sorted;
+    scan.scanned = g_async_queue_new();
+    pool = g_thread_pool_new(scan_artifact, &scan, threads, TRUE, NULL);
+
+    while (inserted < sorted->len) {
+        while (submitted < sorted->len && submitted - inserted < window) {
+            submitted++;
+            g_thread_pool_push(pool, GUINT_TO_POINTER(submitted), NULL);
+        }
+
+        guint index = GPOINTER_TO_UINT(g_async_queue_pop(scan.scanned)) - 1;
+        scanned[index] = TRUE;
+
+        while (inserted < sorted->len && scanned[inserted]) {
+            Artifact *artifact = g_ptr_array_index(sorted, inserted);
+
+            insert_artifact(artifact);
+
+            g_ptr_array_free(artifact->runs, TRUE);
+            artifact->runs = NULL;
+            inserted++;
+        }
+    }
+
+    g_thread_pool_free(pool, FALSE, TRUE);
+    g_async_queue_unref(scan.scanned);
+    g_free(scanned);
+    g_ptr_array_free(sorted, TRUE);
+    g_hash_table_destroy(artifacts);
+}
+
+/*
+ * Collect the containers of the project, JAVA_HOME and the class path in
+ * the order in which the sequential indexer would read them
+ *
+ * The loose classes of a directory come before the JARs found in it.
+ */
+GPtrArray *collect_containers(gchar *classpath, gchar *javahome)
+{
+    GPtrArray *containers = g_ptr_array_new_with_free_func(free_container);
+    gchar **entries = NULL;
+
+    Container *project = add_container(containers, ".", FALSE, TRUE);
+    collect_dir(containers, project, ".");
+
+    if (javahome != NULL) {
+        Container *loose = add_container(containers, javahome, FALSE, FALSE);
+        collect_dir(containers, loose, javahome);
+    }
+
+    if (classpath != NULL && strlen(classpath) > 0) {
+        entries = g_strsplit(classpath, G_SEARCHPATH_SEPARATOR_S, 0);
+
+        for (int i = 0; entries[i] != NULL; i++) {
+            if (nestedjar_is_archive(entries[i])) {
+                add_container(containers, entries[i], TRUE, FALSE);
+            } else if (g_strcmp0(entries[i], ".") != 0) {
+                Container *loose = add_container(containers, entries[i],
+                        FALSE, FALSE);
+                collect_dir(containers, loose, entries[i]);
+            }
+        }
+
+        g_strfreev(entries);
+    }
+
+    return containers;
+}
+
+gint compare_container_size(gconstpointer a, gconstpointer b)
+{
+    const Container *container_a = *(Container * const *) a;
+    const Container *container_b = *(Container * const *) b;
+
+    if (container_a->size > container_b->size) return -1;
+    if (container_a->size < container_b->size) return 1;
+
+    return 0;
+}
+
+/*
+ * Distribute the containers over the shards
+ *
+ * The largest containers are assigned first, each to the shard with the
+ * least bytes so far, so that the shard writers finish at about the same
+ * time.
+ */
+void assign_shards(GPtrArray *containers)
+{
+    GPtrArray *sorted = g_ptr_array_sized_new(containers->len);
+    gint64 *load = g_new0(gint64, jobs);
+
+    for (guint i = 0; i < containers->len; i++) {
+        g_ptr_array_add(sorted, g_ptr_array_index(containers, i));
+    }
+
+    g_ptr_array_sort(sorted, compare_container_size);
+
+    for (guint i = 0; i < sorted->len; i++) {
+        Container *container = g_ptr_array_index(sorted, i);
+        int shard = 0;
+
+        for (int j = 1; j < jobs; j++) {
+            if (load[j] < load[shard]) shard = j;
+        }
+
+        container->shard = shard;
+        load[shard] += container->size;
+    }
+
+    g_free(load);
+    g_ptr_array_free(sorted, TRUE);
+}
+
+gchar *shard_filename(int shard)
+{
+    return g_strdup_printf("%s.shard%d", DB_FILE, shard);
+}
+
+/*
+ * Index the containers of one shard into its own database; runs in the
+ * child process of the shard
+ *
+ * The containers keep the IDs they have in the order of the class path so
+ * that the merge can decide which of several classes with the same name
+ * comes first.
+ */
+void index_shard(GPtrArray *containers, int shard)
+{
+    gchar *filename = shard_filename(shard);
+    int status = 0;
+
+    create_database(filename);
+    g_free(filename);
+
+    if (max_memory > 0) limit_memory();
+
+    prepare_statements();
+
+    status = sqlite3_exec(db, "BEGIN TRANSACTION", NULL, 0, NULL);
+    handle_sql_error(status, __LINE__);
+
+    for (guint i = 0; i < containers->len; i++) {
+        Container *container = g_ptr_array_index(containers, i);
+
+        if (container->shard != shard) continue;
+
+        current_container_id = insert_container(container->path, i + 1);
+
+        if (container->is_jar) {
+            index_jar_classes(container->path);
+        } else {
+            index_dir(container->path, container->index_filenames, FALSE);
+        }
+    }
+
+    status = sqlite3_exec(db, "COMMIT", NULL, 0, NULL);
+    handle_sql_error(status, __LINE__);
+
+    finalize_statements();
+    sqlite3_close(db);
+    db = NULL;
+}
+
+/*
+ * Index the containers with one child process per shard
+ *
+ * Each child has its own SQLite connection and database file, so the
+ * inserts don't have to go through a single writer.
+ */
+void index_shards(GPtrArray *containers)
+{
+    pid_t *pids = NULL;
+    gboolean failed = FALSE;
+
+    if (jobs > containers->len) jobs = containers->len;
+
+    // each shard writer gets its part of the memory limit
+    if (max_memory > 0) max_memory = MAX(max_memory / jobs, 1);
+
+    assign_shards(containers);
+
+    pids = g_new0(pid_t, jobs);
+
+    for (int i = 0; i < jobs; i++) {
+        pids[i] = fork();
+
+        if (pids[i] < 0) {
+            perror("fork");
+            exit(1);
+        }
+
+        if (pids[i] == 0) {
+            trace_child(i);
+            index_shard(containers, i);
+            trace_close();
+            if (show_stats) print_stats();
+
+            // the atexit handlers belong to the parent
+            fflush(stderr);
+            _exit(0);
+        }
+    }
+
+    for (int i = 0; i < jobs; i++) {
+        int wstatus = 0;
+
+        waitpid(pids[i], &wstatus, 0);
+        trace_merge(i);
+
+        if (!WIFEXITED(wstatus) || WEXITSTATUS(wstatus) != 0) {
+            fprintf(stderr, "ERROR: Indexing shard %d failed\n", i);
+            failed = TRUE;
+        }
+    }
+
+    g_free(pids);
+
+    if (failed) exit(1);
+}
+
+/*
+ * Return the highest ID of a table of the index or 0 if it is empty
+ *
+ * An ID in sqlite_sequence counts as well, since an overlay index continues
+ * the IDs of its base index there.
+ */
+gint64 max_id(const gchar *table)
+{
+    sqlite3_stmt *stmt = NULL;
+    gchar *sql = g_strdup_printf("SELECT MAX("
+            "COALESCE((SELECT MAX(id) FROM main.%s), 0), "
+            "COALESCE((SELECT seq FROM main.sqlite_sequence "
+            "WHERE name = '%s'), 0))", table, table);
+    int status = sqlite3_prepare_v2(db, sql, -1, &stmt, NULL);
+    handle_sql_error(status, __LINE__);
+
+    status = sqlite3_step(stmt);
+    handle_sql_error(status, __LINE__);
+
+    gint64 id = sqlite3_column_int64(stmt, 0);
+
+    sqlite3_finalize(stmt);
+    g_free(sql);
+
+    return id;
+}
+
+/*
+ * Execute one of the statements merging a shard with the number of the
+ * shard bound to ?1 and the offset of its field, method or annotation IDs
+ * bound to ?2
+ */
+void exec_merge_sql(const gchar *sql, int shard, gint64 offset)
+{
+    sqlite3_stmt *stmt = NULL;
+    int status = 0;
+    int params = 0;
+    gint64 start = trace_start();
+
+    status = sqlite3_prepare_v2(db, sql, -1, &stmt, NULL);
+    handle_sql_error(status, __LINE__);
+
+    params = sqlite3_bind_parameter_count(stmt);
+
+    if (params >= 1) {
+        status = sqlite3_bind_int(stmt, 1, shard);
         handle_sql_error(status, __LINE__);
-        status = sqlite3_bind_int(stmt_insert_method, 12,
-                javamethod_is_abstract(methods[i]));
+    }
+
+    if (params >= 2) {
+        status = sqlite3_bind_int64(stmt, 2, offset);
         handle_sql_error(status, __LINE__);
+    }
+
+    status = sqlite3_step(stmt);
+    handle_sql_error(status, __LINE__);
+
+    sqlite3_finalize(stmt);
+
+    trace_end("sqlite", "merge", start, -1);
+}
+
+/*
+ * Attach the database of a shard and start a transaction
+ *
+ * SQLite can't attach databases inside of a transaction, so each shard is
+ * merged in a transaction of its own.
+ */
+void attach_shard(int shard)
+{
+    gchar *filename = shard_filename(shard);
+    gchar *sql = sqlite3_mprintf("ATTACH %Q AS shard", filename);
+    int status = 0;
+
+    status = sqlite3_exec(db, sql, NULL, 0, NULL);
+    handle_sql_error(status, __LINE__);
+    status = sqlite3_exec(db, "BEGIN TRANSACTION", NULL, 0, NULL);
+    handle_sql_error(status, __LINE__);
+
+    sqlite3_free(sql);
+    g_free(filename);
+}
+
+void detach_shard()
+{
+    int status = 0;
+
+    status = sqlite3_exec(db, "COMMIT", NULL, 0, NULL);
+    handle_sql_error(status, __LINE__);
+    status = sqlite3_exec(db, "DETACH shard", NULL, 0, NULL);
+    handle_sql_error(status, __LINE__);
+}
+
+/*
+ * Merge the shard databases into the index
+ *
+ * The strings of all shards are inserted first and the local IDs of each
+ * shard are mapped to the global ones. Once all classes are known the first
+ * definition of each class is chosen and only the members of this
+ * definition are copied with INSERT ... SELECT.
+ */
+void merge_shards(GPtrArray *containers)
+{
+    int status = 0;
+
+    create_database(DB_FILE);
+    prepare_statements();
+
+    status = sqlite3_exec(db, NAME_INDEXES, NULL, 0, NULL);
+    handle_sql_error(status, __LINE__);
+    status = sqlite3_exec(db, MERGE_DDL, NULL, 0, NULL);
+    handle_sql_error(status, __LINE__);
+
+    status = sqlite3_exec(db, "BEGIN TRANSACTION", NULL, 0, NULL);
+    handle_sql_error(status, __LINE__);
+
+    for (guint i = 0; i < containers->len; i++) {
+        Container *container = g_ptr_array_index(containers, i);
+        insert_container(container->path, i + 1);
+    }
+
+    status = sqlite3_exec(db, "COMMIT", NULL, 0, NULL);
+    handle_sql_error(status, __LINE__);
+
+    // strings and classes of all shards
+    for (int shard = 0; shard < jobs; shard++) {
+        attach_shard(shard);
+
+        for (int i = 0; i < STRINGS_NUM; i++) {
+            const gchar *table = string_tables[i].table;
+
+            for (int j = 0; MERGE_STRINGS[j] != NULL; j++) {
+                gchar *sql = g_strdup_printf(MERGE_STRINGS[j], table, table,
+                        table);
+
+                exec_merge_sql(sql, shard, 0);
+                g_free(sql);
+            }
+        }
+
+        for (int j = 0; MERGE_CLASSES[j] != NULL; j++) {
+            exec_merge_sql(MERGE_CLASSES[j], shard, 0);
+        }
+
+        detach_shard();
+    }
+
+    status = sqlite3_exec(db, "BEGIN TRANSACTION", NULL, 0, NULL);
+    handle_sql_error(status, __LINE__);
+
+    for (int j = 0; MERGE_WINNERS[j] != NULL; j++) {
+        exec_merge_sql(MERGE_WINNERS[j], 0, 0);
+    }
+
+    status = sqlite3_exec(db, "COMMIT", NULL, 0, NULL);
+    handle_sql_error(status, __LINE__);
+
+    // members of the classes taken from each shard
+    for (int shard = 0; shard < jobs; shard++) {
+        gint64 field_offset = max_id("fields_data");
+        gint64 method_offset = max_id("methods_data");
+        gint64 annotation_offset = max_id("annotations");
+
+        attach_shard(shard);
+
+        for (int j = 0; MERGE_FIELDS[j] != NULL; j++) {
+            exec_merge_sql(MERGE_FIELDS[j], shard, field_offset);
+        }
+
+        for (int j = 0; MERGE_MEMBERS[j] != NULL; j++) {
+            exec_merge_sql(MERGE_MEMBERS[j], shard, method_offset);
+        }
+
+        for (int j = 0; MERGE_ANNOTATIONS[j] != NULL; j++) {
+            exec_merge_sql(MERGE_ANNOTATIONS[j], shard, annotation_offset);
+        }
+
+        detach_shard();
+    }
+
+    status = sqlite3_exec(db, "BEGIN TRANSACTION", NULL, 0, NULL);
+    handle_sql_error(status, __LINE__);
+
+    status = sqlite3_exec(db, "UPDATE containers SET complete=1", NULL, 0,
+            NULL);
+    handle_sql_error(status, __LINE__);
+
+    create_indexes();
+    set_state("complete");
+
+    status = sqlite3_exec(db, "COMMIT", NULL, 0, NULL);
+    handle_sql_error(status, __LINE__);
+
+    for (int shard = 0; shard < jobs; shard++) {
+        gchar *filename = shard_filename(shard);
+
+        unlink(filename);
+        g_free(filename);
+    }
+}
+
+/*
+ * Add the contents of a file to a checksum
+ */
+void hash_file(GChecksum *checksum, const gchar *filename)
+{
+    guchar buffer[64 * 1024];
+    gsize nbytes = 0;
+    FILE *fp = fopen(filename, "rb");
 
-        status = sqlite3_step(stmt_insert_method);
-        handle_sql_error(status, __LINE__);
+    if (fp == NULL) {
+        fprintf(stderr, "ERROR: Can't read '%s'\n", filename);
+        return;
+    }
 
-        gint64 method_id = sqlite3_last_insert_rowid(db);
+    while ((nbytes = fread(buffer, 1, sizeof(buffer), fp)) > 0) {
+        g_checksum_update(checksum, buffer, nbytes);
+    }
 
-        // insert exceptions
-        gchar **exceptions = javamethod_get_exceptions(methods[i]);
-        if (exceptions == NULL) continue;
+    fclose(fp);
+}
+
+gint compare_names(gconstpointer a, gconstpointer b)
+{
+    return strcmp(*(const gchar * const *) a, *(const gchar * const *) b);
+}
+
+/*
+ * Add the relative paths, sizes and modification times of the loose class
+ * files in a directory to a checksum
+ *
+ * The lines are sorted since the order of the directory entries differs
+ * between file systems and checkouts.
+ */
+void hash_dir(GChecksum *checksum, const gchar *root, const gchar *dirname)
+{
+    GPtrArray *lines = g_ptr_array_new_with_free_func(g_free);
 
-        for (int i = 0; exceptions[i]; i++) {
-            gchar *cur = exceptions[i];
-            gchar *classname = javaclass_extract_classname(cur);
-            gchar *package = javaclass_extract_package(cur);
+    list_class_files(lines, root, dirname);
+    g_ptr_array_sort(lines, compare_names);
 
-            gint64 namespace_id = insert_namespace(package);
-            g_free(package);
+    for (guint i = 0; i < lines->len; i++) {
+        const gchar *line = g_ptr_array_index(lines, i);
 
-            gint64 class_id = insert_class(classname);
-            g_free(classname);
+        g_checksum_update(checksum, (const guchar*) line, -1);
+    }
 
-            associate_class_and_namespace(class_id, namespace_id, FALSE);
+    g_ptr_array_free(lines, TRUE);
+}
 
-            sqlite3_reset(stmt_insert_exception);
-            status = sqlite3_bind_int64(stmt_insert_exception, 1,
-                    method_id);
-            handle_sql_error(status, __LINE__);
-            status = sqlite3_bind_int64(stmt_insert_exception, 2,
-                    class_id);
-            handle_sql_error(status, __LINE__);
-            status = sqlite3_bind_int64(stmt_insert_exception, 3,
-                    namespace_id);
-            handle_sql_error(status, __LINE__);
+/*
+ * Add a line with the relative path, size and modification time of every
+ * loose class file below dirname to lines
+ */
+void list_class_files(GPtrArray *lines, const gchar *root,
+        const gchar *dirname)
+{
+    GPtrArray *names = NULL;
+    struct stat st;
 
-            status = sqlite3_step(stmt_insert_exception);
-            handle_sql_error(status, __LINE__);
+    names = readahead_dir(dirname, NULL);
+    if (names == NULL) return;
+
+    for (guint i = 0; i < names->len; i++) {
+        const gchar *name = g_ptr_array_index(names, i);
+        gchar *fullname = g_build_filename(dirname, name, NULL);
+
+        if (g_file_test(fullname, G_FILE_TEST_IS_DIR)
+                && !g_str_has_prefix(name, ".")) {
+            list_class_files(lines, root, fullname);
+        } else if (g_str_has_suffix(name, ".class")
+                && stat(fullname, &st) == 0) {
+            g_ptr_array_add(lines, g_strdup_printf("%s %ld %ld\n",
+                    fullname + strlen(root), (long) st.st_size,
+                    (long) st.st_mtime));
         }
+
+        g_free(fullname);
     }
+
+    g_ptr_array_free(names, TRUE);
 }
 
 /*
- * Insert all the interfaces implemented by a class
+ * Return the file name of the base index of the class path and JAVA_HOME
+ *
+ * The name is derived from the SHA-256 of the contents of all JARs and the
+ * loose class files in their order, so projects with the same dependencies
+ * share one base index no matter where they are checked out, and a changed
+ * dependency results in a new base index.
  */
-void insert_interfaces(JavaClass *c, gint64 class_id, gint64 namespace_id)
+gchar *base_filename(gchar *classpath, gchar *javahome)
 {
-    if (javaclass_get_interface_number(c) <= 0) return;
+    GChecksum *checksum = g_checksum_new(G_CHECKSUM_SHA256);
+    GPtrArray *containers = collect_containers(classpath, javahome);
+
+    // a changed schema or option must not reuse an old base index
+    g_checksum_update(checksum, (const guchar*) DDL, -1);
+    g_checksum_update(checksum, (const guchar*)
+            (clustered ? CLUSTERED_CLASS_TABLES : CLASS_TABLES), -1);
+    g_checksum_update(checksum, (const guchar*) (summaries ? "1" : "0"), 1);
+    gchar *release_str = g_strdup_printf("%d", release);
+    g_checksum_update(checksum, (const guchar*) release_str, -1);
+    g_free(release_str);
+
+    for (guint i = 0; i < containers->len; i++) {
+        Container *container = g_ptr_array_index(containers, i);
+
+        if (container->index_filenames) continue; // the project itself
+
+        g_checksum_update(checksum, (const guchar*) "\n", 1);
+
+        if (container->is_jar) {
+            hash_file(checksum, container->path);
+        } else {
+            hash_dir(checksum, container->path, container->path);
+        }
+    }
+
+    gchar *name = g_strdup_printf("base-%s.db", g_checksum_get_string(checksum));
+    gchar *filename = g_build_filename(base_dir, name, NULL);
+
+    g_free(name);
+    g_ptr_array_free(containers, TRUE);
+    g_checksum_free(checksum);
+
+    return filename;
+}
 
+/*
+ * Index the class path and JAVA_HOME into a new base index
+ *
+ * The index is written to a temporary file which is renamed when it is
+ * complete, so concurrent runs never see a partial base index.
+ */
+void create_base(const gchar *filename, gchar *classpath, gchar *javahome)
+{
+    gchar *tmpname = g_strdup_printf("%s.%d.tmp", filename, (int) getpid());
     int status = 0;
-    gchar **interfaces = javaclass_get_interfaces(c);
 
-    for (int i = 0; interfaces[i]; i++) {
-        gchar *cur = interfaces[i];
-        if (g_strrstr(cur, "$") != NULL) continue; // skip inner interfaces
+    if (g_mkdir_with_parents(base_dir, 0755) != 0) {
+        fprintf(stderr, "Can't create base directory '%s'\n", base_dir);
+        exit(1);
+    }
 
-        gchar *classname = javaclass_extract_classname(cur);
-        gchar *package = javaclass_extract_package(cur);
+    create_database(tmpname);
 
-        gint64 interface_namespace_id = insert_namespace(package);
-        g_free(package);
+    if (max_memory > 0) limit_memory();
 
-        gint64 interface_class_id = insert_class(classname);
-        g_free(classname);
+    prepare_statements();
 
-        associate_class_and_namespace(interface_class_id,
-                interface_namespace_id, FALSE);
+    status = sqlite3_exec(db, "BEGIN TRANSACTION", NULL, 0, NULL);
+    handle_sql_error(status, __LINE__);
 
-        sqlite3_reset(stmt_insert_interface);
-        status = sqlite3_bind_int64(stmt_insert_interface, 1,
-                class_id);
-        handle_sql_error(status, __LINE__);
-        status = sqlite3_bind_int64(stmt_insert_interface, 2,
-                namespace_id);
-        handle_sql_error(status, __LINE__);
+    // the bootstrap class loader is asked before the class path, so the
+    // classes of the JDK win over copies in the JARs
+    if (javahome != NULL) {
+        index_root_dir(javahome, FALSE);
+    }
 
-        status = sqlite3_bind_int64(stmt_insert_interface, 3,
-                interface_class_id);
-        handle_sql_error(status, __LINE__);
-        status = sqlite3_bind_int64(stmt_insert_interface, 4,
-                interface_namespace_id);
-        handle_sql_error(status, __LINE__);
+    if (classpath != NULL) {
+        index_classpath(classpath);
+    }
 
-        status = sqlite3_step(stmt_insert_interface);
-        handle_sql_error(status, __LINE__);
+    create_indexes();
+    set_state("complete");
+
+    status = sqlite3_exec(db, "COMMIT", NULL, 0, NULL);
+    handle_sql_error(status, __LINE__);
+
+    finalize_statements();
+    sqlite3_close(db);
+    db = NULL;
+
+    if (rename(tmpname, filename) != 0) {
+        fprintf(stderr, "Can't rename '%s' to '%s'\n", tmpname, filename);
+        exit(1);
     }
+
+    g_free(tmpname);
 }
 
 /*
- * Takes the bytes of a classfile and analyzes and indexes this class
+ * Copy the names of the base index into the new overlay index and record
+ * the base index in its layers table
  */
-void process_class(JavaClass *c)
+void seed_overlay(const gchar *base)
 {
-    gboolean no_collision = TRUE;
-    const gchar *namespace = NULL;
+    gchar *path = NULL;
+    gchar *sql = NULL;
+    int status = 0;
 
-    namespace = javaclass_get_package(c);
-    if (namespace == NULL) namespace = DEFAULT_PACKAGE;
-    if (strlen(namespace) <= 0) namespace = DEFAULT_PACKAGE;
+    if (g_path_is_absolute(base)) {
+        path = g_strdup(base);
+    } else {
+        gchar *cwd = g_get_current_dir();
+        path = g_build_filename(cwd, base, NULL);
+        g_free(cwd);
+    }
 
-    gint64 namespace_id = insert_namespace(namespace);
-    g_assert(namespace_id != 0);
-    gint64 class_id = insert_class(javaclass_get_name(c));
-    g_assert(class_id != 0);
+    sql = sqlite3_mprintf("ATTACH %Q AS base", path);
+    status = sqlite3_exec(db, sql, NULL, 0, NULL);
+    handle_sql_error(status, __LINE__);
+    sqlite3_free(sql);
 
-    no_collision = associate_class_and_namespace(class_id, namespace_id, TRUE);
+    status = sqlite3_exec(db, "BEGIN TRANSACTION", NULL, 0, NULL);
+    handle_sql_error(status, __LINE__);
+    status = sqlite3_exec(db, SEED_OVERLAY, NULL, 0, NULL);
+    handle_sql_error(status, __LINE__);
 
-    // only add the fields if we don't have a namespace collision
-    if (no_collision) {
-        gint64 parent_namespace_id = 0;
-        gint64 parent_class_id = 0;
-        const gchar *parent = javaclass_get_fq_parent(c);
+    sql = sqlite3_mprintf("INSERT INTO layers (path) VALUES (%Q)", path);
+    status = sqlite3_exec(db, sql, NULL, 0, NULL);
+    handle_sql_error(status, __LINE__);
+    sqlite3_free(sql);
+
+    status = sqlite3_exec(db, "COMMIT", NULL, 0, NULL);
+    handle_sql_error(status, __LINE__);
+    status = sqlite3_exec(db, "DETACH base", NULL, 0, NULL);
+    handle_sql_error(status, __LINE__);
+
+    g_free(path);
+}
+
+/*
+ * Load the names which are already in the database into the string tables
+ *
+ * With --max-memory they are looked up in the database instead by starting
+ * with an empty previous generation.
+ */
+void load_string_tables()
+{
+    for (int i = 0; i < STRINGS_NUM; i++) {
+        StringTable *table = &string_tables[i];
+        sqlite3_stmt *stmt = NULL;
+        gchar *sql = NULL;
+        int status = 0;
+
+        if (max_memory > 0) {
+            if (table->strings.previous == NULL) {
+                table->strings.previous = symtab_new(0);
+            }
+            continue;
+        }
 
-        if (parent != NULL) {
-            gchar *parent_package = javaclass_extract_package(parent);
-            gchar *parent_class   = javaclass_extract_classname(parent);
+        sql = g_strdup_printf("SELECT id, name FROM %s", table->table);
+        status = sqlite3_prepare_v2(db, sql, -1, &stmt, NULL);
+        handle_sql_error(status, __LINE__);
+        g_free(sql);
 
-            if (parent_package == NULL) parent_package = DEFAULT_PACKAGE;
-            parent_namespace_id = insert_namespace(parent_package);
-            parent_class_id = insert_class(parent_class);
+        while ((status = sqlite3_step(stmt)) == SQLITE_ROW) {
+            const gchar *name = (const gchar*) sqlite3_column_text(stmt, 1);
 
-            if (g_strcmp0(parent_package, DEFAULT_PACKAGE) == 0) g_free(parent_package);
-            g_free(parent_class);
+            symtab_insert(table->strings.current, name, symtab_hash(name),
+                    sqlite3_column_int64(stmt, 0));
         }
+        handle_sql_error(status, __LINE__);
 
-        set_class_attributes(c, class_id, namespace_id, parent_class_id,
-                parent_namespace_id);
-        insert_fields(c, class_id, namespace_id);
-        insert_methods(c, class_id, namespace_id);
-        insert_interfaces(c, class_id, namespace_id);
-    } else {
-        fprintf(stderr, "ERROR: Possible namespace collision\n");
-        fprintf(stderr, "Class %s is already in the database\n",
-                javaclass_get_fq_name(c));
+        sqlite3_finalize(stmt);
     }
-
-    javaclass_free(c);
 }
 
 /*
- * Index all the entries of a CLASSPATH style list of directories and JARs
+ * Open one TSV file per exported table and write the header lines
+ *
+ * The rows are streamed into these files while the classes are processed.
+ * Strings are dictionary-encoded: classes, fields, methods and interfaces
+ * only reference the IDs in namespaces.tsv and importables.tsv and all
+ * modifiers are packed into one access_flags column.
  */
-void index_classpath(gchar *classpath)
+void open_export_files()
 {
-    gchar **entries = NULL;
+    if (export_dir == NULL) return;
 
-    if (classpath == NULL) return;
-    if (strlen(classpath) == 0) return;
+    if (g_mkdir_with_parents(export_dir, 0755) != 0) {
+        fprintf(stderr, "Can't create export directory '%s'\n", export_dir);
+        exit(1);
+    }
 
-    entries = g_strsplit(classpath, G_SEARCHPATH_SEPARATOR_S, 0);
+    for (int i = 0; i < EXPORT_NUM; i++) {
+        gchar *filename = g_build_filename(export_dir, EXPORT_FILES[i][0], NULL);
 
-    for (int i = 0; entries[i] != NULL; i++) {
-        if (g_str_has_suffix(entries[i], ".jar")) {
-            index_jar(entries[i]);
-        } else {
-            if (g_strcmp0(entries[i], ".") == 0) continue;
-            index_dir(entries[i], FALSE);
+        export_fp[i] = fopen(filename, "w");
+        if (export_fp[i] == NULL) {
+            fprintf(stderr, "Can't open export file '%s'\n", filename);
+            exit(1);
         }
+
+        setvbuf(export_fp[i], NULL, _IOFBF, EXPORT_BUFFER_SIZE);
+        fprintf(export_fp[i], "%s\n", EXPORT_FILES[i][1]);
+
+        g_free(filename);
     }
+}
 
-    g_strfreev(entries);
+void close_export_files()
+{
+    for (int i = 0; i < EXPORT_NUM; i++) {
+        if (export_fp[i] != NULL) {
+            fclose(export_fp[i]);
+            export_fp[i] = NULL;
+        }
+    }
+}
+
+/*
+ * Write one column of a TSV row
+ *
+ * NULL is written as \N and tabs, newlines and backslashes are escaped so
+ * that the files can be read by the usual CSV/TSV readers of analytics tools.
+ */
+void export_string(FILE *fp, const gchar *str, gboolean last)
+{
+    if (str == NULL) {
+        fputs("\\N", fp);
+    } else {
+        for (const gchar *cur = str; *cur; cur++) {
+            switch (*cur) {
+                case '\t': fputs("\\t", fp); break;
+                case '\n': fputs("\\n", fp); break;
+                case '\\': fputs("\\\\", fp); break;
+                default: fputc(*cur, fp);
+            }
+        }
+    }
+
+    fputc(last ? '\n' : '\t', fp);
+}
+
+void export_int(FILE *fp, gint64 value, gboolean last)
+{
+    fprintf(fp, "%" G_GINT64_FORMAT "%c", value, last ? '\n' : '\t');
+}
+
+/*
+ * Write the ID of an interned string or NULL if the ID is 0
+ */
+void export_id(FILE *fp, gint64 id, gboolean last)
+{
+    if (id == 0) {
+        export_string(fp, NULL, last);
+    } else {
+        export_int(fp, id, last);
+    }
 }
 
 /*
  * Create a index database from scratch
  */
-void create_database()
+void create_database(const gchar *filename)
 {
     int status = 0;
     FILE *fp = NULL;
     gchar *error_msg = NULL;
 
     // overwrite the DB file if it already exists
-    fp = fopen(DB_FILE, "w");
+    fp = fopen(filename, "w");
     fclose(fp);
 
-    status = sqlite3_open(DB_FILE, &db);
+    open_database(filename);
+
+    // create all the tables by executing the DDL statements
+    status = sqlite3_exec(db, DDL, NULL, 0, &error_msg);
+    if (status == SQLITE_OK) {
+        status = sqlite3_exec(db,
+                clustered ? CLUSTERED_CLASS_TABLES : CLASS_TABLES, NULL, 0,
+                &error_msg);
+    }
+    if (status == SQLITE_OK) {
+        status = sqlite3_exec(db, ARTIFACTS_DDL, NULL, 0, &error_msg);
+    }
+    if (status == SQLITE_OK) {
+        status = sqlite3_exec(db, SCHEMA_VIEWS, NULL, 0, &error_msg);
+    }
+
+    if (status != SQLITE_OK) {
+        fprintf(stderr, "SQL error: %s\n", error_msg);
+        exit(1);
+    }
+}
+
+/*
+ * Open an existing index database
+ */
+void open_database(const gchar *filename)
+{
+    int status = sqlite3_open(filename, &db);
 
     if (status != 0) {
         fprintf(stderr, "Can't open database: %s\n", sqlite3_errmsg(db));
@@ -912,16 +4305,87 @@ void create_database()
         exit(1);
     }
 
+    sqlite3_extended_result_codes(db, 1);
+
     // set pragmas
     sqlite3_exec(db, "PRAGMA synchronous = OFF", NULL, 0, NULL);
+}
 
-    // create all the tables by executing the DDL statements
-    status = sqlite3_exec(db, DDL, NULL, 0, &error_msg);
+/*
+ * Prepare the index of an interrupted run for --resume
+ *
+ * Everything indexed from containers which weren't completed is removed
+ * and the completed ones are remembered so that they are skipped. Returns
+ * FALSE if the index has to be created from scratch because it wasn't
+ * written by a version which records its progress.
+ */
+gboolean resume_database()
+{
+    sqlite3_stmt *stmt = NULL;
+    gchar *state = NULL;
+    int status = 0;
 
-    if (status != SQLITE_OK) {
-        fprintf(stderr, "SQL error: %s\n", error_msg);
-        exit(1);
+    status = sqlite3_prepare_v2(db,
+            "SELECT value FROM metadata WHERE name='state'", -1, &stmt, NULL);
+
+    if (status == SQLITE_OK && sqlite3_step(stmt) == SQLITE_ROW) {
+        state = g_strdup((const gchar*) sqlite3_column_text(stmt, 0));
+    }
+
+    sqlite3_finalize(stmt);
+
+    if (state == NULL) {
+        fprintf(stderr, "Can't resume %s, indexing from scratch\n", DB_FILE);
+        sqlite3_close(db);
+        db = NULL;
+
+        return FALSE;
+    }
+
+    if (g_strcmp0(state, "complete") == 0) {
+        fprintf(stderr, "%s is already complete\n", DB_FILE);
+        g_free(state);
+        exit(0);
+    }
+
+    g_free(state);
+
+    status = sqlite3_exec(db, "BEGIN TRANSACTION", NULL, 0, NULL);
+    handle_sql_error(status, __LINE__);
+    status = sqlite3_exec(db, RESUME_CLEANUP, NULL, 0, NULL);
+    handle_sql_error(status, __LINE__);
+    status = sqlite3_exec(db, "COMMIT", NULL, 0, NULL);
+    handle_sql_error(status, __LINE__);
+
+    completed_containers = g_hash_table_new_full(g_str_hash, g_str_equal,
+            g_free, NULL);
+
+    status = sqlite3_prepare_v2(db, "SELECT path FROM containers", -1, &stmt,
+            NULL);
+    handle_sql_error(status, __LINE__);
+
+    while ((status = sqlite3_step(stmt)) == SQLITE_ROW) {
+        g_hash_table_add(completed_containers,
+                g_strdup((const gchar*) sqlite3_column_text(stmt, 0)));
     }
+    handle_sql_error(status, __LINE__);
+
+    sqlite3_finalize(stmt);
+
+    return TRUE;
+}
+
+/*
+ * Record the state of the index in the metadata table
+ */
+void set_state(const gchar *state)
+{
+    gchar *sql = sqlite3_mprintf(
+            "UPDATE metadata SET value=%Q WHERE name='state'", state);
+    int status = sqlite3_exec(db, sql, NULL, 0, NULL);
+
+    handle_sql_error(status, __LINE__);
+    sqlite3_free(sql);
 }
 
 /*
@@ -929,12 +4393,124 @@ void create_database()
  *
  * We create the indexes after we executed all INSERTs since SQLite is faster
  * if the indexes are created once instead of having to update them with
- * each INSERT
+ * each INSERT.
  */
 void create_indexes()
 {
-    int status = sqlite3_exec(db, INDEXES, NULL, 0, NULL);
+    int status = 0;
+    gint64 start = trace_start();
+
+    status = sqlite3_exec(db, NAME_INDEXES, NULL, 0, NULL);
+    handle_sql_error(status, __LINE__);
+
+    status = sqlite3_exec(db, INDEXES, NULL, 0, NULL);
+    handle_sql_error(status, __LINE__);
+
+    trace_end("sqlite", "create_indexes", start, -1);
+}
+
+/*
+ * Set up the bounded-memory mode of --max-memory
+ *
+ * Half of the limit is given to the page cache of SQLite and a quarter to
+ * the string tables; the rest is left for parsing. Since the string tables
+ * fall back to lookups in the database the unique indexes on the names
+ * have to exist from the start.
+ */
+void limit_memory()
+{
+    gint64 limit = (gint64) max_memory * 1024 * 1024;
+    gchar *sql = NULL;
+
+    sqlite3_soft_heap_limit64(limit / 2);
+
+    sql = g_strdup_printf("PRAGMA cache_size = -%" G_GINT64_FORMAT,
+            limit / 2 / 1024);
+    sqlite3_exec(db, sql, NULL, 0, NULL);
+    g_free(sql);
+
+    // the quarter holds the current and the previous generation of the
+    // string tables, so the current ones are rotated at half of it
+    string_tables_limit = limit / 4 / 2;
+
+    int status = sqlite3_exec(db, NAME_INDEXES, NULL, 0, NULL);
+    handle_sql_error(status, __LINE__);
+}
+
+/*
+ * Commit the classes indexed so far every COMMIT_INTERVAL_CLASSES classes
+ * with --max-memory and while the libraries are indexed, so that the
+ * journal and the dirty pages stay small and readers see the progress
+ */
+void commit_periodically()
+{
+    int status = 0;
+    gint64 trace = 0;
+    gint64 start = 0;
+
+    if (max_memory <= 0 && !commit_batches) return;
+    if (++uncommitted_classes < COMMIT_INTERVAL_CLASSES) return;
+
+    trace = trace_start();
+    start = g_get_monotonic_time();
+
+    status = sqlite3_exec(db, "COMMIT", NULL, 0, NULL);
     handle_sql_error(status, __LINE__);
+    status = sqlite3_exec(db, "BEGIN TRANSACTION", NULL, 0, NULL);
+    handle_sql_error(status, __LINE__);
+    trace_end("sqlite", "COMMIT", trace, -1);
+
+    stats.commits++;
+    stats.commit_time += g_get_monotonic_time() - start;
+    uncommitted_classes = 0;
+}
+
+/*
+ * Print the figures of --stats to stderr
+ *
+ * Comparing them between a run with and without --max-memory shows what
+ * the periodic commits and the lookups of dropped names cost.
+ */
+void print_stats()
+{
+    gdouble elapsed = (g_get_monotonic_time() - stats.start) / 1e6;
+
+    fprintf(stderr, "%" G_GUINT64_FORMAT " classes in %.2f s (%.0f classes/s)\n",
+            stats.classes, elapsed,
+            elapsed > 0 ? stats.classes / elapsed : 0.0);
+    fprintf(stderr, "%" G_GUINT64_FORMAT " periodic commits in %.2f s\n",
+            stats.commits, stats.commit_time / 1e6);
+    fprintf(stderr, "%" G_GUINT64_FORMAT " names looked up in the database "
+            "in %.2f s\n", stats.name_lookups, stats.name_lookup_time / 1e6);
+}
+
+/*
+ * Return a buffer for reading a class file of size bytes
+ *
+ * The buffer is reused for all classes instead of allocating one per class.
+ */
+guchar *get_read_buffer(gsize size)
+{
+    if (size > read_buffer_size) {
+        g_free(read_buffer);
+        read_buffer = g_malloc(size);
+        read_buffer_size = size;
+    }
+
+    return read_buffer;
+}
+
+/*
+ * Give the read buffer back if an unusually large class made it grow beyond
+ * MAX_MEMORY_READ_BUFFER with --max-memory
+ */
+void trim_read_buffer()
+{
+    if (max_memory <= 0 || read_buffer_size <= MAX_MEMORY_READ_BUFFER) return;
+
+    g_free(read_buffer);
+    read_buffer = NULL;
+    read_buffer_size = 0;
 }
 
 void handle_sql_error(int status, int line)
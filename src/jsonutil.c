@@ -0,0 +1,52 @@
+/*
+The MIT License (MIT) 
+Copyright (c) 2009,2010,2016 Andreas Heck <aheck@gmx.de>
+
+Permission to use, copy, modify, and/or distribute this software for any
+purpose with or without fee is hereby granted, provided that the above
+copyright notice and this permission notice appear in all copies.
+
+THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+*/
+
+#include <stdio.h>
+#include <glib.h>
+
+#include <jsonutil.h>
+
+/*
+ * Append a string as a quoted and escaped JSON string or null if str is NULL
+ */
+void json_append_string(GString *buffer, const gchar *str)
+{
+    if (str == NULL) {
+        g_string_append(buffer, "null");
+        return;
+    }
+
+    g_string_append_c(buffer, '"');
+
+    for (const guchar *cur = (const guchar*) str; *cur; cur++) {
+        switch (*cur) {
+            case '"':  g_string_append(buffer, "\\\""); break;
+            case '\\': g_string_append(buffer, "\\\\"); break;
+            case '\n': g_string_append(buffer, "\\n"); break;
+            case '\r': g_string_append(buffer, "\\r"); break;
+            case '\t': g_string_append(buffer, "\\t"); break;
+            default:
+                if (*cur < 0x20) {
+                    g_string_append_printf(buffer, "\\u%04x", *cur);
+                } else {
+                    g_string_append_c(buffer, *cur);
+                }
+        }
+    }
+
+    g_string_append_c(buffer, '"');
+}
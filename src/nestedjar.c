@@ -0,0 +1,226 @@
+/*
+The MIT License (MIT) 
+Copyright (c) 2009,2010,2016 Andreas Heck <aheck@gmx.de>
+
+Permission to use, copy, modify, and/or distribute this software for any
+purpose with or without fee is hereby granted, provided that the above
+copyright notice and this permission notice appear in all copies.
+
+THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <glib.h>
+#include <zip.h>
+
+#include <nestedjar.h>
+#include <zipdir.h>
+
+#define ZIP_LOCAL_SIGNATURE 0x04034b50
+#define ZIP_LOCAL_SIZE 30
+
+// Spring Boot nests the JARs of its libraries one level deep, an EAR holds
+// WARs with JARs of their own; anything deeper is skipped instead of
+// recursing without end into an archive which contains itself
+#define MAX_DEPTH 2
+
+// directories of fat JARs and WARs which hold the classes of the
+// application under their package paths
+static const gchar *CLASS_DIRS[] = {
+    "BOOT-INF/classes/",
+    "WEB-INF/classes/",
+    NULL
+};
+
+/*
+ * Wrap a JAR opened by the caller from path so that its nested JARs can be
+ * opened; the zip is closed by nestedjar_close()
+ */
+NestedJar *nestedjar_new(struct zip *zip, const gchar *path)
+{
+    NestedJar *jar = g_new0(NestedJar, 1);
+
+    jar->zip  = zip;
+    jar->path = path;
+
+    return jar;
+}
+
+/*
+ * Read the local header offsets of all entries of a JAR in memory from its
+ * central directory, which has to match the numfiles entries of libzip
+ */
+static guint32 *read_offsets(const guchar *data, gsize size, guint numfiles)
+{
+    gsize tail = MIN(size, ZIPDIR_MAX_TAIL);
+    ZipDirEnd end;
+
+    if (!zipdir_read_end(data + size - tail, tail, size, &end)
+            || end.count != numfiles) {
+        return NULL;
+    }
+
+    return zipdir_read_offsets(data + end.offset, end.size, numfiles);
+}
+
+/*
+ * Return the bytes of a stored entry in the mapping of a JAR or NULL if
+ * they can't be located
+ */
+static const guchar *stored_data(NestedJar *jar, zip_uint64_t index,
+        gsize size)
+{
+    GError *error = NULL;
+
+    if (jar->data == NULL && jar->path != NULL) {
+        jar->mapping = g_mapped_file_new(jar->path, FALSE, &error);
+        if (error != NULL) {
+            g_error_free(error);
+            return NULL;
+        }
+
+        jar->data = (const guchar*) g_mapped_file_get_contents(jar->mapping);
+        jar->size = g_mapped_file_get_length(jar->mapping);
+    }
+
+    if (jar->data == NULL) return NULL;
+
+    if (jar->offsets == NULL) {
+        jar->offsets = read_offsets(jar->data, jar->size,
+                zip_get_num_files(jar->zip));
+        if (jar->offsets == NULL) return NULL;
+    }
+
+    gsize offset = jar->offsets[index];
+
+    if (offset + ZIP_LOCAL_SIZE > jar->size
+            || zipdir_u4(jar->data + offset) != ZIP_LOCAL_SIGNATURE) {
+        return NULL;
+    }
+
+    offset += ZIP_LOCAL_SIZE + zipdir_u2(jar->data + offset + 26)
+        + zipdir_u2(jar->data + offset + 28);
+    if (offset + size > jar->size) return NULL;
+
+    return jar->data + offset;
+}
+
+/*
+ * Open the JAR stored in entry index of parent
+ *
+ * The parent has to stay open as long as the nested JAR is used.
+ */
+NestedJar *nestedjar_open(NestedJar *parent, zip_uint64_t index,
+        GError **error)
+{
+    struct zip_stat st;
+    struct zip_file *fp = NULL;
+    zip_source_t *source = NULL;
+    zip_error_t zip_error;
+    NestedJar *jar = NULL;
+    const gchar *name = zip_get_name(parent->zip, index, 0);
+
+    if (parent->depth >= MAX_DEPTH) {
+        g_set_error(error, G_FILE_ERROR, G_FILE_ERROR_FAILED,
+                "The nested JAR %s is nested more than %d levels deep",
+                name, MAX_DEPTH);
+        return NULL;
+    }
+
+    if (zip_stat_index(parent->zip, index, 0, &st) != 0) {
+        g_set_error(error, G_FILE_ERROR, G_FILE_ERROR_FAILED,
+                "Can't read the nested JAR %s", name);
+        return NULL;
+    }
+
+    jar = g_new0(NestedJar, 1);
+    jar->size  = st.size;
+    jar->depth = parent->depth + 1;
+
+    if (st.comp_method == ZIP_CM_STORE) {
+        jar->data = stored_data(parent, index, st.size);
+    }
+
+    // compressed entries and anything the central directory parser doesn't
+    // understand are read through libzip
+    if (jar->data == NULL) {
+        jar->buffer = g_malloc(st.size > 0 ? st.size : 1);
+        fp = zip_fopen_index(parent->zip, index, 0);
+
+        if (fp == NULL
+                || zip_fread(fp, jar->buffer, st.size) != (zip_int64_t) st.size) {
+            g_set_error(error, G_FILE_ERROR, G_FILE_ERROR_FAILED,
+                    "Can't read the nested JAR %s", name);
+            if (fp != NULL) zip_fclose(fp);
+            nestedjar_close(jar);
+            return NULL;
+        }
+
+        zip_fclose(fp);
+        jar->data = jar->buffer;
+    }
+
+    zip_error_init(&zip_error);
+    source = zip_source_buffer_create(jar->data, jar->size, 0, &zip_error);
+    if (source != NULL) {
+        jar->zip = zip_open_from_source(source, ZIP_RDONLY, &zip_error);
+        if (jar->zip == NULL) zip_source_free(source);
+    }
+    zip_error_fini(&zip_error);
+
+    if (jar->zip == NULL) {
+        g_set_error(error, G_FILE_ERROR, G_FILE_ERROR_FAILED,
+                "The nested JAR %s is no valid ZIP archive", name);
+        nestedjar_close(jar);
+        return NULL;
+    }
+
+    return jar;
+}
+
+/*
+ * Close a JAR with its zip; nested JARs have to be closed before their
+ * parent
+ */
+void nestedjar_close(NestedJar *jar)
+{
+    if (jar->zip != NULL) zip_close(jar->zip);
+    if (jar->mapping != NULL) g_mapped_file_unref(jar->mapping);
+
+    g_free(jar->buffer);
+    g_free(jar->offsets);
+    g_free(jar);
+}
+
+/*
+ * Check if a file or an entry of a JAR is a JAR, WAR or EAR
+ */
+gboolean nestedjar_is_archive(const gchar *filename)
+{
+    return g_str_has_suffix(filename, ".jar")
+        || g_str_has_suffix(filename, ".war")
+        || g_str_has_suffix(filename, ".ear");
+}
+
+/*
+ * Return the path of a class file entry relative to the root of its
+ * packages, i.e. without BOOT-INF/classes/ or WEB-INF/classes/
+ */
+const gchar *nestedjar_class_path(const gchar *filename)
+{
+    for (int i = 0; CLASS_DIRS[i] != NULL; i++) {
+        if (g_str_has_prefix(filename, CLASS_DIRS[i])) {
+            return filename + strlen(CLASS_DIRS[i]);
+        }
+    }
+
+    return filename;
+}
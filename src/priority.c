@@ -0,0 +1,63 @@
+/*
+The MIT License (MIT) 
+Copyright (c) 2009,2010,2016 Andreas Heck <aheck@gmx.de>
+
+Permission to use, copy, modify, and/or distribute this software for any
+purpose with or without fee is hereby granted, provided that the above
+copyright notice and this permission notice appear in all copies.
+
+THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+*/
+
+// setpriority() and syscall() are hidden by -D_POSIX_SOURCE
+#define _GNU_SOURCE
+#define _DARWIN_C_SOURCE
+
+#include <stdio.h>
+#include <string.h>
+#include <errno.h>
+#include <unistd.h>
+#include <sys/time.h>
+#include <sys/resource.h>
+
+#ifdef __linux__
+#include <sys/syscall.h>
+#endif
+
+#include <priority.h>
+
+// lowest priority of nice(1)
+#define PRIORITY_LOWEST 19
+
+// from linux/ioprio.h which isn't installed with every libc
+#define IOPRIO_WHO_PROCESS 1
+#define IOPRIO_CLASS_IDLE 3
+#define IOPRIO_CLASS_SHIFT 13
+
+/*
+ * Lower the CPU and I/O priority of the process to the lowest one
+ */
+void priority_lower()
+{
+    if (setpriority(PRIO_PROCESS, 0, PRIORITY_LOWEST) != 0) {
+        fprintf(stderr, "Can't lower the CPU priority: %s\n",
+                strerror(errno));
+    }
+
+#if defined(__linux__) && defined(SYS_ioprio_set)
+    // only the idle class makes sure that the disk isn't shared with the
+    // foreground; lowering the priority within the best-effort class isn't
+    // enough while an editor reads files
+    if (syscall(SYS_ioprio_set, IOPRIO_WHO_PROCESS, 0,
+                IOPRIO_CLASS_IDLE << IOPRIO_CLASS_SHIFT) != 0) {
+        fprintf(stderr, "Can't lower the I/O priority: %s\n",
+                strerror(errno));
+    }
+#endif
+}
@@ -0,0 +1,1256 @@
+/*
+The MIT License (MIT) 
+Copyright (c) 2009,2010,2016 Andreas Heck <aheck@gmx.de>
+
+Permission to use, copy, modify, and/or distribute this software for any
+purpose with or without fee is hereby granted, provided that the above
+copyright notice and this permission notice appear in all copies.
+
+THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <glib.h>
+#include <sqlite3.h>
+
+#include <global.h>
+#include <jsonutil.h>
+#include <summary.h>
+#include <schema.h>
+
+/*
+ * A mode of java-query
+ */
+typedef struct {
+    const gchar *name;
+    const gchar *args;
+    const gchar *description;
+    int (*run)(int argc, gchar **argv);
+} Command;
+
+int query_members(int argc, gchar **argv);
+int query_artifacts(int argc, gchar **argv);
+int query_annotated(int argc, gchar **argv);
+int query_method_sizes(int argc, gchar **argv);
+int query_providers(int argc, gchar **argv);
+int query_services(int argc, gchar **argv);
+int query_shadowed(int argc, gchar **argv);
+int query_sql(int argc, gchar **argv);
+
+static Command commands[] = {
+    {"members", "CLASS...", "Print all members of fully qualified classes",
+        query_members},
+    {"annotated", "[ANNOTATION...]", "Print the classes, fields and methods "
+        "annotated with fully qualified annotation types (all annotations "
+        "without arguments)", query_annotated},
+    {"artifacts", "CLASS...", "Print the versions of the artifacts indexed "
+        "with --repository which contain fully qualified classes",
+        query_artifacts},
+    {"method-sizes", "[LIMIT...]", "Print the methods whose bytecode is "
+        "longer than each limit in bytes by JAR and package (default: the "
+        "HotSpot limits 8000, 325 and 35)", query_method_sizes},
+    {"providers", "CLASS...", "Print the JARs and directories which contain "
+        "fully qualified classes in class path order", query_providers},
+    {"services", "[SERVICE...]", "Print the implementations of services "
+        "registered in META-INF/services or by Spring in class path order "
+        "(all services without arguments)", query_services},
+    {"shadowed", "", "Print all classes which are shadowed by the same class "
+        "earlier on the class path", query_shadowed},
+    {"sql", "QUERY", "Run an SQL query and print the rows separated by tabs",
+        query_sql},
+    {NULL}
+};
+
+/*
+ * Views combining an overlay index with its base index attached as "base"
+ *
+ * They shadow the tables of the overlay in the temp schema. The overlay
+ * holds the project, which the sequential indexer indexes first, so a class
+ * which is in both is taken from the overlay, unless the overlay only
+ * knows it as a reference.
+ */
+const gchar *LAYER_VIEWS = ""
+    "CREATE TEMP VIEW importables_namespaces_data AS"
+    "    SELECT * FROM main.importables_namespaces_data o"
+    "    WHERE o.done OR NOT EXISTS (SELECT 1"
+    "        FROM base.importables_namespaces_data b"
+    "        WHERE b.importable_id = o.importable_id"
+    "        AND b.namespace_id = o.namespace_id AND b.done)"
+    "    UNION ALL"
+    "    SELECT * FROM base.importables_namespaces_data b"
+    "    WHERE NOT EXISTS (SELECT 1 FROM main.importables_namespaces_data o"
+    "        WHERE o.importable_id = b.importable_id"
+    "        AND o.namespace_id = b.namespace_id AND (o.done OR NOT b.done));"
+    "CREATE TEMP VIEW fields_data AS"
+    "    SELECT * FROM main.fields_data UNION ALL"
+    "    SELECT * FROM base.fields_data b WHERE NOT EXISTS (SELECT 1"
+    "        FROM main.importables_namespaces_data o"
+    "        WHERE o.importable_id = b.importable_id"
+    "        AND o.namespace_id = b.namespace_id AND o.done);"
+    "CREATE TEMP VIEW methods_data AS"
+    "    SELECT * FROM main.methods_data UNION ALL"
+    "    SELECT * FROM base.methods_data b WHERE NOT EXISTS (SELECT 1"
+    "        FROM main.importables_namespaces_data o"
+    "        WHERE o.importable_id = b.importable_id"
+    "        AND o.namespace_id = b.namespace_id AND o.done);"
+    "CREATE TEMP VIEW interfaces AS"
+    "    SELECT * FROM main.interfaces UNION ALL"
+    "    SELECT * FROM base.interfaces b WHERE NOT EXISTS (SELECT 1"
+    "        FROM main.importables_namespaces_data o"
+    "        WHERE o.importable_id = b.importable_id"
+    "        AND o.namespace_id = b.namespace_id AND o.done);"
+    "CREATE TEMP VIEW exceptions AS"
+    "    SELECT * FROM main.exceptions UNION ALL"
+    "    SELECT e.* FROM base.exceptions e"
+    "    JOIN base.methods_data b ON b.id = e.method_id"
+    "    WHERE NOT EXISTS (SELECT 1 FROM main.importables_namespaces_data o"
+    "        WHERE o.importable_id = b.importable_id"
+    "        AND o.namespace_id = b.namespace_id AND o.done);"
+    "CREATE TEMP VIEW class_summaries AS"
+    "    SELECT * FROM main.class_summaries UNION ALL"
+    "    SELECT * FROM base.class_summaries b WHERE NOT EXISTS (SELECT 1"
+    "        FROM main.importables_namespaces_data o"
+    "        WHERE o.importable_id = b.importable_id"
+    "        AND o.namespace_id = b.namespace_id AND o.done);"
+    // the classes of the base which are in the overlay as well are shadowed
+    // by it
+    "CREATE TEMP VIEW shadowed_classes AS"
+    "    SELECT * FROM main.shadowed_classes UNION ALL"
+    "    SELECT * FROM base.shadowed_classes UNION ALL"
+    "    SELECT b.importable_id, b.namespace_id, b.container_id"
+    "    FROM base.importables_namespaces_data b"
+    "    JOIN main.importables_namespaces_data o"
+    "    ON o.importable_id = b.importable_id"
+    "    AND o.namespace_id = b.namespace_id"
+    "    WHERE b.done AND o.done;"
+    "CREATE TEMP VIEW modules AS"
+    "    SELECT * FROM base.modules UNION ALL SELECT * FROM main.modules;"
+    "CREATE TEMP VIEW module_requires AS"
+    "    SELECT * FROM base.module_requires UNION ALL"
+    "    SELECT * FROM main.module_requires;"
+    "CREATE TEMP VIEW module_exports AS"
+    "    SELECT * FROM base.module_exports UNION ALL"
+    "    SELECT * FROM main.module_exports;"
+    "CREATE TEMP VIEW annotations AS"
+    "    SELECT * FROM main.annotations UNION ALL"
+    "    SELECT * FROM base.annotations b WHERE NOT EXISTS (SELECT 1"
+    "        FROM main.importables_namespaces_data o"
+    "        WHERE o.importable_id = b.importable_id"
+    "        AND o.namespace_id = b.namespace_id AND o.done);"
+    "CREATE TEMP VIEW annotation_values AS"
+    "    SELECT * FROM base.annotation_values UNION ALL"
+    "    SELECT * FROM main.annotation_values;"
+    "CREATE TEMP VIEW services AS"
+    "    SELECT * FROM base.services UNION ALL SELECT * FROM main.services;"
+    "";
+
+/*
+ * Command line options
+ */
+static gchar *database = DB_FILE;
+static gboolean json = FALSE;
+
+static GOptionEntry options[] =
+{
+    {"database", 'd', 0, G_OPTION_ARG_FILENAME, &database, "Query FILE instead of " DB_FILE, "FILE"},
+    {"json", 'j', 0, G_OPTION_ARG_NONE, &json, "Print one JSON object per line", NULL},
+    {NULL}
+};
+
+/*
+ * Global variables
+ */
+sqlite3 *db = NULL;
+
+void open_layers();
+void handle_sql_error(int status, int line);
+
+void usage(gchar *errormsg, GOptionContext *context)
+{
+    if (errormsg != NULL) fprintf(stderr, "ERROR: %s\n", errormsg);
+    fprintf(stderr, "%s", g_option_context_get_help(context, TRUE, NULL));
+
+    exit(2);
+}
+
+int main(int argc, char **argv)
+{
+    GError *error = NULL;
+    GOptionContext *context;
+    GString *description = g_string_new("Commands:\n");
+    int status = 0;
+
+    for (int i = 0; commands[i].name != NULL; i++) {
+        g_string_append_printf(description, "  %s %s\n      %s\n",
+                commands[i].name, commands[i].args, commands[i].description);
+    }
+
+    context = g_option_context_new(
+            "COMMAND [ARGS...] - Query the index written by java-indexproject");
+    g_option_context_add_main_entries(context, options, NULL);
+    g_option_context_set_description(context, description->str);
+
+    if (!g_option_context_parse(context, &argc, &argv, &error)) {
+        usage(error->message, context);
+    }
+
+    if (argc < 2) usage("No command given", context);
+
+    status = sqlite3_open_v2(database, &db, SQLITE_OPEN_READONLY, NULL);
+
+    if (status != SQLITE_OK) {
+        fprintf(stderr, "Can't open database: %s\n", sqlite3_errmsg(db));
+        sqlite3_close(db);
+        exit(1);
+    }
+
+    open_layers();
+
+    for (int i = 0; commands[i].name != NULL; i++) {
+        if (g_strcmp0(commands[i].name, argv[1]) == 0) {
+            status = commands[i].run(argc - 2, argv + 2);
+
+            sqlite3_close(db);
+            g_string_free(description, TRUE);
+            g_option_context_free(context);
+
+            return status;
+        }
+    }
+
+    gchar *msg = g_strdup_printf("Unknown command '%s'", argv[1]);
+    usage(msg, context);
+}
+
+/*
+ * Attach the base index if the index is an overlay created with
+ * java-indexproject --base-dir and shadow its tables with views which
+ * combine both
+ */
+void open_layers()
+{
+    sqlite3_stmt *stmt = NULL;
+    gchar *base = NULL;
+    gchar *sql = NULL;
+    int status = 0;
+
+    // indexes of older versions don't have a layers table
+    status = sqlite3_prepare_v2(db, "SELECT path FROM layers", -1, &stmt,
+            NULL);
+    if (status != SQLITE_OK) return;
+
+    if (sqlite3_step(stmt) == SQLITE_ROW) {
+        base = g_strdup((const gchar*) sqlite3_column_text(stmt, 0));
+    }
+
+    sqlite3_finalize(stmt);
+
+    if (base == NULL) return;
+
+    sql = sqlite3_mprintf("ATTACH %Q AS base", base);
+    status = sqlite3_exec(db, sql, NULL, 0, NULL);
+    sqlite3_free(sql);
+
+    if (status != SQLITE_OK) {
+        fprintf(stderr, "Can't open the base index %s: %s\n", base,
+                sqlite3_errmsg(db));
+        exit(1);
+    }
+
+    status = sqlite3_exec(db, LAYER_VIEWS, NULL, 0, NULL);
+    handle_sql_error(status, __LINE__);
+
+    // the views of the schema have to be created in the temp schema as well
+    // so that they use the combined tables
+    gchar **views = g_strsplit(SCHEMA_VIEWS, "CREATE VIEW", 0);
+    sql = g_strjoinv("CREATE TEMP VIEW", views);
+    status = sqlite3_exec(db, sql, NULL, 0, NULL);
+    handle_sql_error(status, __LINE__);
+
+    g_free(sql);
+    g_strfreev(views);
+    g_free(base);
+}
+
+/*
+ * Append a list of class names read from a summary record
+ */
+void append_names(SummaryReader *reader, GString *out, const gchar *prefix)
+{
+    guint64 count = summary_get_uint(reader);
+
+    if (json) g_string_append_c(out, '[');
+
+    for (guint64 i = 0; i < count && !reader->error; i++) {
+        gchar *name = summary_get_string(reader);
+
+        if (json) {
+            if (i > 0) g_string_append_c(out, ',');
+            json_append_string(out, name);
+        } else {
+            g_string_append_printf(out, "%s%s\n", prefix, name);
+        }
+
+        g_free(name);
+    }
+
+    if (json) g_string_append_c(out, ']');
+}
+
+/*
+ * Append the fields or methods of a summary record
+ */
+void append_members(SummaryReader *reader, GString *out, gboolean methods)
+{
+    guint64 count = summary_get_uint(reader);
+
+    if (json) g_string_append_c(out, '[');
+
+    for (guint64 i = 0; i < count && !reader->error; i++) {
+        guint64 access_flags = summary_get_uint(reader);
+        gchar *name = summary_get_string(reader);
+        gchar *descriptor = summary_get_string(reader);
+        gchar *signature = summary_get_string(reader);
+
+        if (json) {
+            if (i > 0) g_string_append_c(out, ',');
+            g_string_append(out, "{\"name\":");
+            json_append_string(out, name);
+            g_string_append(out, ",\"descriptor\":");
+            json_append_string(out, descriptor);
+            g_string_append(out, ",\"signature\":");
+            json_append_string(out, signature);
+            g_string_append_printf(out, ",\"access_flags\":%u",
+                    (guint) access_flags);
+        } else if (methods) {
+            g_string_append_printf(out, "    method %s%s (flags 0x%04x)\n",
+                    name, descriptor, (guint) access_flags);
+        } else {
+            g_string_append_printf(out, "    field %s %s (flags 0x%04x)\n",
+                    descriptor, name, (guint) access_flags);
+        }
+
+        if (!json && signature != NULL) {
+            g_string_append_printf(out, "        signature %s\n", signature);
+        }
+
+        if (methods) {
+            if (json) g_string_append(out, ",\"exceptions\":");
+            append_names(reader, out, "        throws ");
+        }
+
+        if (json) g_string_append_c(out, '}');
+
+        g_free(name);
+        g_free(descriptor);
+        g_free(signature);
+    }
+
+    if (json) g_string_append_c(out, ']');
+}
+
+/*
+ * Format an uncompressed summary record; returns FALSE if the record is
+ * corrupt or of an unknown version
+ */
+gboolean append_summary(const guchar *data, gsize size, GString *out)
+{
+    SummaryReader reader;
+
+    summary_reader_init(&reader, data, size);
+    if (summary_get_uint(&reader) != SUMMARY_VERSION) return FALSE;
+
+    guint64 access_flags = summary_get_uint(&reader);
+    gchar *name = summary_get_string(&reader);
+    gchar *parent = summary_get_string(&reader);
+    gchar *signature = summary_get_string(&reader);
+
+    if (json) {
+        g_string_append(out, "{\"name\":");
+        json_append_string(out, name);
+        g_string_append(out, ",\"parent\":");
+        json_append_string(out, parent);
+        g_string_append(out, ",\"signature\":");
+        json_append_string(out, signature);
+        g_string_append_printf(out, ",\"access_flags\":%u,\"interfaces\":",
+                (guint) access_flags);
+        append_names(&reader, out, NULL);
+        g_string_append(out, ",\"fields\":");
+        append_members(&reader, out, FALSE);
+        g_string_append(out, ",\"methods\":");
+        append_members(&reader, out, TRUE);
+        g_string_append(out, "}\n");
+    } else {
+        g_string_append_printf(out, "%s (flags 0x%04x)\n", name,
+                (guint) access_flags);
+        if (parent != NULL) {
+            g_string_append_printf(out, "    extends %s\n", parent);
+        }
+        if (signature != NULL) {
+            g_string_append_printf(out, "    signature %s\n", signature);
+        }
+        append_names(&reader, out, "    implements ");
+        append_members(&reader, out, FALSE);
+        append_members(&reader, out, TRUE);
+    }
+
+    g_free(name);
+    g_free(parent);
+    g_free(signature);
+
+    return !reader.error;
+}
+
+/*
+ * Print all members of classes from their summary records
+ *
+ * Each class costs one lookup of its name in the primary key of
+ * class_summaries instead of joining the tables of the index.
+ */
+int query_members(int argc, gchar **argv)
+{
+    sqlite3_stmt *stmt = NULL;
+    int status = 0;
+    int result = 0;
+    GString *out = NULL;
+
+    if (argc == 0) {
+        fprintf(stderr, "ERROR: No class given\n");
+        return 2;
+    }
+
+    out = g_string_new(NULL);
+
+    status = sqlite3_prepare_v2(db,
+            "SELECT size, summary FROM class_summaries WHERE name=?",
+            -1, &stmt, NULL);
+    handle_sql_error(status, __LINE__);
+
+    for (int i = 0; i < argc; i++) {
+        sqlite3_reset(stmt);
+        status = sqlite3_bind_text(stmt, 1, argv[i], -1, SQLITE_STATIC);
+        handle_sql_error(status, __LINE__);
+
+        status = sqlite3_step(stmt);
+        handle_sql_error(status, __LINE__);
+
+        if (status != SQLITE_ROW) {
+            fprintf(stderr, "No summary of class %s in the index (was it "
+                    "indexed with --summaries?)\n", argv[i]);
+            result = 1;
+            continue;
+        }
+
+        gsize size = sqlite3_column_int64(stmt, 0);
+        guchar *data = summary_uncompress(sqlite3_column_blob(stmt, 1),
+                sqlite3_column_bytes(stmt, 1), size);
+
+        g_string_truncate(out, 0);
+
+        if (data == NULL || !append_summary(data, size, out)) {
+            fprintf(stderr, "ERROR: The summary of class %s is corrupt\n",
+                    argv[i]);
+            result = 1;
+        } else {
+            fwrite(out->str, 1, out->len, stdout);
+        }
+
+        g_free(data);
+    }
+
+    sqlite3_finalize(stmt);
+    g_string_free(out, TRUE);
+
+    return result;
+}
+
+/*
+ * Names of the targets of annotations in the index
+ */
+static const gchar *ANNOTATION_TARGETS[] = {"class", "field", "method"};
+
+/*
+ * Append the element values of an annotation
+ */
+void append_annotation_values(sqlite3_stmt *stmt, gint64 annotation_id,
+        GString *out)
+{
+    int status = 0;
+    int rows = 0;
+
+    sqlite3_reset(stmt);
+    status = sqlite3_bind_int64(stmt, 1, annotation_id);
+    handle_sql_error(status, __LINE__);
+
+    if (json) g_string_append(out, ",\"values\":[");
+
+    while ((status = sqlite3_step(stmt)) == SQLITE_ROW) {
+        const gchar *name = (const gchar*) sqlite3_column_text(stmt, 0);
+        const gchar *value = (const gchar*) sqlite3_column_text(stmt, 1);
+
+        if (json) {
+            if (rows > 0) g_string_append_c(out, ',');
+            g_string_append(out, "{\"name\":");
+            json_append_string(out, name);
+            g_string_append(out, ",\"value\":");
+            json_append_string(out, value);
+            g_string_append_c(out, '}');
+        } else {
+            g_string_append_printf(out, "%s%s=%s", rows > 0 ? ", " : "\t(",
+                    name, value != NULL ? value : "");
+        }
+
+        rows++;
+    }
+    handle_sql_error(status, __LINE__);
+
+    if (json) {
+        g_string_append_c(out, ']');
+    } else if (rows > 0) {
+        g_string_append_c(out, ')');
+    }
+}
+
+/*
+ * Print the classes, fields and methods with annotations of the given
+ * types or with any annotation if no type is given
+ *
+ * Each type costs a lookup of its names and of its rows in the index on
+ * the types of annotations.
+ */
+int query_annotated(int argc, gchar **argv)
+{
+    sqlite3_stmt *stmt = NULL;
+    sqlite3_stmt *values = NULL;
+    int status = 0;
+    int result = 0;
+    GString *out = g_string_new(NULL);
+
+    status = sqlite3_prepare_v2(db,
+            "SELECT a.id, CASE tn.name WHEN ?1 THEN ti.name "
+            "    ELSE tn.name || '.' || ti.name END, "
+            "    CASE n.name WHEN ?1 THEN i.name "
+            "    ELSE n.name || '.' || i.name END, "
+            "    a.target, a.member_name, d.name, a.visible "
+            "FROM annotations a "
+            "JOIN importables ti ON ti.id = a.type_importable_id "
+            "JOIN namespaces tn ON tn.id = a.type_namespace_id "
+            "JOIN importables i ON i.id = a.importable_id "
+            "JOIN namespaces n ON n.id = a.namespace_id "
+            "LEFT JOIN descriptors d ON d.id = a.descriptor_id "
+            "WHERE ?2 IS NULL OR (ti.name = ?2 AND tn.name = ?3) "
+            "ORDER BY a.id",
+            -1, &stmt, NULL);
+    handle_sql_error(status, __LINE__);
+    status = sqlite3_bind_text(stmt, 1, DEFAULT_PACKAGE, -1, SQLITE_STATIC);
+    handle_sql_error(status, __LINE__);
+
+    status = sqlite3_prepare_v2(db,
+            "SELECT name, value FROM annotation_values "
+            "WHERE annotation_id = ? ORDER BY rowid",
+            -1, &values, NULL);
+    handle_sql_error(status, __LINE__);
+
+    // without a type the loop runs once with NULL bound to ?2
+    for (int i = 0; i < MAX(argc, 1); i++) {
+        gchar *namespace = NULL;
+        const gchar *name = NULL;
+        int rows = 0;
+
+        if (argc > 0) {
+            gchar *dot = strrchr(argv[i], '.');
+
+            if (dot != NULL) {
+                namespace = g_strndup(argv[i], dot - argv[i]);
+                name = dot + 1;
+            } else {
+                namespace = g_strdup(DEFAULT_PACKAGE);
+                name = argv[i];
+            }
+        }
+
+        sqlite3_reset(stmt);
+        status = sqlite3_bind_text(stmt, 2, name, -1, SQLITE_STATIC);
+        handle_sql_error(status, __LINE__);
+        status = sqlite3_bind_text(stmt, 3, namespace, -1, SQLITE_STATIC);
+        handle_sql_error(status, __LINE__);
+
+        while ((status = sqlite3_step(stmt)) == SQLITE_ROW) {
+            gint64 id = sqlite3_column_int64(stmt, 0);
+            const gchar *type = (const gchar*) sqlite3_column_text(stmt, 1);
+            const gchar *class = (const gchar*) sqlite3_column_text(stmt, 2);
+            int target = sqlite3_column_int(stmt, 3);
+            const gchar *member = (const gchar*) sqlite3_column_text(stmt, 4);
+            const gchar *descriptor =
+                (const gchar*) sqlite3_column_text(stmt, 5);
+            gboolean visible = sqlite3_column_int(stmt, 6);
+
+            if (target < 0 || target > 2) target = 0;
+
+            g_string_truncate(out, 0);
+
+            if (json) {
+                g_string_append(out, "{\"annotation\":");
+                json_append_string(out, type);
+                g_string_append(out, ",\"class\":");
+                json_append_string(out, class);
+                g_string_append_printf(out, ",\"target\":\"%s\"",
+                        ANNOTATION_TARGETS[target]);
+                g_string_append(out, ",\"member\":");
+                json_append_string(out, member);
+                g_string_append(out, ",\"descriptor\":");
+                json_append_string(out, descriptor);
+                g_string_append_printf(out, ",\"visible\":%s",
+                        visible ? "true" : "false");
+                append_annotation_values(values, id, out);
+                g_string_append(out, "}\n");
+            } else {
+                g_string_append_printf(out, "%s\t%s\t%s", type, class,
+                        ANNOTATION_TARGETS[target]);
+                if (member != NULL) {
+                    g_string_append_printf(out, "\t%s%s", member,
+                            descriptor != NULL ? descriptor : "");
+                }
+                append_annotation_values(values, id, out);
+                g_string_append_c(out, '\n');
+            }
+
+            fwrite(out->str, 1, out->len, stdout);
+            rows++;
+        }
+        handle_sql_error(status, __LINE__);
+
+        if (argc > 0 && rows == 0) {
+            fprintf(stderr, "No element annotated with %s in the index\n",
+                    argv[i]);
+            result = 1;
+        }
+
+        g_free(namespace);
+    }
+
+    sqlite3_finalize(values);
+    sqlite3_finalize(stmt);
+    g_string_free(out, TRUE);
+
+    return result;
+}
+
+/*
+ * Bytecode sizes above which HotSpot treats methods differently by default
+ */
+static const struct {
+    guint32 limit;
+    const gchar *flag;
+} JIT_LIMITS[] = {
+    {8000, "HugeMethodLimit"},  // not compiled at all
+    {325, "FreqInlineSize"},    // not inlined even if hot
+    {35, "MaxInlineSize"},      // only inlined if hot
+    {0, NULL}
+};
+
+/*
+ * Sort limits in descending order
+ */
+gint compare_limits(gconstpointer a, gconstpointer b)
+{
+    guint32 x = *(const guint32*) a;
+    guint32 y = *(const guint32*) b;
+
+    return x < y ? 1 : (x > y ? -1 : 0);
+}
+
+/*
+ * Print the methods whose bytecode is longer than one of the limits,
+ * grouped by the JAR or directory and the package of their class
+ *
+ * A method is only listed under the highest limit it exceeds. Each limit
+ * costs one scan of methods_data.
+ */
+int query_method_sizes(int argc, gchar **argv)
+{
+    sqlite3_stmt *stmt = NULL;
+    int status = 0;
+    GArray *limits = g_array_new(FALSE, FALSE, sizeof(guint32));
+    GString *out = g_string_new(NULL);
+
+    for (int i = 0; i < argc; i++) {
+        gchar *end = NULL;
+        guint64 limit = g_ascii_strtoull(argv[i], &end, 10);
+
+        if (end == argv[i] || *end != '\0' || limit > G_MAXUINT32) {
+            fprintf(stderr, "ERROR: Invalid limit '%s'\n", argv[i]);
+            g_array_free(limits, TRUE);
+            g_string_free(out, TRUE);
+            return 2;
+        }
+
+        guint32 value = limit;
+        g_array_append_val(limits, value);
+    }
+
+    if (argc == 0) {
+        for (int i = 0; JIT_LIMITS[i].flag != NULL; i++) {
+            g_array_append_val(limits, JIT_LIMITS[i].limit);
+        }
+    }
+
+    g_array_sort(limits, compare_limits);
+
+    status = sqlite3_prepare_v2(db,
+            "SELECT COALESCE(c.path, '(unknown)'), n.name, i.name, m.name, "
+            "    d.name, m.code_length, m.max_stack, m.max_locals, "
+            "    m.exception_handlers, m.invocations "
+            "FROM methods_data m "
+            "JOIN importables_namespaces_data x "
+            "    ON x.importable_id = m.importable_id "
+            "    AND x.namespace_id = m.namespace_id "
+            "LEFT JOIN containers c ON c.id = x.container_id "
+            "JOIN importables i ON i.id = m.importable_id "
+            "JOIN namespaces n ON n.id = m.namespace_id "
+            "JOIN descriptors d ON d.id = m.descriptor_id "
+            "WHERE m.code_length > ?1 AND (?2 IS NULL OR m.code_length <= ?2) "
+            "ORDER BY x.container_id, n.name, m.code_length DESC",
+            -1, &stmt, NULL);
+    handle_sql_error(status, __LINE__);
+
+    for (guint k = 0; k < limits->len; k++) {
+        guint32 limit = g_array_index(limits, guint32, k);
+        gchar *container = NULL;
+        gchar *package = NULL;
+        const gchar *flag = NULL;
+        int rows = 0;
+
+        // each method only counts for the highest limit it exceeds
+        if (k > 0 && limit == g_array_index(limits, guint32, k - 1)) continue;
+
+        for (int i = 0; JIT_LIMITS[i].flag != NULL; i++) {
+            if (JIT_LIMITS[i].limit == limit) flag = JIT_LIMITS[i].flag;
+        }
+
+        sqlite3_reset(stmt);
+        status = sqlite3_bind_int64(stmt, 1, limit);
+        handle_sql_error(status, __LINE__);
+        if (k > 0) {
+            status = sqlite3_bind_int64(stmt, 2,
+                    g_array_index(limits, guint32, k - 1));
+        } else {
+            status = sqlite3_bind_null(stmt, 2);
+        }
+        handle_sql_error(status, __LINE__);
+
+        if (!json) {
+            printf("Methods over %u bytes%s%s%s\n", limit,
+                    flag != NULL ? " (" : "", flag != NULL ? flag : "",
+                    flag != NULL ? ")" : "");
+        }
+
+        while ((status = sqlite3_step(stmt)) == SQLITE_ROW) {
+            const gchar *path = (const gchar*) sqlite3_column_text(stmt, 0);
+            const gchar *namespace = (const gchar*) sqlite3_column_text(stmt, 1);
+            const gchar *class = (const gchar*) sqlite3_column_text(stmt, 2);
+            const gchar *name = (const gchar*) sqlite3_column_text(stmt, 3);
+            const gchar *descriptor =
+                (const gchar*) sqlite3_column_text(stmt, 4);
+            gint64 code_length = sqlite3_column_int64(stmt, 5);
+            int max_stack = sqlite3_column_int(stmt, 6);
+            int max_locals = sqlite3_column_int(stmt, 7);
+            int handlers = sqlite3_column_int(stmt, 8);
+            gint64 invocations = sqlite3_column_int64(stmt, 9);
+
+            g_string_truncate(out, 0);
+
+            if (json) {
+                g_string_append_printf(out, "{\"limit\":%u,\"container\":",
+                        limit);
+                json_append_string(out, path);
+                g_string_append(out, ",\"package\":");
+                json_append_string(out, namespace);
+                g_string_append(out, ",\"class\":");
+                json_append_string(out, class);
+                g_string_append(out, ",\"method\":");
+                json_append_string(out, name);
+                g_string_append(out, ",\"descriptor\":");
+                json_append_string(out, descriptor);
+                g_string_append_printf(out, ",\"code_length\":%" G_GINT64_FORMAT
+                        ",\"max_stack\":%d,\"max_locals\":%d,"
+                        "\"exception_handlers\":%d,\"invocations\":%"
+                        G_GINT64_FORMAT "}\n", code_length, max_stack,
+                        max_locals, handlers, invocations);
+            } else {
+                if (g_strcmp0(container, path) != 0) {
+                    g_free(container);
+                    container = g_strdup(path);
+                    g_free(package);
+                    package = NULL;
+                    g_string_append_printf(out, "  %s\n", path);
+                }
+
+                if (g_strcmp0(package, namespace) != 0) {
+                    g_free(package);
+                    package = g_strdup(namespace);
+                    g_string_append_printf(out, "    %s\n", namespace);
+                }
+
+                g_string_append_printf(out, "      %s.%s%s %" G_GINT64_FORMAT
+                        " bytes, stack %d, locals %d, %d handlers, %"
+                        G_GINT64_FORMAT " calls\n", class, name, descriptor,
+                        code_length, max_stack, max_locals, handlers,
+                        invocations);
+            }
+
+            fwrite(out->str, 1, out->len, stdout);
+            rows++;
+        }
+        handle_sql_error(status, __LINE__);
+
+        if (!json) printf("  %d methods\n", rows);
+
+        g_free(container);
+        g_free(package);
+    }
+
+    sqlite3_finalize(stmt);
+    g_array_free(limits, TRUE);
+    g_string_free(out, TRUE);
+
+    return 0;
+}
+
+/*
+ * Print the containers of classes with the one the JVM would load first
+ *
+ * Each class costs a lookup of its names and of its rows in the primary
+ * keys of importables_namespaces_data and shadowed_classes.
+ */
+int query_providers(int argc, gchar **argv)
+{
+    sqlite3_stmt *stmt = NULL;
+    int status = 0;
+    int result = 0;
+    GString *out = NULL;
+
+    if (argc == 0) {
+        fprintf(stderr, "ERROR: No class given\n");
+        return 2;
+    }
+
+    out = g_string_new(NULL);
+
+    status = sqlite3_prepare_v2(db,
+            "SELECT c.path, p.winner FROM class_providers p "
+            "JOIN importables i ON i.id = p.importable_id "
+            "JOIN namespaces n ON n.id = p.namespace_id "
+            "JOIN containers c ON c.id = p.container_id "
+            "WHERE i.name = ? AND n.name = ? "
+            "ORDER BY p.winner DESC, p.container_id",
+            -1, &stmt, NULL);
+    handle_sql_error(status, __LINE__);
+
+    for (int i = 0; i < argc; i++) {
+        gchar *dot = strrchr(argv[i], '.');
+        gchar *namespace = NULL;
+        const gchar *name = argv[i];
+        int rows = 0;
+
+        if (dot != NULL) {
+            namespace = g_strndup(argv[i], dot - argv[i]);
+            name = dot + 1;
+        } else {
+            namespace = g_strdup(DEFAULT_PACKAGE);
+        }
+
+        sqlite3_reset(stmt);
+        status = sqlite3_bind_text(stmt, 1, name, -1, SQLITE_STATIC);
+        handle_sql_error(status, __LINE__);
+        status = sqlite3_bind_text(stmt, 2, namespace, -1, SQLITE_STATIC);
+        handle_sql_error(status, __LINE__);
+
+        g_string_truncate(out, 0);
+
+        if (json) {
+            g_string_append(out, "{\"name\":");
+            json_append_string(out, argv[i]);
+            g_string_append(out, ",\"providers\":[");
+        } else {
+            g_string_append_printf(out, "%s\n", argv[i]);
+        }
+
+        while ((status = sqlite3_step(stmt)) == SQLITE_ROW) {
+            const gchar *path = (const gchar*) sqlite3_column_text(stmt, 0);
+            gboolean winner = sqlite3_column_int(stmt, 1);
+
+            if (json) {
+                if (rows > 0) g_string_append_c(out, ',');
+                g_string_append(out, "{\"path\":");
+                json_append_string(out, path);
+                g_string_append_printf(out, ",\"winner\":%s}",
+                        winner ? "true" : "false");
+            } else {
+                g_string_append_printf(out, "    %s%s\n", path,
+                        winner ? "" : " (shadowed)");
+            }
+
+            rows++;
+        }
+        handle_sql_error(status, __LINE__);
+
+        if (json) g_string_append(out, "]}\n");
+
+        if (rows == 0) {
+            fprintf(stderr, "Class %s isn't in the index\n", argv[i]);
+            result = 1;
+        } else {
+            fwrite(out->str, 1, out->len, stdout);
+        }
+
+        g_free(namespace);
+    }
+
+    sqlite3_finalize(stmt);
+    g_string_free(out, TRUE);
+
+    return result;
+}
+
+/*
+ * Print the artifacts of the repositories indexed with --repository which
+ * contain classes with the first and last version of each run of versions
+ * containing them
+ */
+int query_artifacts(int argc, gchar **argv)
+{
+    sqlite3_stmt *stmt = NULL;
+    int status = 0;
+    int result = 0;
+    GString *out = NULL;
+
+    if (argc == 0) {
+        fprintf(stderr, "ERROR: No class given\n");
+        return 2;
+    }
+
+    out = g_string_new(NULL);
+
+    status = sqlite3_prepare_v2(db,
+            "SELECT a.group_id, a.artifact_id, f.version, l.version "
+            "FROM artifact_classes ac "
+            "JOIN importables i ON i.id = ac.importable_id "
+            "JOIN namespaces n ON n.id = ac.namespace_id "
+            "JOIN artifact_versions f ON f.id = ac.first_version_id "
+            "JOIN artifact_versions l ON l.id = ac.last_version_id "
+            "JOIN artifacts a ON a.id = f.artifact_id "
+            "WHERE i.name = ? AND n.name = ? "
+            "ORDER BY a.group_id, a.artifact_id, ac.first_version_id",
+            -1, &stmt, NULL);
+    handle_sql_error(status, __LINE__);
+
+    for (int i = 0; i < argc; i++) {
+        gchar *dot = strrchr(argv[i], '.');
+        gchar *namespace = NULL;
+        const gchar *name = argv[i];
+        int rows = 0;
+
+        if (dot != NULL) {
+            namespace = g_strndup(argv[i], dot - argv[i]);
+            name = dot + 1;
+        } else {
+            namespace = g_strdup(DEFAULT_PACKAGE);
+        }
+
+        sqlite3_reset(stmt);
+        status = sqlite3_bind_text(stmt, 1, name, -1, SQLITE_STATIC);
+        handle_sql_error(status, __LINE__);
+        status = sqlite3_bind_text(stmt, 2, namespace, -1, SQLITE_STATIC);
+        handle_sql_error(status, __LINE__);
+
+        g_string_truncate(out, 0);
+
+        if (json) {
+            g_string_append(out, "{\"name\":");
+            json_append_string(out, argv[i]);
+            g_string_append(out, ",\"artifacts\":[");
+        } else {
+            g_string_append_printf(out, "%s\n", argv[i]);
+        }
+
+        while ((status = sqlite3_step(stmt)) == SQLITE_ROW) {
+            const gchar *group_id = (const gchar*) sqlite3_column_text(stmt, 0);
+            const gchar *artifact_id =
+                (const gchar*) sqlite3_column_text(stmt, 1);
+            const gchar *first = (const gchar*) sqlite3_column_text(stmt, 2);
+            const gchar *last = (const gchar*) sqlite3_column_text(stmt, 3);
+
+            if (json) {
+                if (rows > 0) g_string_append_c(out, ',');
+                g_string_append(out, "{\"groupId\":");
+                json_append_string(out, group_id);
+                g_string_append(out, ",\"artifactId\":");
+                json_append_string(out, artifact_id);
+                g_string_append(out, ",\"first\":");
+                json_append_string(out, first);
+                g_string_append(out, ",\"last\":");
+                json_append_string(out, last);
+                g_string_append_c(out, '}');
+            } else if (g_strcmp0(first, last) == 0) {
+                g_string_append_printf(out, "    %s:%s:%s\n", group_id,
+                        artifact_id, first);
+            } else {
+                g_string_append_printf(out, "    %s:%s:%s..%s\n", group_id,
+                        artifact_id, first, last);
+            }
+
+            rows++;
+        }
+        handle_sql_error(status, __LINE__);
+
+        if (json) g_string_append(out, "]}\n");
+
+        if (rows == 0) {
+            fprintf(stderr, "Class %s isn't in any artifact\n", argv[i]);
+            result = 1;
+        } else {
+            fwrite(out->str, 1, out->len, stdout);
+        }
+
+        g_free(namespace);
+    }
+
+    sqlite3_finalize(stmt);
+    g_string_free(out, TRUE);
+
+    return result;
+}
+
+/*
+ * Names of the kinds of resource files registering services
+ */
+static const gchar *SERVICE_KINDS[] = {
+    "services",
+    "spring.factories",
+    "spring.imports"
+};
+
+/*
+ * Print the providers of services with the JAR or directory registering
+ * them
+ *
+ * Each service costs a lookup of its names and of its rows in the index on
+ * the services. Providers whose class isn't in the index are marked as
+ * missing since ServiceLoader would fail to load them.
+ */
+int query_services(int argc, gchar **argv)
+{
+    sqlite3_stmt *stmt = NULL;
+    int status = 0;
+    int result = 0;
+    GString *out = g_string_new(NULL);
+
+    status = sqlite3_prepare_v2(db,
+            "SELECT CASE sn.name WHEN ?1 THEN si.name "
+            "    ELSE sn.name || '.' || si.name END, "
+            "    CASE pn.name WHEN ?1 THEN pi.name "
+            "    ELSE pn.name || '.' || pi.name END, "
+            "    s.kind, COALESCE(c.path, '(unknown)'), COALESCE(x.done, 0) "
+            "FROM services s "
+            "JOIN importables si ON si.id = s.service_importable_id "
+            "JOIN namespaces sn ON sn.id = s.service_namespace_id "
+            "JOIN importables pi ON pi.id = s.provider_importable_id "
+            "JOIN namespaces pn ON pn.id = s.provider_namespace_id "
+            "LEFT JOIN containers c ON c.id = s.container_id "
+            "LEFT JOIN importables_namespaces_data x "
+            "    ON x.importable_id = s.provider_importable_id "
+            "    AND x.namespace_id = s.provider_namespace_id "
+            "WHERE ?2 IS NULL OR (si.name = ?2 AND sn.name = ?3) "
+            "ORDER BY sn.name, si.name, s.container_id",
+            -1, &stmt, NULL);
+    handle_sql_error(status, __LINE__);
+    status = sqlite3_bind_text(stmt, 1, DEFAULT_PACKAGE, -1, SQLITE_STATIC);
+    handle_sql_error(status, __LINE__);
+
+    // without a service the loop runs once with NULL bound to ?2
+    for (int i = 0; i < MAX(argc, 1); i++) {
+        gchar *namespace = NULL;
+        const gchar *name = NULL;
+        int rows = 0;
+
+        if (argc > 0) {
+            gchar *dot = strrchr(argv[i], '.');
+
+            if (dot != NULL) {
+                namespace = g_strndup(argv[i], dot - argv[i]);
+                name = dot + 1;
+            } else {
+                namespace = g_strdup(DEFAULT_PACKAGE);
+                name = argv[i];
+            }
+        }
+
+        sqlite3_reset(stmt);
+        status = sqlite3_bind_text(stmt, 2, name, -1, SQLITE_STATIC);
+        handle_sql_error(status, __LINE__);
+        status = sqlite3_bind_text(stmt, 3, namespace, -1, SQLITE_STATIC);
+        handle_sql_error(status, __LINE__);
+
+        while ((status = sqlite3_step(stmt)) == SQLITE_ROW) {
+            const gchar *service = (const gchar*) sqlite3_column_text(stmt, 0);
+            const gchar *provider = (const gchar*) sqlite3_column_text(stmt, 1);
+            int kind = sqlite3_column_int(stmt, 2);
+            const gchar *path = (const gchar*) sqlite3_column_text(stmt, 3);
+            gboolean indexed = sqlite3_column_int(stmt, 4);
+
+            if (kind < 0 || kind > 2) kind = 0;
+
+            g_string_truncate(out, 0);
+
+            if (json) {
+                g_string_append(out, "{\"service\":");
+                json_append_string(out, service);
+                g_string_append(out, ",\"provider\":");
+                json_append_string(out, provider);
+                g_string_append_printf(out, ",\"kind\":\"%s\",\"container\":",
+                        SERVICE_KINDS[kind]);
+                json_append_string(out, path);
+                g_string_append_printf(out, ",\"indexed\":%s}\n",
+                        indexed ? "true" : "false");
+            } else {
+                g_string_append_printf(out, "%s\t%s\t%s\t%s%s\n", service,
+                        provider, SERVICE_KINDS[kind], path,
+                        indexed ? "" : " (missing)");
+            }
+
+            fwrite(out->str, 1, out->len, stdout);
+            rows++;
+        }
+        handle_sql_error(status, __LINE__);
+
+        if (argc > 0 && rows == 0) {
+            fprintf(stderr, "No provider of service %s in the index\n",
+                    argv[i]);
+            result = 1;
+        }
+
+        g_free(namespace);
+    }
+
+    sqlite3_finalize(stmt);
+    g_string_free(out, TRUE);
+
+    return result;
+}
+
+/*
+ * Print every shadowed class with the container it is taken from and the
+ * container it is shadowed in
+ *
+ * Returns 1 if there are any so that class path conflicts can fail a build.
+ */
+int query_shadowed(int argc, gchar **argv)
+{
+    sqlite3_stmt *stmt = NULL;
+    int status = 0;
+    int result = 0;
+    GString *out = g_string_new(NULL);
+
+    status = sqlite3_prepare_v2(db,
+            "SELECT CASE n.name WHEN ?1 THEN i.name "
+            "    ELSE n.name || '.' || i.name END, w.path, c.path "
+            "FROM shadowed_classes s "
+            "JOIN importables_namespaces_data d "
+            "    ON d.importable_id = s.importable_id "
+            "    AND d.namespace_id = s.namespace_id "
+            "JOIN importables i ON i.id = s.importable_id "
+            "JOIN namespaces n ON n.id = s.namespace_id "
+            "JOIN containers w ON w.id = d.container_id "
+            "JOIN containers c ON c.id = s.container_id "
+            "ORDER BY n.name, i.name, s.container_id",
+            -1, &stmt, NULL);
+    handle_sql_error(status, __LINE__);
+    status = sqlite3_bind_text(stmt, 1, DEFAULT_PACKAGE, -1, SQLITE_STATIC);
+    handle_sql_error(status, __LINE__);
+
+    while ((status = sqlite3_step(stmt)) == SQLITE_ROW) {
+        const gchar *name = (const gchar*) sqlite3_column_text(stmt, 0);
+        const gchar *winner = (const gchar*) sqlite3_column_text(stmt, 1);
+        const gchar *shadowed = (const gchar*) sqlite3_column_text(stmt, 2);
+
+        g_string_truncate(out, 0);
+
+        if (json) {
+            g_string_append(out, "{\"name\":");
+            json_append_string(out, name);
+            g_string_append(out, ",\"winner\":");
+            json_append_string(out, winner);
+            g_string_append(out, ",\"shadowed\":");
+            json_append_string(out, shadowed);
+            g_string_append(out, "}\n");
+        } else {
+            g_string_append_printf(out, "%s\t%s\t%s\n", name, winner,
+                    shadowed);
+        }
+
+        fwrite(out->str, 1, out->len, stdout);
+        result = 1;
+    }
+    handle_sql_error(status, __LINE__);
+
+    sqlite3_finalize(stmt);
+    g_string_free(out, TRUE);
+
+    return result;
+}
+
+/*
+ * Run an SQL query against the index and print its rows
+ *
+ * Columns are separated by tabs and NULL is printed as \N like in the TSV
+ * export of java-indexproject.
+ */
+int query_sql(int argc, gchar **argv)
+{
+    sqlite3_stmt *stmt = NULL;
+    int status = 0;
+
+    if (argc != 1) {
+        fprintf(stderr, "ERROR: Expected exactly one query\n");
+        return 2;
+    }
+
+    status = sqlite3_prepare_v2(db, argv[0], -1, &stmt, NULL);
+    if (status != SQLITE_OK) {
+        fprintf(stderr, "ERROR: %s\n", sqlite3_errmsg(db));
+        return 1;
+    }
+
+    while ((status = sqlite3_step(stmt)) == SQLITE_ROW) {
+        int columns = sqlite3_column_count(stmt);
+
+        for (int i = 0; i < columns; i++) {
+            const gchar *value = (const gchar*) sqlite3_column_text(stmt, i);
+
+            fputs(value != NULL ? value : "\\N", stdout);
+            fputc(i < columns - 1 ? '\t' : '\n', stdout);
+        }
+    }
+    handle_sql_error(status, __LINE__);
+
+    sqlite3_finalize(stmt);
+
+    return 0;
+}
+
+void handle_sql_error(int status, int line)
+{
+    if (status != SQLITE_OK && status != SQLITE_DONE && status != SQLITE_ROW) {
+        fprintf(stderr, "SQL error on line %d: %s\n", line, sqlite3_errmsg(db));
+        exit(1);
+    }
+}
@@ -0,0 +1,228 @@
+/*
+The MIT License (MIT) 
+Copyright (c) 2009,2010,2016 Andreas Heck <aheck@gmx.de>
+
+Permission to use, copy, modify, and/or distribute this software for any
+purpose with or without fee is hereby granted, provided that the above
+copyright notice and this permission notice appear in all copies.
+
+THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+*/
+
+// posix_fadvise() is only declared for POSIX.1-2001
+#define _POSIX_C_SOURCE 200112L
+
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <glib.h>
+
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <dirent.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <readahead.h>
+#include <zipdir.h>
+
+typedef struct {
+    guint index;
+    guint32 offset;
+} ZipEntryOffset;
+
+typedef struct {
+    gchar *name;
+    ino_t inode;
+} DirEntry;
+
+/*
+ * Ask the kernel to read a whole file into the page cache in the background
+ */
+void readahead_file(const gchar *path)
+{
+#ifdef POSIX_FADV_WILLNEED
+    int fd = open(path, O_RDONLY);
+
+    if (fd < 0) return;
+
+    posix_fadvise(fd, 0, 0, POSIX_FADV_WILLNEED);
+    close(fd);
+#endif
+}
+
+static gint compare_offsets(gconstpointer a, gconstpointer b)
+{
+    const ZipEntryOffset *entry_a = a;
+    const ZipEntryOffset *entry_b = b;
+
+    if (entry_a->offset < entry_b->offset) return -1;
+    if (entry_a->offset > entry_b->offset) return 1;
+
+    return 0;
+}
+
+/*
+ * Read size bytes at offset of a file into a new buffer
+ */
+static guchar *read_at(FILE *fp, long offset, gsize size)
+{
+    guchar *buffer = g_malloc(size);
+
+    if (fseek(fp, offset, SEEK_SET) != 0 || fread(buffer, 1, size, fp) != size) {
+        g_free(buffer);
+        return NULL;
+    }
+
+    return buffer;
+}
+
+/*
+ * Read the local header offsets of all entries from the central directory,
+ * which has to match the numfiles entries of libzip
+ */
+static ZipEntryOffset *read_offsets(FILE *fp, gsize file_size,
+        guint numfiles)
+{
+    gsize tail_size = MIN(file_size, ZIPDIR_MAX_TAIL);
+    guchar *tail = read_at(fp, file_size - tail_size, tail_size);
+    guchar *cdir = NULL;
+    guint32 *offsets = NULL;
+    ZipEntryOffset *entries = NULL;
+    ZipDirEnd end;
+    gboolean found = FALSE;
+
+    if (tail == NULL) return NULL;
+
+    found = zipdir_read_end(tail, tail_size, file_size, &end);
+    g_free(tail);
+
+    if (!found || end.count != numfiles) return NULL;
+
+    cdir = read_at(fp, end.offset, end.size);
+    if (cdir == NULL) return NULL;
+
+    offsets = zipdir_read_offsets(cdir, end.size, numfiles);
+    g_free(cdir);
+
+    if (offsets == NULL) return NULL;
+
+    entries = g_new(ZipEntryOffset, numfiles);
+
+    for (guint i = 0; i < numfiles; i++) {
+        entries[i].index  = i;
+        entries[i].offset = offsets[i];
+    }
+
+    g_free(offsets);
+
+    return entries;
+}
+
+/*
+ * Return the indexes of the entries of a JAR sorted by the offsets of
+ * their local headers, or NULL if the entries should be read in the order
+ * of the central directory
+ *
+ * The central directory is parsed here since libzip doesn't expose the
+ * offsets. NULL is returned for anything unusual, e.g. ZIP64 archives or a
+ * central directory which doesn't match the numfiles entries of libzip.
+ */
+guint *readahead_jar_order(const gchar *jarfile, guint numfiles)
+{
+    FILE *fp = NULL;
+    struct stat st;
+    ZipEntryOffset *entries = NULL;
+    guint *order = NULL;
+
+    if (numfiles == 0) return NULL;
+    if (stat(jarfile, &st) != 0) return NULL;
+
+    fp = fopen(jarfile, "rb");
+    if (fp == NULL) return NULL;
+
+    entries = read_offsets(fp, st.st_size, numfiles);
+    fclose(fp);
+
+    if (entries == NULL) return NULL;
+
+    qsort(entries, numfiles, sizeof(ZipEntryOffset), compare_offsets);
+
+    order = g_new(guint, numfiles);
+    for (guint i = 0; i < numfiles; i++) order[i] = entries[i].index;
+
+    g_free(entries);
+
+    return order;
+}
+
+static gint compare_inodes(gconstpointer a, gconstpointer b)
+{
+    const DirEntry *entry_a = a;
+    const DirEntry *entry_b = b;
+
+    if (entry_a->inode < entry_b->inode) return -1;
+    if (entry_a->inode > entry_b->inode) return 1;
+
+    return 0;
+}
+
+/*
+ * Return the names of the entries of a directory sorted by their inode
+ * numbers
+ *
+ * On most file systems the inode order is close to the order of the data
+ * on disk, so reading the files in it avoids most seeks with a cold page
+ * cache. The inode numbers come with the directory entries, so nothing
+ * but the directory itself is read here. Every walk over the class path
+ * uses this order, so that all of them agree on which of two JARs in a
+ * directory comes first. The caller has to free the array with
+ * g_ptr_array_free().
+ */
+GPtrArray *readahead_dir(const gchar *dirname, GError **error)
+{
+    DIR *dir = NULL;
+    struct dirent *dirent = NULL;
+    GArray *entries = NULL;
+    GPtrArray *names = NULL;
+
+    dir = opendir(dirname);
+    if (dir == NULL) {
+        int saved_errno = errno;
+
+        g_set_error(error, G_FILE_ERROR, g_file_error_from_errno(saved_errno),
+                "Error opening directory '%s': %s", dirname,
+                g_strerror(saved_errno));
+        return NULL;
+    }
+
+    entries = g_array_new(FALSE, FALSE, sizeof(DirEntry));
+
+    while ((dirent = readdir(dir)) != NULL) {
+        if (strcmp(dirent->d_name, ".") == 0) continue;
+        if (strcmp(dirent->d_name, "..") == 0) continue;
+
+        DirEntry entry = {g_strdup(dirent->d_name), dirent->d_ino};
+        g_array_append_val(entries, entry);
+    }
+
+    closedir(dir);
+
+    g_array_sort(entries, compare_inodes);
+    names = g_ptr_array_new_with_free_func(g_free);
+
+    for (guint i = 0; i < entries->len; i++) {
+        g_ptr_array_add(names, g_array_index(entries, DirEntry, i).name);
+    }
+
+    g_array_free(entries, TRUE);
+
+    return names;
+}
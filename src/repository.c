@@ -0,0 +1,589 @@
+/*
+The MIT License (MIT) 
+Copyright (c) 2009,2010,2016 Andreas Heck <aheck@gmx.de>
+
+Permission to use, copy, modify, and/or distribute this software for any
+purpose with or without fee is hereby granted, provided that the above
+copyright notice and this permission notice appear in all copies.
+
+THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <glib.h>
+#include <zip.h>
+
+#include <repository.h>
+#include <nestedjar.h>
+
+#define POM_PROPERTIES_PREFIX "META-INF/maven/"
+#define POM_PROPERTIES_SUFFIX "/pom.properties"
+#define MAX_POM_PROPERTIES (64 * 1024)
+
+// JARs of a version which don't contain classes
+static const gchar *SKIPPED_CLASSIFIERS[] = {
+    "-sources.jar",
+    "-javadoc.jar",
+    NULL
+};
+
+/*
+ * Order of the qualifiers of Maven versions; unknown qualifiers come last
+ * in alphabetical order
+ */
+static const struct {
+    const gchar *name;
+    int rank;
+} QUALIFIERS[] = {
+    {"alpha", 0}, {"a", 0},
+    {"beta", 1}, {"b", 1},
+    {"milestone", 2}, {"m", 2},
+    {"rc", 3}, {"cr", 3},
+    {"snapshot", 4},
+    {"", 5}, {"ga", 5}, {"final", 5}, {"release", 5},
+    {"sp", 6},
+    {NULL, 7}
+};
+
+static void free_version(gpointer data)
+{
+    ArtifactVersion *version = (ArtifactVersion*) data;
+
+    g_free(version->version);
+    g_ptr_array_free(version->jars, TRUE);
+    g_free(version);
+}
+
+static void free_run(gpointer data)
+{
+    ClassRun *run = (ClassRun*) data;
+
+    g_free(run->name);
+    g_free(run);
+}
+
+/*
+ * Free an artifact with its versions and runs
+ */
+void repository_artifact_free(Artifact *artifact)
+{
+    g_free(artifact->group_id);
+    g_free(artifact->artifact_id);
+    g_ptr_array_free(artifact->versions, TRUE);
+    if (artifact->runs != NULL) g_ptr_array_free(artifact->runs, TRUE);
+    g_free(artifact);
+}
+
+static gboolean is_hash(const gchar *name)
+{
+    if (strlen(name) < 16) return FALSE;
+
+    for (const gchar *p = name; *p; p++) {
+        if (!g_ascii_isxdigit(*p)) return FALSE;
+    }
+
+    return TRUE;
+}
+
+/*
+ * Read the coordinates from the only META-INF/maven/G/A/pom.properties of a
+ * JAR; JARs which shade other artifacts have several and are skipped
+ */
+static gboolean pom_coordinates(const gchar *path, gchar **group_id,
+        gchar **artifact_id, gchar **version)
+{
+    struct zip *jar = NULL;
+    int errorp = 0;
+    zip_int64_t found = -1;
+    struct zip_stat st;
+
+    jar = zip_open(path, 0, &errorp);
+    if (jar == NULL) return FALSE;
+
+    int numfiles = zip_get_num_files(jar);
+
+    for (int i = 0; i < numfiles; i++) {
+        const gchar *name = zip_get_name(jar, i, 0);
+
+        if (name == NULL) continue;
+        if (!g_str_has_prefix(name, POM_PROPERTIES_PREFIX)) continue;
+        if (!g_str_has_suffix(name, POM_PROPERTIES_SUFFIX)) continue;
+
+        if (found >= 0) {
+            zip_close(jar);
+            return FALSE;
+        }
+
+        found = i;
+    }
+
+    if (found < 0 || zip_stat_index(jar, found, 0, &st) != 0
+            || st.size > MAX_POM_PROPERTIES) {
+        zip_close(jar);
+        return FALSE;
+    }
+
+    gchar *contents = g_malloc(st.size + 1);
+    struct zip_file *fp = zip_fopen_index(jar, found, 0);
+    zip_int64_t nbytes = fp != NULL ? zip_fread(fp, contents, st.size) : -1;
+
+    if (fp != NULL) zip_fclose(fp);
+    zip_close(jar);
+
+    if (nbytes < 0 || (zip_uint64_t) nbytes != st.size) {
+        g_free(contents);
+        return FALSE;
+    }
+
+    contents[st.size] = '\0';
+
+    gchar **lines = g_strsplit(contents, "\n", 0);
+
+    for (int i = 0; lines[i] != NULL; i++) {
+        gchar *line = g_strstrip(lines[i]);
+        gchar *eq = strchr(line, '=');
+
+        if (line[0] == '#' || eq == NULL) continue;
+
+        *eq = '\0';
+        g_strstrip(line);
+
+        if (g_strcmp0(line, "groupId") == 0) {
+            g_free(*group_id);
+            *group_id = g_strdup(g_strstrip(eq + 1));
+        } else if (g_strcmp0(line, "artifactId") == 0) {
+            g_free(*artifact_id);
+            *artifact_id = g_strdup(g_strstrip(eq + 1));
+        } else if (g_strcmp0(line, "version") == 0) {
+            g_free(*version);
+            *version = g_strdup(g_strstrip(eq + 1));
+        }
+    }
+
+    g_strfreev(lines);
+    g_free(contents);
+
+    if (*group_id != NULL && *artifact_id != NULL && *version != NULL) {
+        return TRUE;
+    }
+
+    g_free(*group_id);
+    g_free(*artifact_id);
+    g_free(*version);
+    *group_id = *artifact_id = *version = NULL;
+
+    return FALSE;
+}
+
+/*
+ * Derive the groupId, artifactId and version of a JAR below root
+ *
+ * Both layouts are recognized by the directory names matching the name of
+ * the JAR:
+ *
+ * - Maven: GROUP/PATH/ARTIFACT/VERSION/ARTIFACT-VERSION[-CLASSIFIER].jar
+ * - Gradle: GROUP/ARTIFACT/VERSION/HASH/ARTIFACT-VERSION[-CLASSIFIER].jar
+ *
+ * Otherwise the coordinates are read from the pom.properties in the JAR.
+ */
+gboolean repository_coordinates(const gchar *root, const gchar *path,
+        gchar **group_id, gchar **artifact_id, gchar **version)
+{
+    const gchar *relative = path;
+    gchar **parts = NULL;
+    guint n = 0;
+    gboolean found = FALSE;
+
+    *group_id = *artifact_id = *version = NULL;
+
+    if (g_str_has_prefix(path, root)) {
+        relative = path + strlen(root);
+        while (*relative == G_DIR_SEPARATOR) relative++;
+    }
+
+    parts = g_strsplit(relative, G_DIR_SEPARATOR_S, 0);
+    n = g_strv_length(parts);
+
+    if (n >= 5 && is_hash(parts[n - 2])) {
+        gchar *prefix = g_strconcat(parts[n - 4], "-", NULL);
+
+        if (g_str_has_prefix(parts[n - 1], prefix)) {
+            *group_id = g_strdup(parts[n - 5]);
+            *artifact_id = g_strdup(parts[n - 4]);
+            *version = g_strdup(parts[n - 3]);
+            found = TRUE;
+        }
+
+        g_free(prefix);
+    }
+
+    if (!found && n >= 4) {
+        gchar *prefix = g_strconcat(parts[n - 3], "-", NULL);
+
+        if (g_str_has_prefix(parts[n - 1], prefix)) {
+            gchar *artifact = parts[n - 3];
+
+            parts[n - 3] = NULL;
+            *group_id = g_strjoinv(".", parts);
+            parts[n - 3] = artifact;
+
+            *artifact_id = g_strdup(parts[n - 3]);
+            *version = g_strdup(parts[n - 2]);
+            found = TRUE;
+        }
+
+        g_free(prefix);
+    }
+
+    g_strfreev(parts);
+
+    if (!found) found = pom_coordinates(path, group_id, artifact_id, version);
+
+    return found;
+}
+
+/*
+ * Add a JAR to the version of its artifact
+ */
+static void add_jar(GHashTable *artifacts, const gchar *root,
+        const gchar *path)
+{
+    gchar *group_id = NULL, *artifact_id = NULL, *version = NULL;
+    ArtifactVersion *found = NULL;
+
+    if (!repository_coordinates(root, path, &group_id, &artifact_id,
+                &version)) {
+        fprintf(stderr, "Can't tell the artifact of '%s'\n", path);
+        return;
+    }
+
+    gchar *key = g_strconcat(group_id, ":", artifact_id, NULL);
+    Artifact *artifact = g_hash_table_lookup(artifacts, key);
+
+    if (artifact == NULL) {
+        artifact = g_new0(Artifact, 1);
+        artifact->group_id = group_id;
+        artifact->artifact_id = artifact_id;
+        artifact->versions = g_ptr_array_new_with_free_func(free_version);
+        g_hash_table_insert(artifacts, key, artifact);
+    } else {
+        g_free(group_id);
+        g_free(artifact_id);
+        g_free(key);
+    }
+
+    for (guint i = 0; i < artifact->versions->len && found == NULL; i++) {
+        ArtifactVersion *cur = g_ptr_array_index(artifact->versions, i);
+        if (g_strcmp0(cur->version, version) == 0) found = cur;
+    }
+
+    if (found == NULL) {
+        found = g_new0(ArtifactVersion, 1);
+        found->version = version;
+        found->jars = g_ptr_array_new_with_free_func(g_free);
+        g_ptr_array_add(artifact->versions, found);
+    } else {
+        g_free(version);
+    }
+
+    g_ptr_array_add(found->jars, g_strdup(path));
+}
+
+static void collect_dir(GHashTable *artifacts, const gchar *root,
+        const gchar *dirname)
+{
+    GDir *dir = NULL;
+    const gchar *name = NULL;
+    GError *error = NULL;
+
+    dir = g_dir_open(dirname, 0, &error);
+
+    if (error != NULL) {
+        fprintf(stderr, "ERROR: %s\n", error->message);
+        g_error_free(error);
+        return;
+    }
+
+    while ((name = g_dir_read_name(dir)) != NULL) {
+        gchar *filename = g_build_filename(dirname, name, NULL);
+        gboolean skipped = FALSE;
+
+        for (int i = 0; SKIPPED_CLASSIFIERS[i] != NULL; i++) {
+            if (g_str_has_suffix(name, SKIPPED_CLASSIFIERS[i])) skipped = TRUE;
+        }
+
+        if (g_file_test(filename, G_FILE_TEST_IS_DIR)) {
+            if (!g_str_has_prefix(name, ".")) {
+                collect_dir(artifacts, root, filename);
+            }
+        } else if (g_str_has_suffix(name, ".jar") && !skipped) {
+            add_jar(artifacts, root, filename);
+        }
+
+        g_free(filename);
+    }
+
+    g_dir_close(dir);
+}
+
+/*
+ * Collect the JARs of a Maven repository (e.g. ~/.m2/repository) or a
+ * Gradle cache (e.g. ~/.gradle/caches/modules-2/files-2.1) into artifacts,
+ * which maps "groupId:artifactId" to an Artifact
+ *
+ * Sources and javadoc JARs are skipped. Several repositories can be
+ * collected into the same table.
+ */
+void repository_collect(const gchar *root, GHashTable *artifacts)
+{
+    collect_dir(artifacts, root, root);
+}
+
+static gint compare_artifacts(gconstpointer a, gconstpointer b)
+{
+    const Artifact *artifact_a = *(Artifact * const *) a;
+    const Artifact *artifact_b = *(Artifact * const *) b;
+    gint result = g_strcmp0(artifact_a->group_id, artifact_b->group_id);
+
+    if (result != 0) return result;
+
+    return g_strcmp0(artifact_a->artifact_id, artifact_b->artifact_id);
+}
+
+/*
+ * Return the artifacts collected by repository_collect() sorted by groupId
+ * and artifactId so that they are indexed in a stable order
+ */
+GPtrArray *repository_sorted(GHashTable *artifacts)
+{
+    GPtrArray *sorted = g_ptr_array_sized_new(g_hash_table_size(artifacts));
+    GHashTableIter iter;
+    gpointer value = NULL;
+
+    g_hash_table_iter_init(&iter, artifacts);
+    while (g_hash_table_iter_next(&iter, NULL, &value)) {
+        g_ptr_array_add(sorted, value);
+    }
+
+    g_ptr_array_sort(sorted, compare_artifacts);
+
+    return sorted;
+}
+
+/*
+ * Return the next item of a version string starting at p or NULL at its
+ * end; items are separated by dots and dashes and at the changes between
+ * digits and letters like in Maven
+ */
+static const gchar *next_item(const gchar *p, const gchar **start,
+        gsize *length, gboolean *numeric)
+{
+    while (*p == '.' || *p == '-' || *p == '_') p++;
+    if (*p == '\0') return NULL;
+
+    *start = p;
+    *numeric = g_ascii_isdigit(*p);
+
+    while (*p != '\0' && *p != '.' && *p != '-' && *p != '_'
+            && (g_ascii_isdigit(*p) != 0) == *numeric) {
+        p++;
+    }
+
+    *length = p - *start;
+
+    return p;
+}
+
+static int qualifier_rank(const gchar *start, gsize length)
+{
+    int i = 0;
+
+    for (i = 0; QUALIFIERS[i].name != NULL; i++) {
+        if (strlen(QUALIFIERS[i].name) == length
+                && g_ascii_strncasecmp(QUALIFIERS[i].name, start, length) == 0) {
+            break;
+        }
+    }
+
+    return QUALIFIERS[i].rank;
+}
+
+/*
+ * Compare two items of versions; a missing item (start is NULL) is 0 or
+ * a release, so 1.0 equals 1 and 1.0-rc1 comes before 1.0
+ */
+static gint compare_items(const gchar *a, gsize a_length, gboolean a_numeric,
+        const gchar *b, gsize b_length, gboolean b_numeric)
+{
+    if (a == NULL) {
+        a = b_numeric ? "0" : "";
+        a_length = b_numeric ? 1 : 0;
+        a_numeric = b_numeric;
+    }
+
+    if (b == NULL) {
+        b = a_numeric ? "0" : "";
+        b_length = a_numeric ? 1 : 0;
+        b_numeric = a_numeric;
+    }
+
+    // numbers are newer than qualifiers, e.g. 1.0.1 > 1.0-beta, but zeros
+    // are dropped like trailing ones, so 1.0.0 < 1.0-sp1
+    if (a_numeric != b_numeric) {
+        const gchar *number = a_numeric ? a : b;
+        gsize number_length = a_numeric ? a_length : b_length;
+        gboolean zero = TRUE;
+
+        for (gsize i = 0; i < number_length; i++) {
+            if (number[i] != '0') zero = FALSE;
+        }
+
+        if (!zero) return a_numeric ? 1 : -1;
+
+        if (a_numeric) return compare_items("", 0, FALSE, b, b_length, FALSE);
+
+        return compare_items(a, a_length, FALSE, "", 0, FALSE);
+    }
+
+    if (a_numeric) {
+        while (a_length > 1 && *a == '0') a++, a_length--;
+        while (b_length > 1 && *b == '0') b++, b_length--;
+
+        if (a_length != b_length) return a_length < b_length ? -1 : 1;
+
+        return memcmp(a, b, a_length);
+    }
+
+    int a_rank = qualifier_rank(a, a_length);
+    int b_rank = qualifier_rank(b, b_length);
+
+    if (a_rank != b_rank) return a_rank < b_rank ? -1 : 1;
+
+    // known qualifiers are aliases of each other, e.g. a1 = alpha1
+    if (QUALIFIERS[G_N_ELEMENTS(QUALIFIERS) - 1].rank != a_rank) return 0;
+
+    int result = g_ascii_strncasecmp(a, b, MIN(a_length, b_length));
+    if (result != 0) return result;
+    if (a_length != b_length) return a_length < b_length ? -1 : 1;
+
+    return 0;
+}
+
+/*
+ * Compare two versions roughly like Maven's ComparableVersion
+ */
+gint repository_version_compare(const gchar *a, const gchar *b)
+{
+    const gchar *p = a, *q = b;
+
+    while (p != NULL || q != NULL) {
+        const gchar *a_start = NULL, *b_start = NULL;
+        gsize a_length = 0, b_length = 0;
+        gboolean a_numeric = FALSE, b_numeric = FALSE;
+
+        if (p != NULL) p = next_item(p, &a_start, &a_length, &a_numeric);
+        if (q != NULL) q = next_item(q, &b_start, &b_length, &b_numeric);
+        if (p == NULL && q == NULL) break;
+
+        gint result = compare_items(p != NULL ? a_start : NULL, a_length,
+                a_numeric, q != NULL ? b_start : NULL, b_length, b_numeric);
+        if (result != 0) return result;
+    }
+
+    return 0;
+}
+
+static gint compare_versions(gconstpointer a, gconstpointer b)
+{
+    const ArtifactVersion *version_a = *(ArtifactVersion * const *) a;
+    const ArtifactVersion *version_b = *(ArtifactVersion * const *) b;
+
+    return repository_version_compare(version_a->version, version_b->version);
+}
+
+/*
+ * Add the classes of a JAR to the runs of the version with the given index;
+ * only the central directory is read, nothing is inflated
+ */
+static void scan_jar(Artifact *artifact, GHashTable *open_runs,
+        const gchar *path, guint index)
+{
+    struct zip *jar = NULL;
+    int errorp = 0;
+
+    jar = zip_open(path, 0, &errorp);
+    if (jar == NULL) {
+        fprintf(stderr, "Failed to open '%s'\n", path);
+        return;
+    }
+
+    int numfiles = zip_get_num_files(jar);
+
+    for (int i = 0; i < numfiles; i++) {
+        const gchar *entry = zip_get_name(jar, i, 0);
+
+        if (entry == NULL) continue;
+        if (!g_str_has_suffix(entry, ".class")) continue;
+        if (g_str_has_prefix(entry, "META-INF/")) continue;
+        if (g_str_has_suffix(entry, "module-info.class")) continue;
+
+        entry = nestedjar_class_path(entry);
+
+        gchar *name = g_strndup(entry, strlen(entry) - strlen(".class"));
+        g_strdelimit(name, "/", '.');
+
+        ClassRun *run = g_hash_table_lookup(open_runs, name);
+
+        if (run != NULL && run->last + 1 >= index) {
+            // the class was in the previous version or in another JAR of
+            // this one
+            run->last = index;
+            g_free(name);
+            continue;
+        }
+
+        run = g_new0(ClassRun, 1);
+        run->name = name;
+        run->first = run->last = index;
+        g_ptr_array_add(artifact->runs, run);
+        g_hash_table_replace(open_runs, run->name, run);
+    }
+
+    zip_close(jar);
+}
+
+/*
+ * Sort the versions of an artifact and list the classes of all of them as
+ * runs of consecutive versions
+ *
+ * A class which is in every version is a single run however many versions
+ * there are, so the runs stay about as many as the distinct classes. Only
+ * the artifact is touched, so different artifacts can be scanned by
+ * different threads.
+ */
+void repository_scan_artifact(Artifact *artifact)
+{
+    GHashTable *open_runs = g_hash_table_new(g_str_hash, g_str_equal);
+
+    g_ptr_array_sort(artifact->versions, compare_versions);
+    artifact->runs = g_ptr_array_new_with_free_func(free_run);
+
+    for (guint i = 0; i < artifact->versions->len; i++) {
+        ArtifactVersion *version = g_ptr_array_index(artifact->versions, i);
+
+        for (guint j = 0; j < version->jars->len; j++) {
+            scan_jar(artifact, open_runs, g_ptr_array_index(version->jars, j),
+                    i);
+        }
+    }
+
+    g_hash_table_destroy(open_runs);
+}
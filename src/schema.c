@@ -0,0 +1,78 @@
+/*
+The MIT License (MIT) 
+Copyright (c) 2009,2010,2016 Andreas Heck <aheck@gmx.de>
+
+Permission to use, copy, modify, and/or distribute this software for any
+purpose with or without fee is hereby granted, provided that the above
+copyright notice and this permission notice appear in all copies.
+
+THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+*/
+
+#include <glib.h>
+
+#include <global.h>
+#include <schema.h>
+
+// a column which tells if a flag is set in access_flags; the ACC_*
+// constants are hex literals which SQLite understands
+#define HAS_FLAG(flag) "(access_flags & " G_STRINGIFY(flag) ") != 0"
+
+// the modifiers are stored as the access_flags bitmask of the class file
+// format and descriptors and signatures are interned into their own
+// tables; these views expose them as the columns of older versions of
+// the schema
+const gchar *SCHEMA_VIEWS = ""
+    "CREATE VIEW importables_namespaces AS SELECT"
+    "    importable_id, namespace_id, parent_importable_id,"
+    "    parent_namespace_id, done, access_flags,"
+    "    " HAS_FLAG(ACC_PUBLIC) " AS ispublic,"
+    "    " HAS_FLAG(ACC_FINAL) " AS isfinal,"
+    "    " HAS_FLAG(ACC_INTERFACE) " AS isinterface,"
+    "    " HAS_FLAG(ACC_ABSTRACT) " AS isabstract,"
+    "    " HAS_FLAG(ACC_ANNOTATION) " AS isannotation,"
+    "    " HAS_FLAG(ACC_ENUM) " AS isenum,"
+    "    signature"
+    "    FROM importables_namespaces_data;"
+    "CREATE VIEW fields AS SELECT"
+    "    f.id AS id, f.name AS name, d.name AS descriptor,"
+    "    s.name AS signature, importable_id, namespace_id, access_flags,"
+    "    " HAS_FLAG(ACC_PUBLIC) " AS ispublic,"
+    "    " HAS_FLAG(ACC_PROTECTED) " AS isprotected,"
+    "    " HAS_FLAG(ACC_PRIVATE) " AS isprivate,"
+    "    " HAS_FLAG(ACC_STATIC) " AS isstatic,"
+    "    " HAS_FLAG(ACC_FINAL) " AS isfinal,"
+    "    " HAS_FLAG(ACC_ENUM) " AS isenum"
+    "    FROM fields_data f"
+    "    JOIN descriptors d ON d.id = f.descriptor_id"
+    "    LEFT JOIN signatures s ON s.id = f.signature_id;"
+    "CREATE VIEW methods AS SELECT"
+    "    m.id AS id, m.name AS name, d.name AS descriptor,"
+    "    s.name AS signature, importable_id, namespace_id, access_flags,"
+    "    " HAS_FLAG(ACC_PUBLIC) " AS ispublic,"
+    "    " HAS_FLAG(ACC_PROTECTED) " AS isprotected,"
+    "    " HAS_FLAG(ACC_PRIVATE) " AS isprivate,"
+    "    " HAS_FLAG(ACC_STATIC) " AS isstatic,"
+    "    " HAS_FLAG(ACC_FINAL) " AS isfinal,"
+    "    " HAS_FLAG(ACC_SYNCHRONIZED) " AS issynchronized,"
+    "    " HAS_FLAG(ACC_ABSTRACT) " AS isabstract,"
+    "    code_length, max_stack, max_locals, exception_handlers, invocations"
+    "    FROM methods_data m"
+    "    JOIN descriptors d ON d.id = m.descriptor_id"
+    "    LEFT JOIN signatures s ON s.id = m.signature_id;"
+    // all containers of a class in class path order; the one which the JVM
+    // would load is the winner
+    "CREATE VIEW class_providers AS SELECT"
+    "    importable_id, namespace_id, container_id, 1 AS winner"
+    "    FROM importables_namespaces_data"
+    "    WHERE done AND container_id IS NOT NULL"
+    "    UNION ALL SELECT"
+    "    importable_id, namespace_id, container_id, 0 AS winner"
+    "    FROM shadowed_classes;"
+    "";
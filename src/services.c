@@ -0,0 +1,192 @@
+/*
+The MIT License (MIT) 
+Copyright (c) 2009,2010,2016 Andreas Heck <aheck@gmx.de>
+
+Permission to use, copy, modify, and/or distribute this software for any
+purpose with or without fee is hereby granted, provided that the above
+copyright notice and this permission notice appear in all copies.
+
+THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+*/
+
+#include <string.h>
+#include <glib.h>
+
+#include <services.h>
+
+#define META_INF         "META-INF/"
+#define SERVICES_DIR     "META-INF/services/"
+#define SPRING_FACTORIES "META-INF/spring.factories"
+#define SPRING_DIR       "META-INF/spring/"
+#define IMPORTS_SUFFIX   ".imports"
+
+/*
+ * Return the part of a path starting with its last META-INF directory or
+ * NULL if there is none
+ *
+ * Entries of JARs are relative paths while the files of directories have
+ * the path of the directory in front.
+ */
+static const gchar *meta_inf(const gchar *path)
+{
+    const gchar *found = NULL;
+
+    for (const gchar *cur = path; (cur = strstr(cur, META_INF)) != NULL;
+            cur++) {
+        if (cur == path || cur[-1] == '/') found = cur;
+    }
+
+    return found;
+}
+
+/*
+ * Check if a line of a resource file is a plausible class name
+ */
+static gboolean is_class_name(const gchar *name)
+{
+    if (*name == '\0') return FALSE;
+
+    return strpbrk(name, " \t/;[=") == NULL;
+}
+
+/*
+ * Return the kind of resource file at path or SERVICES_NONE if it doesn't
+ * register services
+ */
+ServicesKind services_kind(const gchar *path)
+{
+    const gchar *start = meta_inf(path);
+    const gchar *name = NULL;
+
+    if (start == NULL) return SERVICES_NONE;
+
+    if (g_str_has_prefix(start, SERVICES_DIR)) {
+        name = start + strlen(SERVICES_DIR);
+        if (*name != '\0' && strchr(name, '/') == NULL) return SERVICES_LOADER;
+    } else if (strcmp(start, SPRING_FACTORIES) == 0) {
+        return SERVICES_SPRING_FACTORIES;
+    } else if (g_str_has_prefix(start, SPRING_DIR)) {
+        name = start + strlen(SPRING_DIR);
+        if (strchr(name, '/') == NULL && g_str_has_suffix(name, IMPORTS_SUFFIX)
+                && strlen(name) > strlen(IMPORTS_SUFFIX)) {
+            return SERVICES_SPRING_IMPORTS;
+        }
+    }
+
+    return SERVICES_NONE;
+}
+
+/*
+ * Report the class names of a file with one name per line and comments
+ * starting with '#' (the format of ServiceLoader and of Spring's .imports)
+ */
+static void parse_class_list(ServicesKind kind, const gchar *service,
+        gchar **lines, ServicesHandler handler, gpointer user_data)
+{
+    for (int i = 0; lines[i] != NULL; i++) {
+        gchar *comment = strchr(lines[i], '#');
+
+        if (comment != NULL) *comment = '\0';
+        g_strstrip(lines[i]);
+
+        if (is_class_name(lines[i])) {
+            handler(kind, service, lines[i], user_data);
+        }
+    }
+}
+
+/*
+ * Report the entries of a spring.factories file, a properties file which
+ * maps each service to a comma-separated list of implementations
+ */
+static void parse_factories(gchar **lines, ServicesHandler handler,
+        gpointer user_data)
+{
+    GString *line = g_string_new(NULL);
+
+    for (int i = 0; lines[i] != NULL; i++) {
+        gchar *cur = g_strchug(lines[i]);
+
+        g_strchomp(cur);
+
+        // comments end with their line even if it ends with a backslash
+        if (line->len == 0 && (cur[0] == '#' || cur[0] == '!')) continue;
+
+        // a backslash at the end of a line continues it on the next one
+        if (g_str_has_suffix(cur, "\\") && lines[i + 1] != NULL) {
+            g_string_append_len(line, cur, strlen(cur) - 1);
+            continue;
+        }
+
+        g_string_append(line, cur);
+
+        gchar *separator = strpbrk(line->str, "=:");
+
+        if (separator != NULL) {
+            *separator = '\0';
+
+            gchar *service = g_strstrip(line->str);
+            gchar **providers = g_strsplit(separator + 1, ",", 0);
+
+            for (int j = 0; providers[j] != NULL; j++) {
+                g_strstrip(providers[j]);
+
+                if (is_class_name(service) && is_class_name(providers[j])) {
+                    handler(SERVICES_SPRING_FACTORIES, service, providers[j],
+                            user_data);
+                }
+            }
+
+            g_strfreev(providers);
+        }
+
+        g_string_truncate(line, 0);
+    }
+
+    g_string_free(line, TRUE);
+}
+
+/*
+ * Parse a resource file registering services and call handler for each
+ * provider of a service in it
+ */
+void services_parse(const gchar *path, const gchar *data, gsize size,
+        ServicesHandler handler, gpointer user_data)
+{
+    ServicesKind kind = services_kind(path);
+    const gchar *name = strrchr(path, '/');
+    gchar *contents = NULL;
+    gchar **lines = NULL;
+    gchar *service = NULL;
+
+    if (kind == SERVICES_NONE) return;
+
+    name = name != NULL ? name + 1 : path;
+    contents = g_strndup(data, size);
+    lines = g_strsplit(contents, "\n", 0);
+
+    switch (kind) {
+        case SERVICES_LOADER:
+            parse_class_list(kind, name, lines, handler, user_data);
+            break;
+        case SERVICES_SPRING_IMPORTS:
+            service = g_strndup(name, strlen(name) - strlen(IMPORTS_SUFFIX));
+            parse_class_list(kind, service, lines, handler, user_data);
+            g_free(service);
+            break;
+        case SERVICES_SPRING_FACTORIES:
+            parse_factories(lines, handler, user_data);
+            break;
+        case SERVICES_NONE:
+            break;
+    }
+
+    g_strfreev(lines);
+    g_free(contents);
+}
@@ -0,0 +1,385 @@
+/*
+The MIT License (MIT) 
+Copyright (c) 2009,2010,2016 Andreas Heck <aheck@gmx.de>
+
+Permission to use, copy, modify, and/or distribute this software for any
+purpose with or without fee is hereby granted, provided that the above
+copyright notice and this permission notice appear in all copies.
+
+THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+*/
+
+#include <stdio.h>
+#include <glib.h>
+
+#include <global.h>
+#include <sink.h>
+#include <jsonutil.h>
+
+/*
+ * The null sink only lets the classes be read and parsed, so that the
+ * throughput of reading can be measured without any storage
+ */
+static void null_begin_container(const gchar *path, gpointer user_data)
+{
+}
+
+static void null_file(const gchar *dirname, const gchar *name,
+        gpointer user_data)
+{
+}
+
+static void null_module(SinkModule *module, gpointer user_data)
+{
+}
+
+static void null_service(ServicesKind kind, const gchar *service,
+        const gchar *provider, gpointer user_data)
+{
+}
+
+static gboolean null_begin_class(SinkClass *c, gpointer user_data)
+{
+    return TRUE;
+}
+
+static void null_member(SinkMember *member, gpointer user_data)
+{
+}
+
+static void null_name(const gchar *name, gpointer user_data)
+{
+}
+
+static void null_annotation(SinkAnnotation *annotation, gpointer user_data)
+{
+}
+
+static void null_annotation_value(const gchar *name, const gchar *value,
+        gpointer user_data)
+{
+}
+
+static void null_end(gpointer user_data)
+{
+}
+
+IndexSink null_sink = {
+    null_begin_container,
+    null_file,
+    null_module,
+    null_service,
+    null_begin_class,
+    null_member,
+    null_member,
+    null_name,
+    null_name,
+    null_annotation,
+    null_annotation_value,
+    null_end,
+    null_end
+};
+
+/*
+ * State of the NDJSON sink: the parts of the object of the current class
+ * are collected separately since its methods come before its interfaces
+ *
+ * Modules and providers of services get objects of their own, which are
+ * told apart from the classes by their "module" and "service" keys. The
+ * containers and the files of the project aren't written.
+ */
+typedef struct {
+    FILE *fp;
+    GString *line;
+    GString *fields;
+    GString *methods;
+    GString *interfaces;
+    GString *annotations;
+    gboolean in_method;         // the exceptions of a method are open
+} NdjsonSink;
+
+static const gchar *NDJSON_TARGETS[] = {"class", "field", "method"};
+static const gchar *NDJSON_SERVICES[] = {
+    "loader",
+    "spring.factories",
+    "spring.imports"
+};
+
+/*
+ * Create the state of an NDJSON sink writing one object per class to fp
+ */
+gpointer sink_ndjson_new(FILE *fp)
+{
+    NdjsonSink *sink = g_new0(NdjsonSink, 1);
+
+    sink->fp          = fp;
+    sink->line        = g_string_new(NULL);
+    sink->fields      = g_string_new(NULL);
+    sink->methods     = g_string_new(NULL);
+    sink->interfaces  = g_string_new(NULL);
+    sink->annotations = g_string_new(NULL);
+
+    return sink;
+}
+
+void sink_ndjson_free(gpointer user_data)
+{
+    NdjsonSink *sink = user_data;
+
+    fflush(sink->fp);
+
+    g_string_free(sink->line, TRUE);
+    g_string_free(sink->fields, TRUE);
+    g_string_free(sink->methods, TRUE);
+    g_string_free(sink->interfaces, TRUE);
+    g_string_free(sink->annotations, TRUE);
+    g_free(sink);
+}
+
+static void append_member(GString *out, SinkMember *member)
+{
+    if (out->len > 0) g_string_append_c(out, ',');
+
+    g_string_append(out, "{\"name\":");
+    json_append_string(out, member->name);
+    g_string_append(out, ",\"descriptor\":");
+    json_append_string(out, member->descriptor);
+
+    if (member->signature != NULL) {
+        g_string_append(out, ",\"signature\":");
+        json_append_string(out, member->signature);
+    }
+
+    g_string_append_printf(out, ",\"access_flags\":%" G_GINT64_FORMAT,
+            member->access_flags);
+}
+
+static gboolean ndjson_begin_class(SinkClass *c, gpointer user_data)
+{
+    NdjsonSink *sink = user_data;
+
+    g_string_truncate(sink->fields, 0);
+    g_string_truncate(sink->methods, 0);
+    g_string_truncate(sink->interfaces, 0);
+    g_string_truncate(sink->annotations, 0);
+    sink->in_method = FALSE;
+
+    g_string_assign(sink->line, "{\"package\":");
+    json_append_string(sink->line, c->package);
+    g_string_append(sink->line, ",\"name\":");
+    json_append_string(sink->line, c->name);
+
+    if (c->parent != NULL) {
+        g_string_append(sink->line, ",\"parent\":");
+        json_append_string(sink->line, c->parent);
+    }
+
+    if (c->signature != NULL) {
+        g_string_append(sink->line, ",\"signature\":");
+        json_append_string(sink->line, c->signature);
+    }
+
+    g_string_append_printf(sink->line, ",\"access_flags\":%" G_GINT64_FORMAT,
+            c->access_flags);
+
+    return TRUE;
+}
+
+static void ndjson_field(SinkMember *field, gpointer user_data)
+{
+    NdjsonSink *sink = user_data;
+
+    append_member(sink->fields, field);
+    g_string_append_c(sink->fields, '}');
+}
+
+static void ndjson_close_method(NdjsonSink *sink)
+{
+    if (sink->in_method) g_string_append(sink->methods, "]}");
+    sink->in_method = FALSE;
+}
+
+static void ndjson_method(SinkMember *method, gpointer user_data)
+{
+    NdjsonSink *sink = user_data;
+
+    ndjson_close_method(sink);
+    append_member(sink->methods, method);
+
+    if (method->code != NULL) {
+        g_string_append_printf(sink->methods, ",\"code_length\":%u"
+                ",\"max_stack\":%u,\"max_locals\":%u,\"handlers\":%u"
+                ",\"invocations\":%u", method->code->code_length,
+                method->code->max_stack, method->code->max_locals,
+                method->code->exception_handlers, method->code->invocations);
+    }
+
+    g_string_append(sink->methods, ",\"exceptions\":[");
+    sink->in_method = TRUE;
+}
+
+static void ndjson_exception(const gchar *name, gpointer user_data)
+{
+    NdjsonSink *sink = user_data;
+    GString *out = sink->methods;
+
+    if (out->str[out->len - 1] != '[') g_string_append_c(out, ',');
+    json_append_string(out, name);
+}
+
+static void ndjson_interface(const gchar *name, gpointer user_data)
+{
+    NdjsonSink *sink = user_data;
+
+    if (sink->interfaces->len > 0) g_string_append_c(sink->interfaces, ',');
+    json_append_string(sink->interfaces, name);
+}
+
+/*
+ * Append an annotation; its values follow as an array of name and value
+ * pairs since the elements of an array are reported one by one
+ */
+static void ndjson_annotation(SinkAnnotation *annotation, gpointer user_data)
+{
+    NdjsonSink *sink = user_data;
+    GString *out = sink->annotations;
+
+    if (out->len > 0) g_string_append(out, "]},");
+
+    g_string_append(out, "{\"type\":");
+    json_append_string(out, annotation->type);
+    g_string_append_printf(out, ",\"target\":\"%s\"",
+            NDJSON_TARGETS[annotation->target]);
+
+    if (annotation->member_name != NULL) {
+        g_string_append(out, ",\"member\":");
+        json_append_string(out, annotation->member_name);
+        g_string_append(out, ",\"descriptor\":");
+        json_append_string(out, annotation->descriptor);
+    }
+
+    g_string_append_printf(out, ",\"visible\":%s,\"values\":[",
+            annotation->visible ? "true" : "false");
+}
+
+static void ndjson_annotation_value(const gchar *name, const gchar *value,
+        gpointer user_data)
+{
+    NdjsonSink *sink = user_data;
+    GString *out = sink->annotations;
+
+    if (out->str[out->len - 1] != '[') g_string_append_c(out, ',');
+    g_string_append(out, "{\"name\":");
+    json_append_string(out, name);
+    g_string_append(out, ",\"value\":");
+    json_append_string(out, value);
+    g_string_append_c(out, '}');
+}
+
+static void ndjson_end_class(gpointer user_data)
+{
+    NdjsonSink *sink = user_data;
+
+    ndjson_close_method(sink);
+    if (sink->annotations->len > 0) g_string_append(sink->annotations, "]}");
+
+    g_string_append_printf(sink->line, ",\"fields\":[%s],\"methods\":[%s]"
+            ",\"interfaces\":[%s],\"annotations\":[%s]}\n",
+            sink->fields->str, sink->methods->str, sink->interfaces->str,
+            sink->annotations->str);
+
+    fwrite(sink->line->str, 1, sink->line->len, sink->fp);
+}
+
+static void ndjson_module(SinkModule *module, gpointer user_data)
+{
+    NdjsonSink *sink = user_data;
+    GString *out = sink->line;
+
+    g_string_assign(out, "{\"module\":");
+    json_append_string(out, module->name);
+
+    if (module->version != NULL) {
+        g_string_append(out, ",\"version\":");
+        json_append_string(out, module->version);
+    }
+
+    g_string_append_printf(out, ",\"access_flags\":%" G_GINT64_FORMAT
+            ",\"requires\":[", module->access_flags);
+
+    for (guint i = 0; i < module->requires->len; i++) {
+        SinkRequire *require = &g_array_index(module->requires, SinkRequire,
+                i);
+
+        if (i > 0) g_string_append_c(out, ',');
+        g_string_append(out, "{\"name\":");
+        json_append_string(out, require->name);
+
+        if (require->version != NULL) {
+            g_string_append(out, ",\"version\":");
+            json_append_string(out, require->version);
+        }
+
+        g_string_append_printf(out, ",\"flags\":%" G_GINT64_FORMAT "}",
+                require->flags);
+    }
+
+    g_string_append(out, "],\"exports\":[");
+
+    for (guint i = 0; i < module->exports->len; i++) {
+        SinkExport *export = &g_array_index(module->exports, SinkExport, i);
+
+        if (i > 0) g_string_append_c(out, ',');
+        g_string_append(out, "{\"package\":");
+        json_append_string(out, export->package);
+
+        if (export->target != NULL) {
+            g_string_append(out, ",\"to\":");
+            json_append_string(out, export->target);
+        }
+
+        g_string_append_printf(out, ",\"flags\":%" G_GINT64_FORMAT "}",
+                export->flags);
+    }
+
+    g_string_append(out, "]}\n");
+    fwrite(out->str, 1, out->len, sink->fp);
+}
+
+static void ndjson_service(ServicesKind kind, const gchar *service,
+        const gchar *provider, gpointer user_data)
+{
+    NdjsonSink *sink = user_data;
+    GString *out = sink->line;
+
+    g_string_assign(out, "{\"service\":");
+    json_append_string(out, service);
+    g_string_append(out, ",\"provider\":");
+    json_append_string(out, provider);
+    g_string_append_printf(out, ",\"kind\":\"%s\"}\n",
+            NDJSON_SERVICES[kind]);
+
+    fwrite(out->str, 1, out->len, sink->fp);
+}
+
+IndexSink ndjson_sink = {
+    null_begin_container,
+    null_file,
+    ndjson_module,
+    ndjson_service,
+    ndjson_begin_class,
+    ndjson_field,
+    ndjson_method,
+    ndjson_exception,
+    ndjson_interface,
+    ndjson_annotation,
+    ndjson_annotation_value,
+    ndjson_end_class,
+    null_end
+};
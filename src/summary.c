@@ -0,0 +1,202 @@
+/*
+The MIT License (MIT) 
+Copyright (c) 2009,2010,2016 Andreas Heck <aheck@gmx.de>
+
+Permission to use, copy, modify, and/or distribute this software for any
+purpose with or without fee is hereby granted, provided that the above
+copyright notice and this permission notice appear in all copies.
+
+THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+*/
+
+#include <string.h>
+#include <glib.h>
+#include <zlib.h>
+
+#include <accessflags.h>
+#include <classscan.h>
+#include <summary.h>
+
+/*
+ * Build the uncompressed summary record of a class; scan is used for the
+ * raw access flags and may be NULL
+ */
+GByteArray *summary_new(JavaClass *c, ClassScan *scan)
+{
+    GByteArray *buffer = g_byte_array_sized_new(256);
+    gsize member = 0;
+
+    summary_put_uint(buffer, SUMMARY_VERSION);
+    summary_put_uint(buffer, class_access_flags(c, scan));
+    summary_put_string(buffer, javaclass_get_fq_name(c));
+    summary_put_string(buffer, javaclass_get_fq_parent(c));
+    summary_put_string(buffer, javaclass_get_signature(c));
+
+    summary_put_uint(buffer, MAX(javaclass_get_interface_number(c), 0));
+    if (javaclass_get_interface_number(c) > 0) {
+        gchar **interfaces = javaclass_get_interfaces(c);
+
+        for (int i = 0; interfaces[i]; i++) {
+            summary_put_string(buffer, interfaces[i]);
+        }
+    }
+
+    summary_put_uint(buffer, MAX(javaclass_get_field_number(c), 0));
+    if (javaclass_get_field_number(c) > 0) {
+        JavaField **fields = javaclass_get_fields(c);
+
+        member = scan != NULL ? scan->fields_start : 0;
+        for (int i = 0; fields[i]; i++) {
+            summary_put_uint(buffer,
+                    field_access_flags(fields[i], scan, member));
+            if (member != 0) member = classscan_next_member(scan, member);
+            summary_put_string(buffer, javafield_get_name(fields[i]));
+            summary_put_string(buffer, javafield_get_descriptor(fields[i]));
+            summary_put_string(buffer, javafield_get_signature(fields[i]));
+        }
+    }
+
+    summary_put_uint(buffer, MAX(javaclass_get_method_number(c), 0));
+    if (javaclass_get_method_number(c) > 0) {
+        JavaMethod **methods = javaclass_get_methods(c);
+
+        member = scan != NULL ? scan->methods_start : 0;
+        for (int i = 0; methods[i]; i++) {
+            gchar **exceptions = javamethod_get_exceptions(methods[i]);
+            guint exception_count = 0;
+
+            summary_put_uint(buffer,
+                    method_access_flags(methods[i], scan, member));
+            if (member != 0) member = classscan_next_member(scan, member);
+            summary_put_string(buffer, javamethod_get_name(methods[i]));
+            summary_put_string(buffer, javamethod_get_descriptor(methods[i]));
+            summary_put_string(buffer, javamethod_get_signature(methods[i]));
+
+            if (exceptions != NULL) exception_count = g_strv_length(exceptions);
+            summary_put_uint(buffer, exception_count);
+
+            for (guint j = 0; j < exception_count; j++) {
+                summary_put_string(buffer, exceptions[j]);
+            }
+        }
+    }
+
+    return buffer;
+}
+
+void summary_put_uint(GByteArray *buffer, guint64 value)
+{
+    guint8 byte = 0;
+
+    do {
+        byte = value & 0x7f;
+        value >>= 7;
+        if (value != 0) byte |= 0x80;
+        g_byte_array_append(buffer, &byte, 1);
+    } while (value != 0);
+}
+
+void summary_put_string(GByteArray *buffer, const gchar *str)
+{
+    if (str == NULL) {
+        summary_put_uint(buffer, 0);
+        return;
+    }
+
+    gsize len = strlen(str);
+
+    summary_put_uint(buffer, len + 1);
+    g_byte_array_append(buffer, (const guint8*) str, len);
+}
+
+void summary_reader_init(SummaryReader *reader, const guchar *data,
+        gsize size)
+{
+    reader->data  = data;
+    reader->size  = size;
+    reader->pos   = 0;
+    reader->error = FALSE;
+}
+
+guint64 summary_get_uint(SummaryReader *reader)
+{
+    guint64 value = 0;
+    int shift = 0;
+
+    while (reader->pos < reader->size && shift < 64) {
+        guchar byte = reader->data[reader->pos++];
+
+        value |= (guint64) (byte & 0x7f) << shift;
+        if ((byte & 0x80) == 0) return value;
+        shift += 7;
+    }
+
+    reader->error = TRUE;
+
+    return 0;
+}
+
+/*
+ * Read a string from the record; the result has to be freed with g_free()
+ */
+gchar *summary_get_string(SummaryReader *reader)
+{
+    guint64 len = summary_get_uint(reader);
+
+    if (len == 0 || reader->error) return NULL;
+
+    len--;
+    if (len > reader->size - reader->pos) {
+        reader->error = TRUE;
+        return NULL;
+    }
+
+    gchar *str = g_strndup((const gchar*) reader->data + reader->pos, len);
+    reader->pos += len;
+
+    return str;
+}
+
+/*
+ * Compress a record; returns NULL on failure
+ */
+guchar *summary_compress(const guchar *data, gsize size,
+        gsize *compressed_size)
+{
+    uLongf len = compressBound(size);
+    guchar *compressed = g_malloc(len);
+
+    if (compress2(compressed, &len, data, size, Z_DEFAULT_COMPRESSION) != Z_OK) {
+        g_free(compressed);
+        return NULL;
+    }
+
+    *compressed_size = len;
+
+    return compressed;
+}
+
+/*
+ * Uncompress a record of which the uncompressed size is known; returns NULL
+ * if the data is corrupt
+ */
+guchar *summary_uncompress(const guchar *data, gsize size,
+        gsize uncompressed_size)
+{
+    uLongf len = uncompressed_size;
+    guchar *uncompressed = g_malloc(MAX(uncompressed_size, 1));
+
+    if (uncompress(uncompressed, &len, data, size) != Z_OK
+            || len != uncompressed_size) {
+        g_free(uncompressed);
+        return NULL;
+    }
+
+    return uncompressed;
+}
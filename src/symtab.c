@@ -0,0 +1,292 @@
+/*
+The MIT License (MIT) 
+Copyright (c) 2009,2010,2016 Andreas Heck <aheck@gmx.de>
+
+Permission to use, copy, modify, and/or distribute this software for any
+purpose with or without fee is hereby granted, provided that the above
+copyright notice and this permission notice appear in all copies.
+
+THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+*/
+
+#include <string.h>
+#include <glib.h>
+
+#include <symtab.h>
+
+#define SYMTAB_MIN_SLOTS 64
+#define SYMTAB_MIN_ARENA 4096
+
+typedef struct {
+    guint32 hash;   // the lower 32 bits of the string hash
+    guint32 offset; // offset of the string in the arena
+    gint64 id;      // 0 marks an empty slot
+} SymTabSlot;
+
+struct _SymTab {
+    SymTabSlot *slots;
+    guint32 mask;
+    guint size;
+
+    gchar *arena;
+    gsize arena_len;
+    gsize arena_capacity;
+};
+
+/*
+ * The slot count is a power of two and the table is kept at most 80% full
+ */
+static guint32 slots_for(guint entries)
+{
+    guint32 slots = SYMTAB_MIN_SLOTS;
+
+    while (slots / 5 * 4 < entries) slots <<= 1;
+
+    return slots;
+}
+
+static inline guint32 probe_distance(SymTab *table, guint32 hash, guint32 pos)
+{
+    return (pos - (hash & table->mask)) & table->mask;
+}
+
+/*
+ * Put an entry into the slot array without touching the arena
+ */
+static void place(SymTab *table, SymTabSlot entry)
+{
+    guint32 pos  = entry.hash & table->mask;
+    guint32 dist = 0;
+
+    for (;;) {
+        SymTabSlot *slot = &table->slots[pos];
+
+        if (slot->id == 0) {
+            *slot = entry;
+            return;
+        }
+
+        // Robin Hood: the entry which is further away from its home slot
+        // keeps the slot and the other one moves on
+        guint32 slot_dist = probe_distance(table, slot->hash, pos);
+        if (slot_dist < dist) {
+            SymTabSlot tmp = *slot;
+            *slot = entry;
+            entry = tmp;
+            dist  = slot_dist;
+        }
+
+        pos = (pos + 1) & table->mask;
+        dist++;
+    }
+}
+
+static void resize(SymTab *table, guint32 slots)
+{
+    SymTabSlot *old = table->slots;
+    guint32 old_slots = table->mask + 1;
+
+    table->slots = g_new0(SymTabSlot, slots);
+    table->mask  = slots - 1;
+
+    if (old == NULL) return;
+
+    for (guint32 i = 0; i < old_slots; i++) {
+        if (old[i].id != 0) place(table, old[i]);
+    }
+
+    g_free(old);
+}
+
+SymTab *symtab_new(guint expected)
+{
+    SymTab *table = g_new0(SymTab, 1);
+
+    resize(table, slots_for(expected));
+
+    return table;
+}
+
+void symtab_free(SymTab *table)
+{
+    if (table == NULL) return;
+
+    g_free(table->slots);
+    g_free(table->arena);
+    g_free(table);
+}
+
+/*
+ * Make room for additional entries so that no rehashing is necessary while
+ * they are inserted, e.g. with the number of entries of a JAR
+ */
+void symtab_reserve(SymTab *table, guint additional)
+{
+    guint32 slots = slots_for(table->size + additional);
+
+    if (slots > table->mask + 1) resize(table, slots);
+}
+
+/*
+ * Remove all entries but keep the allocated memory
+ */
+void symtab_clear(SymTab *table)
+{
+    memset(table->slots, 0, sizeof(SymTabSlot) * (table->mask + 1));
+    table->size = 0;
+    table->arena_len = 0;
+}
+
+/*
+ * 64 bit string hash processing 8 bytes per step and finishing with the
+ * MurmurHash3 avalanche; much better distributed than g_str_hash() for the
+ * long common prefixes of Java package and class names
+ */
+guint64 symtab_hash(const gchar *str)
+{
+    const guint64 m = G_GUINT64_CONSTANT(0x9E3779B97F4A7C15);
+    gsize len = strlen(str);
+    guint64 h = len * m;
+    guint64 k = 0;
+
+    while (len >= 8) {
+        memcpy(&k, str, 8);
+        h = (h ^ k) * m;
+        h ^= h >> 29;
+        str += 8;
+        len -= 8;
+    }
+
+    k = 0;
+    memcpy(&k, str, len);
+    h = (h ^ k) * m;
+
+    h ^= h >> 33;
+    h *= G_GUINT64_CONSTANT(0xFF51AFD7ED558CCD);
+    h ^= h >> 33;
+    h *= G_GUINT64_CONSTANT(0xC4CEB9FE1A85EC53);
+    h ^= h >> 33;
+
+    return h;
+}
+
+/*
+ * Return the ID of str or 0 if it isn't in the table; hash has to be the
+ * result of symtab_hash(str)
+ */
+gint64 symtab_lookup(SymTab *table, const gchar *str, guint64 hash)
+{
+    guint32 h    = (guint32) hash;
+    guint32 pos  = h & table->mask;
+    guint32 dist = 0;
+
+    for (;;) {
+        SymTabSlot *slot = &table->slots[pos];
+
+        if (slot->id == 0) return 0;
+
+        // an entry for str would have displaced this one
+        if (probe_distance(table, slot->hash, pos) < dist) return 0;
+
+        if (slot->hash == h && strcmp(table->arena + slot->offset, str) == 0) {
+            return slot->id;
+        }
+
+        pos = (pos + 1) & table->mask;
+        dist++;
+    }
+}
+
+/*
+ * Add a string which is not yet in the table
+ */
+void symtab_insert(SymTab *table, const gchar *str, guint64 hash, gint64 id)
+{
+    gsize len = strlen(str) + 1;
+    SymTabSlot entry;
+
+    g_return_if_fail(id > 0);
+    g_return_if_fail(table->arena_len + len <= G_MAXUINT32);
+
+    if (table->arena_len + len > table->arena_capacity) {
+        gsize capacity = MAX(table->arena_capacity, SYMTAB_MIN_ARENA);
+        while (capacity < table->arena_len + len) capacity *= 2;
+
+        table->arena = g_realloc(table->arena, capacity);
+        table->arena_capacity = capacity;
+    }
+
+    memcpy(table->arena + table->arena_len, str, len);
+
+    entry.hash   = (guint32) hash;
+    entry.offset = (guint32) table->arena_len;
+    entry.id     = id;
+
+    table->arena_len += len;
+
+    symtab_reserve(table, 1);
+    place(table, entry);
+    table->size++;
+}
+
+guint symtab_size(SymTab *table)
+{
+    return table->size;
+}
+
+/*
+ * Return the number of bytes allocated by the table
+ */
+gsize symtab_memory(SymTab *table)
+{
+    return sizeof(SymTab) + sizeof(SymTabSlot) * (table->mask + 1)
+        + table->arena_capacity;
+}
+
+/*
+ * Return the ID of str from either generation of a cache or 0 if neither
+ * holds it; a string of the previous generation is moved to the current
+ */
+gint64 symcache_lookup(SymCache *cache, const gchar *str, guint64 hash)
+{
+    gint64 id = symtab_lookup(cache->current, str, hash);
+
+    if (id != 0 || cache->previous == NULL) return id;
+
+    id = symtab_lookup(cache->previous, str, hash);
+    if (id != 0) symtab_insert(cache->current, str, hash, id);
+
+    return id;
+}
+
+/*
+ * Start new generations of count caches if their current tables take more
+ * than limit bytes together and return TRUE if they were rotated
+ *
+ * Only the current tables count, so the caches take up to twice the limit
+ * with the previous generation.
+ */
+gboolean symcache_limit(SymCache **caches, guint count, gsize limit)
+{
+    gsize used = 0;
+
+    for (guint i = 0; i < count; i++) {
+        used += symtab_memory(caches[i]->current);
+    }
+
+    if (used <= limit) return FALSE;
+
+    for (guint i = 0; i < count; i++) {
+        symtab_free(caches[i]->previous);
+        caches[i]->previous = caches[i]->current;
+        caches[i]->current  = symtab_new(0);
+    }
+
+    return TRUE;
+}
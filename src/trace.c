@@ -0,0 +1,204 @@
+/*
+The MIT License (MIT) 
+Copyright (c) 2009,2010,2016 Andreas Heck <aheck@gmx.de>
+
+Permission to use, copy, modify, and/or distribute this software for any
+purpose with or without fee is hereby granted, provided that the above
+copyright notice and this permission notice appear in all copies.
+
+THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <glib.h>
+
+#include <trace.h>
+#include <jsonutil.h>
+
+/*
+ * The events recorded by one thread
+ *
+ * Each thread appends to its own buffer, so recording takes no lock; the
+ * buffers are only joined when the trace is written.
+ */
+typedef struct {
+    GString *events;
+    gint tid;
+} TraceBuffer;
+
+gboolean trace_enabled = FALSE;
+
+static gchar *trace_filename = NULL;
+static gint trace_part = -1;        // set in child processes
+static GMutex buffers_lock;
+static GPtrArray *buffers = NULL;
+static GPrivate buffer_key = G_PRIVATE_INIT(NULL);
+
+static gchar *part_filename(int part)
+{
+    return g_strdup_printf("%s.%d", trace_filename, part);
+}
+
+static TraceBuffer *thread_buffer()
+{
+    TraceBuffer *buffer = g_private_get(&buffer_key);
+
+    if (buffer == NULL) {
+        buffer = g_new0(TraceBuffer, 1);
+        buffer->events = g_string_sized_new(64 * 1024);
+
+        g_mutex_lock(&buffers_lock);
+        g_ptr_array_add(buffers, buffer);
+        buffer->tid = buffers->len;
+        g_mutex_unlock(&buffers_lock);
+
+        g_private_set(&buffer_key, buffer);
+    }
+
+    return buffer;
+}
+
+/*
+ * Start recording spans which trace_close() writes to filename in the Trace
+ * Event Format of chrome://tracing and Perfetto
+ *
+ * The file is created right away so that a path which can't be written
+ * fails before the work starts.
+ */
+void trace_open(const gchar *filename)
+{
+    FILE *fp = fopen(filename, "w");
+
+    if (fp == NULL) {
+        perror(filename);
+        exit(2);
+    }
+
+    fclose(fp);
+
+    trace_filename = g_strdup(filename);
+    buffers = g_ptr_array_new();
+    trace_enabled = TRUE;
+}
+
+/*
+ * Record a span from start until now on the calling thread; use trace_end()
+ * instead, which does nothing if tracing is disabled
+ */
+void trace_span(const gchar *category, const gchar *name, gint64 start,
+        gint64 bytes)
+{
+    gint64 end = g_get_monotonic_time();
+    TraceBuffer *buffer = thread_buffer();
+    GString *out = buffer->events;
+
+    // every event starts with the separator, so buffers can be joined
+    g_string_append(out, ",\n{\"name\":");
+    json_append_string(out, name);
+    g_string_append_printf(out, ",\"cat\":\"%s\",\"ph\":\"X\",\"ts\":%"
+            G_GINT64_FORMAT ",\"dur\":%" G_GINT64_FORMAT ",\"pid\":%d"
+            ",\"tid\":%d", category, start, end - start, (int) getpid(),
+            buffer->tid);
+
+    if (bytes >= 0) {
+        g_string_append_printf(out, ",\"args\":{\"bytes\":%" G_GINT64_FORMAT
+                "}", bytes);
+    }
+
+    g_string_append_c(out, '}');
+}
+
+/*
+ * Continue in a forked child process, which records its own events and
+ * writes them as the given part for trace_merge() in the parent
+ */
+void trace_child(int part)
+{
+    if (!trace_enabled) return;
+
+    trace_part = part;
+
+    // the parent writes what was recorded before the fork
+    for (guint i = 0; i < buffers->len; i++) {
+        TraceBuffer *buffer = g_ptr_array_index(buffers, i);
+        g_string_truncate(buffer->events, 0);
+    }
+}
+
+/*
+ * Add the events of a child process which has exited to the trace
+ */
+void trace_merge(int part)
+{
+    gchar *filename = NULL;
+    gchar *contents = NULL;
+    gsize length = 0;
+
+    if (!trace_enabled) return;
+
+    filename = part_filename(part);
+
+    if (g_file_get_contents(filename, &contents, &length, NULL)) {
+        g_string_append_len(thread_buffer()->events, contents, length);
+        unlink(filename);
+    }
+
+    g_free(contents);
+    g_free(filename);
+}
+
+/*
+ * Write the recorded events and stop tracing; all threads which recorded
+ * events must be done
+ */
+void trace_close()
+{
+    GString *all = NULL;
+    gchar *filename = NULL;
+    FILE *fp = NULL;
+
+    if (!trace_enabled) return;
+
+    trace_enabled = FALSE;
+    all = g_string_new(NULL);
+
+    for (guint i = 0; i < buffers->len; i++) {
+        TraceBuffer *buffer = g_ptr_array_index(buffers, i);
+
+        g_string_append_len(all, buffer->events->str, buffer->events->len);
+        g_string_free(buffer->events, TRUE);
+        g_free(buffer);
+    }
+
+    g_ptr_array_free(buffers, TRUE);
+    buffers = NULL;
+
+    filename = trace_part >= 0 ? part_filename(trace_part)
+        : g_strdup(trace_filename);
+    fp = fopen(filename, "w");
+
+    if (fp == NULL) {
+        perror(filename);
+    } else if (trace_part >= 0) {
+        fwrite(all->str, 1, all->len, fp);
+        fclose(fp);
+    } else {
+        // skip the separator of the first event
+        fprintf(fp, "{\"traceEvents\":[%s\n],\"displayTimeUnit\":\"ms\"}\n",
+                all->len > 0 ? all->str + 2 : "");
+        fclose(fp);
+    }
+
+    g_free(filename);
+    g_string_free(all, TRUE);
+    g_free(trace_filename);
+    trace_filename = NULL;
+}
@@ -0,0 +1,91 @@
+/*
+The MIT License (MIT) 
+Copyright (c) 2009,2010,2016 Andreas Heck <aheck@gmx.de>
+
+Permission to use, copy, modify, and/or distribute this software for any
+purpose with or without fee is hereby granted, provided that the above
+copyright notice and this permission notice appear in all copies.
+
+THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+*/
+
+#include <glib.h>
+
+#include <zipdir.h>
+
+#define ZIP_EOCD_SIGNATURE 0x06054b50
+#define ZIP_CDIR_SIGNATURE 0x02014b50
+#define ZIP_EOCD_SIZE 22
+#define ZIP_CDIR_SIZE 46
+
+/*
+ * Find the end of central directory record in the last tail_size bytes of
+ * an archive of archive_size bytes and read it
+ *
+ * Returns FALSE if there is none, if the archive is a ZIP64 archive or if
+ * its central directory doesn't lie within it.
+ */
+gboolean zipdir_read_end(const guchar *tail, gsize tail_size,
+        gsize archive_size, ZipDirEnd *end)
+{
+    const guchar *eocd = NULL;
+
+    if (tail_size < ZIP_EOCD_SIZE) return FALSE;
+
+    for (gssize i = tail_size - ZIP_EOCD_SIZE; i >= 0; i--) {
+        if (zipdir_u4(tail + i) == ZIP_EOCD_SIGNATURE) {
+            eocd = tail + i;
+            break;
+        }
+    }
+
+    if (eocd == NULL) return FALSE;
+
+    end->count  = zipdir_u2(eocd + 10);
+    end->size   = zipdir_u4(eocd + 12);
+    end->offset = zipdir_u4(eocd + 16);
+
+    // ZIP64 keeps the real values in a record of its own
+    if (end->count == 0xffff || end->offset == 0xffffffff) return FALSE;
+
+    return (gsize) end->offset + end->size <= archive_size;
+}
+
+/*
+ * Read the local header offsets of the count entries of the central
+ * directory cdir of size bytes
+ *
+ * Returns NULL if the directory holds fewer entries or one with a ZIP64
+ * offset. The caller has to g_free() the offsets.
+ */
+guint32 *zipdir_read_offsets(const guchar *cdir, gsize size, guint count)
+{
+    guint32 *offsets = NULL;
+    gsize pos = 0;
+
+    if (count == 0) return NULL;
+
+    offsets = g_new(guint32, count);
+
+    for (guint i = 0; i < count; i++) {
+        if (pos + ZIP_CDIR_SIZE > size
+                || zipdir_u4(cdir + pos) != ZIP_CDIR_SIGNATURE
+                || zipdir_u4(cdir + pos + 42) == 0xffffffff) {
+            g_free(offsets);
+            return NULL;
+        }
+
+        offsets[i] = zipdir_u4(cdir + pos + 42);
+
+        pos += ZIP_CDIR_SIZE + zipdir_u2(cdir + pos + 28)
+            + zipdir_u2(cdir + pos + 30) + zipdir_u2(cdir + pos + 32);
+    }
+
+    return offsets;
+}
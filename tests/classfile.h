@@ -0,0 +1,139 @@
+/*
+The MIT License (MIT) 
+Copyright (c) 2009,2010,2016 Andreas Heck <aheck@gmx.de>
+
+Permission to use, copy, modify, and/or distribute this software for any
+purpose with or without fee is hereby granted, provided that the above
+copyright notice and this permission notice appear in all copies.
+
+THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+*/
+
+#ifndef __CLASSFILE_H__
+#define __CLASSFILE_H__
+
+#include <string.h>
+#include <glib.h>
+
+#include <classscan.h>
+
+/*
+ * Builder for the class files the tests feed to the raw scanners
+ *
+ * The bytes are appended in the order of the class file format, so a test
+ * reads like the structure it builds. The constant pool count passed to
+ * classfile_new() has to match the entries which follow.
+ */
+static inline void classfile_u1(GByteArray *bytes, guint8 value)
+{
+    g_byte_array_append(bytes, &value, 1);
+}
+
+static inline void classfile_u2(GByteArray *bytes, guint16 value)
+{
+    classfile_u1(bytes, value >> 8);
+    classfile_u1(bytes, value & 0xff);
+}
+
+static inline void classfile_u4(GByteArray *bytes, guint32 value)
+{
+    classfile_u2(bytes, value >> 16);
+    classfile_u2(bytes, value & 0xffff);
+}
+
+/*
+ * Start a class file of version 52 (Java 8) with constant_pool_count - 1
+ * constants
+ */
+static inline GByteArray *classfile_new(guint16 constant_pool_count)
+{
+    GByteArray *bytes = g_byte_array_new();
+
+    classfile_u4(bytes, 0xCAFEBABE);
+    classfile_u2(bytes, 0);
+    classfile_u2(bytes, 52);
+    classfile_u2(bytes, constant_pool_count);
+
+    return bytes;
+}
+
+static inline void classfile_utf8(GByteArray *bytes, const gchar *str)
+{
+    classfile_u1(bytes, CONSTANT_Utf8);
+    classfile_u2(bytes, strlen(str));
+    g_byte_array_append(bytes, (const guint8*) str, strlen(str));
+}
+
+/*
+ * Append a constant which references another one, e.g. CONSTANT_Class
+ */
+static inline void classfile_ref(GByteArray *bytes, guint8 tag,
+        guint16 index)
+{
+    classfile_u1(bytes, tag);
+    classfile_u2(bytes, index);
+}
+
+/*
+ * Append a CONSTANT_Integer or CONSTANT_Float with its raw bits
+ */
+static inline void classfile_int(GByteArray *bytes, guint8 tag, guint32 bits)
+{
+    classfile_u1(bytes, tag);
+    classfile_u4(bytes, bits);
+}
+
+/*
+ * Append a CONSTANT_Long or CONSTANT_Double, which takes two indexes
+ */
+static inline void classfile_long(GByteArray *bytes, guint8 tag, guint64 bits)
+{
+    classfile_u1(bytes, tag);
+    classfile_u4(bytes, bits >> 32);
+    classfile_u4(bytes, bits & 0xffffffff);
+}
+
+/*
+ * Append the header behind the constant pool up to the fields_count
+ */
+static inline void classfile_header(GByteArray *bytes, guint16 access_flags,
+        guint16 this_class, guint16 super_class)
+{
+    classfile_u2(bytes, access_flags);
+    classfile_u2(bytes, this_class);
+    classfile_u2(bytes, super_class);
+    classfile_u2(bytes, 0);     // interfaces_count
+}
+
+/*
+ * Append the start of a field or method; its attributes_count attributes
+ * have to follow
+ */
+static inline void classfile_member(GByteArray *bytes, guint16 access_flags,
+        guint16 name_index, guint16 descriptor_index,
+        guint16 attributes_count)
+{
+    classfile_u2(bytes, access_flags);
+    classfile_u2(bytes, name_index);
+    classfile_u2(bytes, descriptor_index);
+    classfile_u2(bytes, attributes_count);
+}
+
+/*
+ * Append an attribute with its info
+ */
+static inline void classfile_attribute(GByteArray *bytes, guint16 name_index,
+        const guchar *info, guint32 length)
+{
+    classfile_u2(bytes, name_index);
+    classfile_u4(bytes, length);
+    g_byte_array_append(bytes, info, length);
+}
+
+#endif /* __CLASSFILE_H__ */
@@ -0,0 +1,207 @@
+/*
+The MIT License (MIT) 
+Copyright (c) 2009,2010,2016 Andreas Heck <aheck@gmx.de>
+
+Permission to use, copy, modify, and/or distribute this software for any
+purpose with or without fee is hereby granted, provided that the above
+copyright notice and this permission notice appear in all copies.
+
+THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+*/
+
+#include <string.h>
+#include <glib.h>
+
+#include <ahocorasick.h>
+
+typedef struct {
+    GString *events;
+    guint limit;                // occurrences to report before stopping
+} Occurrences;
+
+static gboolean record(guint id, gsize end, gpointer user_data)
+{
+    Occurrences *occurrences = user_data;
+
+    g_string_append_printf(occurrences->events, "%u:%u ", id, (guint) end);
+
+    return --occurrences->limit > 0;
+}
+
+static gchar *search(const AhoCorasick *ac, const gchar *text, gsize length,
+        guint limit)
+{
+    Occurrences occurrences = {g_string_new(NULL), limit};
+
+    ahocorasick_search(ac, (const guchar*) text, length, record,
+            &occurrences);
+
+    return g_string_free(occurrences.events, FALSE);
+}
+
+static AhoCorasick *compile(gboolean ignore_case, const gchar **patterns)
+{
+    AhoCorasick *ac = ahocorasick_new(ignore_case);
+
+    for (guint i = 0; patterns[i] != NULL; i++) {
+        ahocorasick_add(ac, patterns[i], strlen(patterns[i]), i);
+    }
+
+    ahocorasick_compile(ac);
+
+    return ac;
+}
+
+/*
+ * The example of the original paper: every pattern is reported at its
+ * end, the longer ones first
+ */
+static void test_overlapping()
+{
+    static const gchar *PATTERNS[] = {"he", "she", "his", "hers", NULL};
+    AhoCorasick *ac = compile(FALSE, PATTERNS);
+    gchar *events = search(ac, "ushers", 6, G_MAXUINT);
+
+    g_assert_cmpstr(events, ==, "1:4 0:4 3:6 ");
+    g_free(events);
+
+    events = search(ac, "ahishe", 6, G_MAXUINT);
+    g_assert_cmpstr(events, ==, "2:4 1:6 0:6 ");
+    g_free(events);
+
+    ahocorasick_free(ac);
+}
+
+static void test_suffixes()
+{
+    static const gchar *PATTERNS[] = {"a", "aa", "aaa", NULL};
+    AhoCorasick *ac = compile(FALSE, PATTERNS);
+    gchar *events = search(ac, "aaaa", 4, G_MAXUINT);
+
+    g_assert_cmpstr(events, ==, "0:1 1:2 0:2 2:3 1:3 0:3 2:4 1:4 0:4 ");
+    g_free(events);
+
+    ahocorasick_free(ac);
+}
+
+static void test_ignore_case()
+{
+    static const gchar *PATTERNS[] = {"Class", NULL};
+    static const gchar *TEXT = "a CLASS, a class";
+    AhoCorasick *ac = compile(TRUE, PATTERNS);
+    gchar *events = search(ac, TEXT, strlen(TEXT), G_MAXUINT);
+
+    g_assert_cmpstr(events, ==, "0:7 0:16 ");
+    g_free(events);
+    ahocorasick_free(ac);
+
+    ac = compile(FALSE, PATTERNS);
+    events = search(ac, TEXT, strlen(TEXT), G_MAXUINT);
+
+    g_assert_cmpstr(events, ==, "");
+    g_free(events);
+    ahocorasick_free(ac);
+}
+
+/*
+ * Without a callback the search only tells whether any pattern occurs;
+ * bytes which are in no pattern lead back to the start
+ */
+static void test_first()
+{
+    static const gchar *PATTERNS[] = {"java/lang", NULL};
+    AhoCorasick *ac = compile(FALSE, PATTERNS);
+
+    g_assert_true(ahocorasick_search(ac, (const guchar*) "\xffjava/lang", 10,
+                NULL, NULL));
+    g_assert_false(ahocorasick_search(ac, (const guchar*) "java\xff/lang", 10,
+                NULL, NULL));
+    g_assert_false(ahocorasick_search(ac, (const guchar*) "java/lan", 8,
+                NULL, NULL));
+    g_assert_false(ahocorasick_search(ac, (const guchar*) "", 0, NULL, NULL));
+
+    ahocorasick_free(ac);
+}
+
+static void test_stop()
+{
+    static const gchar *PATTERNS[] = {"a", "aa", NULL};
+    AhoCorasick *ac = compile(FALSE, PATTERNS);
+    gchar *events = search(ac, "aaaa", 4, 2);
+
+    g_assert_cmpstr(events, ==, "0:1 1:2 ");
+    g_free(events);
+
+    ahocorasick_free(ac);
+}
+
+/*
+ * Patterns are byte strings; with every byte in a pattern each of them
+ * still needs a column of its own
+ */
+static void test_binary()
+{
+    AhoCorasick *ac = ahocorasick_new(FALSE);
+    guchar text[256];
+    GString *expected = g_string_new(NULL);
+    gchar *events = NULL;
+
+    for (guint c = 0; c < 256; c++) {
+        gchar pattern = c;
+
+        ahocorasick_add(ac, &pattern, 1, c);
+        text[c] = 255 - c;
+        g_string_append_printf(expected, "%u:%u ", 255 - c, c + 1);
+    }
+
+    ahocorasick_add(ac, "\xca\xfe\0\xbe", 4, 256);
+    ahocorasick_add(ac, "\xff\xff", 2, 257);
+    ahocorasick_compile(ac);
+
+    events = search(ac, (const gchar*) text, sizeof(text), G_MAXUINT);
+    g_assert_cmpstr(events, ==, expected->str);
+    g_free(events);
+
+    events = search(ac, "\xca\xfe\0\xbe", 4, G_MAXUINT);
+    g_assert_cmpstr(events, ==, "202:1 254:2 0:3 256:4 190:4 ");
+    g_free(events);
+
+    events = search(ac, "\xff\xff\0", 3, G_MAXUINT);
+    g_assert_cmpstr(events, ==, "255:1 257:2 255:2 0:3 ");
+    g_free(events);
+
+    g_string_free(expected, TRUE);
+    ahocorasick_free(ac);
+}
+
+static void test_empty()
+{
+    AhoCorasick *ac = ahocorasick_new(TRUE);
+
+    ahocorasick_compile(ac);
+    g_assert_false(ahocorasick_search(ac, (const guchar*) "abc", 3, NULL,
+                NULL));
+
+    ahocorasick_free(ac);
+}
+
+int main(int argc, char **argv)
+{
+    g_test_init(&argc, &argv, NULL);
+
+    g_test_add_func("/ahocorasick/overlapping", test_overlapping);
+    g_test_add_func("/ahocorasick/suffixes", test_suffixes);
+    g_test_add_func("/ahocorasick/ignore-case", test_ignore_case);
+    g_test_add_func("/ahocorasick/first", test_first);
+    g_test_add_func("/ahocorasick/stop", test_stop);
+    g_test_add_func("/ahocorasick/binary", test_binary);
+    g_test_add_func("/ahocorasick/empty", test_empty);
+
+    return g_test_run();
+}
@@ -0,0 +1,254 @@
+/*
+The MIT License (MIT) 
+Copyright (c) 2009,2010,2016 Andreas Heck <aheck@gmx.de>
+
+Permission to use, copy, modify, and/or distribute this software for any
+purpose with or without fee is hereby granted, provided that the above
+copyright notice and this permission notice appear in all copies.
+
+THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+*/
+
+#include <glib.h>
+
+#include <classscan.h>
+#include <annotations.h>
+
+#include "classfile.h"
+#include "truncated.h"
+
+/*
+ * The constants the annotations below refer to in a class without members
+ */
+static GByteArray *constants_class()
+{
+    GByteArray *bytes = classfile_new(13);
+
+    classfile_utf8(bytes, "Ljavax/inject/Named;");          // #1
+    classfile_utf8(bytes, "value");                         // #2
+    classfile_utf8(bytes, "hello");                         // #3
+    classfile_int(bytes, CONSTANT_Integer, 42);             // #4
+    classfile_utf8(bytes, "Lcom/example/Color;");           // #5
+    classfile_utf8(bytes, "RED");                           // #6
+    classfile_utf8(bytes, "Ljava/lang/String;");            // #7
+    classfile_int(bytes, CONSTANT_Integer, 1);              // #8
+    classfile_int(bytes, CONSTANT_Integer, 'A');            // #9
+    classfile_long(bytes, CONSTANT_Long, 1ULL << 40);       // #10, #11
+    classfile_utf8(bytes, "I");                             // #12
+
+    classfile_header(bytes, 0x0021, 0, 0);
+    classfile_u2(bytes, 0);
+    classfile_u2(bytes, 0);
+    classfile_u2(bytes, 0);
+
+    return bytes;
+}
+
+/*
+ * Info of a RuntimeVisibleAnnotations attribute with
+ *
+ *   @Named(value = "hello", value = 42, value = Color.RED,
+ *          value = String.class, value = {"hello", @Named, true})
+ *   @Color(value = 'A', value = 1L << 40, value = @Named("hello"))
+ *
+ * Repeating the element name is invalid Java but keeps the fixture small.
+ */
+static const guchar ANNOTATIONS[] = {
+    0, 2,
+    0, 1, 0, 5,
+        0, 2, 's', 0, 3,
+        0, 2, 'I', 0, 4,
+        0, 2, 'e', 0, 5, 0, 6,
+        0, 2, 'c', 0, 7,
+        0, 2, '[', 0, 3,
+            's', 0, 3,
+            '@', 0, 1, 0, 0,
+            'Z', 0, 8,
+    0, 5, 0, 3,
+        0, 2, 'C', 0, 9,
+        0, 2, 'J', 0, 10,
+        0, 2, '@', 0, 1, 0, 1,
+            0, 2, 's', 0, 3
+};
+
+static void record_annotation(const gchar *type, gpointer user_data)
+{
+    g_string_append_printf(user_data, "@%s ", type);
+}
+
+static void record_value(const gchar *name, const gchar *value,
+        gpointer user_data)
+{
+    g_string_append_printf(user_data, "%s=%s ", name, value);
+}
+
+static AnnotationHandler handler = {
+    record_annotation,
+    record_value
+};
+
+static void test_parse()
+{
+    GByteArray *bytes = constants_class();
+    GString *events = g_string_new(NULL);
+    ClassScan scan = {0};
+
+    g_assert_true(classscan_init(&scan, bytes->data, bytes->len));
+    g_assert_true(annotations_parse(&scan, ANNOTATIONS, sizeof(ANNOTATIONS),
+                &handler, events));
+
+    // nested annotations are skipped, arrays reported element by element
+    g_assert_cmpstr(events->str, ==, "@javax.inject.Named value=hello "
+            "value=42 value=com.example.Color.RED value=java.lang.String "
+            "value=hello value=true @com.example.Color value=A "
+            "value=1099511627776 ");
+
+    g_string_free(events, TRUE);
+    classscan_clear(&scan);
+    g_byte_array_free(bytes, TRUE);
+}
+
+static void check_truncated(const guchar *prefix, gsize size,
+        gpointer user_data)
+{
+    GString *events = g_string_new(NULL);
+
+    g_assert_false(annotations_parse(user_data, prefix, size, &handler,
+                events));
+
+    g_string_free(events, TRUE);
+}
+
+static void test_truncated()
+{
+    GByteArray *bytes = constants_class();
+    ClassScan scan = {0};
+
+    g_assert_true(classscan_init(&scan, bytes->data, bytes->len));
+
+    truncated_prefixes(ANNOTATIONS, sizeof(ANNOTATIONS), check_truncated,
+            &scan);
+
+    classscan_clear(&scan);
+    g_byte_array_free(bytes, TRUE);
+}
+
+static void test_malformed()
+{
+    static const guchar UNKNOWN_TAG[] = {0, 1, 0, 1, 0, 1, 0, 2, 'x', 0, 3};
+    static const guchar TYPE_NOT_UTF8[] = {0, 1, 0, 4, 0, 0};
+    static const guchar BAD_CONSTANTS[] = {
+        0, 1, 0, 1, 0, 3,
+            0, 2, 's', 0, 4,    // a string which is an integer
+            0, 2, 'I', 0, 99,   // beyond the constant pool
+            0, 99, 's', 0, 3    // a name beyond the constant pool
+    };
+    GByteArray *bytes = constants_class();
+    GString *events = g_string_new(NULL);
+    ClassScan scan = {0};
+
+    g_assert_true(classscan_init(&scan, bytes->data, bytes->len));
+
+    g_assert_false(annotations_parse(&scan, UNKNOWN_TAG, sizeof(UNKNOWN_TAG),
+                &handler, events));
+    g_assert_false(annotations_parse(&scan, TYPE_NOT_UTF8,
+                sizeof(TYPE_NOT_UTF8), &handler, events));
+
+    // values which can't be resolved are skipped but the rest is read
+    g_string_truncate(events, 0);
+    g_assert_true(annotations_parse(&scan, BAD_CONSTANTS,
+                sizeof(BAD_CONSTANTS), &handler, events));
+    g_assert_cmpstr(events->str, ==, "@javax.inject.Named ");
+
+    g_string_free(events, TRUE);
+    classscan_clear(&scan);
+    g_byte_array_free(bytes, TRUE);
+}
+
+/*
+ * Arrays nested deeper than any real annotation are rejected before they
+ * can exhaust the stack; shallow ones are skipped without being reported
+ */
+static void test_nesting()
+{
+    GByteArray *bytes = constants_class();
+    GByteArray *info = NULL;
+    GString *events = g_string_new(NULL);
+    ClassScan scan = {0};
+    guint depths[] = {8, 100000};
+
+    g_assert_true(classscan_init(&scan, bytes->data, bytes->len));
+
+    for (guint i = 0; i < G_N_ELEMENTS(depths); i++) {
+        info = g_byte_array_new();
+
+        // @Named(value = {{{ ... { "hello" } ... }}})
+        classfile_u2(info, 1);
+        classfile_u2(info, 1);
+        classfile_u2(info, 1);
+        classfile_u2(info, 2);
+        for (guint j = 0; j < depths[i]; j++) {
+            classfile_u1(info, '[');
+            classfile_u2(info, 1);
+        }
+        classfile_u1(info, 's');
+        classfile_u2(info, 3);
+
+        g_string_truncate(events, 0);
+        if (depths[i] < 64) {
+            g_assert_true(annotations_parse(&scan, info->data, info->len,
+                        &handler, events));
+            g_assert_cmpstr(events->str, ==, "@javax.inject.Named ");
+        } else {
+            g_assert_false(annotations_parse(&scan, info->data, info->len,
+                        &handler, events));
+        }
+
+        g_byte_array_free(info, TRUE);
+    }
+
+    g_string_free(events, TRUE);
+    classscan_clear(&scan);
+    g_byte_array_free(bytes, TRUE);
+}
+
+static void test_type_name()
+{
+    gchar *name = NULL;
+
+    name = annotations_type_name("Ljava/util/Map$Entry;", 21);
+    g_assert_cmpstr(name, ==, "java.util.Map$Entry");
+    g_free(name);
+
+    name = annotations_type_name("[I", 2);
+    g_assert_cmpstr(name, ==, "[I");
+    g_free(name);
+
+    // only the given length of the descriptor is read
+    name = annotations_type_name("Lfoo;Lbar;", 5);
+    g_assert_cmpstr(name, ==, "foo");
+    g_free(name);
+
+    name = annotations_type_name("L", 1);
+    g_assert_cmpstr(name, ==, "L");
+    g_free(name);
+}
+
+int main(int argc, char **argv)
+{
+    g_test_init(&argc, &argv, NULL);
+
+    g_test_add_func("/annotations/parse", test_parse);
+    g_test_add_func("/annotations/truncated", test_truncated);
+    g_test_add_func("/annotations/malformed", test_malformed);
+    g_test_add_func("/annotations/nesting", test_nesting);
+    g_test_add_func("/annotations/type-name", test_type_name);
+
+    return g_test_run();
+}
@@ -0,0 +1,190 @@
+/*
+The MIT License (MIT) 
+Copyright (c) 2009,2010,2016 Andreas Heck <aheck@gmx.de>
+
+Permission to use, copy, modify, and/or distribute this software for any
+purpose with or without fee is hereby granted, provided that the above
+copyright notice and this permission notice appear in all copies.
+
+THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+*/
+
+#include <string.h>
+#include <glib.h>
+
+#include <global.h>
+#include <apichange.h>
+
+#define PUBLIC ACC_PUBLIC
+#define PROTECTED ACC_PROTECTED
+
+/*
+ * A change of an element of the API with the expected compatibility and
+ * reasons joined by ", "
+ */
+typedef struct {
+    ChangeType change;
+    int kind;
+    gint64 old_flags;
+    gint64 new_flags;
+    const gchar *old_type;      // descriptor of a field, parent of a class
+    const gchar *new_type;
+    Compatibility expected;
+    const gchar *reasons;
+} Case;
+
+static const Case CASES[] = {
+    // removing anything breaks its clients, adding is fine
+    {CHANGE_REMOVED, API_CLASS, PUBLIC, 0, NULL, NULL, INCOMPATIBLE, ""},
+    {CHANGE_REMOVED, API_FIELD, PUBLIC, 0, "I", NULL, INCOMPATIBLE, ""},
+    {CHANGE_REMOVED, API_METHOD, PROTECTED, 0, "()V", NULL, INCOMPATIBLE,
+        ""},
+    {CHANGE_ADDED, API_FIELD, 0, PUBLIC | ACC_STATIC, NULL, "I", COMPATIBLE,
+        ""},
+    {CHANGE_ADDED, API_METHOD, 0, PUBLIC, NULL, "()V", COMPATIBLE, ""},
+
+    // subclasses compiled against the old version don't implement it
+    {CHANGE_ADDED, API_METHOD, 0, PUBLIC | ACC_ABSTRACT, NULL, "()V",
+        MAYBE_INCOMPATIBLE, "abstract method"},
+
+    // visibility
+    {CHANGE_CHANGED, API_METHOD, PUBLIC, PROTECTED, "()V", "()V",
+        INCOMPATIBLE, "public to protected"},
+    {CHANGE_CHANGED, API_FIELD, PUBLIC, PROTECTED, "I", "I", INCOMPATIBLE,
+        "public to protected"},
+    {CHANGE_CHANGED, API_METHOD, PROTECTED, PUBLIC, "()V", "()V",
+        COMPATIBLE, "protected to public"},
+
+    // final, whose fields may have been inlined
+    {CHANGE_CHANGED, API_CLASS, PUBLIC, PUBLIC | ACC_FINAL, NULL, NULL,
+        INCOMPATIBLE, "made final"},
+    {CHANGE_CHANGED, API_METHOD, PUBLIC, PUBLIC | ACC_FINAL, "()V", "()V",
+        INCOMPATIBLE, "made final"},
+    {CHANGE_CHANGED, API_FIELD, PUBLIC | ACC_FINAL, PUBLIC, "I", "I",
+        MAYBE_INCOMPATIBLE, "no longer final"},
+    {CHANGE_CHANGED, API_METHOD, PUBLIC | ACC_FINAL, PUBLIC, "()V", "()V",
+        COMPATIBLE, "no longer final"},
+
+    // static
+    {CHANGE_CHANGED, API_METHOD, PUBLIC, PUBLIC | ACC_STATIC, "()V", "()V",
+        INCOMPATIBLE, "made static"},
+    {CHANGE_CHANGED, API_FIELD, PUBLIC | ACC_STATIC, PUBLIC, "I", "I",
+        INCOMPATIBLE, "no longer static"},
+
+    // abstract and interfaces
+    {CHANGE_CHANGED, API_METHOD, PUBLIC, PUBLIC | ACC_ABSTRACT, "()V",
+        "()V", INCOMPATIBLE, "made abstract"},
+    {CHANGE_CHANGED, API_CLASS, PUBLIC | ACC_ABSTRACT, PUBLIC, NULL, NULL,
+        COMPATIBLE, "no longer abstract"},
+    {CHANGE_CHANGED, API_CLASS, PUBLIC, PUBLIC | ACC_INTERFACE |
+        ACC_ABSTRACT, NULL, NULL, INCOMPATIBLE, "class to interface"},
+    {CHANGE_CHANGED, API_CLASS, PUBLIC | ACC_INTERFACE | ACC_ABSTRACT,
+        PUBLIC, NULL, NULL, INCOMPATIBLE, "interface to class"},
+
+    // types and superclasses
+    {CHANGE_CHANGED, API_FIELD, PUBLIC, PUBLIC, "I", "J", INCOMPATIBLE,
+        "type I to J"},
+    {CHANGE_CHANGED, API_CLASS, PUBLIC, PUBLIC, "java.lang.Object",
+        "java.util.AbstractList", MAYBE_INCOMPATIBLE,
+        "superclass java.lang.Object to java.util.AbstractList"},
+
+    // the worst of several reasons wins
+    {CHANGE_CHANGED, API_FIELD, PROTECTED | ACC_FINAL, PUBLIC | ACC_STATIC,
+        "I", "I", INCOMPATIBLE,
+        "protected to public, no longer final, made static"},
+
+    // other flags don't count
+    {CHANGE_CHANGED, API_METHOD, PUBLIC, PUBLIC | ACC_SYNCHRONIZED, "()V",
+        "()V", COMPATIBLE, ""},
+};
+
+/*
+ * Fill in a row of the given kind; the type is the descriptor of a member
+ * or the parent of a class
+ */
+static void set_row(ApiRow *row, int kind, gint64 flags, const gchar *type)
+{
+    row->namespace = "com.example";
+    row->class = "Foo";
+    row->kind = kind;
+    row->name = kind == API_CLASS ? "" : "bar";
+    row->descriptor = kind == API_CLASS ? "" : type;
+    row->access_flags = flags;
+    row->parent = kind == API_CLASS ? type : NULL;
+}
+
+static void test_classify()
+{
+    GPtrArray *reasons = g_ptr_array_new_with_free_func(g_free);
+
+    for (guint i = 0; i < G_N_ELEMENTS(CASES); i++) {
+        const Case *c = &CASES[i];
+        ApiRow old, new;
+        GString *joined = g_string_new(NULL);
+
+        set_row(&old, c->kind, c->old_flags, c->old_type);
+        set_row(&new, c->kind, c->new_flags, c->new_type);
+
+        Compatibility result = apichange_classify(c->change,
+                c->change == CHANGE_ADDED ? NULL : &old,
+                c->change == CHANGE_REMOVED ? NULL : &new, reasons);
+
+        for (guint j = 0; j < reasons->len; j++) {
+            if (j > 0) g_string_append(joined, ", ");
+            g_string_append(joined, g_ptr_array_index(reasons, j));
+        }
+
+        g_assert_cmpstr(joined->str, ==, c->reasons);
+        g_assert_cmpint(result, ==, c->expected);
+
+        g_string_free(joined, TRUE);
+        g_ptr_array_set_size(reasons, 0);
+    }
+
+    g_ptr_array_free(reasons, TRUE);
+}
+
+/*
+ * Fields are matched by name, so a new type is a change, while methods are
+ * overloaded by their descriptor
+ */
+static void test_compare()
+{
+    ApiRow a, b;
+
+    set_row(&a, API_FIELD, PUBLIC, "I");
+    set_row(&b, API_FIELD, PUBLIC, "J");
+    g_assert_cmpint(apichange_compare(&a, &b), ==, 0);
+
+    set_row(&a, API_METHOD, PUBLIC, "(I)V");
+    set_row(&b, API_METHOD, PUBLIC, "(J)V");
+    g_assert_cmpint(apichange_compare(&a, &b), <, 0);
+
+    // a class precedes its fields, which precede its methods
+    set_row(&a, API_CLASS, PUBLIC, NULL);
+    set_row(&b, API_FIELD, PUBLIC, "I");
+    g_assert_cmpint(apichange_compare(&a, &b), <, 0);
+    set_row(&a, API_METHOD, PUBLIC, "()V");
+    g_assert_cmpint(apichange_compare(&a, &b), >, 0);
+
+    b.class = "Bar";
+    g_assert_cmpint(apichange_compare(&a, &b), >, 0);
+    b.namespace = "org.example";
+    g_assert_cmpint(apichange_compare(&a, &b), <, 0);
+}
+
+int main(int argc, char **argv)
+{
+    g_test_init(&argc, &argv, NULL);
+
+    g_test_add_func("/apichange/classify", test_classify);
+    g_test_add_func("/apichange/compare", test_compare);
+
+    return g_test_run();
+}
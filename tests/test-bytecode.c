@@ -0,0 +1,280 @@
+/*
+The MIT License (MIT) 
+Copyright (c) 2009,2010,2016 Andreas Heck <aheck@gmx.de>
+
+Permission to use, copy, modify, and/or distribute this software for any
+purpose with or without fee is hereby granted, provided that the above
+copyright notice and this permission notice appear in all copies.
+
+THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+*/
+
+#include <glib.h>
+
+#include <classscan.h>
+#include <bytecode.h>
+
+#include "classfile.h"
+
+/*
+ * Lengths of the instructions from the JVM specification which take more
+ * than the opcode; tableswitch, lookupswitch and wide vary
+ */
+static const struct {
+    guint8 opcode;
+    gsize length;
+} LONG_INSTRUCTIONS[] = {
+    {0x10, 2}, {0x11, 3}, {0x12, 2}, {0x13, 3}, {0x14, 3},
+    {0x15, 2}, {0x16, 2}, {0x17, 2}, {0x18, 2}, {0x19, 2},
+    {0x36, 2}, {0x37, 2}, {0x38, 2}, {0x39, 2}, {0x3a, 2},
+    {0x84, 3},
+    {0x99, 3}, {0x9a, 3}, {0x9b, 3}, {0x9c, 3}, {0x9d, 3}, {0x9e, 3},
+    {0x9f, 3}, {0xa0, 3}, {0xa1, 3}, {0xa2, 3}, {0xa3, 3}, {0xa4, 3},
+    {0xa5, 3}, {0xa6, 3}, {0xa7, 3}, {0xa8, 3}, {0xa9, 2},
+    {0xb2, 3}, {0xb3, 3}, {0xb4, 3}, {0xb5, 3}, {0xb6, 3}, {0xb7, 3},
+    {0xb8, 3}, {0xb9, 5}, {0xba, 5}, {0xbb, 3}, {0xbc, 2}, {0xbd, 3},
+    {0xc0, 3}, {0xc1, 3}, {0xc5, 4}, {0xc6, 3}, {0xc7, 3}, {0xc8, 5},
+    {0xc9, 5}
+};
+
+static gsize expected_length(guint8 opcode)
+{
+    for (guint i = 0; i < G_N_ELEMENTS(LONG_INSTRUCTIONS); i++) {
+        if (LONG_INSTRUCTIONS[i].opcode == opcode) {
+            return LONG_INSTRUCTIONS[i].length;
+        }
+    }
+
+    if (opcode == 0xaa || opcode == 0xab || opcode == 0xc4) return 0;
+
+    return opcode <= 0xc9 ? 1 : 0;
+}
+
+static void put_u4(guchar *p, guint32 value)
+{
+    p[0] = value >> 24;
+    p[1] = value >> 16;
+    p[2] = value >> 8;
+    p[3] = value;
+}
+
+static void test_fixed()
+{
+    guchar code[8] = {0};
+
+    for (guint opcode = 0; opcode < 256; opcode++) {
+        gsize length = expected_length(opcode);
+
+        if (opcode == 0xaa || opcode == 0xab || opcode == 0xc4) continue;
+
+        code[0] = opcode;
+        g_assert_cmpuint(bytecode_instruction_length(code, sizeof(code), 0),
+                ==, length);
+
+        // an instruction cut off by the end of the code is malformed
+        if (length > 1) {
+            g_assert_cmpuint(bytecode_instruction_length(code, length - 1, 0),
+                    ==, 0);
+        }
+    }
+}
+
+/*
+ * The operands of the switches start at the next multiple of 4 from the
+ * start of the code, so the padding depends on the offset of the opcode
+ */
+static void test_tableswitch()
+{
+    guchar code[64] = {0};
+
+    for (guint32 pc = 0; pc < 8; pc++) {
+        guint32 operands = pc + 1 + 3 - pc % 4;
+        gsize size = operands - pc + 12 + 3 * 4;
+
+        memset(code, 0, sizeof(code));
+        code[pc] = 0xaa;
+        put_u4(code + operands + 4, 1);         // low
+        put_u4(code + operands + 8, 3);         // high
+
+        g_assert_cmpuint(bytecode_instruction_length(code, pc + size, pc),
+                ==, size);
+        g_assert_cmpuint(bytecode_instruction_length(code, pc + size - 1,
+                    pc), ==, 0);
+        g_assert_cmpuint(bytecode_instruction_length(code, operands + 11,
+                    pc), ==, 0);
+
+        put_u4(code + operands + 4, 4);
+        g_assert_cmpuint(bytecode_instruction_length(code, sizeof(code),
+                    pc), ==, 0);
+
+        // the widest table doesn't overflow the length
+        put_u4(code + operands + 4, 0x80000000);
+        put_u4(code + operands + 8, 0x7fffffff);
+        g_assert_cmpuint(bytecode_instruction_length(code, sizeof(code),
+                    pc), ==, 0);
+    }
+}
+
+static void test_lookupswitch()
+{
+    guchar code[64] = {0};
+
+    for (guint32 pc = 0; pc < 8; pc++) {
+        guint32 operands = pc + 1 + 3 - pc % 4;
+        gsize size = operands - pc + 8 + 2 * 8;
+
+        memset(code, 0, sizeof(code));
+        code[pc] = 0xab;
+        put_u4(code + operands + 4, 2);         // npairs
+
+        g_assert_cmpuint(bytecode_instruction_length(code, pc + size, pc),
+                ==, size);
+        g_assert_cmpuint(bytecode_instruction_length(code, pc + size - 1,
+                    pc), ==, 0);
+        g_assert_cmpuint(bytecode_instruction_length(code, operands + 7,
+                    pc), ==, 0);
+
+        put_u4(code + operands + 4, 0xffffffff);
+        g_assert_cmpuint(bytecode_instruction_length(code, sizeof(code),
+                    pc), ==, 0);
+    }
+}
+
+static void test_wide()
+{
+    static const guchar IINC[] = {0xc4, 0x84, 0, 1, 0, 2};
+    static const guchar ILOAD[] = {0xc4, 0x15, 0, 1};
+
+    g_assert_cmpuint(bytecode_instruction_length(IINC, 6, 0), ==, 6);
+    g_assert_cmpuint(bytecode_instruction_length(IINC, 5, 0), ==, 0);
+    g_assert_cmpuint(bytecode_instruction_length(ILOAD, 4, 0), ==, 4);
+    g_assert_cmpuint(bytecode_instruction_length(ILOAD, 3, 0), ==, 0);
+    g_assert_cmpuint(bytecode_instruction_length(ILOAD, 1, 0), ==, 0);
+}
+
+/*
+ * Append a method named run with a Code attribute holding code and
+ * handlers empty exception handlers
+ */
+static void code_method(GByteArray *bytes, const guchar *code,
+        guint32 code_length, guint16 handlers)
+{
+    classfile_member(bytes, 0x0001, 5, 6, 1);
+    classfile_u2(bytes, 7);
+    classfile_u4(bytes, 12 + code_length + 8 * handlers);
+    classfile_u2(bytes, 2);                     // max_stack
+    classfile_u2(bytes, 1);                     // max_locals
+    classfile_u4(bytes, code_length);
+    g_byte_array_append(bytes, code, code_length);
+    classfile_u2(bytes, handlers);
+    for (guint i = 0; i < 8 * handlers; i++) classfile_u1(bytes, 0);
+    classfile_u2(bytes, 0);                     // attributes_count
+}
+
+/*
+ * A class with a method calling four others through a tableswitch, an
+ * abstract method, one whose code runs past its attribute and one whose
+ * last instruction is cut off
+ */
+static GByteArray *methods_class()
+{
+    static const guchar CODE[] = {
+        0x2a,                           // 0: aload_0
+        0xb7, 0, 1,                     // 1: invokespecial
+        0xb8, 0, 1,                     // 4: invokestatic
+        0x03,                           // 7: iconst_0
+        0xaa, 0, 0, 0,                  // 8: tableswitch, padding
+        0, 0, 0, 20,                    // 12: default
+        0, 0, 0, 0,                     // low
+        0, 0, 0, 0,                     // high
+        0, 0, 0, 20,                    // offset
+        0xb9, 0, 1, 1, 0,               // 28: invokeinterface
+        0xba, 0, 1, 0, 0,               // 33: invokedynamic
+        0xb1                            // 38: return
+    };
+    static const guchar CUT_OFF[] = {0x2a, 0xb7, 0};
+    GByteArray *bytes = classfile_new(8);
+
+    classfile_utf8(bytes, "Foo");                           // #1
+    classfile_ref(bytes, CONSTANT_Class, 1);                // #2
+    classfile_utf8(bytes, "java/lang/Object");              // #3
+    classfile_ref(bytes, CONSTANT_Class, 3);                // #4
+    classfile_utf8(bytes, "run");                           // #5
+    classfile_utf8(bytes, "()V");                           // #6
+    classfile_utf8(bytes, "Code");                          // #7
+
+    classfile_header(bytes, 0x0021, 2, 4);
+    classfile_u2(bytes, 0);
+
+    classfile_u2(bytes, 4);
+    code_method(bytes, CODE, sizeof(CODE), 1);
+    classfile_member(bytes, 0x0401, 5, 6, 0);
+
+    // code_length 100 in a Code attribute of 16 bytes
+    classfile_member(bytes, 0x0001, 5, 6, 1);
+    classfile_u2(bytes, 7);
+    classfile_u4(bytes, 16);
+    classfile_u2(bytes, 1);
+    classfile_u2(bytes, 1);
+    classfile_u4(bytes, 100);
+    for (guint i = 0; i < 8; i++) classfile_u1(bytes, 0);
+
+    code_method(bytes, CUT_OFF, sizeof(CUT_OFF), 0);
+
+    classfile_u2(bytes, 0);
+
+    return bytes;
+}
+
+static void test_code_stats()
+{
+    GByteArray *bytes = methods_class();
+    ClassScan scan = {0};
+    CodeStats stats;
+    gsize method = 0;
+
+    g_assert_true(classscan_init(&scan, bytes->data, bytes->len));
+
+    method = scan.methods_start;
+    g_assert_true(bytecode_code_stats(&scan, method, &stats));
+    g_assert_cmpuint(stats.code_length, ==, 39);
+    g_assert_cmpuint(stats.max_stack, ==, 2);
+    g_assert_cmpuint(stats.max_locals, ==, 1);
+    g_assert_cmpuint(stats.exception_handlers, ==, 1);
+    g_assert_cmpuint(stats.invocations, ==, 4);
+
+    method = classscan_next_member(&scan, method);
+    g_assert_false(bytecode_code_stats(&scan, method, &stats));
+    g_assert_cmpuint(stats.code_length, ==, 0);
+
+    method = classscan_next_member(&scan, method);
+    g_assert_false(bytecode_code_stats(&scan, method, &stats));
+
+    method = classscan_next_member(&scan, method);
+    g_assert_false(bytecode_code_stats(&scan, method, &stats));
+
+    g_assert_cmpuint(classscan_next_member(&scan, method), ==,
+            scan.attributes_start);
+
+    classscan_clear(&scan);
+    g_byte_array_free(bytes, TRUE);
+}
+
+int main(int argc, char **argv)
+{
+    g_test_init(&argc, &argv, NULL);
+
+    g_test_add_func("/bytecode/fixed", test_fixed);
+    g_test_add_func("/bytecode/tableswitch", test_tableswitch);
+    g_test_add_func("/bytecode/lookupswitch", test_lookupswitch);
+    g_test_add_func("/bytecode/wide", test_wide);
+    g_test_add_func("/bytecode/code-stats", test_code_stats);
+
+    return g_test_run();
+}
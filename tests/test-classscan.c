@@ -0,0 +1,249 @@
+/*
+The MIT License (MIT) 
+Copyright (c) 2009,2010,2016 Andreas Heck <aheck@gmx.de>
+
+Permission to use, copy, modify, and/or distribute this software for any
+purpose with or without fee is hereby granted, provided that the above
+copyright notice and this permission notice appear in all copies.
+
+THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+*/
+
+#include <glib.h>
+
+#include <classscan.h>
+
+#include "classfile.h"
+#include "truncated.h"
+
+/*
+ * class Foo { private int x; public void run() { return; } } compiled from
+ * Foo.java with a CONSTANT_Long taking up the indexes 10 and 11
+ */
+static GByteArray *foo_class()
+{
+    static const guchar CODE[] = {
+        0, 1, 0, 1,             // max_stack, max_locals
+        0, 0, 0, 1, 0xb1,       // code_length, return
+        0, 0, 0, 0              // exception_table_length, attributes_count
+    };
+    static const guchar SOURCE_FILE[] = {0, 13};
+    GByteArray *bytes = classfile_new(14);
+
+    classfile_utf8(bytes, "Foo");                           // #1
+    classfile_ref(bytes, CONSTANT_Class, 1);                // #2
+    classfile_utf8(bytes, "java/lang/Object");              // #3
+    classfile_ref(bytes, CONSTANT_Class, 3);                // #4
+    classfile_utf8(bytes, "x");                             // #5
+    classfile_utf8(bytes, "I");                             // #6
+    classfile_utf8(bytes, "run");                           // #7
+    classfile_utf8(bytes, "()V");                           // #8
+    classfile_utf8(bytes, "Code");                          // #9
+    classfile_long(bytes, CONSTANT_Long, 42);               // #10, #11
+    classfile_utf8(bytes, "SourceFile");                    // #12
+    classfile_utf8(bytes, "Foo.java");                      // #13
+
+    classfile_header(bytes, 0x0021, 2, 4);
+
+    classfile_u2(bytes, 1);
+    classfile_member(bytes, 0x0002, 5, 6, 0);
+
+    classfile_u2(bytes, 1);
+    classfile_member(bytes, 0x0001, 7, 8, 1);
+    classfile_attribute(bytes, 9, CODE, sizeof(CODE));
+
+    classfile_u2(bytes, 1);
+    classfile_attribute(bytes, 12, SOURCE_FILE, sizeof(SOURCE_FILE));
+
+    return bytes;
+}
+
+static void test_init()
+{
+    GByteArray *bytes = foo_class();
+    ClassScan scan = {0};
+    gchar *name = NULL;
+
+    g_assert_true(classscan_init(&scan, bytes->data, bytes->len));
+    g_assert_cmpuint(scan.major_version, ==, 52);
+    g_assert_cmpuint(scan.constant_pool_count, ==, 14);
+    g_assert_cmpuint(scan.access_flags, ==, 0x0021);
+    g_assert_cmpuint(scan.fields_count, ==, 1);
+    g_assert_cmpuint(scan.methods_count, ==, 1);
+
+    name = classscan_class_name(&scan, scan.this_class);
+    g_assert_cmpstr(name, ==, "Foo");
+    g_free(name);
+
+    name = classscan_class_name(&scan, scan.super_class);
+    g_assert_cmpstr(name, ==, "java/lang/Object");
+    g_free(name);
+
+    // a Utf8 entry is no class and the second half of a long no constant
+    g_assert_null(classscan_class_name(&scan, 1));
+    g_assert_cmpuint(classscan_tag(&scan, 10), ==, CONSTANT_Long);
+    g_assert_cmpuint(classscan_tag(&scan, 11), ==, 0);
+    g_assert_cmpuint(classscan_tag(&scan, 0), ==, 0);
+    g_assert_cmpuint(classscan_tag(&scan, 14), ==, 0);
+
+    classscan_clear(&scan);
+    g_byte_array_free(bytes, TRUE);
+}
+
+static void test_members()
+{
+    GByteArray *bytes = foo_class();
+    ClassScan scan = {0};
+    guint32 length = 0;
+
+    g_assert_true(classscan_init(&scan, bytes->data, bytes->len));
+
+    g_assert_true(classscan_member_is(&scan, scan.fields_start, "x"));
+    g_assert_false(classscan_member_is(&scan, scan.fields_start, "run"));
+    g_assert_true(classscan_member_is(&scan, scan.methods_start, "run"));
+    g_assert_false(classscan_member_is(NULL, scan.fields_start, "x"));
+    g_assert_false(classscan_member_is(&scan, 0, "x"));
+    g_assert_false(classscan_member_is(&scan, bytes->len - 4, "x"));
+
+    // the methods_count lies between the fields and the methods
+    g_assert_cmpuint(classscan_next_member(&scan, scan.fields_start) + 2,
+            ==, scan.methods_start);
+    g_assert_cmpuint(classscan_next_member(&scan, scan.methods_start), ==,
+            scan.attributes_start);
+    g_assert_cmpuint(classscan_next_member(&scan, bytes->len - 4), ==, 0);
+
+    g_assert_nonnull(classscan_member_attribute(&scan, scan.methods_start,
+                "Code", &length));
+    g_assert_cmpuint(length, ==, 13);
+    g_assert_null(classscan_member_attribute(&scan, scan.fields_start,
+                "Code", &length));
+
+    classscan_clear(&scan);
+    g_byte_array_free(bytes, TRUE);
+}
+
+static void test_attributes()
+{
+    GByteArray *bytes = foo_class();
+    ClassScan scan = {0};
+    guint32 length = 0;
+    const guchar *info = NULL;
+
+    g_assert_true(classscan_init(&scan, bytes->data, bytes->len));
+
+    info = classscan_attribute(&scan, "SourceFile", &length);
+    g_assert_nonnull(info);
+    g_assert_cmpuint(length, ==, 2);
+
+    gchar *source = classscan_string(&scan, classscan_u2(info));
+    g_assert_cmpstr(source, ==, "Foo.java");
+    g_free(source);
+
+    g_assert_null(classscan_attribute(&scan, "Source", &length));
+    g_assert_null(classscan_attribute(&scan, "SourceFileX", &length));
+
+    classscan_clear(&scan);
+    g_byte_array_free(bytes, TRUE);
+}
+
+/*
+ * A prefix of the class has to be rejected or, once the members are
+ * complete, lose the class attribute which is cut off
+ */
+static void check_truncated(const guchar *prefix, gsize size,
+        gpointer user_data)
+{
+    gsize attributes_start = *(gsize*) user_data;
+    ClassScan scan = {0};
+    guint32 length = 0;
+    gboolean ok = classscan_init(&scan, prefix, size);
+
+    if (size < attributes_start + 2) {
+        g_assert_false(ok);
+    } else {
+        g_assert_true(ok);
+        g_assert_null(classscan_attribute(&scan, "SourceFile", &length));
+    }
+
+    classscan_clear(&scan);
+}
+
+static void test_truncated()
+{
+    GByteArray *bytes = foo_class();
+    ClassScan scan = {0};
+    gsize attributes_start = 0;
+
+    g_assert_true(classscan_init(&scan, bytes->data, bytes->len));
+    attributes_start = scan.attributes_start;
+
+    truncated_prefixes(bytes->data, bytes->len, check_truncated,
+            &attributes_start);
+
+    classscan_clear(&scan);
+    g_byte_array_free(bytes, TRUE);
+}
+
+static void test_malformed()
+{
+    GByteArray *bytes = NULL;
+    ClassScan scan = {0};
+
+    // wrong magic
+    bytes = foo_class();
+    bytes->data[0] = 0xCB;
+    g_assert_false(classscan_init(&scan, bytes->data, bytes->len));
+    g_byte_array_free(bytes, TRUE);
+
+    // unknown constant pool tag
+    bytes = foo_class();
+    bytes->data[10] = 2;
+    g_assert_false(classscan_init(&scan, bytes->data, bytes->len));
+    g_byte_array_free(bytes, TRUE);
+
+    // a Utf8 constant which claims more bytes than there are
+    bytes = foo_class();
+    bytes->data[11] = 0xff;
+    g_assert_false(classscan_init(&scan, bytes->data, bytes->len));
+    g_byte_array_free(bytes, TRUE);
+
+    // a constant pool count beyond the entries
+    bytes = classfile_new(3);
+    classfile_utf8(bytes, "Foo");
+    g_assert_false(classscan_init(&scan, bytes->data, bytes->len));
+    g_byte_array_free(bytes, TRUE);
+
+    // an attribute of a method longer than the class
+    bytes = classfile_new(2);
+    classfile_utf8(bytes, "Code");
+    classfile_header(bytes, 0x0021, 0, 0);
+    classfile_u2(bytes, 0);
+    classfile_u2(bytes, 1);
+    classfile_member(bytes, 0x0001, 1, 1, 1);
+    classfile_u2(bytes, 1);
+    classfile_u4(bytes, 0xffffffff);
+    classfile_u2(bytes, 0);
+    g_assert_false(classscan_init(&scan, bytes->data, bytes->len));
+    g_byte_array_free(bytes, TRUE);
+
+    classscan_clear(&scan);
+}
+
+int main(int argc, char **argv)
+{
+    g_test_init(&argc, &argv, NULL);
+
+    g_test_add_func("/classscan/init", test_init);
+    g_test_add_func("/classscan/members", test_members);
+    g_test_add_func("/classscan/attributes", test_attributes);
+    g_test_add_func("/classscan/truncated", test_truncated);
+    g_test_add_func("/classscan/malformed", test_malformed);
+
+    return g_test_run();
+}
@@ -0,0 +1,109 @@
+/*
+The MIT License (MIT) 
+Copyright (c) 2009,2010,2016 Andreas Heck <aheck@gmx.de>
+
+Permission to use, copy, modify, and/or distribute this software for any
+purpose with or without fee is hereby granted, provided that the above
+copyright notice and this permission notice appear in all copies.
+
+THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+*/
+
+#include <glib.h>
+#include <glib/gstdio.h>
+
+#include <nestedjar.h>
+
+#include "zipfile.h"
+
+/*
+ * Open the first entry of a JAR and the first entries of the JARs in it
+ * as long as nestedjar_open() allows and return how many levels it took
+ */
+static guint open_levels(NestedJar *jar)
+{
+    GError *error = NULL;
+    NestedJar *nested = nestedjar_open(jar, 0, &error);
+    guint levels = 0;
+
+    if (nested == NULL) {
+        g_assert_nonnull(error);
+        g_error_free(error);
+        return 0;
+    }
+
+    levels = 1 + open_levels(nested);
+    nestedjar_close(nested);
+
+    return levels;
+}
+
+/*
+ * A JAR which contains itself can't be built without compression tricks,
+ * but to the recursion it looks like a chain of JARs which doesn't end
+ * before the depth limit of two levels
+ */
+static void test_depth()
+{
+    gchar *dir = g_dir_make_tmp("nestedjar-XXXXXX", NULL);
+    gchar *path = g_build_filename(dir, "app.ear", NULL);
+    ZipFileEntry entry = {"Foo.class", (const guint8*) "\xca\xfe\xba\xbe", 4};
+    GByteArray *bytes = zipfile_archive(&entry, 1);
+    struct zip *zip = NULL;
+    NestedJar *jar = NULL;
+
+    for (int i = 0; i < 8; i++) {
+        ZipFileEntry nested = {"lib/nested.jar", bytes->data, bytes->len};
+        GByteArray *outer = zipfile_archive(&nested, 1);
+
+        g_byte_array_free(bytes, TRUE);
+        bytes = outer;
+    }
+
+    g_assert_true(g_file_set_contents(path, (const gchar*) bytes->data,
+                bytes->len, NULL));
+    zip = zip_open(path, 0, NULL);
+    g_assert_nonnull(zip);
+
+    jar = nestedjar_new(zip, path);
+    g_assert_cmpuint(open_levels(jar), ==, 2);
+    nestedjar_close(jar);
+
+    g_remove(path);
+    g_rmdir(dir);
+    g_free(path);
+    g_free(dir);
+    g_byte_array_free(bytes, TRUE);
+}
+
+static void test_names()
+{
+    g_assert_true(nestedjar_is_archive("BOOT-INF/lib/spring-core.jar"));
+    g_assert_true(nestedjar_is_archive("app.war"));
+    g_assert_true(nestedjar_is_archive("/srv/app.ear"));
+    g_assert_false(nestedjar_is_archive("Foo.class"));
+    g_assert_false(nestedjar_is_archive("jar"));
+
+    g_assert_cmpstr(nestedjar_class_path("BOOT-INF/classes/com/Foo.class"),
+            ==, "com/Foo.class");
+    g_assert_cmpstr(nestedjar_class_path("WEB-INF/classes/Foo.class"), ==,
+            "Foo.class");
+    g_assert_cmpstr(nestedjar_class_path("com/Foo.class"), ==,
+            "com/Foo.class");
+}
+
+int main(int argc, char **argv)
+{
+    g_test_init(&argc, &argv, NULL);
+
+    g_test_add_func("/nestedjar/names", test_names);
+    g_test_add_func("/nestedjar/depth", test_depth);
+
+    return g_test_run();
+}
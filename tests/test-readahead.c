@@ -0,0 +1,179 @@
+/*
+The MIT License (MIT) 
+Copyright (c) 2009,2010,2016 Andreas Heck <aheck@gmx.de>
+
+Permission to use, copy, modify, and/or distribute this software for any
+purpose with or without fee is hereby granted, provided that the above
+copyright notice and this permission notice appear in all copies.
+
+THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+*/
+
+#include <glib.h>
+#include <glib/gstdio.h>
+
+#include <sys/types.h>
+#include <sys/stat.h>
+
+#include <readahead.h>
+
+#include "truncated.h"
+#include "zipfile.h"
+
+/*
+ * Write an archive to a file in dir and return its path
+ */
+static gchar *write_zip(const gchar *dir, const gchar *name,
+        GByteArray *bytes)
+{
+    gchar *path = g_build_filename(dir, name, NULL);
+
+    g_assert_true(g_file_set_contents(path, (const gchar*) bytes->data,
+                bytes->len, NULL));
+
+    return path;
+}
+
+static void test_jar_order()
+{
+    gchar *dir = g_dir_make_tmp("readahead-XXXXXX", NULL);
+    GByteArray *bytes = g_byte_array_new();
+    guint32 a = zipfile_local(bytes, "a.class", "aa");
+    guint32 b = zipfile_local(bytes, "b.class", "bbb");
+    guint32 c = zipfile_local(bytes, "c.class", "");
+    guint32 cdir_offset = bytes->len;
+    gchar *path = NULL;
+    guint *order = NULL;
+
+    // the central directory lists the last local header first
+    zipfile_central(bytes, "c.class", c, 0, 3);
+    zipfile_central(bytes, "a.class", a, 5, 0);
+    zipfile_central(bytes, "b.class", b, 0, 0);
+    zipfile_end(bytes, 3, bytes->len - cdir_offset, cdir_offset, "comment");
+
+    path = write_zip(dir, "order.jar", bytes);
+    order = readahead_jar_order(path, 3);
+
+    g_assert_nonnull(order);
+    g_assert_cmpuint(order[0], ==, 1);
+    g_assert_cmpuint(order[1], ==, 2);
+    g_assert_cmpuint(order[2], ==, 0);
+    g_free(order);
+
+    // the central directory has to match the entries of libzip
+    g_assert_null(readahead_jar_order(path, 2));
+    g_assert_null(readahead_jar_order(path, 0));
+
+    g_remove(path);
+    g_free(path);
+    g_byte_array_free(bytes, TRUE);
+    g_rmdir(dir);
+    g_free(dir);
+}
+
+/*
+ * A JAR cut short has no order to read ahead in
+ */
+static void check_truncated(const guchar *prefix, gsize size,
+        gpointer user_data)
+{
+    gchar *path = g_build_filename(user_data, "short.jar", NULL);
+
+    g_assert_true(g_file_set_contents(path, (const gchar*) prefix, size,
+                NULL));
+    g_assert_null(readahead_jar_order(path, 2));
+
+    g_remove(path);
+    g_free(path);
+}
+
+static void test_jar_malformed()
+{
+    gchar *dir = g_dir_make_tmp("readahead-XXXXXX", NULL);
+    GByteArray *bytes = g_byte_array_new();
+    guint32 a = zipfile_local(bytes, "a.class", "aa");
+    guint32 cdir_offset = bytes->len;
+    gchar *path = NULL;
+
+    g_assert_null(readahead_jar_order("/nonexistent/foo.jar", 1));
+
+    // ZIP64 marks the offset of an entry as kept in its extra field
+    zipfile_central(bytes, "a.class", a, 0, 0);
+    zipfile_central(bytes, "b.class", 0xffffffff, 0, 0);
+    zipfile_end(bytes, 2, bytes->len - cdir_offset, cdir_offset, "");
+
+    path = write_zip(dir, "zip64.jar", bytes);
+    g_assert_null(readahead_jar_order(path, 2));
+    g_remove(path);
+    g_free(path);
+
+    // no prefix of the archive has an end record
+    truncated_prefixes(bytes->data, bytes->len, check_truncated, dir);
+
+    g_byte_array_free(bytes, TRUE);
+    g_rmdir(dir);
+    g_free(dir);
+}
+
+static void test_dir()
+{
+    static const gchar *NAMES[] = {"b.jar", "a.class", "c", NULL};
+    gchar *dir = g_dir_make_tmp("readahead-XXXXXX", NULL);
+    GPtrArray *names = NULL;
+    GError *error = NULL;
+    ino_t last = 0;
+
+    for (guint i = 0; NAMES[i] != NULL; i++) {
+        gchar *path = g_build_filename(dir, NAMES[i], NULL);
+
+        g_assert_true(g_file_set_contents(path, "", 0, NULL));
+        g_free(path);
+    }
+
+    names = readahead_dir(dir, &error);
+    g_assert_null(error);
+    g_assert_cmpuint(names->len, ==, 3);
+
+    for (guint i = 0; i < names->len; i++) {
+        const gchar *name = g_ptr_array_index(names, i);
+        gchar *path = g_build_filename(dir, name, NULL);
+        struct stat st;
+
+        g_assert_true(g_strcmp0(name, "b.jar") == 0
+                || g_strcmp0(name, "a.class") == 0
+                || g_strcmp0(name, "c") == 0);
+
+        g_assert_cmpint(stat(path, &st), ==, 0);
+        g_assert_true(st.st_ino >= last);
+        last = st.st_ino;
+
+        g_remove(path);
+        g_free(path);
+    }
+
+    g_ptr_array_free(names, TRUE);
+    g_rmdir(dir);
+
+    g_assert_null(readahead_dir(dir, &error));
+    g_assert_nonnull(error);
+    g_error_free(error);
+
+    g_free(dir);
+}
+
+int main(int argc, char **argv)
+{
+    g_test_init(&argc, &argv, NULL);
+
+    g_test_add_func("/readahead/jar-order", test_jar_order);
+    g_test_add_func("/readahead/jar-malformed", test_jar_malformed);
+    g_test_add_func("/readahead/dir", test_dir);
+
+    return g_test_run();
+}
@@ -0,0 +1,376 @@
+/*
+The MIT License (MIT) 
+Copyright (c) 2009,2010,2016 Andreas Heck <aheck@gmx.de>
+
+Permission to use, copy, modify, and/or distribute this software for any
+purpose with or without fee is hereby granted, provided that the above
+copyright notice and this permission notice appear in all copies.
+
+THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+*/
+
+#include <string.h>
+#include <glib.h>
+#include <glib/gstdio.h>
+
+#include <repository.h>
+
+#include "zipfile.h"
+
+/*
+ * Write a JAR of empty entries to the path below dir and return its full
+ * path
+ */
+static gchar *write_jar(const gchar *dir, const gchar *path,
+        const gchar **names)
+{
+    gchar *filename = g_build_filename(dir, path, NULL);
+    gchar *parent = g_path_get_dirname(filename);
+    ZipFileEntry entries[8];
+    guint count = 0;
+    GByteArray *bytes = NULL;
+
+    for (; names[count] != NULL; count++) {
+        entries[count].name = names[count];
+        entries[count].data = (const guint8*) "";
+        entries[count].size = 0;
+    }
+
+    bytes = zipfile_archive(entries, count);
+
+    g_assert_cmpint(g_mkdir_with_parents(parent, 0755), ==, 0);
+    g_assert_true(g_file_set_contents(filename, (const gchar*) bytes->data,
+                bytes->len, NULL));
+
+    g_byte_array_free(bytes, TRUE);
+    g_free(parent);
+
+    return filename;
+}
+
+/*
+ * Write a JAR with a single pom.properties entry of the given contents
+ */
+static gchar *write_pom_jar(const gchar *dir, const gchar *path,
+        const gchar *properties)
+{
+    gchar *filename = g_build_filename(dir, path, NULL);
+    ZipFileEntry entry = {"META-INF/maven/com.example/app/pom.properties",
+        (const guint8*) properties, strlen(properties)};
+    GByteArray *bytes = zipfile_archive(&entry, 1);
+
+    g_assert_true(g_file_set_contents(filename, (const gchar*) bytes->data,
+                bytes->len, NULL));
+    g_byte_array_free(bytes, TRUE);
+
+    return filename;
+}
+
+static void remove_tree(const gchar *path)
+{
+    GDir *dir = g_dir_open(path, 0, NULL);
+    const gchar *name = NULL;
+
+    if (dir == NULL) {
+        g_remove(path);
+        return;
+    }
+
+    while ((name = g_dir_read_name(dir)) != NULL) {
+        gchar *child = g_build_filename(path, name, NULL);
+
+        remove_tree(child);
+        g_free(child);
+    }
+
+    g_dir_close(dir);
+    g_rmdir(path);
+}
+
+/*
+ * Every version is older than the ones after it, however the pairs are
+ * picked
+ */
+static void test_version_order()
+{
+    const gchar *versions[] = {
+        "1.0-alpha1", "1.0-beta1", "1.0-beta2", "1.0-milestone1", "1.0-rc1",
+        "1.0-SNAPSHOT", "1.0", "1.0-sp1", "1.0-custom", "1.0.1", "1.1",
+        "1.9", "1.10", "2", NULL
+    };
+
+    for (int i = 0; versions[i] != NULL; i++) {
+        g_assert_cmpint(repository_version_compare(versions[i],
+                    versions[i]), ==, 0);
+
+        for (int j = i + 1; versions[j] != NULL; j++) {
+            g_assert_cmpint(repository_version_compare(versions[i],
+                        versions[j]), <, 0);
+            g_assert_cmpint(repository_version_compare(versions[j],
+                        versions[i]), >, 0);
+        }
+    }
+}
+
+static void test_version_equal()
+{
+    // zeros are padded and dropped
+    g_assert_cmpint(repository_version_compare("1.0", "1"), ==, 0);
+    g_assert_cmpint(repository_version_compare("1.0.0", "1"), ==, 0);
+    g_assert_cmpint(repository_version_compare("1.01", "1.1"), ==, 0);
+
+    // a release is the empty qualifier and aliases are equal
+    g_assert_cmpint(repository_version_compare("1.0-final", "1.0"), ==, 0);
+    g_assert_cmpint(repository_version_compare("1.0.GA", "1.0"), ==, 0);
+    g_assert_cmpint(repository_version_compare("1.0-a1", "1.0-alpha1"), ==,
+            0);
+    g_assert_cmpint(repository_version_compare("1.0-cr1", "1.0-rc1"), ==,
+            0);
+    g_assert_cmpint(repository_version_compare("1.0-RC1", "1.0-rc1"), ==,
+            0);
+
+    // digits and letters are separate items
+    g_assert_cmpint(repository_version_compare("1.0rc1", "1.0-rc-1"), ==,
+            0);
+    g_assert_cmpint(repository_version_compare("1.0-rc2", "1.0-rc10"), <,
+            0);
+}
+
+static void test_coordinates()
+{
+    gchar *group_id = NULL, *artifact_id = NULL, *version = NULL;
+
+    // Maven: GROUP/PATH/ARTIFACT/VERSION/ARTIFACT-VERSION[-CLASSIFIER].jar
+    g_assert_true(repository_coordinates("/repo/", "/repo/org/apache/"
+                "commons/commons-lang3/3.12.0/commons-lang3-3.12.0.jar",
+                &group_id, &artifact_id, &version));
+    g_assert_cmpstr(group_id, ==, "org.apache.commons");
+    g_assert_cmpstr(artifact_id, ==, "commons-lang3");
+    g_assert_cmpstr(version, ==, "3.12.0");
+    g_free(group_id);
+    g_free(artifact_id);
+    g_free(version);
+
+    g_assert_true(repository_coordinates("/repo", "/repo/io/netty/"
+                "netty-transport/4.1.100.Final/"
+                "netty-transport-4.1.100.Final-linux-x86_64.jar",
+                &group_id, &artifact_id, &version));
+    g_assert_cmpstr(group_id, ==, "io.netty");
+    g_assert_cmpstr(artifact_id, ==, "netty-transport");
+    g_assert_cmpstr(version, ==, "4.1.100.Final");
+    g_free(group_id);
+    g_free(artifact_id);
+    g_free(version);
+
+    // Gradle: GROUP/ARTIFACT/VERSION/HASH/ARTIFACT-VERSION[-CLASSIFIER].jar
+    g_assert_true(repository_coordinates("/cache", "/cache/"
+                "com.google.guava/guava/32.1.2-jre/"
+                "5e64ec7e056456bef3a4bc4c6fdaef71e8ab6318/"
+                "guava-32.1.2-jre.jar",
+                &group_id, &artifact_id, &version));
+    g_assert_cmpstr(group_id, ==, "com.google.guava");
+    g_assert_cmpstr(artifact_id, ==, "guava");
+    g_assert_cmpstr(version, ==, "32.1.2-jre");
+    g_free(group_id);
+    g_free(artifact_id);
+    g_free(version);
+
+    // neither layout and no JAR to read pom.properties from
+    g_assert_false(repository_coordinates("/repo", "/repo/lib/app.jar",
+                &group_id, &artifact_id, &version));
+    g_assert_null(group_id);
+    g_assert_null(artifact_id);
+    g_assert_null(version);
+}
+
+/*
+ * JARs outside both layouts are named by their pom.properties
+ */
+static void test_pom_properties()
+{
+    gchar *dir = g_dir_make_tmp("repository-XXXXXX", NULL);
+    gchar *group_id = NULL, *artifact_id = NULL, *version = NULL;
+    gchar *path = write_pom_jar(dir, "app.jar",
+            "#Generated by Maven\n"
+            "groupId=com.example\r\n"
+            "artifactId = app\n"
+            "version=1.2.3\n");
+
+    g_assert_true(repository_coordinates(dir, path, &group_id, &artifact_id,
+                &version));
+    g_assert_cmpstr(group_id, ==, "com.example");
+    g_assert_cmpstr(artifact_id, ==, "app");
+    g_assert_cmpstr(version, ==, "1.2.3");
+    g_free(group_id);
+    g_free(artifact_id);
+    g_free(version);
+    g_free(path);
+
+    // all three coordinates are needed
+    path = write_pom_jar(dir, "partial.jar",
+            "groupId=com.example\nartifactId=app\n");
+    g_assert_false(repository_coordinates(dir, path, &group_id,
+                &artifact_id, &version));
+    g_assert_null(group_id);
+    g_free(path);
+
+    // a JAR which shades other artifacts can't be told apart from them
+    const gchar *shaded[] = {
+        "META-INF/maven/com.example/app/pom.properties",
+        "META-INF/maven/com.google.guava/guava/pom.properties",
+        NULL
+    };
+    path = write_jar(dir, "shaded.jar", shaded);
+    g_assert_false(repository_coordinates(dir, path, &group_id,
+                &artifact_id, &version));
+    g_free(path);
+
+    remove_tree(dir);
+    g_free(dir);
+}
+
+/*
+ * The JARs of a Maven repository are grouped by artifact and version and
+ * sources and javadoc JARs are skipped
+ */
+static void test_collect()
+{
+    gchar *dir = g_dir_make_tmp("repository-XXXXXX", NULL);
+    GHashTable *artifacts = g_hash_table_new_full(g_str_hash, g_str_equal,
+            g_free, (GDestroyNotify) repository_artifact_free);
+    const gchar *names[] = {"com/example/Lib.class", NULL};
+    const gchar *paths[] = {
+        "com/example/lib/1.0/lib-1.0.jar",
+        "com/example/lib/1.0/lib-1.0-sources.jar",
+        "com/example/lib/1.0/lib-1.0-linux.jar",
+        "com/example/lib/1.1/lib-1.1.jar",
+        "org/example/tool/2/tool-2.jar",
+        NULL
+    };
+
+    for (int i = 0; paths[i] != NULL; i++) g_free(write_jar(dir, paths[i],
+                names));
+
+    repository_collect(dir, artifacts);
+    GPtrArray *sorted = repository_sorted(artifacts);
+
+    g_assert_cmpuint(sorted->len, ==, 2);
+
+    Artifact *lib = g_ptr_array_index(sorted, 0);
+    g_assert_cmpstr(lib->group_id, ==, "com.example");
+    g_assert_cmpstr(lib->artifact_id, ==, "lib");
+    g_assert_cmpuint(lib->versions->len, ==, 2);
+
+    for (guint i = 0; i < lib->versions->len; i++) {
+        ArtifactVersion *version = g_ptr_array_index(lib->versions, i);
+        guint jars = g_strcmp0(version->version, "1.0") == 0 ? 2 : 1;
+
+        g_assert_cmpuint(version->jars->len, ==, jars);
+    }
+
+    Artifact *tool = g_ptr_array_index(sorted, 1);
+    g_assert_cmpstr(tool->group_id, ==, "org.example");
+    g_assert_cmpstr(tool->artifact_id, ==, "tool");
+
+    g_ptr_array_free(sorted, TRUE);
+    g_hash_table_destroy(artifacts);
+    remove_tree(dir);
+    g_free(dir);
+}
+
+static void add_version(Artifact *artifact, const gchar *version,
+        gchar *jar)
+{
+    ArtifactVersion *added = g_new0(ArtifactVersion, 1);
+
+    added->version = g_strdup(version);
+    added->jars = g_ptr_array_new_with_free_func(g_free);
+    g_ptr_array_add(added->jars, jar);
+    g_ptr_array_add(artifact->versions, added);
+}
+
+static void assert_run(Artifact *artifact, guint index, const gchar *name,
+        guint first, guint last)
+{
+    ClassRun *run = g_ptr_array_index(artifact->runs, index);
+
+    g_assert_cmpstr(run->name, ==, name);
+    g_assert_cmpuint(run->first, ==, first);
+    g_assert_cmpuint(run->last, ==, last);
+}
+
+/*
+ * The versions are sorted and a class gets one run per stretch of
+ * consecutive versions it is in
+ */
+static void test_runs()
+{
+    gchar *dir = g_dir_make_tmp("repository-XXXXXX", NULL);
+    Artifact *artifact = g_new0(Artifact, 1);
+    const gchar *rc[] = {
+        "com/A.class", "com/B.class", "module-info.class",
+        "META-INF/versions/9/com/A.class", "META-INF/MANIFEST.MF", NULL
+    };
+    const gchar *old[] = {"com/A.class", "BOOT-INF/classes/com/C.class", NULL};
+    const gchar *native[] = {"com/D.class", NULL};
+    const gchar *new[] = {
+        "com/A.class", "com/A$Inner.class", "com/B.class", "com/C.class", NULL
+    };
+
+    artifact->group_id = g_strdup("com.example");
+    artifact->artifact_id = g_strdup("lib");
+    artifact->versions = g_ptr_array_new();
+
+    add_version(artifact, "1.10", write_jar(dir, "new.jar", new));
+    add_version(artifact, "1.9", write_jar(dir, "old.jar", old));
+    add_version(artifact, "1.0-rc1", write_jar(dir, "rc.jar", rc));
+    g_ptr_array_add(((ArtifactVersion*) g_ptr_array_index(artifact->versions,
+                    1))->jars, write_jar(dir, "native.jar", native));
+
+    repository_scan_artifact(artifact);
+
+    g_assert_cmpstr(((ArtifactVersion*) g_ptr_array_index(
+                    artifact->versions, 0))->version, ==, "1.0-rc1");
+    g_assert_cmpstr(((ArtifactVersion*) g_ptr_array_index(
+                    artifact->versions, 2))->version, ==, "1.10");
+
+    g_assert_cmpuint(artifact->runs->len, ==, 6);
+    assert_run(artifact, 0, "com.A", 0, 2);
+    assert_run(artifact, 1, "com.B", 0, 0);
+    assert_run(artifact, 2, "com.C", 1, 2);
+    assert_run(artifact, 3, "com.D", 1, 1);
+    assert_run(artifact, 4, "com.A$Inner", 2, 2);
+    assert_run(artifact, 5, "com.B", 2, 2);
+
+    for (guint i = 0; i < artifact->versions->len; i++) {
+        ArtifactVersion *version = g_ptr_array_index(artifact->versions, i);
+
+        g_free(version->version);
+        g_ptr_array_free(version->jars, TRUE);
+        g_free(version);
+    }
+
+    repository_artifact_free(artifact);
+    remove_tree(dir);
+    g_free(dir);
+}
+
+int main(int argc, char **argv)
+{
+    g_test_init(&argc, &argv, NULL);
+
+    g_test_add_func("/repository/version-order", test_version_order);
+    g_test_add_func("/repository/version-equal", test_version_equal);
+    g_test_add_func("/repository/coordinates", test_coordinates);
+    g_test_add_func("/repository/pom-properties", test_pom_properties);
+    g_test_add_func("/repository/collect", test_collect);
+    g_test_add_func("/repository/runs", test_runs);
+
+    return g_test_run();
+}
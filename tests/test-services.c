@@ -0,0 +1,160 @@
+/*
+The MIT License (MIT) 
+Copyright (c) 2009,2010,2016 Andreas Heck <aheck@gmx.de>
+
+Permission to use, copy, modify, and/or distribute this software for any
+purpose with or without fee is hereby granted, provided that the above
+copyright notice and this permission notice appear in all copies.
+
+THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+*/
+
+#include <string.h>
+#include <glib.h>
+
+#include <services.h>
+
+static const gchar *KINDS[] = {"loader", "factories", "imports"};
+
+static void record(ServicesKind kind, const gchar *service,
+        const gchar *provider, gpointer user_data)
+{
+    g_string_append_printf(user_data, "%s %s=%s\n", KINDS[kind], service,
+            provider);
+}
+
+static gchar *parse(const gchar *path, const gchar *data)
+{
+    GString *events = g_string_new(NULL);
+
+    services_parse(path, data, strlen(data), record, events);
+
+    return g_string_free(events, FALSE);
+}
+
+static void test_kind()
+{
+    g_assert_cmpint(services_kind("META-INF/services/java.sql.Driver"), ==,
+            SERVICES_LOADER);
+    g_assert_cmpint(services_kind("/src/app/META-INF/services/a.B"), ==,
+            SERVICES_LOADER);
+    g_assert_cmpint(services_kind("META-INF/spring.factories"), ==,
+            SERVICES_SPRING_FACTORIES);
+    g_assert_cmpint(services_kind(
+                "BOOT-INF/classes/META-INF/spring.factories"), ==,
+            SERVICES_SPRING_FACTORIES);
+    g_assert_cmpint(services_kind("META-INF/spring/"
+                "org.springframework.boot.autoconfigure.AutoConfiguration"
+                ".imports"), ==, SERVICES_SPRING_IMPORTS);
+
+    g_assert_cmpint(services_kind("META-INF/services/"), ==, SERVICES_NONE);
+    g_assert_cmpint(services_kind("META-INF/services/sub/a.B"), ==,
+            SERVICES_NONE);
+    g_assert_cmpint(services_kind("META-INF/spring/.imports"), ==,
+            SERVICES_NONE);
+    g_assert_cmpint(services_kind("META-INF/spring/a/B.imports"), ==,
+            SERVICES_NONE);
+    g_assert_cmpint(services_kind("XMETA-INF/services/a.B"), ==,
+            SERVICES_NONE);
+    g_assert_cmpint(services_kind("META-INF/MANIFEST.MF"), ==,
+            SERVICES_NONE);
+    g_assert_cmpint(services_kind("com/Foo.class"), ==, SERVICES_NONE);
+}
+
+/*
+ * The format of ServiceLoader: one name per line, comments, blank lines
+ * and the line ends of Windows
+ */
+static void test_loader()
+{
+    gchar *events = parse("META-INF/services/java.sql.Driver",
+            "# drivers\r\n"
+            "com.Foo # the default\r\n"
+            "\r\n"
+            "  com.Bar  \n"
+            "not a name\n"
+            "com/Baz\n"
+            "com.Last");
+
+    g_assert_cmpstr(events, ==,
+            "loader java.sql.Driver=com.Foo\n"
+            "loader java.sql.Driver=com.Bar\n"
+            "loader java.sql.Driver=com.Last\n");
+    g_free(events);
+}
+
+static void test_imports()
+{
+    gchar *events = parse("META-INF/spring/a.AutoConfiguration.imports",
+            "# auto-configurations\n"
+            "b.FirstAutoConfiguration\n"
+            "b.SecondAutoConfiguration\n");
+
+    g_assert_cmpstr(events, ==,
+            "imports a.AutoConfiguration=b.FirstAutoConfiguration\n"
+            "imports a.AutoConfiguration=b.SecondAutoConfiguration\n");
+    g_free(events);
+}
+
+static void test_factories()
+{
+    gchar *events = parse("META-INF/spring.factories",
+            "# comments don't continue \\\n"
+            "a.Listener=b.Listener\n"
+            "a.Initializer=b.First,\\\r\n"
+            "  b.Second , \\\n"
+            "  b.Third\n"
+            "! another comment\n"
+            "a.Filter : b.Filter\n"
+            "a.Empty=\n"
+            "not a service=b.Ignored\n"
+            "a.Mixed=b/Invalid,b.Valid\n"
+            "no separator\n");
+
+    g_assert_cmpstr(events, ==,
+            "factories a.Listener=b.Listener\n"
+            "factories a.Initializer=b.First\n"
+            "factories a.Initializer=b.Second\n"
+            "factories a.Initializer=b.Third\n"
+            "factories a.Filter=b.Filter\n"
+            "factories a.Mixed=b.Valid\n");
+    g_free(events);
+}
+
+/*
+ * The data isn't terminated and files of other kinds are skipped
+ */
+static void test_bounds()
+{
+    static const gchar DATA[] = "com.Foo\ncom.Bar\n";
+    GString *events = g_string_new(NULL);
+
+    services_parse("META-INF/services/a.B", DATA, 7, record, events);
+    g_assert_cmpstr(events->str, ==, "loader a.B=com.Foo\n");
+
+    g_string_truncate(events, 0);
+    services_parse("META-INF/MANIFEST.MF", DATA, strlen(DATA), record,
+            events);
+    g_assert_cmpstr(events->str, ==, "");
+
+    g_string_free(events, TRUE);
+}
+
+int main(int argc, char **argv)
+{
+    g_test_init(&argc, &argv, NULL);
+
+    g_test_add_func("/services/kind", test_kind);
+    g_test_add_func("/services/loader", test_loader);
+    g_test_add_func("/services/imports", test_imports);
+    g_test_add_func("/services/factories", test_factories);
+    g_test_add_func("/services/bounds", test_bounds);
+
+    return g_test_run();
+}
@@ -0,0 +1,193 @@
+/*
+The MIT License (MIT) 
+Copyright (c) 2009,2010,2016 Andreas Heck <aheck@gmx.de>
+
+Permission to use, copy, modify, and/or distribute this software for any
+purpose with or without fee is hereby granted, provided that the above
+copyright notice and this permission notice appear in all copies.
+
+THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+*/
+
+#include <string.h>
+#include <glib.h>
+
+#include <summary.h>
+
+#include "truncated.h"
+
+static void test_uint()
+{
+    static const guint64 VALUES[] = {
+        0, 1, 127, 128, 300, 16383, 16384, G_MAXUINT32, G_MAXUINT64
+    };
+    static const guint LENGTHS[] = {1, 1, 1, 2, 2, 2, 3, 5, 10};
+    GByteArray *buffer = g_byte_array_new();
+    SummaryReader reader;
+
+    for (guint i = 0; i < G_N_ELEMENTS(VALUES); i++) {
+        g_byte_array_set_size(buffer, 0);
+        summary_put_uint(buffer, VALUES[i]);
+        g_assert_cmpuint(buffer->len, ==, LENGTHS[i]);
+
+        summary_reader_init(&reader, buffer->data, buffer->len);
+        g_assert_true(summary_get_uint(&reader) == VALUES[i]);
+        g_assert_false(reader.error);
+        g_assert_cmpuint(reader.pos, ==, buffer->len);
+    }
+
+    // the lowest 7 bits come first
+    g_byte_array_set_size(buffer, 0);
+    summary_put_uint(buffer, 300);
+    g_assert_cmpuint(buffer->data[0], ==, 0xac);
+    g_assert_cmpuint(buffer->data[1], ==, 0x02);
+
+    g_byte_array_free(buffer, TRUE);
+}
+
+static void test_string()
+{
+    GByteArray *buffer = g_byte_array_new();
+    SummaryReader reader;
+    gchar *str = NULL;
+
+    summary_put_string(buffer, "java.lang.Object");
+    summary_put_string(buffer, NULL);
+    summary_put_string(buffer, "");
+
+    summary_reader_init(&reader, buffer->data, buffer->len);
+
+    str = summary_get_string(&reader);
+    g_assert_cmpstr(str, ==, "java.lang.Object");
+    g_free(str);
+
+    g_assert_null(summary_get_string(&reader));
+    g_assert_false(reader.error);
+
+    str = summary_get_string(&reader);
+    g_assert_cmpstr(str, ==, "");
+    g_free(str);
+
+    g_assert_false(reader.error);
+    g_assert_cmpuint(reader.pos, ==, buffer->len);
+
+    g_byte_array_free(buffer, TRUE);
+}
+
+/*
+ * A prefix of a record ends in the middle of a number or a string
+ */
+static void check_truncated(const guchar *prefix, gsize size,
+        gpointer user_data)
+{
+    SummaryReader reader;
+
+    summary_reader_init(&reader, prefix, size);
+
+    summary_get_uint(&reader);
+    g_free(summary_get_string(&reader));
+    summary_get_uint(&reader);
+
+    g_assert_true(reader.error);
+    g_assert_cmpuint(reader.pos, <=, size);
+}
+
+static void test_truncated()
+{
+    GByteArray *buffer = g_byte_array_new();
+
+    summary_put_uint(buffer, 1000);
+    summary_put_string(buffer, "java.io.Serializable");
+    summary_put_uint(buffer, G_MAXUINT64);
+
+    truncated_prefixes(buffer->data, buffer->len, check_truncated, NULL);
+
+    g_byte_array_free(buffer, TRUE);
+}
+
+static void test_malformed()
+{
+    static const guchar OVERLONG[] = {
+        0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x01
+    };
+    static const guchar LONG_STRING[] = {0x0b, 'a', 'b', 'c'};
+    SummaryReader reader;
+
+    // no number takes more than 64 bits
+    summary_reader_init(&reader, OVERLONG, sizeof(OVERLONG));
+    g_assert_true(summary_get_uint(&reader) == 0);
+    g_assert_true(reader.error);
+
+    // a string longer than the rest of the record
+    summary_reader_init(&reader, LONG_STRING, sizeof(LONG_STRING));
+    g_assert_null(summary_get_string(&reader));
+    g_assert_true(reader.error);
+    g_assert_cmpuint(reader.pos, ==, 1);
+}
+
+static void test_compress()
+{
+    GByteArray *buffer = g_byte_array_new();
+    guchar *compressed = NULL;
+    guchar *uncompressed = NULL;
+    gsize compressed_size = 0;
+
+    for (guint i = 0; i < 100; i++) {
+        summary_put_string(buffer, "java.lang.String");
+        summary_put_uint(buffer, i);
+    }
+
+    compressed = summary_compress(buffer->data, buffer->len,
+            &compressed_size);
+    g_assert_nonnull(compressed);
+    g_assert_cmpuint(compressed_size, <, buffer->len);
+
+    uncompressed = summary_uncompress(compressed, compressed_size,
+            buffer->len);
+    g_assert_nonnull(uncompressed);
+    g_assert_cmpmem(uncompressed, buffer->len, buffer->data, buffer->len);
+    g_free(uncompressed);
+
+    // the size stored next to the record has to match
+    g_assert_null(summary_uncompress(compressed, compressed_size,
+                buffer->len - 1));
+    g_assert_null(summary_uncompress(compressed, compressed_size,
+                buffer->len + 1));
+
+    // a truncated or corrupt stream
+    g_assert_null(summary_uncompress(compressed, compressed_size / 2,
+                buffer->len));
+    compressed[compressed_size / 2] ^= 0xff;
+    g_assert_null(summary_uncompress(compressed, compressed_size,
+                buffer->len));
+    g_free(compressed);
+
+    // an empty record
+    compressed = summary_compress(buffer->data, 0, &compressed_size);
+    g_assert_nonnull(compressed);
+    uncompressed = summary_uncompress(compressed, compressed_size, 0);
+    g_assert_nonnull(uncompressed);
+    g_free(uncompressed);
+    g_free(compressed);
+
+    g_byte_array_free(buffer, TRUE);
+}
+
+int main(int argc, char **argv)
+{
+    g_test_init(&argc, &argv, NULL);
+
+    g_test_add_func("/summary/uint", test_uint);
+    g_test_add_func("/summary/string", test_string);
+    g_test_add_func("/summary/truncated", test_truncated);
+    g_test_add_func("/summary/malformed", test_malformed);
+    g_test_add_func("/summary/compress", test_compress);
+
+    return g_test_run();
+}
@@ -0,0 +1,227 @@
+/*
+The MIT License (MIT) 
+Copyright (c) 2009,2010,2016 Andreas Heck <aheck@gmx.de>
+
+Permission to use, copy, modify, and/or distribute this software for any
+purpose with or without fee is hereby granted, provided that the above
+copyright notice and this permission notice appear in all copies.
+
+THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+*/
+
+#include <glib.h>
+
+#include <symtab.h>
+
+/*
+ * Strings are looked up with the hash they were inserted with, so the
+ * tests choose colliding hashes to control where the entries land
+ */
+static void test_insert()
+{
+    SymTab *table = symtab_new(0);
+    gchar name[32];
+
+    // enough entries for several resizes from the 64 initial slots
+    for (gint64 id = 1; id <= 1000; id++) {
+        g_snprintf(name, sizeof(name), "java/lang/Class%d", (int) id);
+        symtab_insert(table, name, symtab_hash(name), id);
+    }
+
+    g_assert_cmpuint(symtab_size(table), ==, 1000);
+
+    for (gint64 id = 1; id <= 1000; id++) {
+        g_snprintf(name, sizeof(name), "java/lang/Class%d", (int) id);
+        g_assert_cmpint(symtab_lookup(table, name, symtab_hash(name)), ==,
+                id);
+    }
+
+    g_assert_cmpint(symtab_lookup(table, "java/lang/Class0",
+                symtab_hash("java/lang/Class0")), ==, 0);
+    g_assert_cmpint(symtab_lookup(table, "", symtab_hash("")), ==, 0);
+
+    symtab_clear(table);
+    g_assert_cmpuint(symtab_size(table), ==, 0);
+    g_assert_cmpint(symtab_lookup(table, "java/lang/Class1",
+                symtab_hash("java/lang/Class1")), ==, 0);
+
+    symtab_free(table);
+}
+
+/*
+ * Entries with the same home slot are displaced into the following slots;
+ * one whose home slot is the last wraps around to the start of the table
+ */
+static void test_collisions()
+{
+    SymTab *table = symtab_new(0);
+
+    // "a" is at home in the last of the 64 slots and "d" in the first
+    symtab_insert(table, "a", 63, 1);
+    symtab_insert(table, "d", 0, 4);
+
+    // "b" and "c" have the home of "a" and wrap around to the start; Robin
+    // Hood moves "d" on to slot 2 since they are further from home
+    symtab_insert(table, "b", 63, 2);
+    symtab_insert(table, "c", 63, 3);
+    symtab_insert(table, "e", 64 + 1, 5);
+
+    g_assert_cmpint(symtab_lookup(table, "a", 63), ==, 1);
+    g_assert_cmpint(symtab_lookup(table, "b", 63), ==, 2);
+    g_assert_cmpint(symtab_lookup(table, "c", 63), ==, 3);
+    g_assert_cmpint(symtab_lookup(table, "d", 0), ==, 4);
+    g_assert_cmpint(symtab_lookup(table, "e", 64 + 1), ==, 5);
+
+    // the same string with another hash and other strings with a colliding
+    // hash are not found
+    g_assert_cmpint(symtab_lookup(table, "a", 62), ==, 0);
+    g_assert_cmpint(symtab_lookup(table, "z", 63), ==, 0);
+    g_assert_cmpint(symtab_lookup(table, "z", 0), ==, 0);
+    g_assert_cmpint(symtab_lookup(table, "z", 1), ==, 0);
+
+    // the collisions survive the resize into more slots
+    symtab_reserve(table, 1000);
+    g_assert_cmpint(symtab_lookup(table, "c", 63), ==, 3);
+    g_assert_cmpint(symtab_lookup(table, "d", 0), ==, 4);
+    g_assert_cmpint(symtab_lookup(table, "e", 64 + 1), ==, 5);
+    g_assert_cmpuint(symtab_size(table), ==, 5);
+
+    symtab_free(table);
+}
+
+static void test_memory()
+{
+    SymTab *table = symtab_new(0);
+    gsize empty = symtab_memory(table);
+    gsize memory = 0;
+
+    g_assert_cmpuint(empty, >=, 64 * 16);
+
+    // the first string allocates the arena
+    symtab_insert(table, "java/lang", symtab_hash("java/lang"), 1);
+    memory = symtab_memory(table);
+    g_assert_cmpuint(memory, ==, empty + 4096);
+
+    // 2048 slots keep 1001 entries at most 80% full
+    symtab_reserve(table, 1000);
+    g_assert_cmpuint(symtab_memory(table), ==, memory + (2048 - 64) * 16);
+    memory = symtab_memory(table);
+
+    // the memory is kept when the table is cleared
+    symtab_clear(table);
+    g_assert_cmpuint(symtab_memory(table), ==, memory);
+
+    symtab_free(table);
+
+    // a table sized up front starts with all its slots
+    table = symtab_new(1000);
+    g_assert_cmpuint(symtab_memory(table), ==, empty + (2048 - 64) * 16);
+    symtab_free(table);
+}
+
+/*
+ * Intern name like the indexer: from the caches or as a new string with
+ * the next ID, then rotate the caches if they grew beyond limit
+ */
+static gint64 intern(SymCache **caches, const gchar *name, gint64 *next_id,
+        gsize limit, gboolean *rotated)
+{
+    guint64 hash = symtab_hash(name);
+    gint64 id = symcache_lookup(caches[0], name, hash);
+
+    if (id == 0) {
+        id = (*next_id)++;
+        symtab_insert(caches[0]->current, name, hash, id);
+    }
+
+    *rotated = symcache_limit(caches, 2, limit);
+
+    return id;
+}
+
+static void test_cache()
+{
+    SymCache namespaces = {symtab_new(0), symtab_new(0)};
+    SymCache other = {symtab_new(0), symtab_new(0)};
+    SymCache *caches[] = {&namespaces, &other};
+    gsize limit = symtab_memory(other.current) + 64 * 1024;
+    gint64 next_id = 1;
+    gboolean rotated = FALSE;
+    gchar name[32];
+    guint i = 0;
+
+    // intern until the current generation is rotated
+    for (i = 0; !rotated; i++) {
+        g_snprintf(name, sizeof(name), "com/example/Class%u", i);
+        g_assert_cmpint(intern(caches, name, &next_id, limit, &rotated), ==,
+                i + 1);
+    }
+
+    g_assert_cmpuint(symtab_size(namespaces.current), ==, 0);
+    g_assert_cmpuint(symtab_size(namespaces.previous), ==, i);
+
+    // the strings interned just before keep their IDs and the next one
+    // doesn't rotate the tables again
+    g_assert_cmpint(intern(caches, "com/example/Class0", &next_id, limit,
+                &rotated), ==, 1);
+    g_assert_false(rotated);
+    g_snprintf(name, sizeof(name), "com/example/Class%u", i - 1);
+    g_assert_cmpint(intern(caches, name, &next_id, limit, &rotated), ==, i);
+    g_assert_false(rotated);
+    g_assert_cmpint(intern(caches, "com/example/New", &next_id, limit,
+                &rotated), ==, i + 1);
+    g_assert_false(rotated);
+    g_assert_cmpuint(symtab_size(namespaces.current), ==, 3);
+
+    // after the next rotation only the strings used since the last one are
+    // left
+    for (guint j = 0; !rotated; j++) {
+        g_snprintf(name, sizeof(name), "org/example/Class%u", j);
+        intern(caches, name, &next_id, limit, &rotated);
+    }
+
+    g_assert_cmpint(symcache_lookup(&namespaces, "com/example/Class0",
+                symtab_hash("com/example/Class0")), ==, 1);
+    g_assert_cmpint(symcache_lookup(&namespaces, "com/example/Class1",
+                symtab_hash("com/example/Class1")), ==, 0);
+
+    for (guint j = 0; j < G_N_ELEMENTS(caches); j++) {
+        symtab_free(caches[j]->current);
+        symtab_free(caches[j]->previous);
+    }
+}
+
+/*
+ * Without a previous generation a cache is a plain symbol table
+ */
+static void test_cache_unbounded()
+{
+    SymCache cache = {symtab_new(0), NULL};
+
+    symtab_insert(cache.current, "java/lang", symtab_hash("java/lang"), 7);
+    g_assert_cmpint(symcache_lookup(&cache, "java/lang",
+                symtab_hash("java/lang")), ==, 7);
+    g_assert_cmpint(symcache_lookup(&cache, "java/util",
+                symtab_hash("java/util")), ==, 0);
+
+    symtab_free(cache.current);
+}
+
+int main(int argc, char **argv)
+{
+    g_test_init(&argc, &argv, NULL);
+
+    g_test_add_func("/symtab/insert", test_insert);
+    g_test_add_func("/symtab/collisions", test_collisions);
+    g_test_add_func("/symtab/memory", test_memory);
+    g_test_add_func("/symtab/cache", test_cache);
+    g_test_add_func("/symtab/cache-unbounded", test_cache_unbounded);
+
+    return g_test_run();
+}
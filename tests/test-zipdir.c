@@ -0,0 +1,195 @@
+/*
+The MIT License (MIT) 
+Copyright (c) 2009,2010,2016 Andreas Heck <aheck@gmx.de>
+
+Permission to use, copy, modify, and/or distribute this software for any
+purpose with or without fee is hereby granted, provided that the above
+copyright notice and this permission notice appear in all copies.
+
+THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+*/
+
+#include <string.h>
+#include <glib.h>
+
+#include <zipdir.h>
+
+#include "truncated.h"
+#include "zipfile.h"
+
+#define A_OFFSET 0
+#define B_OFFSET (30 + 7 + 2)
+#define C_OFFSET (B_OFFSET + 30 + 7 + 3)
+#define CDIR_OFFSET (C_OFFSET + 30 + 9)
+
+/*
+ * An archive of three entries whose central directory lists them in
+ * another order than their local headers, with an extra field and a
+ * comment on the second entry
+ */
+static GByteArray *three_entries(const gchar *comment)
+{
+    GByteArray *bytes = g_byte_array_new();
+    guint32 a = zipfile_local(bytes, "a.class", "aa");
+    guint32 b = zipfile_local(bytes, "b.class", "bbb");
+    guint32 c = zipfile_local(bytes, "lib/c.jar", "");
+    guint32 cdir_offset = bytes->len;
+
+    zipfile_central(bytes, "lib/c.jar", c, 0, 0);
+    zipfile_central(bytes, "a.class", a, 4, 7);
+    zipfile_central(bytes, "b.class", b, 0, 0);
+    zipfile_end(bytes, 3, bytes->len - cdir_offset, cdir_offset, comment);
+
+    return bytes;
+}
+
+/*
+ * Read the end record from the tail of an archive in memory like the
+ * callers do
+ */
+static gboolean read_end(GByteArray *bytes, ZipDirEnd *end)
+{
+    gsize tail = MIN(bytes->len, ZIPDIR_MAX_TAIL);
+
+    return zipdir_read_end(bytes->data + bytes->len - tail, tail, bytes->len,
+            end);
+}
+
+/*
+ * The end record is the last 22 bytes of an archive without a comment;
+ * patch its entry count and the size and offset of the directory
+ */
+static void set_end(GByteArray *bytes, guint16 count, guint32 size,
+        guint32 offset)
+{
+    guchar *eocd = bytes->data + bytes->len - 22;
+
+    eocd[8]  = eocd[10] = count & 0xff;
+    eocd[9]  = eocd[11] = count >> 8;
+
+    for (guint i = 0; i < 4; i++) {
+        eocd[12 + i] = size >> (8 * i);
+        eocd[16 + i] = offset >> (8 * i);
+    }
+}
+
+static void test_end()
+{
+    GByteArray *bytes = three_entries("");
+    guint32 size = bytes->len - 22 - CDIR_OFFSET;
+    ZipDirEnd end;
+
+    g_assert_true(read_end(bytes, &end));
+    g_assert_cmpuint(end.count, ==, 3);
+    g_assert_cmpuint(end.size, ==, size);
+    g_assert_cmpuint(end.offset, ==, CDIR_OFFSET);
+
+    // the directory has to lie within the archive
+    set_end(bytes, 3, bytes->len - CDIR_OFFSET + 1, CDIR_OFFSET);
+    g_assert_false(read_end(bytes, &end));
+    set_end(bytes, 3, size, bytes->len);
+    g_assert_false(read_end(bytes, &end));
+
+    // ZIP64 keeps the count and the offset in another record
+    set_end(bytes, 3, size, 0xffffffff);
+    g_assert_false(read_end(bytes, &end));
+    set_end(bytes, 0xffff, size, CDIR_OFFSET);
+    g_assert_false(read_end(bytes, &end));
+
+    g_assert_false(zipdir_read_end(bytes->data, 21, bytes->len, &end));
+
+    g_byte_array_free(bytes, TRUE);
+
+    // the end record is searched backwards across the archive comment
+    bytes = three_entries("built by hand");
+
+    g_assert_true(read_end(bytes, &end));
+    g_assert_cmpuint(end.offset, ==, CDIR_OFFSET);
+
+    g_byte_array_free(bytes, TRUE);
+}
+
+static void test_offsets()
+{
+    GByteArray *bytes = three_entries("");
+    const guchar *cdir = bytes->data + CDIR_OFFSET;
+    gsize size = bytes->len - 22 - CDIR_OFFSET;
+    guint32 *offsets = zipdir_read_offsets(cdir, size, 3);
+
+    g_assert_nonnull(offsets);
+    g_assert_cmpuint(offsets[0], ==, C_OFFSET);
+    g_assert_cmpuint(offsets[1], ==, A_OFFSET);
+    g_assert_cmpuint(offsets[2], ==, B_OFFSET);
+    g_free(offsets);
+
+    // fewer entries are fine, more aren't
+    offsets = zipdir_read_offsets(cdir, size, 2);
+    g_assert_nonnull(offsets);
+    g_free(offsets);
+    g_assert_null(zipdir_read_offsets(cdir, size, 4));
+    g_assert_null(zipdir_read_offsets(cdir, size, 0));
+
+    // a directory which cuts off the header of its last entry
+    g_assert_null(zipdir_read_offsets(cdir, size - strlen("b.class") - 1,
+                3));
+
+    // a directory which doesn't start with a header
+    g_assert_null(zipdir_read_offsets(cdir + 4, size - 4, 3));
+
+    g_byte_array_free(bytes, TRUE);
+}
+
+static void test_zip64()
+{
+    GByteArray *bytes = g_byte_array_new();
+    guint32 a = zipfile_local(bytes, "a.class", "aa");
+    guint32 cdir_offset = bytes->len;
+
+    // ZIP64 marks the offset of an entry as kept in its extra field
+    zipfile_central(bytes, "a.class", a, 0, 0);
+    zipfile_central(bytes, "b.class", 0xffffffff, 0, 0);
+
+    g_assert_null(zipdir_read_offsets(bytes->data + cdir_offset,
+                bytes->len - cdir_offset, 2));
+
+    g_byte_array_free(bytes, TRUE);
+}
+
+/*
+ * A prefix of an archive without a comment lacks its end record
+ */
+static void check_truncated(const guchar *prefix, gsize size,
+        gpointer user_data)
+{
+    gsize tail = MIN(size, ZIPDIR_MAX_TAIL);
+    ZipDirEnd end;
+
+    g_assert_false(zipdir_read_end(prefix + size - tail, tail, size, &end));
+}
+
+static void test_truncated()
+{
+    GByteArray *bytes = three_entries("");
+
+    truncated_prefixes(bytes->data, bytes->len, check_truncated, NULL);
+
+    g_byte_array_free(bytes, TRUE);
+}
+
+int main(int argc, char **argv)
+{
+    g_test_init(&argc, &argv, NULL);
+
+    g_test_add_func("/zipdir/end", test_end);
+    g_test_add_func("/zipdir/offsets", test_offsets);
+    g_test_add_func("/zipdir/zip64", test_zip64);
+    g_test_add_func("/zipdir/truncated", test_truncated);
+
+    return g_test_run();
+}
@@ -0,0 +1,45 @@
+/*
+The MIT License (MIT) 
+Copyright (c) 2009,2010,2016 Andreas Heck <aheck@gmx.de>
+
+Permission to use, copy, modify, and/or distribute this software for any
+purpose with or without fee is hereby granted, provided that the above
+copyright notice and this permission notice appear in all copies.
+
+THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+*/
+
+#ifndef __TRUNCATED_H__
+#define __TRUNCATED_H__
+
+#include <string.h>
+#include <glib.h>
+
+typedef void (*TruncatedFunc)(const guchar *prefix, gsize size,
+        gpointer user_data);
+
+/*
+ * Call func for every proper prefix of data, from the empty one up
+ *
+ * Each prefix is a copy of its own which ends where the prefix ends, so
+ * ASan catches reads past it that a prefix of the whole buffer would hide.
+ */
+static inline void truncated_prefixes(const guchar *data, gsize size,
+        TruncatedFunc func, gpointer user_data)
+{
+    for (gsize length = 0; length < size; length++) {
+        guchar *prefix = length > 0 ? g_malloc(length) : NULL;
+
+        if (length > 0) memcpy(prefix, data, length);
+        func(prefix, length, user_data);
+        g_free(prefix);
+    }
+}
+
+#endif /* __TRUNCATED_H__ */
@@ -0,0 +1,191 @@
+/*
+The MIT License (MIT) 
+Copyright (c) 2009,2010,2016 Andreas Heck <aheck@gmx.de>
+
+Permission to use, copy, modify, and/or distribute this software for any
+purpose with or without fee is hereby granted, provided that the above
+copyright notice and this permission notice appear in all copies.
+
+THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+*/
+
+#ifndef __ZIPFILE_H__
+#define __ZIPFILE_H__
+
+#include <string.h>
+#include <glib.h>
+#include <zlib.h>
+
+/*
+ * Builder for the ZIP archives the tests feed to the central directory
+ * parsers
+ *
+ * Entries are stored uncompressed and without checksums, since only the
+ * headers are read. The local headers, the central directory and its end
+ * record are appended in turn like in a real archive, but the order of
+ * the central directory can differ from the one of the local headers.
+ * Only zipfile_archive() builds archives which libzip can read entries of.
+ */
+static inline void zipfile_u2(GByteArray *bytes, guint16 value)
+{
+    guint8 le[2] = {value & 0xff, value >> 8};
+
+    g_byte_array_append(bytes, le, 2);
+}
+
+static inline void zipfile_u4(GByteArray *bytes, guint32 value)
+{
+    zipfile_u2(bytes, value & 0xffff);
+    zipfile_u2(bytes, value >> 16);
+}
+
+static inline void zipfile_zeros(GByteArray *bytes, guint count)
+{
+    static const guint8 ZERO = 0;
+
+    for (guint i = 0; i < count; i++) g_byte_array_append(bytes, &ZERO, 1);
+}
+
+/*
+ * Append a local header with the stored contents of an entry and return
+ * its offset
+ */
+static inline guint32 zipfile_local(GByteArray *bytes, const gchar *name,
+        const gchar *contents)
+{
+    guint32 offset = bytes->len;
+
+    zipfile_u4(bytes, 0x04034b50);
+    zipfile_u2(bytes, 10);                      // version needed
+    zipfile_u2(bytes, 0);                       // flags
+    zipfile_u2(bytes, 0);                       // stored
+    zipfile_u4(bytes, 0);                       // time and date
+    zipfile_u4(bytes, 0);                       // crc-32
+    zipfile_u4(bytes, strlen(contents));
+    zipfile_u4(bytes, strlen(contents));
+    zipfile_u2(bytes, strlen(name));
+    zipfile_u2(bytes, 0);                       // extra field length
+    g_byte_array_append(bytes, (const guint8*) name, strlen(name));
+    g_byte_array_append(bytes, (const guint8*) contents, strlen(contents));
+
+    return offset;
+}
+
+/*
+ * Append the central directory header of an entry with extra_length bytes
+ * of extra field and comment_length bytes of comment
+ */
+static inline void zipfile_central(GByteArray *bytes, const gchar *name,
+        guint32 offset, guint16 extra_length, guint16 comment_length)
+{
+    zipfile_u4(bytes, 0x02014b50);
+    zipfile_u2(bytes, 20);                      // version made by
+    zipfile_u2(bytes, 10);                      // version needed
+    zipfile_u2(bytes, 0);                       // flags
+    zipfile_u2(bytes, 0);                       // stored
+    zipfile_u4(bytes, 0);                       // time and date
+    zipfile_u4(bytes, 0);                       // crc-32
+    zipfile_u4(bytes, 0);                       // compressed size
+    zipfile_u4(bytes, 0);                       // uncompressed size
+    zipfile_u2(bytes, strlen(name));
+    zipfile_u2(bytes, extra_length);
+    zipfile_u2(bytes, comment_length);
+    zipfile_u2(bytes, 0);                       // disk number
+    zipfile_u2(bytes, 0);                       // internal attributes
+    zipfile_u4(bytes, 0);                       // external attributes
+    zipfile_u4(bytes, offset);
+    g_byte_array_append(bytes, (const guint8*) name, strlen(name));
+    zipfile_zeros(bytes, extra_length + comment_length);
+}
+
+/*
+ * Append the end of central directory record followed by an archive
+ * comment
+ */
+static inline void zipfile_end(GByteArray *bytes, guint16 count,
+        guint32 cdir_size, guint32 cdir_offset, const gchar *comment)
+{
+    zipfile_u4(bytes, 0x06054b50);
+    zipfile_u2(bytes, 0);                       // disk number
+    zipfile_u2(bytes, 0);                       // disk of the directory
+    zipfile_u2(bytes, count);
+    zipfile_u2(bytes, count);
+    zipfile_u4(bytes, cdir_size);
+    zipfile_u4(bytes, cdir_offset);
+    zipfile_u2(bytes, strlen(comment));
+    g_byte_array_append(bytes, (const guint8*) comment, strlen(comment));
+}
+
+typedef struct {
+    const gchar *name;
+    const guint8 *data;
+    guint32 size;
+} ZipFileEntry;
+
+/*
+ * Build an archive of stored entries with the sizes and checksums libzip
+ * checks when it reads them
+ */
+static inline GByteArray *zipfile_archive(const ZipFileEntry *entries,
+        guint count)
+{
+    GByteArray *bytes = g_byte_array_new();
+    guint32 *offsets = g_new(guint32, count);
+    guint32 *crcs = g_new(guint32, count);
+    guint32 cdir_offset = 0;
+
+    for (guint i = 0; i < count; i++) {
+        const ZipFileEntry *entry = &entries[i];
+
+        offsets[i] = bytes->len;
+        crcs[i] = crc32(0, entry->data, entry->size);
+
+        zipfile_u4(bytes, 0x04034b50);
+        zipfile_u2(bytes, 10);                  // version needed
+        zipfile_u4(bytes, 0);                   // flags and stored
+        zipfile_u4(bytes, 0);                   // time and date
+        zipfile_u4(bytes, crcs[i]);
+        zipfile_u4(bytes, entry->size);
+        zipfile_u4(bytes, entry->size);
+        zipfile_u2(bytes, strlen(entry->name));
+        zipfile_u2(bytes, 0);                   // extra field length
+        g_byte_array_append(bytes, (const guint8*) entry->name,
+                strlen(entry->name));
+        g_byte_array_append(bytes, entry->data, entry->size);
+    }
+
+    cdir_offset = bytes->len;
+
+    for (guint i = 0; i < count; i++) {
+        const ZipFileEntry *entry = &entries[i];
+
+        zipfile_u4(bytes, 0x02014b50);
+        zipfile_u2(bytes, 20);                  // version made by
+        zipfile_u2(bytes, 10);                  // version needed
+        zipfile_u4(bytes, 0);                   // flags and stored
+        zipfile_u4(bytes, 0);                   // time and date
+        zipfile_u4(bytes, crcs[i]);
+        zipfile_u4(bytes, entry->size);
+        zipfile_u4(bytes, entry->size);
+        zipfile_u2(bytes, strlen(entry->name));
+        zipfile_zeros(bytes, 12);               // lengths and attributes
+        zipfile_u4(bytes, offsets[i]);
+        g_byte_array_append(bytes, (const guint8*) entry->name,
+                strlen(entry->name));
+    }
+
+    zipfile_end(bytes, count, bytes->len - cdir_offset, cdir_offset, "");
+
+    g_free(offsets);
+    g_free(crcs);
+
+    return bytes;
+}
+
+#endif /* __ZIPFILE_H__ */